@@ -0,0 +1,156 @@
+#include "BatchRunner.h"
+#include "CommandParser.h"
+#include "LinkArbiter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace Visca {
+
+namespace {
+    using Clock = LinkArbiter::Clock;
+
+    constexpr LinkArbiter::ClientId Script = 1;
+
+    enum class State { Queued, Sent, Acknowledged, Completed, Failed };
+}
+
+bool readBatch(std::istream& input, std::vector<BatchLine>& lines, std::vector<std::string>& errors)
+{
+    std::string text;
+    for (size_t number = 1; std::getline(input, text); ++number) {
+        if (!text.empty() && text.back() == '\r')
+            text.pop_back();
+
+        BatchLine line;
+        bool blank = false;
+        std::string error;
+        if (!parseCommand(text, line.command, blank, error)) {
+            errors.push_back("line " + std::to_string(number) + ": " + error);
+            continue;
+        }
+        if (blank)
+            continue;
+
+        line.lineNumber = number;
+        line.text = text.substr(0, text.find('#'));
+        line.text.erase(line.text.find_last_not_of(" \t") + 1);
+        line.text.erase(0, line.text.find_first_not_of(" \t"));
+        lines.push_back(std::move(line));
+    }
+    return errors.empty();
+}
+
+int runBatch(ViscaController& camera, const std::vector<BatchLine>& lines, const BatchOptions& options,
+    const std::atomic<bool>& stop)
+{
+    LinkArbiter::Config config;
+    config.sockets = options.sockets;
+    config.maxQueued = std::max<size_t>(lines.size(), 1);
+    config.replyTimeout = options.replyTimeout;
+    config.completionTimeout = options.completionTimeout;
+    LinkArbiter arbiter(config);
+
+    std::vector<State> states(lines.size(), State::Queued);
+    std::vector<Clock::time_point> sentAt(lines.size());
+    std::vector<LinkArbiter::Output> outputs;
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const auto& packet = lines[i].command.packet();
+        arbiter.submit(Script, static_cast<uint32_t>(i), packet.data(), packet.size(), start, outputs);
+    }
+
+    char prefix[48];
+    auto print = [&](Clock::time_point now) {
+        for (const auto& output : outputs) {
+            if (output.tag >= lines.size())
+                continue;
+            Response response;
+            response.parse(output.data);
+            State& state = states[output.tag];
+            if (response.isAcknowledge())
+                state = State::Acknowledged;
+            else if (response.isCompletion())
+                state = State::Completed;
+            else if (response.isError())
+                state = State::Failed;
+
+            double ms = std::chrono::duration<double, std::milli>(now - sentAt[output.tag]).count();
+            std::snprintf(prefix, sizeof(prefix), "%5zu %9.3f ms  ", lines[output.tag].lineNumber, ms);
+            std::cout << prefix << formatBytes(output.data) << "  " << describeReply(response) << "  "
+                      << lines[output.tag].text << '\n';
+        }
+        outputs.clear();
+    };
+
+    bool stopped = false;
+    while (!arbiter.isIdle()) {
+        if (stop && !stopped) {
+            // Send nothing more, but wait for what is running
+            arbiter.removeClient(Script);
+            stopped = true;
+        }
+
+        LinkArbiter::Dispatch dispatch;
+        while (arbiter.next(dispatch, Clock::now())) {
+            sentAt[dispatch.tag] = Clock::now();
+            states[dispatch.tag] = State::Sent;
+            if (!camera.sendAsync(lines[dispatch.tag].command)) {
+                std::cerr << "Line " << lines[dispatch.tag].lineNumber << ": sending failed, link lost" << std::endl;
+                return 1;
+            }
+        }
+
+        // Wake up for a reply, or when the arbiter gives up waiting for one
+        int waitMs = 100;
+        Clock::time_point deadline;
+        if (arbiter.nextDeadline(deadline)) {
+            auto untilDeadline = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+            waitMs = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(waitMs, untilDeadline.count() + 1)));
+        }
+        Response response;
+        if (camera.pollResponse(response, waitMs)) {
+            auto now = Clock::now();
+            arbiter.onReply(response.data().data(), response.data().size(), now, outputs);
+            print(now);
+        }
+        arbiter.expire(Clock::now());
+    }
+
+    size_t completed = 0, failed = 0, unanswered = 0, notSent = 0;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        switch (states[i]) {
+        case State::Completed:
+            ++completed;
+            break;
+        case State::Failed:
+            ++failed;
+            break;
+        case State::Queued:
+            ++notSent;
+            break;
+        default:
+            ++unanswered;
+            std::snprintf(prefix, sizeof(prefix), "%5zu %12s  ", lines[i].lineNumber, "");
+            std::cout << prefix << (states[i] == State::Sent ? "no reply" : "no completion") << "  " << lines[i].text
+                      << '\n';
+            break;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    char timing[64];
+    std::snprintf(timing, sizeof(timing), "%.3f s (%.1f/s)", seconds,
+        seconds > 0 ? static_cast<double>(lines.size() - notSent) / seconds : 0.0);
+    std::cout << "--- " << lines.size() - notSent << " commands in " << timing << ": " << completed << " completed, "
+              << failed << " failed, " << unanswered << " unanswered";
+    if (notSent > 0)
+        std::cout << ", " << notSent << " not sent";
+    std::cout << std::endl;
+
+    return completed == lines.size() ? 0 : 1;
+}
+
+}
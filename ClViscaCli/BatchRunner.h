@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Commands.h"
+#include "ViscaController.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief One command of a batch script.
+ */
+struct BatchLine {
+    size_t lineNumber { 0 };
+    std::string text; ///< As written, without the comment
+    Command command;
+};
+
+struct BatchOptions {
+    uint8_t sockets { 2 }; ///< Command buffers of the camera, commands running at once
+    std::chrono::milliseconds replyTimeout { 1000 }; ///< For the ACK or inquiry reply
+    std::chrono::seconds completionTimeout { 10 };
+};
+
+/**
+ * @brief Read a script, one command per line in the syntax of parseCommand(); blank lines and comments are skipped.
+ * @return false, with every bad line and its number in errors, if any line is not a command.
+ */
+bool readBatch(std::istream& input, std::vector<BatchLine>& lines, std::vector<std::string>& errors);
+
+/**
+ * @brief Send the commands over one connection, pipelined, and print every reply as it arrives.
+ *
+ * The commands go through a LinkArbiter in script order: the next packet is written as soon as the previous one got
+ * its ACK or reply, while both camera sockets run commands only inquiries may go ahead of the waiting command, so
+ * the line stays busy without overrunning the camera. Each reply is printed with the script line it belongs to, the
+ * time since that command was written and the reply bytes; a summary follows at the end.
+ * @param stop Set (e.g. from a SIGINT handler) to stop sending, replies of commands already sent are still awaited.
+ * @return 0 if every command completed, 1 if any failed or went unanswered.
+ */
+int runBatch(ViscaController& camera, const std::vector<BatchLine>& lines, const BatchOptions& options,
+    const std::atomic<bool>& stop);
+
+}
@@ -0,0 +1,186 @@
+#include "CommandParser.h"
+
+#include <cctype>
+#include <cstdio>
+#include <sstream>
+
+namespace Visca {
+
+namespace {
+    bool isHex(const std::string& text)
+    {
+        for (char c : text) {
+            if (!std::isxdigit(static_cast<unsigned char>(c)))
+                return false;
+        }
+        return !text.empty();
+    }
+
+    bool parseNumber(const std::string& text, unsigned long maximum, unsigned long& value)
+    {
+        try {
+            size_t end = 0;
+            value = std::stoul(text, &end, 0);
+            return end == text.size() && value <= maximum;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    Command build(const std::string& name, unsigned long argument)
+    {
+        auto speed = static_cast<uint8_t>(argument);
+        auto position = static_cast<uint16_t>(argument);
+        if (name == "power-on")
+            return Command::powerOn();
+        if (name == "power-off")
+            return Command::powerOff();
+        if (name == "power-inquiry")
+            return Command::powerInquiry();
+        if (name == "zoom-stop")
+            return Command::zoomStop();
+        if (name == "zoom-tele")
+            return Command::zoomTeleStandard();
+        if (name == "zoom-wide")
+            return Command::zoomWideStandard();
+        if (name == "zoom-tele-variable")
+            return Command::zoomTeleVariable(1, speed);
+        if (name == "zoom-wide-variable")
+            return Command::zoomWideVariable(1, speed);
+        if (name == "zoom-direct")
+            return Command::zoomDirect(1, position);
+        if (name == "zoom-inquiry")
+            return Command::zoomPositionInquiry();
+        if (name == "focus-stop")
+            return Command::focusStop();
+        if (name == "focus-far")
+            return Command::focusFarStandard();
+        if (name == "focus-near")
+            return Command::focusNearStandard();
+        if (name == "focus-far-variable")
+            return Command::focusFarVariable(1, speed);
+        if (name == "focus-near-variable")
+            return Command::focusNearVariable(1, speed);
+        if (name == "focus-direct")
+            return Command::focusDirect(1, position);
+        if (name == "focus-auto")
+            return Command::focusAuto();
+        if (name == "focus-manual")
+            return Command::focusManual();
+        if (name == "focus-one-push")
+            return Command::focusOnePushTrigger();
+        if (name == "focus-inquiry")
+            return Command::focusPositionInquiry();
+        return Command::versionInquiry();
+    }
+}
+
+const std::vector<NamedCommand>& namedCommands()
+{
+    static const std::vector<NamedCommand> commands {
+        { "power-on", nullptr, "Power on" },
+        { "power-off", nullptr, "Power off (standby)" },
+        { "power-inquiry", nullptr, "Power state" },
+        { "zoom-stop", nullptr, "Stop zooming" },
+        { "zoom-tele", nullptr, "Zoom in at standard speed" },
+        { "zoom-wide", nullptr, "Zoom out at standard speed" },
+        { "zoom-tele-variable", "speed", "Zoom in at speed 0-7" },
+        { "zoom-wide-variable", "speed", "Zoom out at speed 0-7" },
+        { "zoom-direct", "position", "Zoom to a position" },
+        { "zoom-inquiry", nullptr, "Zoom position" },
+        { "focus-stop", nullptr, "Stop focusing" },
+        { "focus-far", nullptr, "Focus far at standard speed" },
+        { "focus-near", nullptr, "Focus near at standard speed" },
+        { "focus-far-variable", "speed", "Focus far at speed 0-7" },
+        { "focus-near-variable", "speed", "Focus near at speed 0-7" },
+        { "focus-direct", "position", "Focus to a position (manual focus)" },
+        { "focus-auto", nullptr, "Auto focus" },
+        { "focus-manual", nullptr, "Manual focus" },
+        { "focus-one-push", nullptr, "One push auto focus" },
+        { "focus-inquiry", nullptr, "Focus position" },
+        { "version", nullptr, "Vendor, model, ROM revision and sockets" },
+    };
+    return commands;
+}
+
+bool parseCommand(const std::string& line, Command& command, bool& blank, std::string& error)
+{
+    command = Command();
+    std::istringstream stream(line.substr(0, line.find('#')));
+    std::vector<std::string> tokens;
+    std::string token;
+    while (stream >> token)
+        tokens.push_back(token);
+
+    blank = tokens.empty();
+    if (blank)
+        return true;
+
+    // Raw packet: every token is hex, together an even number of digits
+    std::string digits;
+    bool raw = true;
+    for (const auto& t : tokens) {
+        raw = raw && isHex(t);
+        digits += t;
+    }
+    if (raw) {
+        if (digits.size() % 2 != 0) {
+            error = "odd number of hex digits";
+            return false;
+        }
+        std::vector<uint8_t> packet;
+        for (size_t i = 0; i < digits.size(); i += 2)
+            packet.push_back(static_cast<uint8_t>(std::stoul(digits.substr(i, 2), nullptr, 16)));
+        command = Command::fromPacket(packet);
+        if (command.empty()) {
+            error = "not a VISCA packet (8x header, FF only at the end, at most 16 bytes)";
+            return false;
+        }
+        return true;
+    }
+
+    for (const auto& named : namedCommands()) {
+        if (tokens[0] != named.name)
+            continue;
+
+        unsigned long argument = 0;
+        size_t expected = named.argument ? 2 : 1;
+        if (tokens.size() != expected) {
+            error = tokens[0] + (named.argument ? std::string(" takes a ") + named.argument : " takes no argument");
+            return false;
+        }
+        if (named.argument && !parseNumber(tokens[1], std::string(named.argument) == "speed" ? 7 : 0xFFFF, argument)) {
+            error = "bad " + std::string(named.argument) + ": " + tokens[1];
+            return false;
+        }
+        command = build(named.name, argument);
+        return true;
+    }
+
+    error = "unknown command: " + tokens[0];
+    return false;
+}
+
+std::string formatBytes(const std::vector<uint8_t>& bytes)
+{
+    std::string text;
+    char hex[4];
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        std::snprintf(hex, sizeof(hex), i ? " %02X" : "%02X", bytes[i]);
+        text += hex;
+    }
+    return text;
+}
+
+std::string describeReply(const Response& response)
+{
+    if (response.isAcknowledge())
+        return "ack";
+    if (response.isCompletion())
+        return response.data().size() > 3 ? "reply" : "completion";
+    if (response.isError())
+        return "error: " + response.errorString();
+    return "unknown";
+}
+
+}
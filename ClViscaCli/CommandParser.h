@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Commands.h"
+
+#include <string>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief A command the CLI knows by name, with the argument it takes.
+ */
+struct NamedCommand {
+    const char* name;
+    const char* argument; ///< "speed" (0-7), "position" (0x0000-0xFFFF) or nullptr
+    const char* description;
+};
+
+const std::vector<NamedCommand>& namedCommands();
+
+/**
+ * @brief Parse one command as typed in a script or at a prompt.
+ *
+ * Either a name from namedCommands() with its argument (decimal or 0x hex), e.g. "zoom-direct 0x4000", or the raw
+ * packet as hex bytes, e.g. "81 01 04 07 02 FF" or "8101040702FF". Anything from a '#' on is a comment.
+ * @param blank Set when the line holds no command (empty or only a comment), command is left empty then.
+ * @return false, with a message in error, if the line is not a command.
+ */
+bool parseCommand(const std::string& line, Command& command, bool& blank, std::string& error);
+
+/**
+ * @brief Hex bytes separated by spaces, e.g. "90 41 FF".
+ */
+std::string formatBytes(const std::vector<uint8_t>& bytes);
+
+/**
+ * @brief What a reply is: "ack", "completion", "reply" (an inquiry's, with data), "error: <reason>" or "unknown".
+ */
+std::string describeReply(const Response& response);
+
+}
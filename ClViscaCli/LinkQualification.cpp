@@ -0,0 +1,405 @@
+#include "LinkQualification.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+namespace Visca {
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    std::string formatNs(uint64_t ns)
+    {
+        char text[32];
+        if (ns < 1000000)
+            std::snprintf(text, sizeof(text), "%.0f us", static_cast<double>(ns) / 1e3);
+        else if (ns < 1000000000)
+            std::snprintf(text, sizeof(text), "%.2f ms", static_cast<double>(ns) / 1e6);
+        else
+            std::snprintf(text, sizeof(text), "%.2f s", static_cast<double>(ns) / 1e9);
+        return text;
+    }
+
+    std::string formatBound(uint64_t ns)
+    {
+        char text[32];
+        if (ns < 1000000)
+            std::snprintf(text, sizeof(text), "%g us", static_cast<double>(ns) / 1e3);
+        else if (ns < 1000000000)
+            std::snprintf(text, sizeof(text), "%g ms", static_cast<double>(ns) / 1e6);
+        else
+            std::snprintf(text, sizeof(text), "%g s", static_cast<double>(ns) / 1e9);
+        return text;
+    }
+
+    std::string formatElapsed(Clock::duration elapsed)
+    {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(elapsed).count();
+        char text[32];
+        std::snprintf(text, sizeof(text), "%3lld:%02lld:%02lld", static_cast<long long>(seconds / 3600),
+            static_cast<long long>(seconds / 60 % 60), static_cast<long long>(seconds % 60));
+        return text;
+    }
+
+    // Sleep in short slices so that a stop request is not held up by a long interval
+    void sleepUntil(Clock::time_point until, const std::atomic<bool>& stop)
+    {
+        while (!stop) {
+            auto now = Clock::now();
+            if (now >= until)
+                return;
+            std::this_thread::sleep_for(std::min<Clock::duration>(until - now, std::chrono::milliseconds(50)));
+        }
+    }
+
+    bool inquiryByName(const std::string& name, Command& command)
+    {
+        if (name == "zoom")
+            command = Command::zoomPositionInquiry();
+        else if (name == "focus")
+            command = Command::focusPositionInquiry();
+        else if (name == "power")
+            command = Command::powerInquiry();
+        else if (name == "version")
+            command = Command::versionInquiry();
+        else
+            return false;
+        return true;
+    }
+
+    // Moving commands alternate between two positions so that every one of them makes the motor travel
+    Command soakCommand(const std::string& name, uint64_t use)
+    {
+        if (name == "zoom-inquiry")
+            return Command::zoomPositionInquiry();
+        if (name == "focus-inquiry")
+            return Command::focusPositionInquiry();
+        if (name == "power-inquiry")
+            return Command::powerInquiry();
+        if (name == "version")
+            return Command::versionInquiry();
+        if (name == "zoom-direct")
+            return Command::zoomDirect(1, use % 2 ? 0x4000 : 0x0000);
+        if (name == "zoom-stop")
+            return Command::zoomStop();
+        return Command::focusStop();
+    }
+
+    void printPercentiles(std::ostream& out, const HistogramSnapshot& histogram)
+    {
+        out << "p50 " << formatNs(histogram.percentileNs(0.50)) << "  p99 " << formatNs(histogram.percentileNs(0.99))
+            << "  max " << formatNs(histogram.maxNs);
+    }
+}
+
+const std::vector<std::string>& soakCommandNames()
+{
+    static const std::vector<std::string> names { "zoom-inquiry", "focus-inquiry", "power-inquiry", "version",
+        "zoom-direct", "zoom-stop", "focus-stop" };
+    return names;
+}
+
+bool parseSoakMix(const std::string& mix, std::vector<SoakCommand>& commands, std::string& error)
+{
+    commands.clear();
+    std::stringstream stream(mix);
+    std::string entry;
+    while (std::getline(stream, entry, ',')) {
+        SoakCommand command;
+        auto colon = entry.find(':');
+        command.name = entry.substr(0, colon);
+        if (colon != std::string::npos) {
+            const std::string weight = entry.substr(colon + 1);
+            if (weight.empty() || weight.find_first_not_of("0123456789") != std::string::npos
+                || std::stoul(weight) == 0) {
+                error = entry;
+                return false;
+            }
+            command.weight = static_cast<unsigned>(std::stoul(weight));
+        }
+        const auto& names = soakCommandNames();
+        if (std::find(names.begin(), names.end(), command.name) == names.end()) {
+            error = entry;
+            return false;
+        }
+        commands.push_back(command);
+    }
+    if (commands.empty()) {
+        error = mix;
+        return false;
+    }
+    return true;
+}
+
+bool parseDuration(const std::string& text, std::chrono::seconds& duration)
+{
+    size_t end = 0;
+    long long value;
+    try {
+        value = std::stoll(text, &end);
+    } catch (const std::exception&) {
+        return false;
+    }
+    const std::string unit = text.substr(end);
+    if (value < 0)
+        return false;
+    if (unit.empty() || unit == "s")
+        duration = std::chrono::seconds(value);
+    else if (unit == "m")
+        duration = std::chrono::minutes(value);
+    else if (unit == "h")
+        duration = std::chrono::hours(value);
+    else
+        return false;
+    return true;
+}
+
+void printHistogram(std::ostream& out, const HistogramSnapshot& histogram)
+{
+    if (histogram.count == 0) {
+        out << "  (no samples)" << std::endl;
+        return;
+    }
+
+    size_t first = 0;
+    while (first < histogram.buckets.size() && histogram.buckets[first] == 0)
+        ++first;
+    uint64_t fastest = HdrHistogram::bucketUpperBound(first);
+
+    // Ten rows a decade: 1 us, 1.2 us, 1.5 us, 2 us ... 8 us, 10 us ... up to the row holding the slowest sample
+    std::vector<uint64_t> bounds;
+    for (uint64_t decade = 100; bounds.empty() || bounds.back() < histogram.maxNs; decade *= 10) {
+        for (uint64_t step : { 10, 12, 15, 20, 25, 30, 40, 50, 60, 80 }) {
+            uint64_t bound = decade * step;
+            if (bound >= fastest && (bounds.empty() || bounds.back() < histogram.maxNs))
+                bounds.push_back(bound);
+        }
+    }
+
+    std::vector<uint64_t> rows;
+    uint64_t below = 0;
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        uint64_t atOrBelow = i + 1 == bounds.size() ? histogram.count : histogram.countAtOrBelow(bounds[i]);
+        rows.push_back(atOrBelow - below);
+        below = atOrBelow;
+    }
+    uint64_t widest = *std::max_element(rows.begin(), rows.end());
+
+    constexpr size_t BarWidth = 40;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        // A gap between clusters (e.g. inquiries and motor moves) shows as one line
+        if (rows[i] == 0 && i > 0 && rows[i - 1] == 0)
+            continue;
+        if (rows[i] == 0 && i + 1 < rows.size() && rows[i + 1] == 0) {
+            out << "  ..." << std::endl;
+            continue;
+        }
+        size_t bar = widest ? static_cast<size_t>(rows[i] * BarWidth / widest) : 0;
+        if (rows[i] > 0 && bar == 0)
+            bar = 1;
+        char line[160];
+        std::snprintf(line, sizeof(line), "  <= %-7s |%-*s| %10llu %5.1f%%", formatBound(bounds[i]).c_str(),
+            static_cast<int>(BarWidth), std::string(bar, '#').c_str(), static_cast<unsigned long long>(rows[i]),
+            100.0 * static_cast<double>(rows[i]) / static_cast<double>(histogram.count));
+        out << line << std::endl;
+    }
+}
+
+int runLatency(ViscaController& camera, const LatencyOptions& options, const std::atomic<bool>& stop)
+{
+    Command probe;
+    if (!inquiryByName(options.inquiry, probe)) {
+        std::cerr << "Unknown inquiry: " << options.inquiry << " (zoom, focus, power or version)" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Probing with the " << options.inquiry << " inquiry every " << options.interval.count()
+              << " ms, Ctrl+C to stop" << std::endl;
+
+    HdrHistogram rtt;
+    uint64_t sent = 0;
+    uint64_t timeouts = 0;
+    uint64_t errors = 0;
+    auto printSummary = [&] {
+        auto snapshot = rtt.snapshot();
+        uint64_t lost = timeouts + errors;
+        std::cout << "--- " << sent << " probes, " << snapshot.count << " answered, " << timeouts << " timeouts, "
+                  << errors << " errors (" << (sent ? 100.0 * static_cast<double>(lost) / static_cast<double>(sent) : 0)
+                  << "% lost)" << std::endl;
+        if (snapshot.count > 0) {
+            std::cout << "    rtt mean " << formatNs(static_cast<uint64_t>(snapshot.meanNs())) << "  ";
+            printPercentiles(std::cout, snapshot);
+            std::cout << std::endl;
+        }
+        printHistogram(std::cout, snapshot);
+    };
+
+    auto next = Clock::now();
+    auto nextReport = next + options.reportInterval;
+    while (!stop && (options.count == 0 || sent < options.count)) {
+        Response response;
+        auto start = Clock::now();
+        bool answered = camera.execute(probe, response);
+        auto elapsed = Clock::now() - start;
+        ++sent;
+
+        if (answered) {
+            rtt.record(elapsed);
+            std::cout << "seq=" << sent << " rtt=" << formatNs(static_cast<uint64_t>(elapsed.count())) << std::endl;
+        } else if (response.isError()) {
+            ++errors;
+            std::cout << "seq=" << sent << " error: " << response.errorString() << std::endl;
+        } else {
+            ++timeouts;
+            std::cout << "seq=" << sent << " no reply" << std::endl;
+        }
+
+        if (Clock::now() >= nextReport) {
+            printSummary();
+            nextReport += options.reportInterval;
+        }
+        next += options.interval;
+        if (options.count == 0 || sent < options.count)
+            sleepUntil(next, stop);
+    }
+
+    printSummary();
+    return timeouts + errors == 0 && sent > 0 ? 0 : 1;
+}
+
+int runSoak(ViscaController& camera, const SoakOptions& options, const std::atomic<bool>& stop)
+{
+    std::vector<SoakCommand> commands;
+    std::string error;
+    if (!parseSoakMix(options.mix, commands, error)) {
+        std::cerr << "Bad mix entry: " << error << ", commands are:";
+        for (const auto& name : soakCommandNames())
+            std::cerr << " " << name;
+        std::cerr << std::endl;
+        return 1;
+    }
+
+    std::cout << "Soaking for " << formatElapsed(options.duration) << " with " << options.mix << ", report every "
+              << options.reportInterval.count() << " s, Ctrl+C to stop" << std::endl;
+
+    // Smooth weighted round robin: the commands interleave instead of coming in runs of their weight
+    std::vector<long long> credit(commands.size(), 0);
+    long long totalWeight = 0;
+    for (const auto& command : commands)
+        totalWeight += command.weight;
+    std::vector<uint64_t> uses(commands.size(), 0);
+
+    int responseTimeout = camera.responseTimeout();
+    camera.setResponseTimeout(options.responseTimeoutMs);
+
+    // Motor moves take as long as they travel, the drift of the link shows in the inquiries when the mix has any
+    bool driftOfInquiries = false;
+    for (const auto& command : commands)
+        driftOfInquiries = driftOfInquiries || soakCommand(command.name, 0).isInquiry();
+
+    HdrHistogram total;
+    auto interval = std::make_unique<HdrHistogram>();
+    auto intervalInquiries = std::make_unique<HdrHistogram>();
+    uint64_t commandsTotal = 0, timeoutsTotal = 0, errorsTotal = 0;
+    uint64_t commandsNow = 0, timeoutsNow = 0, errorsNow = 0;
+    uint64_t baselineP50 = 0;
+    uint64_t staleBefore = camera.metrics().staleReplies;
+
+    auto start = Clock::now();
+    auto deadline = start + options.duration;
+    auto nextReport = start + options.reportInterval;
+    auto lastReport = start;
+    auto report = [&](Clock::time_point now) {
+        auto snapshot = interval->snapshot();
+        uint64_t stale = camera.metrics().staleReplies;
+        double seconds = std::chrono::duration<double>(now - lastReport).count();
+        char rate[32];
+        std::snprintf(rate, sizeof(rate), "%.1f/s", seconds > 0 ? static_cast<double>(commandsNow) / seconds : 0.0);
+        std::cout << "[" << formatElapsed(now - start) << "] " << commandsNow << " commands " << rate << "  timeouts "
+                  << timeoutsNow << "  errors " << errorsNow << "  late replies " << stale - staleBefore << " | ";
+        if (snapshot.count > 0)
+            printPercentiles(std::cout, snapshot);
+        else
+            std::cout << "no replies";
+        auto driftSnapshot = driftOfInquiries ? intervalInquiries->snapshot() : snapshot;
+        if (driftSnapshot.count > 0) {
+            uint64_t p50 = driftSnapshot.percentileNs(0.50);
+            if (baselineP50 == 0)
+                baselineP50 = p50;
+            double base = static_cast<double>(baselineP50);
+            char drift[32];
+            std::snprintf(drift, sizeof(drift), "%+.1f%%", 100.0 * (static_cast<double>(p50) - base) / base);
+            std::cout << " | " << (driftOfInquiries ? "inquiry " : "") << "p50 drift " << drift;
+        }
+        std::cout << std::endl;
+
+        staleBefore = stale;
+        lastReport = now;
+        commandsNow = timeoutsNow = errorsNow = 0;
+        interval = std::make_unique<HdrHistogram>();
+        intervalInquiries = std::make_unique<HdrHistogram>();
+    };
+
+    while (!stop && Clock::now() < deadline) {
+        size_t pick = 0;
+        for (size_t i = 0; i < commands.size(); ++i) {
+            credit[i] += commands[i].weight;
+            if (credit[i] > credit[pick])
+                pick = i;
+        }
+        credit[pick] -= totalWeight;
+
+        Command command = soakCommand(commands[pick].name, uses[pick]++);
+        Response response;
+        auto sentAt = Clock::now();
+        bool completed = camera.execute(command, response);
+        auto elapsed = Clock::now() - sentAt;
+        ++commandsNow;
+        ++commandsTotal;
+        if (completed) {
+            interval->record(elapsed);
+            total.record(elapsed);
+            if (command.isInquiry())
+                intervalInquiries->record(elapsed);
+        } else if (response.isError()) {
+            ++errorsNow;
+            ++errorsTotal;
+            std::cout << "[" << formatElapsed(Clock::now() - start) << "] " << commands[pick].name
+                      << ": " << response.errorString() << std::endl;
+        } else {
+            ++timeoutsNow;
+            ++timeoutsTotal;
+        }
+
+        auto now = Clock::now();
+        if (now >= nextReport) {
+            report(now);
+            nextReport += options.reportInterval;
+        }
+        if (options.interval.count() > 0)
+            sleepUntil(std::min(now + options.interval, deadline), stop);
+    }
+    if (commandsNow > 0)
+        report(Clock::now());
+    camera.setResponseTimeout(responseTimeout);
+
+    auto snapshot = total.snapshot();
+    std::cout << "--- " << formatElapsed(Clock::now() - start) << ", " << commandsTotal << " commands, "
+              << timeoutsTotal << " timeouts, " << errorsTotal << " errors" << std::endl;
+    if (snapshot.count > 0) {
+        std::cout << "    ";
+        printPercentiles(std::cout, snapshot);
+        std::cout << std::endl;
+    }
+    printHistogram(std::cout, snapshot);
+
+    bool passed = commandsTotal > 0 && timeoutsTotal == 0 && errorsTotal == 0;
+    std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+    return passed ? 0 : 1;
+}
+
+}
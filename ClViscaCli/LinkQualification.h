@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ControllerMetrics.h"
+#include "ViscaController.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief Options of the latency subcommand: ping a camera with one inquiry.
+ */
+struct LatencyOptions {
+    std::string inquiry { "zoom" }; ///< zoom, focus, power or version
+    uint64_t count { 0 }; ///< Probes to send, 0 until stopped
+    std::chrono::milliseconds interval { 200 }; ///< From one probe's start to the next
+    std::chrono::seconds reportInterval { 10 }; ///< How often the histogram is printed
+};
+
+/**
+ * @brief Options of the soak subcommand: a command mix for hours, reported every reportInterval.
+ */
+struct SoakOptions {
+    std::chrono::seconds duration { 3600 };
+    std::string mix { "zoom-inquiry:4,focus-inquiry:2,power-inquiry:1,zoom-direct:1" }; ///< name:weight,...
+    std::chrono::milliseconds interval { 0 }; ///< Pause between commands
+    std::chrono::seconds reportInterval { 60 };
+    int responseTimeoutMs { 5000 }; ///< Long enough for zoom-direct to travel end to end
+};
+
+/**
+ * @brief One entry of a soak mix, see soakCommandNames() for the names.
+ */
+struct SoakCommand {
+    std::string name;
+    unsigned weight { 1 };
+};
+
+/**
+ * @brief Parse "name:weight,name,..." (weight 1 when left out).
+ * @return false, with the offending entry in error, if a name is unknown or a weight is not a positive number.
+ */
+bool parseSoakMix(const std::string& mix, std::vector<SoakCommand>& commands, std::string& error);
+
+const std::vector<std::string>& soakCommandNames();
+
+/**
+ * @brief Parse a duration such as 90, 90s, 15m or 8h; plain numbers are seconds.
+ */
+bool parseDuration(const std::string& text, std::chrono::seconds& duration);
+
+/**
+ * @brief Round-trip times as rows of a bar chart, ten rows a decade from the fastest to the slowest sample.
+ */
+void printHistogram(std::ostream& out, const HistogramSnapshot& histogram);
+
+/**
+ * @brief Send the inquiry every interval and print each round-trip time as it comes, like ping, and the histogram of
+ * all of them every reportInterval and at the end.
+ * @param stop Set (e.g. from a SIGINT handler) to end early.
+ * @return 0 if every probe was answered, 1 otherwise.
+ */
+int runLatency(ViscaController& camera, const LatencyOptions& options, const std::atomic<bool>& stop);
+
+/**
+ * @brief Run the command mix in a weighted round robin for the duration, every reportInterval print the commands,
+ * timeouts and errors of the interval, its latency percentiles and how far its median drifted from the first
+ * interval's; a summary with the histogram of the whole run at the end.
+ * @return 0 if no command timed out or failed, 1 otherwise.
+ */
+int runSoak(ViscaController& camera, const SoakOptions& options, const std::atomic<bool>& stop);
+
+}
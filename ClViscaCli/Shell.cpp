@@ -0,0 +1,539 @@
+#include "Shell.h"
+#include "CommandParser.h"
+#include "LinkArbiter.h"
+#include "Terminal.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Visca {
+
+namespace {
+    using Clock = LinkArbiter::Clock;
+
+    constexpr LinkArbiter::ClientId TypedClient = 1;
+    constexpr LinkArbiter::ClientId TelemetryClient = 2;
+    constexpr uint32_t ZoomTag = 0;
+    constexpr uint32_t FocusTag = 1;
+
+    const std::vector<std::string> Builtins { "help", "telemetry", "quit" };
+
+    /**
+     * @brief What the prompt shows, published by the pump thread.
+     */
+    struct Status {
+        bool telemetry { false };
+        bool zoomKnown { false };
+        bool focusKnown { false };
+        uint16_t zoom { 0 };
+        uint16_t focus { 0 };
+        double roundTripMs { 0 }; ///< Of the last telemetry inquiry
+        size_t running { 0 }; ///< Typed commands not yet completed
+        bool linkLost { false };
+    };
+
+    double msSince(Clock::time_point since, Clock::time_point now)
+    {
+        return std::chrono::duration<double, std::milli>(now - since).count();
+    }
+
+    /**
+     * @brief Owns the link while the prompt is open: sends the typed commands and the telemetry inquiries, and turns
+     * the replies into lines for the keyboard thread to print.
+     */
+    class Pump {
+    public:
+        Pump(ViscaController& camera, const ShellOptions& options)
+            : m_camera(camera)
+            , m_options(options)
+            , m_arbiter(config(options))
+        {
+            m_status.telemetry = options.telemetryInterval.count() > 0;
+            m_telemetryInterval = options.telemetryInterval;
+        }
+
+        ~Pump() { stop(); }
+
+        void start()
+        {
+            m_running = true;
+            m_thread = std::thread(&Pump::run, this);
+        }
+
+        void stop()
+        {
+            m_running = false;
+            if (m_thread.joinable())
+                m_thread.join();
+        }
+
+        void submit(uint32_t id, const std::string& text, const Command& command)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_submitted.push_back({ id, text, command });
+        }
+
+        void setTelemetryInterval(std::chrono::milliseconds interval)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_telemetryInterval = interval;
+            m_status.telemetry = interval.count() > 0;
+        }
+
+        bool takeLine(std::string& line)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_lines.empty())
+                return false;
+            line = std::move(m_lines.front());
+            m_lines.pop_front();
+            return true;
+        }
+
+        Status status() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_status;
+        }
+
+    private:
+        struct Request {
+            uint32_t id;
+            std::string text;
+            Command command;
+        };
+
+        struct Running {
+            std::string text;
+            Command command;
+            Clock::time_point sent {}; ///< Or submitted, until it is sent
+            bool acknowledged { false };
+            Clock::time_point acknowledgedAt {};
+        };
+
+        static LinkArbiter::Config config(const ShellOptions& options)
+        {
+            LinkArbiter::Config config;
+            config.sockets = options.sockets;
+            config.maxQueued = 64;
+            config.replyTimeout = options.replyTimeout;
+            config.completionTimeout = options.completionTimeout;
+            return config;
+        }
+
+        void run()
+        {
+            std::vector<LinkArbiter::Output> outputs;
+            while (m_running) {
+                auto now = Clock::now();
+                std::deque<Request> submitted;
+                std::chrono::milliseconds interval;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    submitted.swap(m_submitted);
+                    interval = m_telemetryInterval;
+                }
+
+                // A full queue is answered with an error reply, handled like any other
+                for (auto& request : submitted) {
+                    const auto& packet = request.command.packet();
+                    m_commands[request.id] = { request.text, request.command, now };
+                    m_arbiter.submit(TypedClient, request.id, packet.data(), packet.size(), now, outputs);
+                }
+                handle(outputs, now);
+
+                // The next poll only once both answers of the last one are in, a slow link is not flooded
+                if (interval.count() > 0 && now >= m_nextTelemetry && !m_telemetryPending[ZoomTag]
+                    && !m_telemetryPending[FocusTag]) {
+                    for (uint32_t tag : { ZoomTag, FocusTag }) {
+                        const auto& packet = telemetryCommand(tag).packet();
+                        m_arbiter.submit(TelemetryClient, tag, packet.data(), packet.size(), now, outputs);
+                        m_telemetryPending[tag] = true;
+                    }
+                    m_nextTelemetry = now + interval;
+                }
+
+                dispatch();
+
+                // Short waits, so typed commands go out without delay
+                int waitMs = 10;
+                Clock::time_point deadline;
+                if (m_arbiter.nextDeadline(deadline)) {
+                    auto untilDeadline = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+                    waitMs = static_cast<int>(
+                        std::max<int64_t>(0, std::min<int64_t>(waitMs, untilDeadline.count() + 1)));
+                }
+                Response response;
+                if (m_camera.pollResponse(response, waitMs)) {
+                    now = Clock::now();
+                    m_arbiter.onReply(response.data().data(), response.data().size(), now, outputs);
+                    handle(outputs, now);
+                }
+                expire(Clock::now());
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_status.running = m_commands.size();
+            }
+        }
+
+        static const Command& telemetryCommand(uint32_t tag)
+        {
+            static const Command zoom = Command::zoomPositionInquiry();
+            static const Command focus = Command::focusPositionInquiry();
+            return tag == ZoomTag ? zoom : focus;
+        }
+
+        void dispatch()
+        {
+            LinkArbiter::Dispatch dispatch;
+            while (m_arbiter.next(dispatch, Clock::now())) {
+                auto sent = Clock::now();
+                bool ok = true;
+                if (dispatch.client == TelemetryClient) {
+                    m_telemetrySent[dispatch.tag] = sent;
+                    ok = m_camera.sendAsync(telemetryCommand(dispatch.tag));
+                    if (!ok)
+                        m_telemetryPending[dispatch.tag] = false;
+                } else {
+                    auto it = m_commands.find(dispatch.tag);
+                    if (it == m_commands.end())
+                        continue;
+                    it->second.sent = sent;
+                    ok = m_camera.sendAsync(it->second.command);
+                    if (!ok) {
+                        print(tagged(dispatch.tag, "not sent, link lost", it->second.text));
+                        m_commands.erase(it);
+                    }
+                }
+
+                // The arbiter lets go of a packet that failed to go out after the reply timeout
+                m_awaiting = { ok, dispatch.client, dispatch.tag };
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_status.linkLost = !ok;
+            }
+        }
+
+        void handle(std::vector<LinkArbiter::Output>& outputs, Clock::time_point now)
+        {
+            for (const auto& output : outputs) {
+                if (m_awaiting.valid && output.client == m_awaiting.client && output.tag == m_awaiting.tag)
+                    m_awaiting.valid = false;
+
+                Response response;
+                response.parse(output.data);
+                if (output.client == TelemetryClient) {
+                    updateTelemetry(output.tag, response, now);
+                    continue;
+                }
+
+                auto it = m_commands.find(output.tag);
+                if (it == m_commands.end())
+                    continue;
+                char prefix[48];
+                std::snprintf(prefix, sizeof(prefix), "#%-4u %9.3f ms  ", output.tag, msSince(it->second.sent, now));
+                print(prefix + formatBytes(output.data) + "  " + describeReply(response) + "  " + it->second.text);
+
+                if (response.isAcknowledge()) {
+                    it->second.acknowledged = true;
+                    it->second.acknowledgedAt = now;
+                } else {
+                    m_commands.erase(it);
+                }
+            }
+            outputs.clear();
+        }
+
+        void updateTelemetry(uint32_t tag, const Response& response, Clock::time_point now)
+        {
+            m_telemetryPending[tag] = false;
+            bool known = response.isCompletion() && response.data().size() >= 7;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_status.roundTripMs = msSince(m_telemetrySent[tag], now);
+            if (tag == ZoomTag) {
+                m_status.zoomKnown = known;
+                m_status.zoom = response.getZoomPosition();
+            } else {
+                m_status.focusKnown = known;
+                m_status.focus = response.getFocusPosition();
+            }
+        }
+
+        void expire(Clock::time_point now)
+        {
+            auto before = m_arbiter.stats();
+            m_arbiter.expire(now);
+            const auto& after = m_arbiter.stats();
+
+            if (after.replyTimeouts != before.replyTimeouts && m_awaiting.valid) {
+                m_awaiting.valid = false;
+                if (m_awaiting.client == TelemetryClient) {
+                    m_telemetryPending[m_awaiting.tag] = false;
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    (m_awaiting.tag == ZoomTag ? m_status.zoomKnown : m_status.focusKnown) = false;
+                } else {
+                    auto it = m_commands.find(m_awaiting.tag);
+                    if (it != m_commands.end()) {
+                        print(tagged(it->first, "no reply", it->second.text));
+                        m_commands.erase(it);
+                    }
+                }
+            }
+
+            if (after.completionTimeouts != before.completionTimeouts) {
+                for (auto it = m_commands.begin(); it != m_commands.end();) {
+                    if (it->second.acknowledged && now - it->second.acknowledgedAt >= m_options.completionTimeout) {
+                        print(tagged(it->first, "no completion", it->second.text));
+                        it = m_commands.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+        }
+
+        static std::string tagged(uint32_t id, const char* what, const std::string& text)
+        {
+            char prefix[48];
+            std::snprintf(prefix, sizeof(prefix), "#%-4u %12s  ", id, "");
+            return prefix + std::string(what) + "  " + text;
+        }
+
+        void print(std::string line)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_lines.push_back(std::move(line));
+        }
+
+        ViscaController& m_camera;
+        ShellOptions m_options;
+        std::thread m_thread;
+        std::atomic<bool> m_running { false };
+
+        mutable std::mutex m_mutex; ///< Guards the members below, shared with the keyboard thread
+        std::deque<Request> m_submitted;
+        std::deque<std::string> m_lines;
+        Status m_status;
+        std::chrono::milliseconds m_telemetryInterval { 0 };
+
+        // Only touched by the pump thread
+        LinkArbiter m_arbiter;
+        std::map<uint32_t, Running> m_commands; ///< Typed commands by id, until completed or given up
+        struct {
+            bool valid { false };
+            LinkArbiter::ClientId client { 0 };
+            uint32_t tag { 0 };
+        } m_awaiting; ///< The packet the arbiter waits on for a first reply
+        bool m_telemetryPending[2] { false, false };
+        Clock::time_point m_telemetrySent[2] {};
+        Clock::time_point m_nextTelemetry {};
+    };
+
+    std::string prompt(const Status& status)
+    {
+        std::vector<std::string> parts;
+        char text[32];
+        if (status.linkLost) {
+            parts.push_back("link lost");
+        } else if (status.telemetry) {
+            std::snprintf(text, sizeof(text), status.zoomKnown ? "zoom %04X" : "zoom ----", status.zoom);
+            parts.push_back(text);
+            std::snprintf(text, sizeof(text), status.focusKnown ? "focus %04X" : "focus ----", status.focus);
+            parts.push_back(text);
+            if (status.zoomKnown || status.focusKnown) {
+                std::snprintf(text, sizeof(text), "%.1f ms", status.roundTripMs);
+                parts.push_back(text);
+            }
+        }
+        if (status.running > 0)
+            parts.push_back(std::to_string(status.running) + " running");
+
+        std::string result;
+        for (const auto& part : parts)
+            result += (result.empty() ? "[" : "  ") + part;
+        return result.empty() ? "visca> " : result + "] visca> ";
+    }
+
+    std::string help()
+    {
+        std::ostringstream text;
+        char row[96];
+        for (const auto& named : namedCommands()) {
+            std::snprintf(row, sizeof(row), "  %-20s %-9s %s\n", named.name, named.argument ? named.argument : "",
+                named.description);
+            text << row;
+        }
+        text << "  81 09 04 47 FF           Any packet as hex bytes\n"
+             << "  telemetry <ms>           Zoom and focus in the prompt every <ms>, 0 turns it off\n"
+             << "  quit                     Leave, as do Ctrl+D and Ctrl+C on an empty line\n";
+        return text.str();
+    }
+
+    std::vector<std::string> completions(const std::string& prefix)
+    {
+        std::vector<std::string> matches;
+        for (const auto& builtin : Builtins) {
+            if (builtin.compare(0, prefix.size(), prefix) == 0)
+                matches.push_back(builtin);
+        }
+        for (const auto& named : namedCommands()) {
+            std::string name = named.name;
+            if (name.compare(0, prefix.size(), prefix) == 0)
+                matches.push_back(name);
+        }
+        return matches;
+    }
+}
+
+int runShell(ViscaController& camera, const ShellOptions& options, const std::atomic<bool>& stop)
+{
+    Terminal terminal;
+    if (!terminal.open()) {
+        std::cerr << "The shell needs a terminal, use batch to run a script" << std::endl;
+        return 1;
+    }
+
+    Pump pump(camera, options);
+    pump.start();
+    terminal.write("Type help for the commands, Tab completes them, Ctrl+D leaves\n");
+
+    std::string line; // Being typed
+    std::string shown; // Prompt line on the screen, empty if it has to be drawn again
+    std::vector<std::string> history;
+    size_t historyIndex = 0;
+    uint32_t nextId = 1;
+    bool quit = false;
+    bool tabbed = false;
+
+    // Returns what to print for a line the user entered
+    auto enter = [&](const std::string& entered) -> std::string {
+        std::istringstream stream(entered);
+        std::string word, argument;
+        stream >> word >> argument;
+        if (word == "quit" || word == "exit") {
+            quit = true;
+            return "";
+        }
+        if (word == "help")
+            return help();
+        if (word == "telemetry") {
+            try {
+                pump.setTelemetryInterval(std::chrono::milliseconds(std::stoi(argument)));
+                return "";
+            } catch (const std::exception&) {
+                return "telemetry takes an interval in ms\n";
+            }
+        }
+
+        Command command;
+        bool blank = false;
+        std::string error;
+        if (!parseCommand(entered, command, blank, error))
+            return error + "\n";
+        if (blank)
+            return "";
+        pump.submit(nextId++, entered, command);
+        return "";
+    };
+
+    while (!quit && !stop) {
+        Terminal::KeyPress key;
+        bool pressed = terminal.readKey(key, 50);
+
+        // Replies go above the prompt line, which is drawn again below them
+        std::string output;
+        std::string text;
+        while (pump.takeLine(text))
+            output += "\r\033[K" + text + "\n";
+
+        if (pressed && key.key != Terminal::Key::Tab)
+            tabbed = false;
+        switch (key.key) {
+        case Terminal::Key::Char:
+            line += key.ch;
+            break;
+        case Terminal::Key::Backspace:
+            if (!line.empty())
+                line.pop_back();
+            break;
+        case Terminal::Key::Enter: {
+            output += "\r\033[K> " + line + "\n";
+            if (!line.empty() && (history.empty() || history.back() != line))
+                history.push_back(line);
+            historyIndex = history.size();
+            std::string entered = line.substr(0, line.find_last_not_of(' ') + 1);
+            line.clear();
+            output += enter(entered);
+            break;
+        }
+        case Terminal::Key::Tab: {
+            // Names only, arguments are numbers
+            if (line.find(' ') != std::string::npos)
+                break;
+            auto matches = completions(line);
+            if (matches.size() == 1) {
+                line = matches.front() + " ";
+            } else if (matches.size() > 1) {
+                std::string common = matches.front();
+                for (const auto& match : matches) {
+                    size_t n = 0;
+                    while (n < common.size() && n < match.size() && common[n] == match[n])
+                        ++n;
+                    common.resize(n);
+                }
+                if (common.size() > line.size()) {
+                    line = common;
+                } else if (tabbed) {
+                    output += "\r\033[K";
+                    for (const auto& match : matches)
+                        output += match + "  ";
+                    output += "\n";
+                }
+            }
+            tabbed = true;
+            break;
+        }
+        case Terminal::Key::Up:
+            if (historyIndex > 0)
+                line = history[--historyIndex];
+            break;
+        case Terminal::Key::Down:
+            if (historyIndex < history.size()) {
+                ++historyIndex;
+                line = historyIndex < history.size() ? history[historyIndex] : "";
+            }
+            break;
+        case Terminal::Key::Interrupt:
+        case Terminal::Key::EndOfInput:
+            if (line.empty())
+                quit = true;
+            line.clear();
+            break;
+        default:
+            break;
+        }
+
+        if (!output.empty()) {
+            terminal.write(output);
+            shown.clear();
+        }
+        std::string current = prompt(pump.status()) + line;
+        if (current != shown) {
+            terminal.write("\r\033[K" + current);
+            shown = current;
+        }
+    }
+
+    terminal.write("\r\033[K");
+    return 0;
+}
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ViscaController.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Visca {
+
+struct ShellOptions {
+    uint8_t sockets { 2 }; ///< Command buffers of the camera, commands running at once
+    std::chrono::milliseconds replyTimeout { 1000 }; ///< For the ACK or inquiry reply
+    std::chrono::seconds completionTimeout { 10 };
+    std::chrono::milliseconds telemetryInterval { 250 }; ///< Zoom and focus inquiries for the status line, 0 for none
+};
+
+/**
+ * @brief Interactive prompt over an open connection.
+ *
+ * Commands are typed in the syntax of parseCommand(), with tab completion of the names and a history on the up and
+ * down keys. The keyboard and the link are served by different threads: a command is handed to a pump thread that
+ * sends it with sendAsync() through a LinkArbiter and collects the replies with pollResponse(), so a slow camera never
+ * holds up typing and several commands can run at once. Every reply is printed with the time since its command was
+ * sent. Between commands the pump asks for the zoom and focus positions, shown in the prompt as they change.
+ * @param stop Set (e.g. from a SIGINT handler) to leave the prompt; Ctrl+C on an empty line and Ctrl+D do the same.
+ * @return 0, or 1 if standard input is not a terminal.
+ */
+int runShell(ViscaController& camera, const ShellOptions& options, const std::atomic<bool>& stop);
+
+}
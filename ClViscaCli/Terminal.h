@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace Visca {
+
+/**
+ * @brief The console in raw mode: keys one at a time, without echo, with a timeout.
+ */
+class Terminal {
+public:
+    enum class Key {
+        None, ///< Timed out
+        Char, ///< A printable character, in KeyPress::ch
+        Enter,
+        Backspace,
+        Tab,
+        Up,
+        Down,
+        Interrupt, ///< Ctrl+C, not a signal while the terminal is open
+        EndOfInput, ///< Ctrl+D (Ctrl+Z on Windows)
+        Other
+    };
+
+    struct KeyPress {
+        Key key { Key::None };
+        char ch { 0 };
+    };
+
+    Terminal();
+    ~Terminal();
+
+    /**
+     * @brief Switch the console to raw mode (and, on Windows, enable ANSI escapes).
+     * @return false if standard input is not a terminal.
+     */
+    bool open();
+
+    /**
+     * @brief Restore the console as it was; also done by the destructor.
+     */
+    void close();
+
+    /**
+     * @brief Wait up to timeoutMs for a key.
+     * @return false, with key set to Key::None, on timeout.
+     */
+    bool readKey(KeyPress& key, int timeoutMs);
+
+    void write(const std::string& text);
+
+private:
+    bool m_open { false };
+
+    // Forward declaration of the platform-specific implementation
+    struct Impl;
+    std::unique_ptr<Impl> m_pImpl;
+};
+
+}
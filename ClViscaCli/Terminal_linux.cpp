@@ -0,0 +1,117 @@
+#include "Terminal.h"
+
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace Visca {
+struct Terminal::Impl {
+    termios saved {};
+};
+
+namespace {
+    bool readByte(char& c, int timeoutMs)
+    {
+        pollfd pfd { STDIN_FILENO, POLLIN, 0 };
+        if (::poll(&pfd, 1, timeoutMs) <= 0)
+            return false;
+        return ::read(STDIN_FILENO, &c, 1) == 1;
+    }
+}
+
+Terminal::Terminal()
+    : m_pImpl(std::make_unique<Impl>())
+{
+}
+
+Terminal::~Terminal() { close(); }
+
+bool Terminal::open()
+{
+    if (m_open)
+        return true;
+    if (!::isatty(STDIN_FILENO) || ::tcgetattr(STDIN_FILENO, &m_pImpl->saved) != 0)
+        return false;
+
+    // No line buffering, echo or signal keys; output processing stays on so "\n" still returns the carriage
+    termios raw = m_pImpl->saved;
+    raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+    raw.c_iflag &= ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if (::tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0)
+        return false;
+
+    m_open = true;
+    return true;
+}
+
+void Terminal::close()
+{
+    if (!m_open)
+        return;
+    ::tcsetattr(STDIN_FILENO, TCSAFLUSH, &m_pImpl->saved);
+    m_open = false;
+}
+
+bool Terminal::readKey(KeyPress& key, int timeoutMs)
+{
+    key = KeyPress();
+    char c = 0;
+    if (!readByte(c, timeoutMs))
+        return false;
+
+    switch (c) {
+    case '\r':
+    case '\n':
+        key.key = Key::Enter;
+        break;
+    case 127:
+    case 8:
+        key.key = Key::Backspace;
+        break;
+    case '\t':
+        key.key = Key::Tab;
+        break;
+    case 3:
+        key.key = Key::Interrupt;
+        break;
+    case 4:
+        key.key = Key::EndOfInput;
+        break;
+    case 27: {
+        // Arrow keys arrive as ESC [ A..D in one write; a lone ESC is ignored
+        char bracket = 0, code = 0;
+        key.key = Key::Other;
+        if (readByte(bracket, 10) && (bracket == '[' || bracket == 'O') && readByte(code, 10)) {
+            if (code == 'A')
+                key.key = Key::Up;
+            else if (code == 'B')
+                key.key = Key::Down;
+        }
+        break;
+    }
+    default:
+        if (static_cast<unsigned char>(c) >= 32) {
+            key.key = Key::Char;
+            key.ch = c;
+        } else {
+            key.key = Key::Other;
+        }
+        break;
+    }
+    return true;
+}
+
+void Terminal::write(const std::string& text)
+{
+    size_t written = 0;
+    while (written < text.size()) {
+        ssize_t n = ::write(STDOUT_FILENO, text.data() + written, text.size() - written);
+        if (n <= 0)
+            break;
+        written += static_cast<size_t>(n);
+    }
+}
+
+}
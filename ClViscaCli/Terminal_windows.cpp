@@ -0,0 +1,109 @@
+#include "Terminal.h"
+
+#include <chrono>
+#include <conio.h>
+#include <cstdio>
+#include <io.h>
+#include <thread>
+#include <windows.h>
+
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+
+namespace Visca {
+struct Terminal::Impl {
+    DWORD savedInputMode { 0 };
+    DWORD savedOutputMode { 0 };
+};
+
+Terminal::Terminal()
+    : m_pImpl(std::make_unique<Impl>())
+{
+}
+
+Terminal::~Terminal() { close(); }
+
+bool Terminal::open()
+{
+    if (m_open)
+        return true;
+    if (!_isatty(_fileno(stdin)))
+        return false;
+
+    HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+    HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (!GetConsoleMode(input, &m_pImpl->savedInputMode) || !GetConsoleMode(output, &m_pImpl->savedOutputMode))
+        return false;
+
+    // Ctrl+C as a key, and ANSI escapes for redrawing the prompt line
+    SetConsoleMode(input, m_pImpl->savedInputMode & ~ENABLE_PROCESSED_INPUT);
+    SetConsoleMode(output, m_pImpl->savedOutputMode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+
+    m_open = true;
+    return true;
+}
+
+void Terminal::close()
+{
+    if (!m_open)
+        return;
+    SetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), m_pImpl->savedInputMode);
+    SetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), m_pImpl->savedOutputMode);
+    m_open = false;
+}
+
+bool Terminal::readKey(KeyPress& key, int timeoutMs)
+{
+    key = KeyPress();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!_kbhit()) {
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    int c = _getch();
+    switch (c) {
+    case 0:
+    case 0xE0: {
+        // Extended key, the scan code follows
+        int code = _getch();
+        key.key = code == 72 ? Key::Up : code == 80 ? Key::Down : Key::Other;
+        break;
+    }
+    case '\r':
+        key.key = Key::Enter;
+        break;
+    case 8:
+        key.key = Key::Backspace;
+        break;
+    case '\t':
+        key.key = Key::Tab;
+        break;
+    case 3:
+        key.key = Key::Interrupt;
+        break;
+    case 4:
+    case 26:
+        key.key = Key::EndOfInput;
+        break;
+    default:
+        if (c >= 32 && c < 127) {
+            key.key = Key::Char;
+            key.ch = static_cast<char>(c);
+        } else {
+            key.key = Key::Other;
+        }
+        break;
+    }
+    return true;
+}
+
+void Terminal::write(const std::string& text)
+{
+    std::fwrite(text.data(), 1, text.size(), stdout);
+    std::fflush(stdout);
+}
+
+}
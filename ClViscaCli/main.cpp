@@ -1,54 +1,178 @@
+#include "BatchRunner.h"
+#include "BaudDetector.h"
 #include "Commands.h"
+#include "Discovery.h"
+#include "LinkQualification.h"
 #include "Logger.h"
 #include "SerialCommunicator.h"
+#include "Shell.h"
 #include "TcpCommunicator.h"
 #include "UdpCommunicator.h"
 #include "ViscaController.h"
+#include <atomic>
+#include <csignal>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <thread>
 
 using namespace Visca;
 
+static std::atomic<bool> s_stop { false };
+
+static void onInterrupt(int) { s_stop = true; }
+
+static int runDiscovery(int argc, char* argv[])
+{
+    // discover [subnet] [port] [timeoutMs]
+    Discovery::Options options;
+    if (argc > 2)
+        options.probeSubnet = argv[2];
+    if (argc > 3)
+        options.probePort = static_cast<uint16_t>(std::stoi(argv[3]));
+    if (argc > 4)
+        options.timeoutMs = std::stoi(argv[4]);
+
+    std::cout << "Discovering cameras";
+    if (!options.probeSubnet.empty())
+        std::cout << " (probing " << options.probeSubnet << " on port " << options.probePort << ")";
+    std::cout << "..." << std::endl;
+
+    Discovery discovery(options);
+    auto cameras = discovery.run();
+
+    for (const auto& camera : cameras) {
+        std::cout << camera.address;
+        if (camera.answeredNetworkInquiry)
+            std::cout << " MAC: " << camera.macAddress << " Model: " << camera.model << " Name: " << camera.name;
+        if (camera.answeredVersionInquiry)
+            std::cout << " Vendor: 0x" << std::hex << camera.vendorId << " Model: 0x" << camera.modelId
+                      << " ROM: 0x" << camera.romRevision << std::dec;
+        std::cout << std::endl;
+    }
+    std::cout << cameras.size() << " camera(s) found" << std::endl;
+
+    return cameras.empty() ? 1 : 0;
+}
+
+static int runLatencyProbe(ViscaController& camera, int argc, char* argv[])
+{
+    // <connection> latency [inquiry] [count] [intervalMs] [reportSeconds]
+    LatencyOptions options;
+    if (argc > 5)
+        options.inquiry = argv[5];
+    if (argc > 6)
+        options.count = std::stoull(argv[6]);
+    if (argc > 7)
+        options.interval = std::chrono::milliseconds(std::stoi(argv[7]));
+    if (argc > 8)
+        options.reportInterval = std::chrono::seconds(std::stoi(argv[8]));
+
+    return runLatency(camera, options, s_stop);
+}
+
+static int runSoakTest(ViscaController& camera, int argc, char* argv[])
+{
+    // <connection> soak [duration] [mix] [reportSeconds] [intervalMs]
+    SoakOptions options;
+    if (argc > 5 && !parseDuration(argv[5], options.duration)) {
+        std::cerr << "Bad duration: " << argv[5] << " (e.g. 90s, 30m, 8h)" << std::endl;
+        return 1;
+    }
+    if (argc > 6)
+        options.mix = argv[6];
+    if (argc > 7)
+        options.reportInterval = std::chrono::seconds(std::stoi(argv[7]));
+    if (argc > 8)
+        options.interval = std::chrono::milliseconds(std::stoi(argv[8]));
+
+    return runSoak(camera, options, s_stop);
+}
+
 int main(int argc, char* argv[])
 {
     // Parse command line arguments
     std::string connectionType = "serial";
     std::string device = "/dev/ttyUSB0";
     int baudRate = 9600;
+    bool autoBaud = false;
     std::string ip = "192.168.1.100";
     int port = 5678;
 
     if (argc > 1)
         connectionType = argv[1];
 
+    if (connectionType == "discover")
+        return runDiscovery(argc, argv);
+
     if (connectionType == "serial" && argc > 2)
         device = argv[2];
-    if (connectionType == "serial" && argc > 3)
-        baudRate = std::stoi(argv[3]);
+    if (connectionType == "serial" && argc > 3) {
+        autoBaud = std::string(argv[3]) == "auto";
+        if (!autoBaud)
+            baudRate = std::stoi(argv[3]);
+    }
 
     if ((connectionType == "tcp" || connectionType == "udp") && argc > 2)
         ip = argv[2];
     if ((connectionType == "tcp" || connectionType == "udp") && argc > 3)
         port = std::stoi(argv[3]);
 
+    // A batch script is checked before connecting; its replies are the output, everything else goes to stderr
+    std::string action = argc > 4 ? argv[4] : "";
+    std::vector<BatchLine> batch;
+    if (action == "batch") {
+        std::string path = argc > 5 ? argv[5] : "-";
+        std::ifstream file;
+        if (path != "-") {
+            file.open(path);
+            if (!file) {
+                std::cerr << "Cannot open " << path << std::endl;
+                return 1;
+            }
+        }
+        std::vector<std::string> errors;
+        if (!readBatch(path == "-" ? std::cin : file, batch, errors)) {
+            for (const auto& error : errors)
+                std::cerr << path << ": " << error << std::endl;
+            return 1;
+        }
+        Logger::instance().setOutput(&std::cerr);
+    }
+    std::ostream& out = action == "batch" ? std::cerr : std::cout;
+
     // Set log level
     Logger::instance().setLevel(LogLevel::Info);
 
-    std::cout << "VISCA Camera Control CLI" << std::endl;
-    std::cout << "Connection type: " << connectionType << std::endl;
+    out << "VISCA Camera Control CLI" << std::endl;
+    out << "Connection type: " << connectionType << std::endl;
 
     // Create appropriate communicator
     std::unique_ptr<ICommunicator> communicator;
 
-    if (connectionType == "serial") {
-        std::cout << "Device: " << device << " at " << baudRate << " baud" << std::endl;
+    if (connectionType == "serial" && autoBaud) {
+        auto serial = std::make_unique<SerialCommunicator>(device, baudRate);
+        if (!serial->open()) {
+            std::cerr << "Failed to open " << device << std::endl;
+            return 1;
+        }
+        auto result = BaudDetector().run(*serial);
+        if (!result.found) {
+            std::cerr << "No camera answered on " << device << " (" << result.probes << " probes, "
+                      << result.elapsed.count() << " ms)" << std::endl;
+            return 1;
+        }
+        out << "Device: " << device << " at " << result.baudRate << " baud (detected in "
+            << result.elapsed.count() << " ms)" << std::endl;
+        communicator = std::move(serial);
+    } else if (connectionType == "serial") {
+        out << "Device: " << device << " at " << baudRate << " baud" << std::endl;
         communicator = std::make_unique<SerialCommunicator>(device, baudRate);
     } else if (connectionType == "tcp") {
-        std::cout << "TCP: " << ip << ":" << port << " (Client mode)" << std::endl;
+        out << "TCP: " << ip << ":" << port << " (Client mode)" << std::endl;
         communicator = std::make_unique<TcpCommunicator>(ip, port, NetworkMode::Client);
     } else if (connectionType == "udp") {
-        std::cout << "UDP: " << ip << ":" << port << " (Client mode)" << std::endl;
+        out << "UDP: " << ip << ":" << port << " (Client mode)" << std::endl;
         communicator = std::make_unique<UdpCommunicator>(ip, port, NetworkMode::Client);
     } else {
         std::cerr << "Unknown connection type: " << connectionType << std::endl;
@@ -63,7 +187,32 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    std::cout << "Connected to camera" << std::endl;
+    out << "Connected to camera" << std::endl;
+
+    // Link qualification or a script instead of the demo, until done or Ctrl+C
+    if (!action.empty()) {
+        std::signal(SIGINT, onInterrupt);
+        if (action == "latency")
+            return runLatencyProbe(camera, argc, argv);
+        if (action == "soak")
+            return runSoakTest(camera, argc, argv);
+        if (action == "batch") {
+            BatchOptions options;
+            options.replyTimeout = std::chrono::milliseconds(camera.responseTimeout());
+            return runBatch(camera, batch, options, s_stop);
+        }
+        if (action == "shell") {
+            // Only problems may interrupt the prompt line
+            Logger::instance().setLevel(LogLevel::Warning);
+            ShellOptions options;
+            options.replyTimeout = std::chrono::milliseconds(camera.responseTimeout());
+            if (argc > 5)
+                options.telemetryInterval = std::chrono::milliseconds(std::stoi(argv[5]));
+            return runShell(camera, options, s_stop);
+        }
+        std::cerr << "Unknown action: " << action << " (latency, soak, batch or shell)" << std::endl;
+        return 1;
+    }
 
     // Power on
     std::cout << "Powering on..." << std::endl;
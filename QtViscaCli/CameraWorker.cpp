@@ -0,0 +1,293 @@
+#include "CameraWorker.h"
+#include "SerialCommunicator.h"
+#include "TcpCommunicator.h"
+#include "UdpCommunicator.h"
+
+#include <QTimer>
+
+namespace Visca {
+
+namespace {
+    constexpr LinkArbiter::ClientId PanelClient = 1;
+    constexpr LinkArbiter::ClientId TelemetryClient = 2;
+    constexpr uint32_t ZoomTag = 0;
+    constexpr uint32_t FocusTag = 1;
+    constexpr std::chrono::seconds CompletionTimeout { 10 };
+
+    double msSince(LinkArbiter::Clock::time_point since, LinkArbiter::Clock::time_point now)
+    {
+        return std::chrono::duration<double, std::milli>(now - since).count();
+    }
+
+    QString describe(const Response& response)
+    {
+        if (response.isAcknowledge())
+            return QStringLiteral("ack");
+        if (response.isCompletion())
+            return response.data().size() > 3 ? QStringLiteral("reply") : QStringLiteral("completion");
+        if (response.isError())
+            return QStringLiteral("error: ") + QString::fromStdString(response.errorString());
+        return QStringLiteral("unknown");
+    }
+
+    const Command& telemetryCommand(uint32_t tag)
+    {
+        static const Command zoom = Command::zoomPositionInquiry();
+        static const Command focus = Command::focusPositionInquiry();
+        return tag == ZoomTag ? zoom : focus;
+    }
+}
+
+CameraWorker::CameraWorker(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    // Parented, so it moves to the worker thread with this object
+    m_timer->setInterval(10);
+    connect(m_timer, &QTimer::timeout, this, &CameraWorker::pump);
+}
+
+CameraWorker::~CameraWorker() { close(); }
+
+void CameraWorker::open(const QString& type, const QString& address, int port)
+{
+    close();
+
+    std::unique_ptr<ICommunicator> communicator;
+    std::string host = address.toStdString();
+    if (type == QLatin1String("serial"))
+        communicator = std::make_unique<SerialCommunicator>(host, port);
+    else if (type == QLatin1String("tcp"))
+        communicator = std::make_unique<TcpCommunicator>(host, static_cast<uint16_t>(port), NetworkMode::Client);
+    else if (type == QLatin1String("udp"))
+        communicator = std::make_unique<UdpCommunicator>(host, static_cast<uint16_t>(port), NetworkMode::Client);
+    else {
+        emit opened(false, QStringLiteral("Unknown connection type: ") + type);
+        return;
+    }
+
+    auto camera = std::make_unique<ViscaController>(std::move(communicator));
+    if (!camera->connect()) {
+        emit opened(false, QStringLiteral("Failed to connect to ") + address);
+        return;
+    }
+
+    LinkArbiter::Config config;
+    config.replyTimeout = std::chrono::milliseconds(camera->responseTimeout());
+    config.maxQueued = 64;
+    config.completionTimeout = CompletionTimeout;
+    m_arbiter = std::make_unique<LinkArbiter>(config);
+    m_camera = std::move(camera);
+    m_timer->start();
+    emit opened(true, QStringLiteral("Connected to ") + address);
+}
+
+void CameraWorker::close()
+{
+    if (!m_camera)
+        return;
+
+    m_timer->stop();
+    m_camera->disconnect();
+    m_camera.reset();
+    m_arbiter.reset();
+    m_outputs.clear();
+    m_commands.clear();
+    m_zoom = Target();
+    m_focus = Target();
+    m_awaiting.valid = false;
+    m_telemetryPending[ZoomTag] = m_telemetryPending[FocusTag] = false;
+    m_zoomKnown = m_focusKnown = false;
+    emit closed();
+}
+
+void CameraWorker::setZoomTarget(int position)
+{
+    m_zoom.wanted = true;
+    m_zoom.position = static_cast<uint16_t>(position);
+}
+
+void CameraWorker::setFocusTarget(int position)
+{
+    m_focus.wanted = true;
+    m_focus.position = static_cast<uint16_t>(position);
+}
+
+void CameraWorker::send(const QString& name, const Command& command)
+{
+    if (m_arbiter)
+        submit(name, command, Clock::now());
+}
+
+void CameraWorker::setTelemetryInterval(int ms) { m_telemetryMs = ms; }
+
+void CameraWorker::submit(const QString& name, const Command& command, Clock::time_point now)
+{
+    uint32_t id = m_nextId++;
+    m_commands[id] = { name, command, now };
+    const auto& packet = command.packet();
+    // A full queue is answered with an error reply, reported like any other
+    m_arbiter->submit(PanelClient, id, packet.data(), packet.size(), now, m_outputs);
+}
+
+void CameraWorker::pump()
+{
+    if (!m_camera)
+        return;
+
+    auto now = Clock::now();
+    for (auto* target : { &m_zoom, &m_focus }) {
+        if (!target->wanted || target->inFlight)
+            continue;
+        bool zoom = target == &m_zoom;
+        target->id = m_nextId;
+        target->inFlight = true;
+        target->wanted = false;
+        submit(zoom ? QStringLiteral("zoom-direct") : QStringLiteral("focus-direct"),
+            zoom ? Command::zoomDirect(1, target->position) : Command::focusDirect(1, target->position), now);
+    }
+
+    // The next poll only once both answers of the last one are in
+    if (m_telemetryMs > 0 && now >= m_nextTelemetry && !m_telemetryPending[ZoomTag]
+        && !m_telemetryPending[FocusTag]) {
+        for (uint32_t tag : { ZoomTag, FocusTag }) {
+            const auto& packet = telemetryCommand(tag).packet();
+            m_arbiter->submit(TelemetryClient, tag, packet.data(), packet.size(), now, m_outputs);
+            m_telemetryPending[tag] = true;
+        }
+        m_nextTelemetry = now + std::chrono::milliseconds(m_telemetryMs);
+    }
+    handle(now);
+
+    dispatch();
+
+    Response response;
+    while (m_camera->pollResponse(response, 0)) {
+        now = Clock::now();
+        m_arbiter->onReply(response.data().data(), response.data().size(), now, m_outputs);
+        handle(now);
+    }
+    expire(Clock::now());
+}
+
+void CameraWorker::dispatch()
+{
+    LinkArbiter::Dispatch dispatch;
+    while (m_arbiter->next(dispatch, Clock::now())) {
+        auto sent = Clock::now();
+        bool ok = true;
+        if (dispatch.client == TelemetryClient) {
+            m_telemetrySent[dispatch.tag] = sent;
+            ok = m_camera->sendAsync(telemetryCommand(dispatch.tag));
+            if (!ok)
+                m_telemetryPending[dispatch.tag] = false;
+        } else {
+            auto it = m_commands.find(dispatch.tag);
+            if (it == m_commands.end())
+                continue;
+            it->second.sent = sent;
+            ok = m_camera->sendAsync(it->second.command);
+            if (!ok) {
+                emit replied(it->second.name, QStringLiteral("not sent, link lost"), 0.0);
+                finished(dispatch.tag);
+            }
+        }
+
+        // The arbiter lets go of a packet that failed to go out after the reply timeout
+        m_awaiting = { ok, dispatch.client, dispatch.tag };
+        if (!ok)
+            emit linkLost();
+    }
+}
+
+void CameraWorker::handle(Clock::time_point now)
+{
+    bool telemetry = false;
+    for (const auto& output : m_outputs) {
+        if (m_awaiting.valid && output.client == m_awaiting.client && output.tag == m_awaiting.tag)
+            m_awaiting.valid = false;
+
+        Response response;
+        response.parse(output.data);
+        if (output.client == TelemetryClient) {
+            m_telemetryPending[output.tag] = false;
+            bool known = response.isCompletion() && response.data().size() >= 7;
+            if (output.tag == ZoomTag) {
+                m_zoomKnown = known;
+                m_zoomPosition = response.getZoomPosition();
+            } else {
+                m_focusKnown = known;
+                m_focusPosition = response.getFocusPosition();
+            }
+            telemetry = !m_telemetryPending[ZoomTag] && !m_telemetryPending[FocusTag];
+            continue;
+        }
+
+        auto it = m_commands.find(output.tag);
+        if (it == m_commands.end())
+            continue;
+        emit replied(it->second.name, describe(response), msSince(it->second.sent, now));
+        if (response.isAcknowledge()) {
+            it->second.acknowledged = true;
+            it->second.acknowledgedAt = now;
+            // Accepted: a newer target may now replace this one on the camera
+            for (auto* target : { &m_zoom, &m_focus }) {
+                if (target->inFlight && target->id == output.tag)
+                    target->inFlight = false;
+            }
+        } else {
+            finished(output.tag);
+        }
+    }
+    m_outputs.clear();
+
+    if (telemetry) {
+        emit positions(m_zoomPosition, m_focusPosition, m_zoomKnown, m_focusKnown,
+            msSince(m_telemetrySent[FocusTag], now));
+    }
+}
+
+void CameraWorker::expire(Clock::time_point now)
+{
+    auto before = m_arbiter->stats();
+    m_arbiter->expire(now);
+    const auto& after = m_arbiter->stats();
+
+    if (after.replyTimeouts != before.replyTimeouts && m_awaiting.valid) {
+        m_awaiting.valid = false;
+        if (m_awaiting.client == TelemetryClient) {
+            m_telemetryPending[m_awaiting.tag] = false;
+            (m_awaiting.tag == ZoomTag ? m_zoomKnown : m_focusKnown) = false;
+            emit positions(m_zoomPosition, m_focusPosition, m_zoomKnown, m_focusKnown, 0.0);
+        } else {
+            auto it = m_commands.find(m_awaiting.tag);
+            if (it != m_commands.end()) {
+                emit replied(it->second.name, QStringLiteral("no reply"), msSince(it->second.sent, now));
+                finished(m_awaiting.tag);
+            }
+        }
+    }
+
+    if (after.completionTimeouts != before.completionTimeouts) {
+        std::vector<uint32_t> lost;
+        for (const auto& [id, command] : m_commands) {
+            if (command.acknowledged && now - command.acknowledgedAt >= CompletionTimeout) {
+                emit replied(command.name, QStringLiteral("no completion"), msSince(command.sent, now));
+                lost.push_back(id);
+            }
+        }
+        for (uint32_t id : lost)
+            finished(id);
+    }
+}
+
+void CameraWorker::finished(uint32_t id)
+{
+    m_commands.erase(id);
+    for (auto* target : { &m_zoom, &m_focus }) {
+        if (target->inFlight && target->id == id)
+            target->inFlight = false;
+    }
+}
+
+}
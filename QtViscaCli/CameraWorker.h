@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Commands.h"
+#include "LinkArbiter.h"
+#include "ViscaController.h"
+
+#include <QObject>
+#include <QString>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+class QTimer;
+
+namespace Visca {
+
+/**
+ * @brief The camera connection, run on its own thread so the UI never waits for the link.
+ *
+ * Lives in a QThread and is driven only through queued signals: slots send nothing themselves, they record what is
+ * wanted and a 10 ms timer on the worker thread pumps the link. Packets go out with sendAsync() through a
+ * LinkArbiter and replies are collected with pollResponse() without blocking. Zoom and focus targets are coalesced:
+ * while one direct command waits for its ACK, newer targets from a dragged slider only replace each other, and the
+ * latest goes out once the link is free. Zoom and focus positions are polled for positions().
+ */
+class CameraWorker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit CameraWorker(QObject* parent = nullptr);
+    ~CameraWorker() override;
+
+public slots:
+    /**
+     * @brief Connect to a camera; type is "serial" (address is the device, port the baud rate), "tcp" or "udp".
+     */
+    void open(const QString& type, const QString& address, int port);
+    void close();
+
+    void setZoomTarget(int position);
+    void setFocusTarget(int position);
+
+    /**
+     * @brief Queue a one-shot command, e.g. Command::zoomStop(); name is only used to report its replies.
+     */
+    void send(const QString& name, const Visca::Command& command);
+
+    void setTelemetryInterval(int ms); ///< 0 stops polling the positions
+
+signals:
+    void opened(bool ok, const QString& message);
+    void closed();
+    void positions(int zoom, int focus, bool zoomKnown, bool focusKnown, double roundTripMs);
+    void replied(const QString& name, const QString& reply, double ms);
+    void linkLost();
+
+private slots:
+    void pump();
+
+private:
+    using Clock = LinkArbiter::Clock;
+
+    struct Running {
+        QString name;
+        Command command;
+        Clock::time_point sent {}; ///< Or queued, until it is sent
+        bool acknowledged { false };
+        Clock::time_point acknowledgedAt {};
+    };
+
+    /**
+     * @brief Latest position asked for by a slider, sent once the previous one is acknowledged.
+     */
+    struct Target {
+        bool wanted { false };
+        uint16_t position { 0 };
+        bool inFlight { false }; ///< A direct command waits for its ACK
+        uint32_t id { 0 };
+    };
+
+    void submit(const QString& name, const Command& command, Clock::time_point now);
+    void dispatch();
+    void handle(Clock::time_point now);
+    void expire(Clock::time_point now);
+    void finished(uint32_t id); ///< Forget a command, freeing its target for the next position
+
+    std::unique_ptr<ViscaController> m_camera;
+    std::unique_ptr<LinkArbiter> m_arbiter;
+    std::vector<LinkArbiter::Output> m_outputs;
+    QTimer* m_timer;
+
+    std::map<uint32_t, Running> m_commands; ///< By tag, until completed or given up
+    uint32_t m_nextId { 1 };
+    Target m_zoom;
+    Target m_focus;
+    struct {
+        bool valid { false };
+        LinkArbiter::ClientId client { 0 };
+        uint32_t tag { 0 };
+    } m_awaiting; ///< The packet the arbiter waits on for a first reply
+
+    int m_telemetryMs { 100 };
+    bool m_telemetryPending[2] { false, false };
+    Clock::time_point m_telemetrySent[2] {};
+    Clock::time_point m_nextTelemetry {};
+    int m_zoomPosition { 0 };
+    int m_focusPosition { 0 };
+    bool m_zoomKnown { false };
+    bool m_focusKnown { false };
+};
+
+}
+
+Q_DECLARE_METATYPE(Visca::Command)
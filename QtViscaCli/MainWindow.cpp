@@ -0,0 +1,208 @@
+#include "MainWindow.h"
+#include "CameraWorker.h"
+#include "PositionGraph.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSlider>
+#include <QSpinBox>
+#include <QStatusBar>
+#include <QVBoxLayout>
+
+namespace Visca {
+
+namespace {
+    // Optical zoom and the focus range of the FCB block cameras
+    constexpr int ZoomMin = 0x0000;
+    constexpr int ZoomMax = 0x4000;
+    constexpr int FocusMin = 0x1000;
+    constexpr int FocusMax = 0xC000;
+
+    QString hex(int position) { return QStringLiteral("%1").arg(position, 4, 16, QLatin1Char('0')).toUpper(); }
+}
+
+MainWindow::MainWindow(QWidget* parent)
+    : QMainWindow(parent)
+    , m_worker(new CameraWorker)
+{
+    setWindowTitle(tr("VISCA Camera Control"));
+
+    // Connection
+    m_type = new QComboBox;
+    m_type->addItems({ QStringLiteral("serial"), QStringLiteral("tcp"), QStringLiteral("udp") });
+    m_address = new QLineEdit(QStringLiteral("/dev/ttyUSB0"));
+    m_port = new QSpinBox;
+    m_port->setRange(1, 921600);
+    m_port->setValue(9600);
+    m_connect = new QPushButton(tr("Connect"));
+
+    auto* connection = new QHBoxLayout;
+    connection->addWidget(m_type);
+    connection->addWidget(m_address, 1);
+    connection->addWidget(m_port);
+    connection->addWidget(m_connect);
+
+    // Power
+    auto* powerOn = new QPushButton(tr("Power on"));
+    auto* powerOff = new QPushButton(tr("Power off"));
+    auto* power = new QHBoxLayout;
+    power->addWidget(powerOn);
+    power->addWidget(powerOff);
+    power->addStretch();
+
+    // Zoom
+    m_zoom = new QSlider(Qt::Horizontal);
+    m_zoom->setRange(ZoomMin, ZoomMax);
+    m_zoomPosition = new QLabel(QStringLiteral("----"));
+    auto* zoomStop = new QPushButton(tr("Stop"));
+    auto* zoom = new QHBoxLayout;
+    zoom->addWidget(m_zoom, 1);
+    zoom->addWidget(m_zoomPosition);
+    zoom->addWidget(zoomStop);
+
+    // Focus
+    m_focus = new QSlider(Qt::Horizontal);
+    m_focus->setRange(FocusMin, FocusMax);
+    m_focus->setEnabled(false);
+    m_focusPosition = new QLabel(QStringLiteral("----"));
+    m_autoFocus = new QCheckBox(tr("Auto"));
+    m_autoFocus->setChecked(true);
+    auto* onePush = new QPushButton(tr("One push"));
+    auto* focus = new QHBoxLayout;
+    focus->addWidget(m_focus, 1);
+    focus->addWidget(m_focusPosition);
+    focus->addWidget(m_autoFocus);
+    focus->addWidget(onePush);
+
+    auto* form = new QFormLayout;
+    form->addRow(tr("Power"), power);
+    form->addRow(tr("Zoom"), zoom);
+    form->addRow(tr("Focus"), focus);
+    m_controls = new QGroupBox(tr("Camera"));
+    m_controls->setLayout(form);
+    m_controls->setEnabled(false);
+
+    m_graph = new PositionGraph;
+    m_graph->setRanges(ZoomMax, FocusMax);
+
+    auto* layout = new QVBoxLayout;
+    layout->addLayout(connection);
+    layout->addWidget(m_controls);
+    layout->addWidget(m_graph, 1);
+    auto* central = new QWidget;
+    central->setLayout(layout);
+    setCentralWidget(central);
+    statusBar()->showMessage(tr("Not connected"));
+
+    connect(m_type, &QComboBox::currentTextChanged, this, &MainWindow::onTypeChanged);
+    connect(m_connect, &QPushButton::clicked, this, &MainWindow::onConnectClicked);
+    connect(m_autoFocus, &QCheckBox::toggled, this, &MainWindow::onAutoFocusToggled);
+    connect(powerOn, &QPushButton::clicked, this,
+        [this] { emit commandRequested(QStringLiteral("power-on"), Command::powerOn()); });
+    connect(powerOff, &QPushButton::clicked, this,
+        [this] { emit commandRequested(QStringLiteral("power-off"), Command::powerOff()); });
+    connect(zoomStop, &QPushButton::clicked, this,
+        [this] { emit commandRequested(QStringLiteral("zoom-stop"), Command::zoomStop()); });
+    connect(onePush, &QPushButton::clicked, this,
+        [this] { emit commandRequested(QStringLiteral("focus-one-push"), Command::focusOnePushTrigger()); });
+    connect(m_zoom, &QSlider::valueChanged, this, &MainWindow::zoomTargetChanged);
+    connect(m_focus, &QSlider::valueChanged, this, &MainWindow::focusTargetChanged);
+
+    // Everything that reaches the camera crosses to the worker thread as a queued call
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(this, &MainWindow::openRequested, m_worker, &CameraWorker::open);
+    connect(this, &MainWindow::closeRequested, m_worker, &CameraWorker::close);
+    connect(this, &MainWindow::zoomTargetChanged, m_worker, &CameraWorker::setZoomTarget);
+    connect(this, &MainWindow::focusTargetChanged, m_worker, &CameraWorker::setFocusTarget);
+    connect(this, &MainWindow::commandRequested, m_worker, &CameraWorker::send);
+    connect(m_worker, &CameraWorker::opened, this, &MainWindow::onOpened);
+    connect(m_worker, &CameraWorker::closed, this, &MainWindow::onClosed);
+    connect(m_worker, &CameraWorker::positions, this, &MainWindow::onPositions);
+    connect(m_worker, &CameraWorker::replied, this, &MainWindow::onReplied);
+    connect(m_worker, &CameraWorker::linkLost, this, [this] { statusBar()->showMessage(tr("Link lost")); });
+    m_thread.start();
+}
+
+MainWindow::~MainWindow()
+{
+    // Disconnect on the worker thread before it stops; the worker deletes itself when it has
+    QMetaObject::invokeMethod(m_worker, "close", Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void MainWindow::onConnectClicked()
+{
+    m_connect->setEnabled(false);
+    if (m_connected) {
+        emit closeRequested();
+        return;
+    }
+    statusBar()->showMessage(tr("Connecting to %1...").arg(m_address->text()));
+    emit openRequested(m_type->currentText(), m_address->text(), m_port->value());
+}
+
+void MainWindow::onTypeChanged(const QString& type)
+{
+    bool serial = type == QLatin1String("serial");
+    m_address->setText(serial ? QStringLiteral("/dev/ttyUSB0") : QStringLiteral("192.168.1.100"));
+    m_port->setValue(serial ? 9600 : 5678);
+}
+
+void MainWindow::onOpened(bool ok, const QString& message)
+{
+    statusBar()->showMessage(message);
+    setConnected(ok);
+    if (ok) {
+        m_graph->clear();
+        onAutoFocusToggled(m_autoFocus->isChecked());
+    }
+}
+
+void MainWindow::onClosed()
+{
+    statusBar()->showMessage(tr("Disconnected"));
+    setConnected(false);
+}
+
+void MainWindow::onPositions(int zoom, int focus, bool zoomKnown, bool focusKnown, double roundTripMs)
+{
+    m_zoomPosition->setText(zoomKnown ? hex(zoom) : QStringLiteral("----"));
+    m_focusPosition->setText(focusKnown ? hex(focus) : QStringLiteral("----"));
+    m_zoomPosition->setToolTip(tr("Inquiry round trip %1 ms").arg(roundTripMs, 0, 'f', 1));
+    m_graph->addSample(zoom, focus, zoomKnown, focusKnown);
+}
+
+void MainWindow::onReplied(const QString& name, const QString& reply, double ms)
+{
+    statusBar()->showMessage(tr("%1: %2 after %3 ms").arg(name, reply).arg(ms, 0, 'f', 1));
+}
+
+void MainWindow::onAutoFocusToggled(bool on)
+{
+    m_focus->setEnabled(!on);
+    if (on)
+        emit commandRequested(QStringLiteral("focus-auto"), Command::focusAuto());
+    else
+        emit commandRequested(QStringLiteral("focus-manual"), Command::focusManual());
+}
+
+void MainWindow::setConnected(bool connected)
+{
+    m_connected = connected;
+    m_connect->setText(connected ? tr("Disconnect") : tr("Connect"));
+    m_connect->setEnabled(true);
+    m_controls->setEnabled(connected);
+    m_type->setEnabled(!connected);
+    m_address->setEnabled(!connected);
+    m_port->setEnabled(!connected);
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Commands.h"
+
+#include <QMainWindow>
+#include <QThread>
+
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSlider;
+class QSpinBox;
+
+namespace Visca {
+
+class CameraWorker;
+class PositionGraph;
+
+/**
+ * @brief Control panel: connection, power, zoom and focus sliders and a graph of the positions.
+ *
+ * Talks to the camera only through queued signals to a CameraWorker on its own thread, so no click or slider move
+ * waits for the link; replies and positions come back the same way.
+ */
+class MainWindow : public QMainWindow {
+    Q_OBJECT
+
+public:
+    explicit MainWindow(QWidget* parent = nullptr);
+    ~MainWindow() override;
+
+signals:
+    void openRequested(const QString& type, const QString& address, int port);
+    void closeRequested();
+    void zoomTargetChanged(int position);
+    void focusTargetChanged(int position);
+    void commandRequested(const QString& name, const Visca::Command& command);
+
+private slots:
+    void onConnectClicked();
+    void onTypeChanged(const QString& type);
+    void onOpened(bool ok, const QString& message);
+    void onClosed();
+    void onPositions(int zoom, int focus, bool zoomKnown, bool focusKnown, double roundTripMs);
+    void onReplied(const QString& name, const QString& reply, double ms);
+    void onAutoFocusToggled(bool on);
+
+private:
+    void setConnected(bool connected);
+
+    QThread m_thread;
+    CameraWorker* m_worker;
+    bool m_connected { false };
+
+    QComboBox* m_type;
+    QLineEdit* m_address;
+    QSpinBox* m_port;
+    QPushButton* m_connect;
+    QWidget* m_controls;
+    QSlider* m_zoom;
+    QLabel* m_zoomPosition;
+    QSlider* m_focus;
+    QLabel* m_focusPosition;
+    QCheckBox* m_autoFocus;
+    PositionGraph* m_graph;
+};
+
+}
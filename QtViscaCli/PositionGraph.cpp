@@ -0,0 +1,86 @@
+#include "PositionGraph.h"
+
+#include <QPainter>
+#include <QPainterPath>
+
+#include <algorithm>
+
+namespace Visca {
+
+PositionGraph::PositionGraph(QWidget* parent)
+    : QWidget(parent)
+{
+    setMinimumHeight(120);
+    m_clock.start();
+}
+
+void PositionGraph::setRanges(int zoomMax, int focusMax)
+{
+    m_zoomMax = std::max(zoomMax, 1);
+    m_focusMax = std::max(focusMax, 1);
+    update();
+}
+
+void PositionGraph::addSample(int zoom, int focus, bool zoomKnown, bool focusKnown)
+{
+    qint64 now = m_clock.elapsed();
+    m_samples.push_back({ now, zoomKnown ? zoom : -1, focusKnown ? focus : -1 });
+    while (!m_samples.empty() && now - m_samples.front().ms > SpanMs)
+        m_samples.pop_front();
+    update();
+}
+
+void PositionGraph::clear()
+{
+    m_samples.clear();
+    update();
+}
+
+void PositionGraph::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.fillRect(rect(), palette().base());
+
+    // Ten seconds per grid line
+    painter.setPen(QPen(palette().mid().color(), 0, Qt::DotLine));
+    for (int i = 1; i < SpanMs / 10000; ++i) {
+        int x = width() * i * 10000 / SpanMs;
+        painter.drawLine(x, 0, x, height());
+    }
+
+    qint64 now = m_clock.elapsed();
+    auto plot = [&](int Sample::*value, int maximum, const QColor& color) {
+        // Gaps where the position was unknown
+        QPainterPath path;
+        bool drawing = false;
+        for (const auto& sample : m_samples) {
+            int position = sample.*value;
+            if (position < 0) {
+                drawing = false;
+                continue;
+            }
+            QPointF point(width() - (now - sample.ms) * width() / double(SpanMs),
+                height() - 1 - std::min(position, maximum) * (height() - 2) / double(maximum));
+            if (drawing)
+                path.lineTo(point);
+            else
+                path.moveTo(point);
+            drawing = true;
+        }
+        painter.setPen(QPen(color, 2));
+        painter.drawPath(path);
+    };
+    const QColor zoomColor(0x1f, 0x77, 0xb4);
+    const QColor focusColor(0xff, 0x7f, 0x0e);
+    plot(&Sample::zoom, m_zoomMax, zoomColor);
+    plot(&Sample::focus, m_focusMax, focusColor);
+
+    QRect legend = rect().adjusted(6, 4, -6, -4);
+    painter.setPen(zoomColor);
+    painter.drawText(legend, Qt::AlignTop | Qt::AlignLeft, tr("zoom"));
+    painter.setPen(focusColor);
+    painter.drawText(legend, Qt::AlignTop | Qt::AlignRight, tr("focus"));
+}
+
+}
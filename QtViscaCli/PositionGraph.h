@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QWidget>
+
+#include <deque>
+
+namespace Visca {
+
+/**
+ * @brief Zoom and focus positions over the last seconds, newest on the right.
+ */
+class PositionGraph : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit PositionGraph(QWidget* parent = nullptr);
+
+    QSize sizeHint() const override { return QSize(480, 160); }
+
+    /**
+     * @brief Positions drawn at the top of the graph, the bottom is 0.
+     */
+    void setRanges(int zoomMax, int focusMax);
+
+public slots:
+    void addSample(int zoom, int focus, bool zoomKnown, bool focusKnown);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    struct Sample {
+        qint64 ms; ///< Since the graph started
+        int zoom; ///< -1 when unknown
+        int focus;
+    };
+
+    static constexpr qint64 SpanMs = 30000;
+
+    QElapsedTimer m_clock;
+    int m_zoomMax { 0xFFFF };
+    int m_focusMax { 0xFFFF };
+    std::deque<Sample> m_samples;
+};
+
+}
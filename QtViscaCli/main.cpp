@@ -0,0 +1,16 @@
+#include "CameraWorker.h"
+#include "MainWindow.h"
+
+#include <QApplication>
+
+int main(int argc, char* argv[])
+{
+    QApplication app(argc, argv);
+
+    // Passed by value between the UI and the worker thread
+    qRegisterMetaType<Visca::Command>("Visca::Command");
+
+    Visca::MainWindow window;
+    window.show();
+    return app.exec();
+}
@@ -0,0 +1,240 @@
+#include "Commands.h"
+#include "TrafficCapture.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+void printUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [--summary] CAPTURE\n"
+              << "  Prints every frame of a capture written by CaptureCommunicator with its time since the start\n"
+              << "  of the capture, direction, bytes and meaning.\n"
+              << "  --summary  Only print frame counts, errors and ACK/completion latencies\n";
+}
+
+std::string hex(Span<const uint8_t> data)
+{
+    std::string text;
+    char byte[4];
+    for (size_t i = 0; i < data.size(); ++i) {
+        std::snprintf(byte, sizeof(byte), i == 0 ? "%02X" : " %02X", data[i]);
+        text += byte;
+    }
+    return text;
+}
+
+enum class Kind { Command, Inquiry, Cancel, Broadcast, Ack, Completion, Reply, Error, Other };
+
+Kind classify(const CaptureRecord& record)
+{
+    const auto& data = record.data;
+    if (data.size() < 3)
+        return Kind::Other;
+
+    if (record.direction == CaptureDirection::Sent) {
+        if (data[0] == 0x88)
+            return Kind::Broadcast;
+        if ((data[1] & 0xF0) == 0x20)
+            return Kind::Cancel;
+        if (data[1] == 0x01)
+            return Kind::Command;
+        if (data[1] == 0x09)
+            return Kind::Inquiry;
+        return Kind::Other;
+    }
+
+    switch (data[1] & 0xF0) {
+    case 0x40:
+        return Kind::Ack;
+    case 0x50:
+        return data.size() > 3 ? Kind::Reply : Kind::Completion;
+    case 0x60:
+        return Kind::Error;
+    default:
+        return Kind::Other;
+    }
+}
+
+std::string describe(const CaptureRecord& record, Kind kind)
+{
+    const auto& data = record.data;
+    char text[64];
+    switch (kind) {
+    case Kind::Command:
+        std::snprintf(text, sizeof(text), "command to %u", data[0] & 0x0F);
+        return text;
+    case Kind::Inquiry:
+        std::snprintf(text, sizeof(text), "inquiry to %u", data[0] & 0x0F);
+        return text;
+    case Kind::Cancel:
+        std::snprintf(text, sizeof(text), "cancel socket %u", data[1] & 0x0F);
+        return text;
+    case Kind::Broadcast:
+        if (data[1] == 0x30)
+            return "address set";
+        if (data[1] == 0x01 && data.size() > 3 && data[2] == 0x00 && data[3] == 0x01)
+            return "IF_Clear";
+        return "broadcast";
+    case Kind::Ack:
+        std::snprintf(text, sizeof(text), "ACK socket %u", data[1] & 0x0F);
+        return text;
+    case Kind::Completion:
+        std::snprintf(text, sizeof(text), "completion socket %u", data[1] & 0x0F);
+        return text;
+    case Kind::Reply:
+        return "inquiry reply";
+    case Kind::Error: {
+        Response response;
+        response.parse(std::vector<uint8_t>(data.begin(), data.end()));
+        std::snprintf(
+            text, sizeof(text), "error socket %u: %s", data[1] & 0x0F, response.errorString().c_str());
+        return text;
+    }
+    default:
+        return "";
+    }
+}
+
+struct Latencies {
+    std::vector<double> samples;
+
+    void print(const char* name)
+    {
+        if (samples.empty()) {
+            std::printf("  %-12s none\n", name);
+            return;
+        }
+        std::sort(samples.begin(), samples.end());
+        auto at = [this](double p) {
+            return samples[std::min(samples.size() - 1, static_cast<size_t>(p * (samples.size() - 1) + 0.5))];
+        };
+        std::printf("  %-12s n=%zu min=%.3f p50=%.3f p99=%.3f max=%.3f ms\n", name, samples.size(), samples.front(),
+            at(0.50), at(0.99), samples.back());
+    }
+};
+}
+
+int main(int argc, char* argv[])
+{
+    bool summary = false;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--summary") {
+            summary = true;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            path = arg;
+        }
+    }
+
+    if (path.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    CaptureReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Cannot read capture " << path << std::endl;
+        return 1;
+    }
+
+    std::time_t started = static_cast<std::time_t>(reader.startWallClockNs() / 1000000000ULL);
+    char startText[64];
+    std::strftime(startText, sizeof(startText), "%Y-%m-%d %H:%M:%S", std::localtime(&started));
+    std::printf("Capture %s, started %s\n", path.c_str(), startText);
+
+    std::map<Kind, uint64_t> counts;
+    std::map<uint8_t, uint64_t> errors;
+    std::deque<uint64_t> awaitingFirstReply; ///< Send times of frames not answered yet, oldest first
+    std::map<uint8_t, uint64_t> socketSent; ///< Send time of the command running in each socket
+    Latencies ack, completion, reply;
+    uint64_t sent = 0;
+    uint64_t received = 0;
+
+    auto ms = [](uint64_t from, uint64_t to) { return to > from ? static_cast<double>(to - from) / 1e6 : 0.0; };
+
+    CaptureRecord record;
+    while (reader.next(record)) {
+        Kind kind = classify(record);
+        ++counts[kind];
+        record.direction == CaptureDirection::Sent ? ++sent : ++received;
+
+        if (!summary) {
+            std::printf("%12.6f ms  %s  %-40s %s\n", ms(reader.startMonotonicNs(), record.timestampNs),
+                record.direction == CaptureDirection::Sent ? "TX" : "RX", hex(record.data).c_str(),
+                describe(record, kind).c_str());
+        }
+
+        uint8_t socket = record.data.size() > 1 ? record.data[1] & 0x0F : 0;
+        switch (kind) {
+        case Kind::Command:
+        case Kind::Inquiry:
+            awaitingFirstReply.push_back(record.timestampNs);
+            break;
+        case Kind::Ack:
+            if (!awaitingFirstReply.empty()) {
+                ack.samples.push_back(ms(awaitingFirstReply.front(), record.timestampNs));
+                socketSent[socket] = awaitingFirstReply.front();
+                awaitingFirstReply.pop_front();
+            }
+            break;
+        case Kind::Completion:
+            if (socketSent.count(socket)) {
+                completion.samples.push_back(ms(socketSent[socket], record.timestampNs));
+                socketSent.erase(socket);
+            }
+            break;
+        case Kind::Reply:
+            if (!awaitingFirstReply.empty()) {
+                reply.samples.push_back(ms(awaitingFirstReply.front(), record.timestampNs));
+                awaitingFirstReply.pop_front();
+            }
+            break;
+        case Kind::Error: {
+            uint8_t code = record.data.size() > 3 ? record.data[2] : 0;
+            ++errors[code];
+            // Cancelled ends a running command, every other error answers a send instead of its ACK
+            if (code == 0x04)
+                socketSent.erase(socket);
+            else if (!awaitingFirstReply.empty())
+                awaitingFirstReply.pop_front();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    std::printf("\n%llu frames sent, %llu received\n", static_cast<unsigned long long>(sent),
+        static_cast<unsigned long long>(received));
+    std::printf("  commands %llu, inquiries %llu, cancels %llu, broadcasts %llu\n",
+        static_cast<unsigned long long>(counts[Kind::Command]), static_cast<unsigned long long>(counts[Kind::Inquiry]),
+        static_cast<unsigned long long>(counts[Kind::Cancel]),
+        static_cast<unsigned long long>(counts[Kind::Broadcast]));
+    std::printf("  ACKs %llu, completions %llu, inquiry replies %llu, errors %llu, other %llu\n",
+        static_cast<unsigned long long>(counts[Kind::Ack]), static_cast<unsigned long long>(counts[Kind::Completion]),
+        static_cast<unsigned long long>(counts[Kind::Reply]), static_cast<unsigned long long>(counts[Kind::Error]),
+        static_cast<unsigned long long>(counts[Kind::Other]));
+    for (const auto& error : errors) {
+        std::printf("  error 0x%02X: %llu\n", error.first, static_cast<unsigned long long>(error.second));
+    }
+
+    std::printf("Latency from send\n");
+    ack.print("ACK");
+    completion.print("completion");
+    reply.print("reply");
+
+    return 0;
+}
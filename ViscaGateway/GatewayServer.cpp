@@ -0,0 +1,608 @@
+#include "GatewayServer.h"
+#include "Logger.h"
+#include "UnixSocketCommunicator.h"
+#include "ViscaOverIp.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Visca {
+
+namespace {
+    constexpr size_t MaxEvents = 256;
+    constexpr size_t MaxPartial = 64; ///< Longest garbage run kept while waiting for a 0xFF terminator
+
+    std::string formatAddress(const struct sockaddr_in& addr)
+    {
+        char text[INET_ADDRSTRLEN] = {};
+        ::inet_ntop(AF_INET, &addr.sin_addr, text, sizeof(text));
+        return std::string(text) + ":" + std::to_string(ntohs(addr.sin_port));
+    }
+
+    uint64_t peerKey(const struct sockaddr_in& addr)
+    {
+        return (static_cast<uint64_t>(addr.sin_addr.s_addr) << 16) | addr.sin_port;
+    }
+
+    std::string unixSocketPath(const std::string& dir, const std::string& device)
+    {
+        auto slash = device.rfind('/');
+        return dir + "/" + (slash == std::string::npos ? device : device.substr(slash + 1)) + ".sock";
+    }
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency)
+{
+    uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+    ++m_count;
+    m_totalNs += ns;
+    m_maxNs = std::max(m_maxNs, ns);
+    ++m_buckets[HdrHistogram::bucketIndex(ns)];
+    if (ns >= 1000000)
+        ++m_overLimit;
+}
+
+double LatencyHistogram::percentileUs(double p) const
+{
+    if (m_count == 0)
+        return 0.0;
+
+    auto target = static_cast<uint64_t>(p * static_cast<double>(m_count) + 0.5);
+    target = std::max<uint64_t>(1, std::min(target, m_count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < m_buckets.size(); ++i) {
+        seen += m_buckets[i];
+        if (seen >= target)
+            return static_cast<double>(std::min(HdrHistogram::bucketUpperBound(i), m_maxNs)) / 1000.0;
+    }
+    return maxUs();
+}
+
+GatewayServer::GatewayServer(const Options& options)
+    : m_options(options)
+    , m_buffer(65536)
+{
+}
+
+GatewayServer::~GatewayServer()
+{
+    for (auto& port : m_ports) {
+        for (auto& client : port.clients) {
+            if (client.second.transport != Transport::Udp)
+                ::close(client.second.fd);
+        }
+        if (port.udpFd >= 0)
+            ::close(port.udpFd);
+        if (port.tcpFd >= 0)
+            ::close(port.tcpFd);
+        if (port.unixFd >= 0) {
+            ::close(port.unixFd);
+            ::unlink(port.unixPath.c_str());
+        }
+    }
+    if (m_epollFd >= 0)
+        ::close(m_epollFd);
+}
+
+bool GatewayServer::start()
+{
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0) {
+        VISCALOG_ERROR("Gateway: epoll_create1 failed: " << std::strerror(errno));
+        return false;
+    }
+
+    m_ports.reserve(m_options.ports.size());
+    for (size_t i = 0; i < m_options.ports.size(); ++i) {
+        if (!openPort(i))
+            return false;
+    }
+
+    VISCALOG_INFO("Gateway: serving " << m_ports.size() << " serial cameras");
+    return true;
+}
+
+bool GatewayServer::openPort(size_t index)
+{
+    const SerialPort& config = m_options.ports[index];
+    uint16_t udpPort = m_options.viscaOverIpPort ? static_cast<uint16_t>(m_options.viscaOverIpPort + index) : 0;
+    if (m_options.viscaOverIpPort + index > 65535 || (m_options.tcpPort && m_options.tcpPort + index > 65535)) {
+        VISCALOG_ERROR("Gateway: Out of ports for " << config.device);
+        return false;
+    }
+
+    Port port;
+    port.device = config.device;
+    port.arbiter = LinkArbiter(m_options.arbiter);
+    port.serial = std::make_unique<SerialCommunicator>(config.device, config.baudRate);
+    if (!port.serial->open())
+        return false;
+    port.serialFd = port.serial->nativeHandle();
+
+    struct sockaddr_in addr;
+    port.udpFd = openSocket(SOCK_DGRAM, udpPort, addr);
+    if (port.udpFd < 0)
+        return false;
+    port.endpoint = formatAddress(addr);
+    port.stats.viscaOverIpPort = ntohs(addr.sin_port);
+
+    if (m_options.tcpPort) {
+        port.tcpFd = openSocket(SOCK_STREAM, static_cast<uint16_t>(m_options.tcpPort + index), addr);
+        if (port.tcpFd < 0) {
+            ::close(port.udpFd);
+            return false;
+        }
+        port.endpoint += " tcp " + formatAddress(addr);
+    }
+
+    if (!m_options.unixSocketDir.empty()) {
+        port.unixPath = unixSocketPath(m_options.unixSocketDir, config.device);
+        port.unixFd = openUnixSocket(port.unixPath);
+        if (port.unixFd < 0) {
+            ::close(port.udpFd);
+            if (port.tcpFd >= 0)
+                ::close(port.tcpFd);
+            return false;
+        }
+        port.endpoint += " unix " + port.unixPath;
+    }
+
+    port.stats.device = port.device;
+    port.stats.endpoint = port.endpoint;
+    m_ports.push_back(std::move(port));
+
+    Port& added = m_ports.back();
+    VISCALOG_INFO("Gateway: " << added.device << " at " << config.baudRate << " baud on " << added.endpoint);
+    return watch(index, added.serialFd) && watch(index, added.udpFd) && (added.tcpFd < 0 || watch(index, added.tcpFd))
+        && (added.unixFd < 0 || watch(index, added.unixFd));
+}
+
+int GatewayServer::openSocket(int type, uint16_t port, struct sockaddr_in& addr)
+{
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (::inet_pton(AF_INET, m_options.bindAddress.c_str(), &addr.sin_addr) != 1) {
+        VISCALOG_ERROR("Gateway: Invalid bind address " << m_options.bindAddress);
+        return -1;
+    }
+
+    int fd = ::socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        VISCALOG_ERROR("Gateway: socket failed: " << std::strerror(errno));
+        return -1;
+    }
+
+    int opt = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0
+        || (type == SOCK_STREAM && ::listen(fd, 16) < 0)) {
+        VISCALOG_ERROR("Gateway: Cannot bind " << formatAddress(addr) << ": " << std::strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+
+    // Report the port actually bound, port 0 picks a free one
+    socklen_t length = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &length);
+    return fd;
+}
+
+int GatewayServer::openUnixSocket(const std::string& path)
+{
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        VISCALOG_ERROR("Gateway: Socket path too long: " << path);
+        return -1;
+    }
+    std::memcpy(addr.sun_path, path.data(), path.size());
+
+    int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        VISCALOG_ERROR("Gateway: socket failed: " << std::strerror(errno));
+        return -1;
+    }
+
+    // The socket file of an earlier run is still there after a crash
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 16) < 0) {
+        VISCALOG_ERROR("Gateway: Cannot listen on " << path << ": " << std::strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool GatewayServer::watch(size_t port, int fd)
+{
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = (static_cast<uint64_t>(port) << 32) | static_cast<uint32_t>(fd);
+    if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        VISCALOG_ERROR("Gateway: epoll_ctl failed: " << std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+int GatewayServer::poll(int timeoutMs)
+{
+    auto now = Clock::now();
+    int timeout = timeoutMs;
+    for (const auto& port : m_ports) {
+        Clock::time_point deadline;
+        if (!port.arbiter.nextDeadline(deadline))
+            continue;
+        auto untilDue = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count();
+        int dueMs = static_cast<int>((std::max<int64_t>(untilDue, 0) + 999) / 1000);
+        timeout = timeout < 0 ? dueMs : std::min(timeout, dueMs);
+    }
+    for (const auto& port : m_ports) {
+        // Wake up for the next attempt to reopen a serial port that hung up
+        if (port.serialFd < 0)
+            timeout = timeout < 0 ? 1000 : std::min(timeout, 1000);
+    }
+
+    struct epoll_event events[MaxEvents];
+    int ready = ::epoll_wait(m_epollFd, events, static_cast<int>(MaxEvents), timeout);
+    if (ready < 0)
+        return errno == EINTR ? 0 : -1;
+
+    for (int i = 0; i < ready; ++i) {
+        size_t port = static_cast<size_t>(events[i].data.u64 >> 32);
+        int fd = static_cast<int>(events[i].data.u64 & 0xFFFFFFFF);
+        handleEvent(port, fd, events[i].events);
+    }
+
+    housekeeping(Clock::now());
+    return ready;
+}
+
+GatewayServer::PortStats GatewayServer::stats(size_t index) const
+{
+    if (index >= m_ports.size())
+        return PortStats();
+
+    const Port& port = m_ports[index];
+    PortStats stats = port.stats;
+    stats.clients = port.clients.size();
+    stats.queued = port.arbiter.queued();
+    stats.arbiter = port.arbiter.stats();
+    return stats;
+}
+
+void GatewayServer::handleEvent(size_t index, int fd, uint32_t events)
+{
+    if (index >= m_ports.size())
+        return;
+
+    Port& port = m_ports[index];
+    if (fd == port.serialFd)
+        readSerial(port, events);
+    else if (fd == port.udpFd)
+        readDatagrams(port);
+    else if (fd == port.tcpFd)
+        acceptClients(index, port, port.tcpFd, Transport::Tcp);
+    else if (fd == port.unixFd)
+        acceptClients(index, port, port.unixFd, Transport::Unix);
+    else
+        readClient(port, fd);
+}
+
+void GatewayServer::readSerial(Port& port, uint32_t events)
+{
+    size_t received = port.serial->receive(m_buffer.data(), m_buffer.size());
+    if (received == 0 && (events & (EPOLLHUP | EPOLLERR))) {
+        // The device is gone (USB adapter unplugged), it stays readable with nothing to read
+        VISCALOG_ERROR("Gateway: " << port.device << " hung up, reopening it");
+        closeSerial(port);
+        ++port.stats.serialHangups;
+        return;
+    }
+    auto now = Clock::now();
+    port.stats.bytesFromCamera += received;
+
+    for (size_t i = 0; i < received; ++i) {
+        port.partial.push_back(m_buffer[i]);
+        if (m_buffer[i] != 0xFF) {
+            if (port.partial.size() > MaxPartial)
+                port.partial.clear();
+            continue;
+        }
+        port.arbiter.onReply(port.partial.data(), port.partial.size(), now, m_outputs);
+        port.partial.clear();
+    }
+
+    // Let the next packet go before the replies, the line is the bottleneck
+    pump(port);
+    deliver(port, now);
+}
+
+void GatewayServer::closeSerial(Port& port)
+{
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, port.serialFd, nullptr);
+    port.serial->close();
+    port.serialFd = -1;
+    port.partial.clear();
+    port.stats.serialOpen = false;
+}
+
+void GatewayServer::reopenSerial(size_t index, Port& port)
+{
+    if (!port.serial->open())
+        return;
+    if (!watch(index, port.serial->nativeHandle())) {
+        port.serial->close();
+        return;
+    }
+    port.serialFd = port.serial->nativeHandle();
+    port.stats.serialOpen = true;
+    VISCALOG_INFO("Gateway: " << port.device << " is back");
+}
+
+void GatewayServer::readDatagrams(Port& port)
+{
+    auto now = Clock::now();
+    while (true) {
+        struct sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        ssize_t received = ::recvfrom(
+            port.udpFd, m_buffer.data(), m_buffer.size(), 0, reinterpret_cast<struct sockaddr*>(&from), &fromLen);
+        if (received < 0)
+            break;
+
+        ViscaOverIp::Header header;
+        if (!ViscaOverIp::decode(m_buffer.data(), static_cast<size_t>(received), header))
+            continue;
+
+        auto known = port.peers.find(peerKey(from));
+        LinkArbiter::ClientId id;
+        if (known == port.peers.end()) {
+            id = port.nextClient++;
+            port.peers[peerKey(from)] = id;
+            Client client;
+            client.peer = from;
+            port.clients[id] = client;
+            VISCALOG_DEBUG("Gateway: " << formatAddress(from) << " joined " << port.device);
+        } else {
+            id = known->second;
+        }
+        Client& client = port.clients[id];
+        client.lastSeen = now;
+
+        const uint8_t* payload = m_buffer.data() + ViscaOverIp::HeaderSize;
+        switch (header.type) {
+        case ViscaOverIp::PayloadType::Command:
+        case ViscaOverIp::PayloadType::Inquiry:
+            port.arbiter.submit(id, header.sequence, payload, header.length, now, m_outputs);
+            break;
+        case ViscaOverIp::PayloadType::ControlCommand: {
+            // RESET (01) only concerns this client's sequence numbers, answer it here
+            static const uint8_t ack = 0x01;
+            auto reply = ViscaOverIp::encode(ViscaOverIp::PayloadType::ControlReply, header.sequence, &ack, 1);
+            ::sendto(port.udpFd, reply.data(), reply.size(), 0, reinterpret_cast<const struct sockaddr*>(&from),
+                sizeof(from));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    pump(port);
+    deliver(port, now);
+}
+
+void GatewayServer::acceptClients(size_t index, Port& port, int listenFd, Transport transport)
+{
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+
+        if (transport == Transport::Tcp) {
+            int opt = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        }
+        if (!watch(index, fd)) {
+            ::close(fd);
+            continue;
+        }
+
+        Client client;
+        client.transport = transport;
+        client.fd = fd;
+        client.lastSeen = Clock::now();
+        port.clients[port.nextClient++] = client;
+        VISCALOG_DEBUG("Gateway: " << (transport == Transport::Tcp ? "TCP" : "Local") << " client joined "
+                                   << port.device);
+    }
+}
+
+void GatewayServer::readClient(Port& port, int fd)
+{
+    auto found = std::find_if(port.clients.begin(), port.clients.end(),
+        [fd](const std::pair<const LinkArbiter::ClientId, Client>& client) { return client.second.fd == fd; });
+    if (found == port.clients.end())
+        return;
+
+    auto now = Clock::now();
+    if (found->second.transport == Transport::Unix)
+        readMessages(port, found->first, found->second, now);
+    else
+        readStream(port, found->first, found->second, now);
+
+    pump(port);
+    deliver(port, now);
+}
+
+void GatewayServer::readStream(Port& port, LinkArbiter::ClientId id, Client& client, Clock::time_point now)
+{
+    while (true) {
+        ssize_t received = ::read(client.fd, m_buffer.data(), m_buffer.size());
+        if (received < 0 && (errno == EAGAIN || errno == EINTR))
+            break;
+        if (received <= 0) {
+            dropClient(port, id);
+            return;
+        }
+
+        client.lastSeen = now;
+        for (ssize_t i = 0; i < received; ++i) {
+            client.partial.push_back(m_buffer[static_cast<size_t>(i)]);
+            if (m_buffer[static_cast<size_t>(i)] != 0xFF) {
+                if (client.partial.size() > MaxPartial)
+                    client.partial.clear();
+                continue;
+            }
+            port.arbiter.submit(id, 0, client.partial.data(), client.partial.size(), now, m_outputs);
+            client.partial.clear();
+        }
+    }
+}
+
+void GatewayServer::readMessages(Port& port, LinkArbiter::ClientId id, Client& client, Clock::time_point now)
+{
+    // One VISCA packet per message, behind its type byte
+    uint8_t type = 0;
+    while (true) {
+        struct iovec iov[2];
+        iov[0].iov_base = &type;
+        iov[0].iov_len = 1;
+        iov[1].iov_base = m_buffer.data();
+        iov[1].iov_len = LocalProtocol::MaxMessageSize;
+        struct msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = iov;
+        message.msg_iovlen = 2;
+
+        ssize_t received = ::recvmsg(client.fd, &message, 0);
+        if (received < 0 && (errno == EAGAIN || errno == EINTR))
+            break;
+        if (received <= 0) {
+            dropClient(port, id);
+            return;
+        }
+
+        client.lastSeen = now;
+        if (type == static_cast<uint8_t>(LocalProtocol::MessageType::Packet) && received > 1)
+            port.arbiter.submit(id, 0, m_buffer.data(), static_cast<size_t>(received) - 1, now, m_outputs);
+    }
+}
+
+void GatewayServer::dropClient(Port& port, LinkArbiter::ClientId id)
+{
+    auto client = port.clients.find(id);
+    if (client == port.clients.end())
+        return;
+
+    if (client->second.transport != Transport::Udp) {
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, client->second.fd, nullptr);
+        ::close(client->second.fd);
+    } else {
+        port.peers.erase(peerKey(client->second.peer));
+    }
+    port.arbiter.removeClient(id);
+    port.clients.erase(client);
+}
+
+void GatewayServer::pump(Port& port)
+{
+    LinkArbiter::Dispatch dispatch;
+    while (port.arbiter.next(dispatch, Clock::now())) {
+        if (!port.serial->send(dispatch.data))
+            VISCALOG_WARN("Gateway: Write to " << port.device << " failed");
+        port.stats.forward.record(Clock::now() - dispatch.eligible);
+        port.stats.bytesToCamera += dispatch.data.size();
+    }
+}
+
+void GatewayServer::deliver(Port& port, Clock::time_point since)
+{
+    for (const auto& output : m_outputs) {
+        if (output.client == LinkArbiter::AllClients) {
+            for (const auto& client : port.clients)
+                sendTo(port, client.second, 0, output.data);
+        } else {
+            // Replies for clients that went away are dropped
+            auto client = port.clients.find(output.client);
+            if (client != port.clients.end())
+                sendTo(port, client->second, output.tag, output.data);
+        }
+        port.stats.reply.record(Clock::now() - since);
+    }
+    m_outputs.clear();
+}
+
+void GatewayServer::sendTo(Port& port, const Client& client, uint32_t tag, const std::vector<uint8_t>& data)
+{
+    if (client.transport == Transport::Tcp) {
+        // Replies are a few bytes, a client whose socket buffer is full has stopped reading
+        if (::send(client.fd, data.data(), data.size(), MSG_NOSIGNAL) < 0)
+            VISCALOG_DEBUG("Gateway: Reply to TCP client dropped: " << std::strerror(errno));
+        return;
+    }
+
+    if (client.transport == Transport::Unix) {
+        uint8_t type = static_cast<uint8_t>(LocalProtocol::MessageType::Reply);
+        struct iovec iov[2];
+        iov[0].iov_base = &type;
+        iov[0].iov_len = 1;
+        iov[1].iov_base = const_cast<uint8_t*>(data.data());
+        iov[1].iov_len = data.size();
+        struct msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = iov;
+        message.msg_iovlen = 2;
+        if (::sendmsg(client.fd, &message, MSG_NOSIGNAL) < 0)
+            VISCALOG_DEBUG("Gateway: Reply to local client dropped: " << std::strerror(errno));
+        return;
+    }
+
+    auto datagram = ViscaOverIp::encode(ViscaOverIp::PayloadType::Reply, tag, data.data(), data.size());
+    ::sendto(port.udpFd, datagram.data(), datagram.size(), 0, reinterpret_cast<const struct sockaddr*>(&client.peer),
+        sizeof(client.peer));
+}
+
+void GatewayServer::housekeeping(Clock::time_point now)
+{
+    for (auto& port : m_ports) {
+        Clock::time_point deadline;
+        if (port.arbiter.nextDeadline(deadline) && deadline <= now) {
+            port.arbiter.expire(now);
+            pump(port);
+        }
+    }
+
+    if (now < m_nextIdleCheck)
+        return;
+    m_nextIdleCheck = now + std::chrono::seconds(1);
+
+    for (size_t i = 0; i < m_ports.size(); ++i) {
+        if (m_ports[i].serialFd < 0)
+            reopenSerial(i, m_ports[i]);
+    }
+
+    for (auto& port : m_ports) {
+        std::vector<LinkArbiter::ClientId> idle;
+        for (const auto& client : port.clients) {
+            if (client.second.transport == Transport::Udp && now - client.second.lastSeen > m_options.clientIdle)
+                idle.push_back(client.first);
+        }
+        for (auto id : idle)
+            dropClient(port, id);
+    }
+}
+
+}
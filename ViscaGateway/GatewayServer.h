@@ -0,0 +1,166 @@
+#pragma once
+
+#include "ControllerMetrics.h"
+#include "LinkArbiter.h"
+#include "SerialCommunicator.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief Latency histogram of the event loop, bucketed like HdrHistogram so percentiles stay within 6 % at any scale.
+ *
+ * Only the loop thread records, so the buckets are plain counters instead of the atomics of HdrHistogram.
+ */
+class LatencyHistogram {
+public:
+    void record(std::chrono::nanoseconds latency);
+
+    uint64_t count() const { return m_count; }
+    uint64_t overLimit() const { return m_overLimit; } ///< Samples of 1 ms or more
+    double maxUs() const { return static_cast<double>(m_maxNs) / 1000.0; }
+    double meanUs() const { return m_count ? static_cast<double>(m_totalNs) / 1000.0 / m_count : 0.0; }
+
+    /**
+     * @return Upper bound of the bucket holding the percentile p (0..1), never more than maxUs(); 0 when empty.
+     */
+    double percentileUs(double p) const;
+
+private:
+    std::array<uint64_t, HdrHistogram::Buckets> m_buckets {}; ///< Indexed by HdrHistogram::bucketIndex()
+    uint64_t m_count { 0 };
+    uint64_t m_overLimit { 0 };
+    uint64_t m_totalNs { 0 };
+    uint64_t m_maxNs { 0 };
+};
+
+/**
+ * @brief Exposes serial cameras to the network, many clients per camera.
+ *
+ * Every serial port gets a VISCA-over-IP endpoint (UDP, base port + index), optionally a raw VISCA TCP endpoint and a
+ * Unix domain socket for local processes (LocalProtocol, see UnixSocketCommunicator).
+ * Packets of all clients of a camera go through a LinkArbiter, which keeps one packet outstanding on the line, fills
+ * the camera sockets and routes replies back to the client and VISCA-over-IP sequence number they belong to. Everything
+ * runs in one epoll loop; the time a packet waits for the loop (forward) and a reply spends between the serial read
+ * and the network send (return) is kept in histograms, that is the latency the gateway adds to the line.
+ */
+class GatewayServer {
+public:
+    using Clock = LinkArbiter::Clock;
+
+    struct SerialPort {
+        std::string device;
+        uint32_t baudRate { 9600 };
+    };
+
+    struct Options {
+        std::vector<SerialPort> ports;
+        std::string bindAddress { "0.0.0.0" };
+        uint16_t viscaOverIpPort { 52381 }; ///< Camera i listens on this port + i, 0 for free ports
+        uint16_t tcpPort { 0 }; ///< Raw VISCA over TCP on this port + i, 0 to disable
+        std::string unixSocketDir; ///< Local sockets DIR/<device name>.sock, empty to disable
+        LinkArbiter::Config arbiter;
+        Clock::duration clientIdle { std::chrono::seconds(60) }; ///< UDP clients are forgotten after this
+    };
+
+    struct PortStats {
+        std::string device;
+        std::string endpoint;
+        uint16_t viscaOverIpPort { 0 };
+        size_t clients { 0 };
+        size_t queued { 0 };
+        LinkArbiter::Stats arbiter;
+        uint64_t bytesToCamera { 0 };
+        uint64_t bytesFromCamera { 0 };
+        uint64_t serialHangups { 0 }; ///< Times the serial port went away (adapter unplugged) and was reopened
+        bool serialOpen { true };
+        LatencyHistogram forward; ///< Packet could go out until written to the serial port
+        LatencyHistogram reply; ///< Frame read from the serial port until sent to the client
+    };
+
+    explicit GatewayServer(const Options& options);
+    ~GatewayServer();
+
+    GatewayServer(const GatewayServer&) = delete;
+    GatewayServer& operator=(const GatewayServer&) = delete;
+
+    /**
+     * @brief Open all serial ports and create the network endpoints.
+     * @return false if any of them failed, nothing is served then.
+     */
+    bool start();
+
+    /**
+     * @brief Serve until an event was handled, a timeout in an arbiter expired or timeoutMs elapsed.
+     * @return -1 on error.
+     */
+    int poll(int timeoutMs);
+
+    size_t portCount() const { return m_ports.size(); }
+    PortStats stats(size_t port) const;
+
+private:
+    enum class Transport { Udp, Tcp, Unix };
+
+    struct Client {
+        Transport transport { Transport::Udp };
+        int fd { -1 }; ///< TCP or Unix socket connection
+        struct sockaddr_in peer {}; ///< UDP peer
+        std::vector<uint8_t> partial;
+        Clock::time_point lastSeen {};
+    };
+
+    struct Port {
+        std::string device;
+        std::string endpoint;
+        std::unique_ptr<SerialCommunicator> serial;
+        int serialFd { -1 };
+        int udpFd { -1 };
+        int tcpFd { -1 };
+        int unixFd { -1 };
+        std::string unixPath;
+        LinkArbiter arbiter;
+        std::map<LinkArbiter::ClientId, Client> clients;
+        std::map<uint64_t, LinkArbiter::ClientId> peers; ///< UDP address and port to client
+        LinkArbiter::ClientId nextClient { 1 };
+        std::vector<uint8_t> partial; ///< Serial bytes of a frame not terminated yet
+        PortStats stats;
+    };
+
+    bool openPort(size_t index);
+    int openSocket(int type, uint16_t port, struct sockaddr_in& addr);
+    int openUnixSocket(const std::string& path);
+    bool watch(size_t port, int fd);
+
+    void handleEvent(size_t index, int fd, uint32_t events);
+    void readSerial(Port& port, uint32_t events);
+    void closeSerial(Port& port);
+    void reopenSerial(size_t index, Port& port);
+    void readDatagrams(Port& port);
+    void acceptClients(size_t index, Port& port, int listenFd, Transport transport);
+    void readClient(Port& port, int fd);
+    void readStream(Port& port, LinkArbiter::ClientId id, Client& client, Clock::time_point now);
+    void readMessages(Port& port, LinkArbiter::ClientId id, Client& client, Clock::time_point now);
+    void dropClient(Port& port, LinkArbiter::ClientId id);
+    void pump(Port& port);
+    void deliver(Port& port, Clock::time_point since);
+    void sendTo(Port& port, const Client& client, uint32_t tag, const std::vector<uint8_t>& data);
+    void housekeeping(Clock::time_point now);
+
+    Options m_options;
+    std::vector<Port> m_ports;
+    int m_epollFd { -1 };
+    std::vector<uint8_t> m_buffer;
+    std::vector<LinkArbiter::Output> m_outputs;
+    Clock::time_point m_nextIdleCheck {}; ///< Also paces the reopening of serial ports that hung up
+};
+
+}
@@ -0,0 +1,197 @@
+#include "GatewayServer.h"
+#include "Logger.h"
+#include "Tracing.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace Visca;
+
+namespace {
+std::atomic<bool> g_running { true };
+
+void onSignal(int) { g_running = false; }
+
+void printUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [options] DEVICE[@BAUD]...\n"
+              << "  Serves every serial camera as a VISCA-over-IP endpoint shared by any number of clients.\n"
+              << "  --baud N              Baud rate of devices given without @BAUD (default 9600)\n"
+              << "  --bind ADDRESS        Address to bind (default 0.0.0.0)\n"
+              << "  --port N              VISCA-over-IP UDP port of the first camera, next ones count up\n"
+              << "                        (default 52381)\n"
+              << "  --tcp-port N          Also serve raw VISCA over TCP from this port, 0 to disable (default 0)\n"
+              << "  --unix DIR            Also serve local processes on DIR/<device name>.sock\n"
+              << "  --sockets N           Command sockets of the cameras (default 2)\n"
+              << "  --reply-timeout-ms MS Wait for ACK or inquiry reply before moving on (default 200)\n"
+              << "  --queue N             Packets queued per client before \"buffer full\" (default 32)\n"
+              << "  --report SECONDS      Statistics interval, 0 to disable (default 10)\n"
+              << "  --log-file PATH       Log to PATH instead of the console, rotated to PATH.1, PATH.2, ...\n"
+              << "  --log-size MB         Size at which the log file rotates (default 10)\n"
+              << "  --log-files N         Log files kept, the current one included (default 5)\n"
+              << "  --trace PATH          Write a Chrome trace of the link events to PATH on exit (needs a\n"
+              << "                        library built with ENABLE_TRACING)\n"
+              << "  --verbose             Debug logging\n";
+}
+
+void report(const GatewayServer& server)
+{
+    for (size_t i = 0; i < server.portCount(); ++i) {
+        auto stats = server.stats(i);
+        std::printf("%s: %zu clients, %zu queued, %llu sent, %llu routed, %llu timeouts, %llu rejected, "
+                    "%llu/%llu bytes out/in\n",
+            stats.device.c_str(), stats.clients, stats.queued,
+            static_cast<unsigned long long>(stats.arbiter.dispatched),
+            static_cast<unsigned long long>(stats.arbiter.routed),
+            static_cast<unsigned long long>(stats.arbiter.replyTimeouts + stats.arbiter.completionTimeouts),
+            static_cast<unsigned long long>(stats.arbiter.rejected),
+            static_cast<unsigned long long>(stats.bytesToCamera),
+            static_cast<unsigned long long>(stats.bytesFromCamera));
+        if (!stats.serialOpen || stats.serialHangups > 0)
+            std::printf("  serial port %s, hung up %llu times\n", stats.serialOpen ? "open" : "gone",
+                static_cast<unsigned long long>(stats.serialHangups));
+        std::printf("  added latency forward p50 %.0f us p99 %.0f us max %.0f us, reply p50 %.0f us p99 %.0f us "
+                    "max %.0f us\n",
+            stats.forward.percentileUs(0.50), stats.forward.percentileUs(0.99), stats.forward.maxUs(),
+            stats.reply.percentileUs(0.50), stats.reply.percentileUs(0.99), stats.reply.maxUs());
+    }
+    std::fflush(stdout);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    GatewayServer::Options options;
+    uint32_t baudRate = 9600;
+    int reportSeconds = 10;
+    bool verbose = false;
+    std::string logFile;
+    RotatingFile::Options logRotation;
+    std::string traceFile;
+    std::vector<std::string> devices;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg.compare(0, 2, "--") != 0) {
+            devices.push_back(arg);
+        } else if (!hasValue) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else if (arg == "--baud") {
+            baudRate = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--bind") {
+            options.bindAddress = argv[++i];
+        } else if (arg == "--port") {
+            options.viscaOverIpPort = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--tcp-port") {
+            options.tcpPort = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--unix") {
+            options.unixSocketDir = argv[++i];
+        } else if (arg == "--sockets") {
+            options.arbiter.sockets = static_cast<uint8_t>(std::stoi(argv[++i]));
+        } else if (arg == "--reply-timeout-ms") {
+            options.arbiter.replyTimeout = std::chrono::milliseconds(std::stoi(argv[++i]));
+        } else if (arg == "--queue") {
+            options.arbiter.maxQueued = std::stoul(argv[++i]);
+        } else if (arg == "--report") {
+            reportSeconds = std::stoi(argv[++i]);
+        } else if (arg == "--log-file") {
+            logFile = argv[++i];
+        } else if (arg == "--log-size") {
+            logRotation.maxFileSize = std::stoul(argv[++i]) << 20;
+        } else if (arg == "--log-files") {
+            logRotation.maxFiles = std::stoul(argv[++i]);
+        } else if (arg == "--trace") {
+            traceFile = argv[++i];
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (devices.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    for (const auto& device : devices) {
+        GatewayServer::SerialPort port;
+        port.device = device;
+        port.baudRate = baudRate;
+        auto at = device.rfind('@');
+        if (at != std::string::npos) {
+            port.device = device.substr(0, at);
+            port.baudRate = static_cast<uint32_t>(std::stoul(device.substr(at + 1)));
+        }
+        options.ports.push_back(port);
+    }
+
+    Logger::instance().setLevel(verbose ? LogLevel::Debug : LogLevel::Info);
+    if (!logFile.empty() && !Logger::instance().setRotatingOutputFile(logFile, logRotation)) {
+        std::cerr << "Cannot open log file " << logFile << std::endl;
+        return 1;
+    }
+    Logger::instance().startAsync(); // Keeps formatting and file writes off the event loop
+
+    std::unique_ptr<ChromeTraceWriter> tracer;
+    if (!traceFile.empty()) {
+        if (!Tracing::compiledIn())
+            std::cerr << "Tracing is not compiled in, " << traceFile << " will be empty" << std::endl;
+        tracer.reset(new ChromeTraceWriter(1 << 20));
+        Tracing::setTracer(tracer.get());
+    }
+
+    GatewayServer server(options);
+    if (!server.start())
+        return 1;
+
+    for (size_t i = 0; i < server.portCount(); ++i) {
+        auto stats = server.stats(i);
+        std::cout << stats.device << ": " << stats.endpoint << std::endl;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    auto lastReport = std::chrono::steady_clock::now();
+    while (g_running) {
+        if (server.poll(100) < 0) {
+            std::cerr << "Event loop failed: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (reportSeconds > 0 && now - lastReport >= std::chrono::seconds(reportSeconds)) {
+            report(server);
+            lastReport = now;
+        }
+    }
+
+    std::printf("Summary:\n");
+    report(server);
+
+    if (tracer) {
+        Tracing::setTracer(nullptr); // The event loop is the only thread tracing and it has stopped
+        if (!tracer->writeFile(traceFile)) {
+            std::cerr << "Cannot write trace file " << traceFile << std::endl;
+            return 1;
+        }
+        if (tracer->dropped() > 0)
+            std::cerr << tracer->dropped() << " trace events dropped, the buffer was full" << std::endl;
+    }
+    return 0;
+}
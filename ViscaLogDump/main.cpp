@@ -0,0 +1,71 @@
+#include "BinaryLog.h"
+#include "Logger.h"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace Visca;
+
+namespace {
+void printUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [--no-location] [--level LEVEL] LOG\n"
+              << "  Prints a binary log written with Logger::setOutputFile(..., LogFormat::Binary) as text, the\n"
+              << "  same lines the text logger writes.\n"
+              << "  --no-location  Leave out file, line and function\n"
+              << "  --level LEVEL  Only print messages up to LEVEL: ERROR, WARN, INFO or DEBUG (default)\n";
+}
+
+bool parseLevel(const std::string& text, LogLevel& level)
+{
+    for (LogLevel candidate : { LogLevel::Error, LogLevel::Warning, LogLevel::Info, LogLevel::Debug }) {
+        if (text == Logger::levelToString(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    bool showLocation = true;
+    LogLevel maxLevel = LogLevel::Debug;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-location") {
+            showLocation = false;
+        } else if (arg == "--level" && i + 1 < argc) {
+            if (!parseLevel(argv[++i], maxLevel)) {
+                std::cerr << "Unknown level " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            path = arg;
+        }
+    }
+
+    if (path.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    BinaryLogReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Cannot read log " << path << std::endl;
+        return 1;
+    }
+
+    BinaryLogEntry entry;
+    while (reader.next(entry)) {
+        if (entry.level <= maxLevel)
+            std::printf("%s\n", BinaryLogReader::format(entry, showLocation).c_str());
+    }
+    return 0;
+}
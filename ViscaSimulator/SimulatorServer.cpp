@@ -0,0 +1,460 @@
+#include "SimulatorServer.h"
+#include "Logger.h"
+#include "ViscaOverIp.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace Visca {
+
+namespace {
+    constexpr size_t MaxEvents = 256;
+    constexpr size_t MaxPartial = 64; ///< Longest garbage run kept while waiting for a 0xFF terminator
+
+    bool setNonBlocking(int fd)
+    {
+        int flags = ::fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    std::string formatAddress(const struct sockaddr_in& addr)
+    {
+        char text[INET_ADDRSTRLEN] = {};
+        ::inet_ntop(AF_INET, &addr.sin_addr, text, sizeof(text));
+        return std::string(text) + ":" + std::to_string(ntohs(addr.sin_port));
+    }
+}
+
+SimulatorServer::SimulatorServer(const Options& options)
+    : m_options(options)
+    , m_buffer(65536)
+{
+}
+
+SimulatorServer::~SimulatorServer()
+{
+    for (auto& camera : m_cameras) {
+        for (auto& client : camera.clients) {
+            if (client.fd != camera.fd)
+                ::close(client.fd);
+        }
+        if (camera.fd >= 0)
+            ::close(camera.fd);
+        if (camera.slaveFd >= 0)
+            ::close(camera.slaveFd);
+    }
+    if (m_epollFd >= 0)
+        ::close(m_epollFd);
+}
+
+bool SimulatorServer::start()
+{
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0) {
+        VISCALOG_ERROR("Simulator: epoll_create1 failed: " << std::strerror(errno));
+        return false;
+    }
+
+    size_t total = m_options.tcpCount + m_options.udpCount + m_options.viscaOverIpCount + m_options.ptyCount;
+    m_cameras.reserve(total);
+
+    for (size_t i = 0; i < m_options.tcpCount; ++i) {
+        if (!addSocketCamera(Transport::Tcp, i))
+            return false;
+    }
+    for (size_t i = 0; i < m_options.udpCount; ++i) {
+        if (!addSocketCamera(Transport::Udp, i))
+            return false;
+    }
+    for (size_t i = 0; i < m_options.viscaOverIpCount; ++i) {
+        if (!addSocketCamera(Transport::ViscaOverIp, i))
+            return false;
+    }
+    for (size_t i = 0; i < m_options.ptyCount; ++i) {
+        if (!addPtyCamera())
+            return false;
+    }
+
+    VISCALOG_INFO("Simulator: serving " << m_cameras.size() << " cameras");
+    return true;
+}
+
+bool SimulatorServer::addSocketCamera(Transport transport, size_t index)
+{
+    uint16_t basePort = transport == Transport::Tcp ? m_options.tcpPort
+        : transport == Transport::Udp               ? m_options.udpPort
+                                                    : m_options.viscaOverIpPort;
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    if (::inet_pton(AF_INET, m_options.bindAddress.c_str(), &addr.sin_addr) != 1) {
+        VISCALOG_ERROR("Simulator: Invalid bind address " << m_options.bindAddress);
+        return false;
+    }
+    if (m_options.addressPerCamera) {
+        addr.sin_addr.s_addr = htonl(ntohl(addr.sin_addr.s_addr) + static_cast<uint32_t>(index));
+        addr.sin_port = htons(basePort);
+    } else {
+        if (basePort + index > 65535) {
+            VISCALOG_ERROR("Simulator: Out of ports for " << transportName(transport) << " camera " << index);
+            return false;
+        }
+        addr.sin_port = htons(static_cast<uint16_t>(basePort + index));
+    }
+
+    int type = transport == Transport::Tcp ? SOCK_STREAM : SOCK_DGRAM;
+    int fd = ::socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        VISCALOG_ERROR("Simulator: socket failed: " << std::strerror(errno));
+        return false;
+    }
+
+    int opt = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0
+        || (transport == Transport::Tcp && ::listen(fd, 16) < 0)) {
+        VISCALOG_ERROR("Simulator: Cannot bind " << formatAddress(addr) << ": " << std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    Camera camera(m_options.camera);
+    camera.transport = transport;
+    camera.endpoint = formatAddress(addr);
+    camera.fd = fd;
+    m_cameras.push_back(std::move(camera));
+    return watch(m_cameras.size() - 1, fd);
+}
+
+bool SimulatorServer::addPtyCamera()
+{
+    int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || ::grantpt(master) < 0 || ::unlockpt(master) < 0) {
+        VISCALOG_ERROR("Simulator: Cannot create pseudo-terminal: " << std::strerror(errno));
+        if (master >= 0)
+            ::close(master);
+        return false;
+    }
+
+    const char* slaveName = ::ptsname(master);
+    int slave = slaveName ? ::open(slaveName, O_RDWR | O_NOCTTY) : -1;
+    if (slave < 0) {
+        VISCALOG_ERROR("Simulator: Cannot open pseudo-terminal slave: " << std::strerror(errno));
+        ::close(master);
+        return false;
+    }
+
+    // Raw mode on the slave, so VISCA bytes pass unchanged until the client applies its own settings
+    struct termios tty;
+    if (::tcgetattr(slave, &tty) == 0) {
+        ::cfmakeraw(&tty);
+        ::tcsetattr(slave, TCSANOW, &tty);
+    }
+    setNonBlocking(master);
+    ::fcntl(master, F_SETFD, FD_CLOEXEC);
+    ::fcntl(slave, F_SETFD, FD_CLOEXEC);
+
+    Camera camera(m_options.camera);
+    camera.transport = Transport::Pty;
+    camera.endpoint = slaveName;
+    camera.fd = master;
+    camera.slaveFd = slave;
+    camera.replyFd = master;
+    camera.clients.push_back({ master, {} });
+    m_cameras.push_back(std::move(camera));
+    return watch(m_cameras.size() - 1, master);
+}
+
+bool SimulatorServer::watch(size_t camera, int fd)
+{
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = (static_cast<uint64_t>(camera) << 32) | static_cast<uint32_t>(fd);
+    if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        VISCALOG_ERROR("Simulator: epoll_ctl failed: " << std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+int SimulatorServer::poll(int timeoutMs)
+{
+    auto now = Clock::now();
+    flushReplies(now);
+
+    int timeout = timeoutMs;
+    if (!m_wakeups.empty()) {
+        auto untilDue = std::chrono::duration_cast<std::chrono::microseconds>(m_wakeups.top().first - now).count();
+        int dueMs = static_cast<int>((std::max<int64_t>(untilDue, 0) + 999) / 1000);
+        timeout = timeout < 0 ? dueMs : std::min(timeout, dueMs);
+    }
+
+    struct epoll_event events[MaxEvents];
+    int ready = ::epoll_wait(m_epollFd, events, static_cast<int>(MaxEvents), timeout);
+    if (ready < 0)
+        return errno == EINTR ? 0 : -1;
+
+    for (int i = 0; i < ready; ++i) {
+        size_t camera = static_cast<size_t>(events[i].data.u64 >> 32);
+        int fd = static_cast<int>(events[i].data.u64 & 0xFFFFFFFF);
+        handleEvent(camera, fd);
+    }
+
+    flushReplies(Clock::now());
+    return ready;
+}
+
+SimulatorServer::CameraStats SimulatorServer::stats(size_t index) const
+{
+    CameraStats stats;
+    if (index >= m_cameras.size())
+        return stats;
+
+    const Camera& camera = m_cameras[index];
+    stats.transport = camera.transport;
+    stats.endpoint = camera.endpoint;
+    stats.requests = camera.requests;
+    stats.replies = camera.replies;
+    stats.errors = camera.simulator.errorCount();
+    return stats;
+}
+
+const char* SimulatorServer::transportName(Transport transport)
+{
+    switch (transport) {
+    case Transport::Tcp:
+        return "tcp";
+    case Transport::Udp:
+        return "udp";
+    case Transport::ViscaOverIp:
+        return "visca-ip";
+    case Transport::Pty:
+        return "pty";
+    default:
+        return "unknown";
+    }
+}
+
+void SimulatorServer::handleEvent(size_t index, int fd)
+{
+    if (index >= m_cameras.size())
+        return;
+
+    Camera& camera = m_cameras[index];
+    switch (camera.transport) {
+    case Transport::Tcp:
+        if (fd == camera.fd)
+            acceptClient(camera);
+        else
+            readStream(index, camera, fd);
+        break;
+    case Transport::Udp:
+    case Transport::ViscaOverIp:
+        readDatagrams(index, camera);
+        break;
+    case Transport::Pty:
+        readStream(index, camera, fd);
+        break;
+    }
+}
+
+void SimulatorServer::acceptClient(Camera& camera)
+{
+    while (true) {
+        int client = ::accept4(camera.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client < 0)
+            return;
+
+        int opt = 1;
+        ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        size_t index = static_cast<size_t>(&camera - m_cameras.data());
+        if (!watch(index, client)) {
+            ::close(client);
+            continue;
+        }
+        camera.clients.push_back({ client, {} });
+        VISCALOG_DEBUG("Simulator: Client connected to " << camera.endpoint);
+    }
+}
+
+void SimulatorServer::readStream(size_t index, Camera& camera, int fd)
+{
+    auto client = std::find_if(
+        camera.clients.begin(), camera.clients.end(), [fd](const Client& client) { return client.fd == fd; });
+    if (client == camera.clients.end())
+        return;
+
+    while (true) {
+        ssize_t received = ::read(fd, m_buffer.data(), m_buffer.size());
+        if (received > 0) {
+            camera.replyFd = fd;
+            processPackets(index, camera, client->partial, m_buffer.data(), static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EINTR))
+            return;
+
+        // Peer closed (or the pty has no slave user right now), only TCP clients go away
+        if (camera.transport == Transport::Tcp)
+            dropClient(camera, fd);
+        return;
+    }
+}
+
+void SimulatorServer::readDatagrams(size_t index, Camera& camera)
+{
+    while (true) {
+        struct sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        ssize_t received = ::recvfrom(
+            camera.fd, m_buffer.data(), m_buffer.size(), 0, reinterpret_cast<struct sockaddr*>(&from), &fromLen);
+        if (received < 0)
+            return;
+
+        camera.peer = from;
+        camera.hasPeer = true;
+        if (camera.transport == Transport::ViscaOverIp) {
+            processViscaOverIp(index, camera, m_buffer.data(), static_cast<size_t>(received));
+        } else {
+            // A datagram carries whole packets, nothing is carried over to the next one
+            m_datagram.clear();
+            processPackets(index, camera, m_datagram, m_buffer.data(), static_cast<size_t>(received));
+        }
+    }
+}
+
+void SimulatorServer::processPackets(
+    size_t index, Camera& camera, std::vector<uint8_t>& partial, const uint8_t* data, size_t size)
+{
+    auto now = Clock::now();
+    for (size_t i = 0; i < size; ++i) {
+        partial.push_back(data[i]);
+        if (data[i] != 0xFF) {
+            if (partial.size() > MaxPartial)
+                partial.clear();
+            continue;
+        }
+        camera.simulator.process(partial.data(), partial.size(), now);
+        ++camera.requests;
+        partial.clear();
+    }
+    schedule(index, camera);
+}
+
+void SimulatorServer::processViscaOverIp(size_t index, Camera& camera, const uint8_t* data, size_t size)
+{
+    ViscaOverIp::Header header;
+    if (!ViscaOverIp::decode(data, size, header))
+        return;
+
+    const uint8_t* payload = data + ViscaOverIp::HeaderSize;
+    switch (header.type) {
+    case ViscaOverIp::PayloadType::Command:
+    case ViscaOverIp::PayloadType::Inquiry:
+        camera.sequence = header.sequence;
+        camera.simulator.process(payload, header.length, Clock::now());
+        ++camera.requests;
+        schedule(index, camera);
+        break;
+    case ViscaOverIp::PayloadType::ControlCommand: {
+        // RESET (01) clears the sequence number, the camera answers with an ACK (01)
+        static const uint8_t ack = 0x01;
+        if (header.length >= 1 && payload[0] == 0x01)
+            camera.sequence = 0;
+        auto reply = ViscaOverIp::encode(ViscaOverIp::PayloadType::ControlReply, header.sequence, &ack, 1);
+        sendDatagram(camera, reply.data(), reply.size());
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void SimulatorServer::schedule(size_t index, Camera& camera)
+{
+    Clock::time_point due;
+    if (camera.simulator.nextReplyTime(due) && due < camera.wakeup) {
+        camera.wakeup = due;
+        m_wakeups.emplace(due, index);
+    }
+}
+
+void SimulatorServer::flushReplies(Clock::time_point now)
+{
+    while (!m_wakeups.empty() && m_wakeups.top().first <= now) {
+        Wakeup wakeup = m_wakeups.top();
+        m_wakeups.pop();
+
+        // Superseded by an earlier wakeup for the same camera
+        Camera& camera = m_cameras[wakeup.second];
+        if (wakeup.first != camera.wakeup)
+            continue;
+        camera.wakeup = Clock::time_point::max();
+
+        size_t index = wakeup.second;
+        m_replies.clear();
+        camera.simulator.collectReplies(now, m_replies);
+        for (const auto& reply : m_replies)
+            sendReply(camera, reply.data);
+
+        // Cancelled replies leave their wakeup behind, it just finds nothing to collect
+        schedule(index, camera);
+    }
+}
+
+void SimulatorServer::sendReply(Camera& camera, const std::vector<uint8_t>& data)
+{
+    ++camera.replies;
+
+    switch (camera.transport) {
+    case Transport::Tcp:
+    case Transport::Pty:
+        if (camera.replyFd < 0)
+            return;
+        if (camera.transport == Transport::Tcp)
+            ::send(camera.replyFd, data.data(), data.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        else if (::write(camera.replyFd, data.data(), data.size()) < 0)
+            VISCALOG_DEBUG("Simulator: Reply dropped on " << camera.endpoint);
+        break;
+    case Transport::Udp:
+        sendDatagram(camera, data.data(), data.size());
+        break;
+    case Transport::ViscaOverIp: {
+        auto datagram
+            = ViscaOverIp::encode(ViscaOverIp::PayloadType::Reply, camera.sequence, data.data(), data.size());
+        sendDatagram(camera, datagram.data(), datagram.size());
+        break;
+    }
+    }
+}
+
+void SimulatorServer::sendDatagram(Camera& camera, const uint8_t* data, size_t size)
+{
+    if (!camera.hasPeer)
+        return;
+    ::sendto(camera.fd, data, size, MSG_DONTWAIT, reinterpret_cast<const struct sockaddr*>(&camera.peer),
+        sizeof(camera.peer));
+}
+
+void SimulatorServer::dropClient(Camera& camera, int fd)
+{
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    camera.clients.erase(std::remove_if(camera.clients.begin(), camera.clients.end(),
+                             [fd](const Client& client) { return client.fd == fd; }),
+        camera.clients.end());
+    if (camera.replyFd == fd)
+        camera.replyFd = camera.clients.empty() ? -1 : camera.clients.back().fd;
+    VISCALOG_DEBUG("Simulator: Client disconnected from " << camera.endpoint);
+}
+
+}
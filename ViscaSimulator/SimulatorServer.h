@@ -0,0 +1,127 @@
+#pragma once
+
+#include "CameraSimulator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <netinet/in.h>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief Serves many simulated cameras from one epoll loop.
+ *
+ * Every camera is a CameraSimulator behind its own endpoint: a TCP listening socket (several clients may connect,
+ * replies go to the client that sent the last packet), a UDP socket carrying raw VISCA or VISCA-over-IP datagrams
+ * (replies go to the last sender), or a pseudo-terminal whose slave side is opened like a serial port. Replies are
+ * released when the simulated camera emits them, the loop sleeps until the next one is due.
+ */
+class SimulatorServer {
+public:
+    using Clock = CameraSimulator::Clock;
+
+    enum class Transport { Tcp, Udp, ViscaOverIp, Pty };
+
+    struct Options {
+        CameraSimulator::Config camera;
+        std::string bindAddress { "127.0.0.1" };
+        bool addressPerCamera { false }; ///< Camera i binds bindAddress + i on the base port instead of base port + i
+        size_t tcpCount { 0 };
+        uint16_t tcpPort { 5678 };
+        size_t udpCount { 0 };
+        uint16_t udpPort { 6678 };
+        size_t viscaOverIpCount { 0 };
+        uint16_t viscaOverIpPort { 52381 };
+        size_t ptyCount { 0 };
+    };
+
+    struct CameraStats {
+        Transport transport { Transport::Tcp };
+        std::string endpoint;
+        uint64_t requests { 0 }; ///< VISCA packets received
+        uint64_t replies { 0 }; ///< VISCA packets sent
+        uint64_t errors { 0 }; ///< Error replies (syntax, buffer full, not executable, ...)
+    };
+
+    explicit SimulatorServer(const Options& options);
+    ~SimulatorServer();
+
+    SimulatorServer(const SimulatorServer&) = delete;
+    SimulatorServer& operator=(const SimulatorServer&) = delete;
+
+    /**
+     * @brief Create all endpoints.
+     * @return false if any endpoint could not be created, nothing is served then.
+     */
+    bool start();
+
+    /**
+     * @brief Serve requests until the next reply is due, timeoutMs elapsed or an event was handled.
+     * @return -1 on error.
+     */
+    int poll(int timeoutMs);
+
+    size_t cameraCount() const { return m_cameras.size(); }
+    CameraStats stats(size_t camera) const;
+
+    static const char* transportName(Transport transport);
+
+private:
+    struct Client {
+        int fd { -1 };
+        std::vector<uint8_t> partial;
+    };
+
+    struct Camera {
+        explicit Camera(const CameraSimulator::Config& config)
+            : simulator(config)
+        {
+        }
+
+        Transport transport { Transport::Tcp };
+        std::string endpoint;
+        CameraSimulator simulator;
+        int fd { -1 }; ///< Listening socket, datagram socket or pty master
+        int slaveFd { -1 }; ///< Pty slave, kept open so the master never sees a hangup
+        std::vector<Client> clients; ///< TCP connections, or the pty master as the only client
+        int replyFd { -1 };
+        struct sockaddr_in peer {};
+        bool hasPeer { false };
+        uint32_t sequence { 0 }; ///< VISCA-over-IP sequence number of the last request
+        Clock::time_point wakeup { Clock::time_point::max() }; ///< Earliest queued wakeup for this camera
+        uint64_t requests { 0 };
+        uint64_t replies { 0 };
+    };
+
+    bool addSocketCamera(Transport transport, size_t index);
+    bool addPtyCamera();
+    bool watch(size_t camera, int fd);
+
+    void handleEvent(size_t camera, int fd);
+    void acceptClient(Camera& camera);
+    void readStream(size_t index, Camera& camera, int fd);
+    void readDatagrams(size_t index, Camera& camera);
+    void processPackets(size_t index, Camera& camera, std::vector<uint8_t>& partial, const uint8_t* data, size_t size);
+    void processViscaOverIp(size_t index, Camera& camera, const uint8_t* data, size_t size);
+    void schedule(size_t index, Camera& camera);
+    void flushReplies(Clock::time_point now);
+    void sendReply(Camera& camera, const std::vector<uint8_t>& data);
+    void sendDatagram(Camera& camera, const uint8_t* data, size_t size);
+    void dropClient(Camera& camera, int fd);
+
+    using Wakeup = std::pair<Clock::time_point, size_t>;
+
+    Options m_options;
+    std::vector<Camera> m_cameras;
+    int m_epollFd { -1 };
+    std::priority_queue<Wakeup, std::vector<Wakeup>, std::greater<Wakeup>> m_wakeups;
+    std::vector<CameraSimulator::Reply> m_replies;
+    std::vector<uint8_t> m_buffer;
+    std::vector<uint8_t> m_datagram;
+};
+
+}
@@ -0,0 +1,197 @@
+#include "Logger.h"
+#include "SimulatorServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+std::atomic<bool> g_running { true };
+
+void onSignal(int) { g_running = false; }
+
+void printUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --tcp N               TCP cameras, raw VISCA (ports from --tcp-port, default 5678)\n"
+              << "  --udp N               UDP cameras, raw VISCA (ports from --udp-port, default 6678)\n"
+              << "  --visca-ip N          UDP cameras, VISCA-over-IP (ports from --visca-ip-port, default 52381)\n"
+              << "  --pty N               Pseudo-terminal cameras, use the printed /dev/pts path as serial device\n"
+              << "  --bind ADDRESS        Address to bind (default 127.0.0.1)\n"
+              << "  --address-per-camera  Give every camera its own address (bind + i) on the base port\n"
+              << "  --ack-delay-ms MS     Packet to ACK/inquiry reply delay (default 1)\n"
+              << "  --command-time-ms MS  ACK to completion of instant commands (default 5)\n"
+              << "  --zoom-travel-ms MS   Wide to tele at full speed (default 2500)\n"
+              << "  --focus-travel-ms MS  Far to near at full speed (default 2000)\n"
+              << "  --report SECONDS      Request rate report interval, 0 to disable (default 5)\n"
+              << "  --top N               Cameras listed per report, busiest first (default 10)\n"
+              << "  --verbose             Debug logging\n";
+}
+
+/**
+ * @brief Lift the soft open file limit to the hard one, every camera needs at least one descriptor.
+ */
+void raiseFileLimit(size_t cameras)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
+        return;
+    if (limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    if (limit.rlim_cur != RLIM_INFINITY && cameras * 2 + 64 > limit.rlim_cur)
+        std::cerr << "Warning: open file limit " << limit.rlim_cur << " may be too low for " << cameras
+                  << " cameras" << std::endl;
+}
+
+void report(const SimulatorServer& server, std::vector<uint64_t>& lastRequests, double seconds, size_t top)
+{
+    struct Rate {
+        size_t camera;
+        uint64_t requests;
+    };
+    std::vector<Rate> rates;
+    uint64_t total = 0;
+    size_t active = 0;
+
+    for (size_t i = 0; i < server.cameraCount(); ++i) {
+        auto stats = server.stats(i);
+        uint64_t requests = stats.requests - lastRequests[i];
+        lastRequests[i] = stats.requests;
+        total += requests;
+        if (requests > 0) {
+            ++active;
+            rates.push_back({ i, requests });
+        }
+    }
+
+    std::printf("%zu/%zu cameras active, %.1f req/s total\n", active, server.cameraCount(),
+        static_cast<double>(total) / seconds);
+
+    size_t shown = std::min(top, rates.size());
+    std::partial_sort(rates.begin(), rates.begin() + static_cast<std::ptrdiff_t>(shown), rates.end(),
+        [](const Rate& a, const Rate& b) { return a.requests > b.requests; });
+    for (size_t i = 0; i < shown; ++i) {
+        auto stats = server.stats(rates[i].camera);
+        std::printf("  #%-5zu %-8s %-24s %10.1f req/s %10llu replies %8llu errors\n", rates[i].camera,
+            SimulatorServer::transportName(stats.transport), stats.endpoint.c_str(),
+            static_cast<double>(rates[i].requests) / seconds, static_cast<unsigned long long>(stats.replies),
+            static_cast<unsigned long long>(stats.errors));
+    }
+    std::fflush(stdout);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    SimulatorServer::Options options;
+    int reportSeconds = 5;
+    size_t top = 10;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "--address-per-camera") {
+            options.addressPerCamera = true;
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (!hasValue) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else if (arg == "--tcp") {
+            options.tcpCount = std::stoul(argv[++i]);
+        } else if (arg == "--tcp-port") {
+            options.tcpPort = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--udp") {
+            options.udpCount = std::stoul(argv[++i]);
+        } else if (arg == "--udp-port") {
+            options.udpPort = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--visca-ip") {
+            options.viscaOverIpCount = std::stoul(argv[++i]);
+        } else if (arg == "--visca-ip-port") {
+            options.viscaOverIpPort = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--pty") {
+            options.ptyCount = std::stoul(argv[++i]);
+        } else if (arg == "--bind") {
+            options.bindAddress = argv[++i];
+        } else if (arg == "--ack-delay-ms") {
+            options.camera.ackDelay = std::chrono::milliseconds(std::stoi(argv[++i]));
+        } else if (arg == "--command-time-ms") {
+            options.camera.commandTime = std::chrono::milliseconds(std::stoi(argv[++i]));
+        } else if (arg == "--zoom-travel-ms") {
+            options.camera.zoomFullTravel = std::chrono::milliseconds(std::stoi(argv[++i]));
+        } else if (arg == "--focus-travel-ms") {
+            options.camera.focusFullTravel = std::chrono::milliseconds(std::stoi(argv[++i]));
+        } else if (arg == "--report") {
+            reportSeconds = std::stoi(argv[++i]);
+        } else if (arg == "--top") {
+            top = std::stoul(argv[++i]);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    size_t cameras = options.tcpCount + options.udpCount + options.viscaOverIpCount + options.ptyCount;
+    if (cameras == 0) {
+        // Nothing asked for, serve a single TCP camera on the ClViscaCli default port
+        options.tcpCount = 1;
+        cameras = 1;
+    }
+
+    Logger::instance().setLevel(verbose ? LogLevel::Debug : LogLevel::Info);
+    raiseFileLimit(cameras);
+
+    SimulatorServer server(options);
+    if (!server.start())
+        return 1;
+
+    for (size_t i = 0; i < server.cameraCount(); ++i) {
+        auto stats = server.stats(i);
+        std::cout << "camera " << i << ": " << SimulatorServer::transportName(stats.transport) << " "
+                  << stats.endpoint << std::endl;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::vector<uint64_t> lastRequests(server.cameraCount(), 0);
+    auto started = std::chrono::steady_clock::now();
+    auto lastReport = started;
+
+    while (g_running) {
+        if (server.poll(100) < 0) {
+            std::cerr << "Event loop failed: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (reportSeconds > 0 && now - lastReport >= std::chrono::seconds(reportSeconds)) {
+            report(server, lastRequests, std::chrono::duration<double>(now - lastReport).count(), top);
+            lastReport = now;
+        }
+    }
+
+    // Final summary over the whole run
+    std::fill(lastRequests.begin(), lastRequests.end(), 0);
+    std::printf("Summary:\n");
+    report(server, lastRequests,
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count(), top);
+    return 0;
+}
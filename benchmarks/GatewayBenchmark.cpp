@@ -0,0 +1,350 @@
+/**
+ * @file GatewayBenchmark.cpp
+ * @brief Latency the serial to VISCA-over-IP gateway adds while the serial line runs at full rate.
+ *
+ * A simulated camera sits on the master side of a pseudo-terminal and paces both directions like a serial line at
+ * the given baud rate (10 bit times per byte). The gateway opens the slave side as its serial port. Several
+ * clients keep one request each in flight (zoom stop and zoom position inquiry in turn), so the gateway always has
+ * work queued and the line never idles because of the clients. Clients use VISCA-over-IP, or the gateway's Unix
+ * domain socket with transport "unix".
+ *
+ * Reported are the gateway's own histograms (forward: packet could go out until written to the serial port, reply:
+ * serial frame read until sent to the client), the line turnaround seen by the camera (last reply written until the
+ * next request arrives, which adds two pty hops to the gateway's reaction) and line utilisation.
+ *
+ * Usage: GatewayBenchmark [seconds] [clients] [baud] [udp|unix]
+ */
+
+#include "Commands.h"
+#include "GatewayServer.h"
+#include "Logger.h"
+#include "MockCommunicator.h"
+#include "UnixSocketCommunicator.h"
+#include "ViscaOverIp.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <memory>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief CameraSimulator behind the master side of a pty, paced like a serial line.
+ */
+class LineCamera {
+public:
+    LineCamera(const CameraSimulator::Config& config, uint32_t baudRate)
+        : m_camera(config)
+        , m_baudRate(baudRate)
+    {
+    }
+
+    ~LineCamera()
+    {
+        if (m_master >= 0)
+            ::close(m_master);
+    }
+
+    bool open()
+    {
+        m_master = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (m_master < 0 || ::grantpt(m_master) < 0 || ::unlockpt(m_master) < 0)
+            return false;
+        const char* name = ::ptsname(m_master);
+        if (!name)
+            return false;
+        m_slaveName = name;
+        int flags = ::fcntl(m_master, F_GETFL, 0);
+        ::fcntl(m_master, F_SETFL, flags | O_NONBLOCK);
+        return true;
+    }
+
+    const std::string& slaveName() const { return m_slaveName; }
+
+    void run(const std::atomic<bool>& running)
+    {
+        std::vector<uint8_t> buffer(4096);
+        std::vector<CameraSimulator::Reply> replies;
+
+        while (running) {
+            auto now = Clock::now();
+
+            // Requests whose last byte has crossed the line reach the camera
+            while (!m_arriving.empty() && m_arriving.front().due <= now) {
+                m_camera.process(m_arriving.front().data.data(), m_arriving.front().data.size(), m_arriving.front().due);
+                m_arriving.pop_front();
+            }
+
+            // Replies leave one after the other at line rate
+            replies.clear();
+            m_camera.collectReplies(now, replies);
+            for (auto& reply : replies) {
+                auto done = std::max(reply.due, m_rxFreeAt) + MockCommunicator::wireTime(reply.data.size(), m_baudRate);
+                m_rxFreeAt = done;
+                m_leaving.push_back({ done, std::move(reply.data) });
+            }
+
+            while (!m_leaving.empty() && m_leaving.front().due <= now) {
+                if (::write(m_master, m_leaving.front().data.data(), m_leaving.front().data.size()) > 0) {
+                    m_lastWrite = Clock::now();
+                    m_bytesOut += m_leaving.front().data.size();
+                }
+                m_leaving.pop_front();
+            }
+
+            Clock::time_point wakeup = now + std::chrono::milliseconds(10);
+            Clock::time_point due;
+            if (!m_arriving.empty())
+                wakeup = std::min(wakeup, m_arriving.front().due);
+            if (!m_leaving.empty())
+                wakeup = std::min(wakeup, m_leaving.front().due);
+            if (m_camera.nextReplyTime(due))
+                wakeup = std::min(wakeup, due);
+
+            auto wait = std::max(wakeup - Clock::now(), Clock::duration::zero());
+            struct timespec timeout;
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+            timeout.tv_sec = static_cast<time_t>(ns / 1000000000);
+            timeout.tv_nsec = static_cast<long>(ns % 1000000000);
+            struct pollfd pfd = { m_master, POLLIN, 0 };
+            if (::ppoll(&pfd, 1, &timeout, nullptr) <= 0)
+                continue;
+
+            ssize_t received = ::read(m_master, buffer.data(), buffer.size());
+            auto readAt = Clock::now();
+            for (ssize_t i = 0; i < received; ++i) {
+                m_partial.push_back(buffer[static_cast<size_t>(i)]);
+                if (buffer[static_cast<size_t>(i)] != 0xFF)
+                    continue;
+
+                if (m_lastWrite > m_lastRead)
+                    m_turnaround.record(readAt - m_lastWrite);
+                m_lastRead = readAt;
+
+                auto arrival = std::max(readAt, m_txFreeAt) + MockCommunicator::wireTime(m_partial.size(), m_baudRate);
+                m_txFreeAt = arrival;
+                m_bytesIn += m_partial.size();
+                m_arriving.push_back({ arrival, std::move(m_partial) });
+                m_partial.clear();
+            }
+        }
+    }
+
+    const LatencyHistogram& turnaround() const { return m_turnaround; }
+    uint64_t bytesIn() const { return m_bytesIn; }
+    uint64_t bytesOut() const { return m_bytesOut; }
+
+private:
+    struct Frame {
+        Clock::time_point due;
+        std::vector<uint8_t> data;
+    };
+
+    CameraSimulator m_camera;
+    uint32_t m_baudRate;
+    int m_master { -1 };
+    std::string m_slaveName;
+    std::vector<uint8_t> m_partial;
+    std::deque<Frame> m_arriving;
+    std::deque<Frame> m_leaving;
+    Clock::time_point m_txFreeAt {};
+    Clock::time_point m_rxFreeAt {};
+    Clock::time_point m_lastWrite {};
+    Clock::time_point m_lastRead {};
+    LatencyHistogram m_turnaround;
+    uint64_t m_bytesIn { 0 };
+    uint64_t m_bytesOut { 0 };
+};
+
+struct Client {
+    int fd { -1 };
+    bool local { false }; ///< LocalProtocol over the Unix socket instead of VISCA-over-IP
+    uint32_t sequence { 0 };
+    bool inquiry { false };
+    Clock::time_point sent {};
+};
+
+bool sendRequest(Client& client)
+{
+    client.inquiry = !client.inquiry;
+    const Command command = client.inquiry ? Command::zoomPositionInquiry() : Command::zoomStop();
+    const auto& packet = command.packet();
+    std::vector<uint8_t> datagram;
+    if (client.local) {
+        datagram.push_back(static_cast<uint8_t>(LocalProtocol::MessageType::Packet));
+        datagram.insert(datagram.end(), packet.begin(), packet.end());
+    } else {
+        datagram = ViscaOverIp::encode(
+            ViscaOverIp::payloadTypeFor(packet.data(), packet.size()), ++client.sequence, packet.data(), packet.size());
+    }
+    client.sent = Clock::now();
+    return ::send(client.fd, datagram.data(), datagram.size(), 0) == static_cast<ssize_t>(datagram.size());
+}
+
+void printHistogram(const char* name, const LatencyHistogram& histogram)
+{
+    std::printf("  %-28s n=%-8llu mean %7.0f us  p50 %6.0f us  p99 %6.0f us  max %7.0f us  >=1ms %llu\n", name,
+        static_cast<unsigned long long>(histogram.count()), histogram.meanUs(), histogram.percentileUs(0.50),
+        histogram.percentileUs(0.99), histogram.maxUs(), static_cast<unsigned long long>(histogram.overLimit()));
+}
+}
+
+int main(int argc, char* argv[])
+{
+    int seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+    size_t clientCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+    uint32_t baudRate = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 38400;
+    bool local = argc > 4 && std::strcmp(argv[4], "unix") == 0;
+
+    Logger::instance().enableLogging(false);
+
+    CameraSimulator::Config camera;
+    camera.ackDelay = std::chrono::microseconds(200);
+    camera.commandTime = std::chrono::milliseconds(2);
+
+    LineCamera line(camera, baudRate);
+    if (!line.open()) {
+        std::fprintf(stderr, "Cannot create pseudo-terminal\n");
+        return 1;
+    }
+
+    GatewayServer::Options options;
+    options.bindAddress = "127.0.0.1";
+    options.viscaOverIpPort = 0;
+    options.ports.push_back({ line.slaveName(), baudRate });
+    char socketDir[] = "/tmp/visca-gateway-XXXXXX";
+    if (local) {
+        if (!::mkdtemp(socketDir)) {
+            std::fprintf(stderr, "Cannot create socket directory\n");
+            return 1;
+        }
+        options.unixSocketDir = socketDir;
+    }
+    auto gateway = std::make_unique<GatewayServer>(options);
+    if (!gateway->start()) {
+        std::fprintf(stderr, "Cannot start gateway on %s\n", line.slaveName().c_str());
+        return 1;
+    }
+    uint16_t port = gateway->stats(0).viscaOverIpPort;
+
+    std::atomic<bool> running { true };
+    std::thread cameraThread([&] { line.run(running); });
+    std::thread gatewayThread([&] {
+        while (running)
+            gateway->poll(10);
+    });
+
+    int epollFd = ::epoll_create1(0);
+    std::vector<Client> clients(clientCount);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    struct sockaddr_un localAddr;
+    std::memset(&localAddr, 0, sizeof(localAddr));
+    localAddr.sun_family = AF_UNIX;
+    std::string socketPath = std::string(socketDir) + line.slaveName().substr(line.slaveName().rfind('/')) + ".sock";
+    std::strncpy(localAddr.sun_path, socketPath.c_str(), sizeof(localAddr.sun_path) - 1);
+    for (size_t i = 0; i < clients.size(); ++i) {
+        clients[i].local = local;
+        if (local) {
+            clients[i].fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0);
+            ::connect(clients[i].fd, reinterpret_cast<struct sockaddr*>(&localAddr), sizeof(localAddr));
+        } else {
+            clients[i].fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+            ::connect(clients[i].fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+        }
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, clients[i].fd, &event);
+    }
+
+    std::printf("%zu %s clients, %u baud, %d s\n", clientCount, local ? "local" : "VISCA-over-IP", baudRate, seconds);
+    for (auto& client : clients)
+        sendRequest(client);
+
+    LatencyHistogram endToEnd;
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+    auto start = Clock::now();
+    auto end = start + std::chrono::seconds(seconds);
+    uint8_t buffer[256];
+
+    while (Clock::now() < end) {
+        struct epoll_event events[64];
+        int ready = ::epoll_wait(epollFd, events, 64, 100);
+        for (int i = 0; i < ready; ++i) {
+            Client& client = clients[events[i].data.u64];
+            ssize_t received;
+            while ((received = ::recv(client.fd, buffer, sizeof(buffer), 0)) > 0) {
+                const uint8_t* reply = buffer + 1;
+                if (!client.local) {
+                    ViscaOverIp::Header header;
+                    if (!ViscaOverIp::decode(buffer, static_cast<size_t>(received), header)
+                        || header.sequence != client.sequence)
+                        continue;
+                    reply = buffer + ViscaOverIp::HeaderSize;
+                } else if (received < 3 || buffer[0] != static_cast<uint8_t>(LocalProtocol::MessageType::Reply)) {
+                    continue;
+                }
+
+                // A command is done with its completion, an inquiry with its reply, either with an error
+                uint8_t type = reply[1] & 0xF0;
+                if (type == 0x40)
+                    continue;
+                if (type == 0x60)
+                    ++errors;
+                ++completed;
+                endToEnd.record(Clock::now() - client.sent);
+                sendRequest(client);
+            }
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    running = false;
+    gatewayThread.join();
+    cameraThread.join();
+    for (auto& client : clients)
+        ::close(client.fd);
+    ::close(epollFd);
+
+    auto stats = gateway->stats(0);
+    gateway.reset();
+    if (local)
+        ::rmdir(socketDir);
+    double lineBytesPerSecond = baudRate / 10.0;
+    std::printf("%.1f requests/s, %llu errors, %llu gateway timeouts\n", static_cast<double>(completed) / elapsed,
+        static_cast<unsigned long long>(errors),
+        static_cast<unsigned long long>(stats.arbiter.replyTimeouts + stats.arbiter.completionTimeouts));
+    std::printf("line utilisation: to camera %.1f%%, from camera %.1f%%\n",
+        100.0 * static_cast<double>(line.bytesIn()) / elapsed / lineBytesPerSecond,
+        100.0 * static_cast<double>(line.bytesOut()) / elapsed / lineBytesPerSecond);
+    printHistogram("gateway forward", stats.forward);
+    printHistogram("gateway reply", stats.reply);
+    printHistogram("line turnaround (2 pty hops)", line.turnaround());
+    printHistogram("client end to end", endToEnd);
+
+    bool pass = stats.forward.percentileUs(0.99) < 1000.0 && stats.reply.percentileUs(0.99) < 1000.0;
+    std::printf("added latency p99 under 1 ms: %s\n", pass ? "yes" : "NO");
+    return pass ? 0 : 1;
+}
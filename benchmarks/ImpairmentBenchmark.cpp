@@ -0,0 +1,135 @@
+/**
+ * @file ImpairmentBenchmark.cpp
+ * @brief Goodput and command latency of ViscaController over an increasingly impaired link.
+ *
+ * The controller talks to a MockCommunicator (simulated camera, fixed one-way latency) through an
+ * ImpairedCommunicator. At every level the drop, split, merge, duplicate ACK and bit error rates are scaled together
+ * and the jitter grows with them. Each level runs the same seeded command mix (zoom stop, zoom position inquiry) and
+ * reports successful commands per second and latency percentiles of the successful ones.
+ *
+ * Usage: ImpairmentBenchmark [commands per level] [response timeout ms] [seed]
+ */
+
+#include "Commands.h"
+#include "ImpairedCommunicator.h"
+#include "Logger.h"
+#include "MockCommunicator.h"
+#include "ViscaController.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Level {
+    double rate; ///< Base impairment probability
+    int jitterUs;
+};
+
+struct Result {
+    size_t succeeded { 0 };
+    size_t failed { 0 };
+    double seconds { 0 };
+    double p50Us { 0 };
+    double p99Us { 0 };
+    double maxUs { 0 };
+    ImpairedCommunicator::Stats stats;
+};
+
+double percentile(std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+Result runLevel(const Level& level, size_t commands, int timeoutMs, uint64_t seed)
+{
+    MockCommunicator::Config mock;
+    mock.latency = std::chrono::microseconds(500);
+    mock.camera.ackDelay = std::chrono::microseconds(200);
+    mock.camera.commandTime = std::chrono::microseconds(500);
+    mock.receiveTimeoutMs = 20;
+
+    ImpairedCommunicator::Config config;
+    config.seed = seed;
+    config.dropRate = level.rate;
+    config.splitRate = level.rate * 2;
+    config.mergeRate = level.rate * 2;
+    config.duplicateAckRate = level.rate * 2;
+    config.bitErrorRate = level.rate / 10;
+    config.jitter = std::chrono::microseconds(level.jitterUs);
+
+    auto impaired = std::make_unique<ImpairedCommunicator>(std::make_unique<MockCommunicator>(mock), config);
+    ImpairedCommunicator* link = impaired.get();
+
+    ViscaController camera(std::move(impaired));
+    camera.setResponseTimeout(timeoutMs);
+
+    Result result;
+    if (!camera.connect())
+        return result;
+
+    std::vector<double> latencies;
+    latencies.reserve(commands);
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < commands; ++i) {
+        const Command command = i % 2 == 0 ? Command::zoomStop() : Command::zoomPositionInquiry();
+        auto sent = Clock::now();
+        if (camera.execute(command)) {
+            ++result.succeeded;
+            latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent).count());
+        } else {
+            ++result.failed;
+        }
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.stats = link->stats();
+    camera.disconnect();
+
+    std::sort(latencies.begin(), latencies.end());
+    result.p50Us = percentile(latencies, 0.50);
+    result.p99Us = percentile(latencies, 0.99);
+    result.maxUs = latencies.empty() ? 0 : latencies.back();
+    return result;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    size_t commands = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    int timeoutMs = argc > 2 ? std::atoi(argv[2]) : 50;
+    uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+
+    Logger::instance().enableLogging(false);
+
+    const Level levels[] = { { 0.0, 0 }, { 0.001, 100 }, { 0.005, 250 }, { 0.01, 500 }, { 0.02, 1000 },
+        { 0.05, 2000 } };
+
+    std::printf("%zu commands per level, response timeout %d ms, seed %llu\n", commands, timeoutMs,
+        static_cast<unsigned long long>(seed));
+    std::printf("%8s %8s %10s %8s %10s %10s %10s %8s %8s %8s %8s\n", "drop", "jitter", "goodput/s", "failed",
+        "p50 us", "p99 us", "max us", "dropped", "dupAck", "split", "merged");
+
+    for (const auto& level : levels) {
+        Result result = runLevel(level, commands, timeoutMs, seed);
+        std::printf("%8.3f %6dus %10.1f %8zu %10.0f %10.0f %10.0f %8llu %8llu %8llu %8llu\n", level.rate,
+            level.jitterUs, result.seconds > 0 ? static_cast<double>(result.succeeded) / result.seconds : 0.0,
+            result.failed, result.p50Us, result.p99Us, result.maxUs,
+            static_cast<unsigned long long>(result.stats.dropped),
+            static_cast<unsigned long long>(result.stats.duplicated),
+            static_cast<unsigned long long>(result.stats.split), static_cast<unsigned long long>(result.stats.merged));
+        std::fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file IoEngineBenchmark.cpp
+ * @brief Compares the blocking TcpCommunicator path with the IoEngine backends over loopback.
+ *
+ * A responder thread answers every VISCA packet with an ACK and a completion. Each round sends one command to every
+ * endpoint and waits until both replies arrived on all of them. The blocking path does one send() and at least one
+ * recv() per endpoint per round, the engines batch the whole round.
+ *
+ * Usage: IoEngineBenchmark [endpoints] [rounds]
+ */
+
+#include "Commands.h"
+#include "IoEngine.h"
+#include "Logger.h"
+#include "TcpCommunicator.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+/**
+ * @brief Loopback camera stand-in: replies "90 41 FF 90 51 FF" to every 0xFF-terminated packet.
+ */
+class Responder {
+public:
+    bool start()
+    {
+        m_listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int opt = 1;
+        setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        if (::bind(m_listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(m_listenFd, 1024) < 0)
+            return false;
+
+        socklen_t len = sizeof(addr);
+        getsockname(m_listenFd, (struct sockaddr*)&addr, &len);
+        m_port = ntohs(addr.sin_port);
+
+        m_epollFd = ::epoll_create1(0);
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = m_listenFd;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &event);
+
+        m_running = true;
+        m_thread = std::thread(&Responder::run, this);
+        return true;
+    }
+
+    void stop()
+    {
+        m_running = false;
+        if (m_thread.joinable())
+            m_thread.join();
+        ::close(m_epollFd);
+        ::close(m_listenFd);
+    }
+
+    uint16_t port() const { return m_port; }
+
+private:
+    void run()
+    {
+        static const uint8_t reply[] = { 0x90, 0x41, 0xFF, 0x90, 0x51, 0xFF };
+        struct epoll_event events[64];
+        uint8_t buffer[4096];
+
+        while (m_running) {
+            int ready = epoll_wait(m_epollFd, events, 64, 50);
+            for (int i = 0; i < ready; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == m_listenFd) {
+                    int client = ::accept(m_listenFd, nullptr, nullptr);
+                    struct epoll_event event;
+                    event.events = EPOLLIN;
+                    event.data.fd = client;
+                    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, client, &event);
+                    continue;
+                }
+
+                ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+                if (received <= 0) {
+                    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                    ::close(fd);
+                    continue;
+                }
+                for (ssize_t j = 0; j < received; ++j) {
+                    if (buffer[j] == 0xFF)
+                        ::send(fd, reply, sizeof(reply), MSG_NOSIGNAL);
+                }
+            }
+        }
+    }
+
+    int m_listenFd { -1 };
+    int m_epollFd { -1 };
+    uint16_t m_port { 0 };
+    std::atomic<bool> m_running { false };
+    std::thread m_thread;
+};
+
+struct Result {
+    double wallSeconds { 0 };
+    double cpuSeconds { 0 };
+};
+
+double threadCpuSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+std::vector<std::unique_ptr<TcpCommunicator>> connectAll(uint16_t port, size_t endpoints)
+{
+    std::vector<std::unique_ptr<TcpCommunicator>> communicators;
+    for (size_t i = 0; i < endpoints; ++i) {
+        auto communicator = std::make_unique<TcpCommunicator>("127.0.0.1", port, NetworkMode::Client);
+        if (!communicator->open()) {
+            std::fprintf(stderr, "Failed to connect endpoint %zu\n", i);
+            return {};
+        }
+        communicators.push_back(std::move(communicator));
+    }
+    return communicators;
+}
+
+bool runBlocking(uint16_t port, size_t endpoints, size_t rounds, Result& result)
+{
+    auto communicators = connectAll(port, endpoints);
+    if (communicators.empty())
+        return false;
+
+    auto packet = Command::zoomStop().packet();
+    uint8_t buffer[256];
+
+    auto start = std::chrono::steady_clock::now();
+    double cpuStart = threadCpuSeconds();
+
+    for (size_t round = 0; round < rounds; ++round) {
+        for (auto& communicator : communicators)
+            communicator->send(packet);
+
+        for (auto& communicator : communicators) {
+            int terminators = 0;
+            while (terminators < 2) {
+                size_t received = communicator->receive(buffer, sizeof(buffer));
+                if (received == 0)
+                    return false;
+                for (size_t i = 0; i < received; ++i)
+                    terminators += buffer[i] == 0xFF ? 1 : 0;
+            }
+        }
+    }
+
+    result.cpuSeconds = threadCpuSeconds() - cpuStart;
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool runEngine(IoEngine::Backend backend, uint16_t port, size_t endpoints, size_t rounds, Result& result)
+{
+    auto engine = IoEngine::create(backend);
+    if (!engine)
+        return false;
+
+    auto communicators = connectAll(port, endpoints);
+    if (communicators.empty())
+        return false;
+
+    std::vector<int> terminators(endpoints, 0);
+    size_t completed = 0;
+    std::vector<int> ids;
+    for (auto& communicator : communicators) {
+        int id = engine->add(*communicator, [&](int endpoint, const uint8_t* data, size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                if (data[i] == 0xFF && ++terminators[static_cast<size_t>(endpoint)] == 2)
+                    ++completed;
+            }
+        });
+        if (id < 0)
+            return false;
+        ids.push_back(id);
+    }
+
+    auto packet = Command::zoomStop().packet();
+
+    auto start = std::chrono::steady_clock::now();
+    double cpuStart = threadCpuSeconds();
+
+    for (size_t round = 0; round < rounds; ++round) {
+        std::fill(terminators.begin(), terminators.end(), 0);
+        completed = 0;
+        for (int id : ids)
+            engine->send(id, packet);
+
+        while (completed < endpoints) {
+            if (engine->poll(1000) < 0)
+                return false;
+        }
+    }
+
+    result.cpuSeconds = threadCpuSeconds() - cpuStart;
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void report(const char* name, size_t endpoints, size_t rounds, const Result& result)
+{
+    double frames = static_cast<double>(endpoints * rounds * 2);
+    std::printf("%-10s %10.0f frames/s %10.2f us/round %10.0f ns CPU/frame\n", name, frames / result.wallSeconds,
+        result.wallSeconds * 1e6 / static_cast<double>(rounds), result.cpuSeconds * 1e9 / frames);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    size_t endpoints = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    size_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+
+    Logger::instance().setLevel(LogLevel::Warning);
+
+    Responder responder;
+    if (!responder.start()) {
+        std::fprintf(stderr, "Failed to start responder\n");
+        return 1;
+    }
+
+    std::printf("%zu endpoints, %zu rounds, 2 reply frames per command\n", endpoints, rounds);
+
+    Result result;
+    if (runBlocking(responder.port(), endpoints, rounds, result))
+        report("blocking", endpoints, rounds, result);
+    else
+        std::printf("%-10s failed\n", "blocking");
+
+    if (runEngine(IoEngine::Backend::Epoll, responder.port(), endpoints, rounds, result))
+        report("epoll", endpoints, rounds, result);
+    else
+        std::printf("%-10s failed\n", "epoll");
+
+    if (runEngine(IoEngine::Backend::IoUring, responder.port(), endpoints, rounds, result))
+        report("io_uring", endpoints, rounds, result);
+    else
+        std::printf("%-10s not available\n", "io_uring");
+
+    responder.stop();
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file LoggerBenchmark.cpp
+ * @brief Cost of one log call on the receive path: synchronous, asynchronous and binary logging.
+ *
+ * A thread stands in for ViscaController's receive thread: it logs the "Received: N bytes" debug line for every
+ * frame, with a little busy work in between, and times each VISCALOG_DEBUG call. The log goes to a file, as on a
+ * deployed gateway (undecoded in binary mode). Each mode reports the per-call latency percentiles, the messages
+ * dropped and how long the writer needed to catch up after the last call.
+ *
+ * Usage: LoggerBenchmark [calls] [work us between calls] [log file]
+ */
+
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Mode {
+    const char* name;
+    bool async;
+    LogOverflow overflow;
+    LogFormat format;
+};
+
+double percentile(std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void busyWait(std::chrono::nanoseconds duration)
+{
+    auto until = Clock::now() + duration;
+    while (Clock::now() < until) {
+    }
+}
+
+void run(const Mode& mode, size_t calls, std::chrono::nanoseconds work, const std::string& path)
+{
+    Logger& logger = Logger::instance();
+    logger.setOutputFile(path, false, mode.format);
+    logger.setLevel(LogLevel::Debug);
+    if (mode.async) {
+        Logger::AsyncOptions options;
+        options.overflow = mode.overflow;
+        logger.startAsync(options);
+    }
+    uint64_t dropped = logger.droppedMessages();
+
+    std::vector<double> latencies;
+    latencies.reserve(calls);
+    for (size_t i = 0; i < calls; ++i) {
+        size_t bytes = 3 + i % 8;
+        auto start = Clock::now();
+        VISCALOG_DEBUG("Received: " << bytes << " bytes");
+        latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        busyWait(work);
+    }
+
+    auto drainStart = Clock::now();
+    logger.flush();
+    double drainMs = std::chrono::duration<double, std::milli>(Clock::now() - drainStart).count();
+    logger.stopAsync();
+    logger.setOutputToConsole();
+
+    double sum = 0;
+    for (double latency : latencies)
+        sum += latency;
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%-14s %9.0f %9.0f %9.0f %10.0f %9llu %9.1f\n", mode.name, sum / static_cast<double>(calls),
+        percentile(latencies, 0.50), percentile(latencies, 0.99), latencies.back(),
+        static_cast<unsigned long long>(logger.droppedMessages() - dropped), drainMs);
+    std::fflush(stdout);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    size_t calls = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    int workUs = argc > 2 ? std::atoi(argv[2]) : 2;
+    std::string path = argc > 3 ? argv[3] : "LoggerBenchmark.log";
+
+    const Mode modes[] = { { "sync", false, LogOverflow::Drop, LogFormat::Text },
+        { "async/drop", true, LogOverflow::Drop, LogFormat::Text },
+        { "async/block", true, LogOverflow::Block, LogFormat::Text },
+        { "binary", false, LogOverflow::Drop, LogFormat::Binary } };
+
+    std::printf("%zu calls, %d us of work between calls, log file %s\n", calls, workUs, path.c_str());
+    std::printf("%-14s %9s %9s %9s %10s %9s %9s\n", "mode", "mean ns", "p50 ns", "p99 ns", "max ns", "dropped",
+        "drain ms");
+    for (const auto& mode : modes)
+        run(mode, calls, std::chrono::microseconds(workUs), path);
+
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,307 @@
+/**
+ * @file MicroBenchmark.cpp
+ * @brief Nanoseconds per call of the library's hot paths, no camera or network needed.
+ *
+ * Covers every Command builder, Response::parse() and the value decoders, RingBuffer push/pop alone and with threads
+ * contending for it, the UtilsCommon serialization and hex helpers, and a Logger call whose level is filtered out and
+ * one that is written (to a discarding stream). Each case runs in batches until the time budget is used, the batch
+ * with the lowest time per call is reported, so a one-off preemption does not show up as a regression. Run it before
+ * and after a change to the hot paths, on an otherwise idle machine.
+ *
+ * Usage: MicroBenchmark [filter] [ms per case]
+ */
+
+#include "Commands.h"
+#include "Logger.h"
+#include "RingBuffer.h"
+#include "UtilsCommon.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+std::string g_filter;
+std::chrono::milliseconds g_budget { 200 };
+
+// Keeps the optimizer from dropping a computation whose result is otherwise unused
+template <typename T> void keep(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct NullBuffer : std::streambuf {
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+/**
+ * @brief Time body(iterations) in growing batches, print the best ns per iteration.
+ */
+void bench(const std::string& name, const std::function<void(size_t)>& body)
+{
+    if (!g_filter.empty() && name.find(g_filter) == std::string::npos)
+        return;
+
+    size_t batch = 16;
+    double best = 1e30;
+    auto deadline = Clock::now() + g_budget;
+    while (Clock::now() < deadline) {
+        auto start = Clock::now();
+        body(batch);
+        double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        best = std::min(best, elapsed / static_cast<double>(batch));
+        if (elapsed < 1e6 && batch < (size_t(1) << 24))
+            batch *= 2; // Batches of about a millisecond keep the clock reads out of the result
+    }
+    std::printf("%-40s %10.1f\n", name.c_str(), best);
+    std::fflush(stdout);
+}
+
+void benchCommands()
+{
+    const struct {
+        const char* name;
+        Command (*build)();
+    } builders[] = {
+        { "powerOn", [] { return Command::powerOn(); } },
+        { "powerOff", [] { return Command::powerOff(); } },
+        { "powerInquiry", [] { return Command::powerInquiry(); } },
+        { "zoomStop", [] { return Command::zoomStop(); } },
+        { "zoomTeleStandard", [] { return Command::zoomTeleStandard(); } },
+        { "zoomWideStandard", [] { return Command::zoomWideStandard(); } },
+        { "zoomTeleVariable", [] { return Command::zoomTeleVariable(1, 5); } },
+        { "zoomWideVariable", [] { return Command::zoomWideVariable(1, 5); } },
+        { "zoomDirect", [] { return Command::zoomDirect(1, 0x1234); } },
+        { "zoomPositionInquiry", [] { return Command::zoomPositionInquiry(); } },
+        { "focusStop", [] { return Command::focusStop(); } },
+        { "focusFarStandard", [] { return Command::focusFarStandard(); } },
+        { "focusNearStandard", [] { return Command::focusNearStandard(); } },
+        { "focusFarVariable", [] { return Command::focusFarVariable(1, 5); } },
+        { "focusNearVariable", [] { return Command::focusNearVariable(1, 5); } },
+        { "focusDirect", [] { return Command::focusDirect(1, 0x1234); } },
+        { "focusAuto", [] { return Command::focusAuto(); } },
+        { "focusManual", [] { return Command::focusManual(); } },
+        { "focusOnePushTrigger", [] { return Command::focusOnePushTrigger(); } },
+        { "focusPositionInquiry", [] { return Command::focusPositionInquiry(); } },
+        { "versionInquiry", [] { return Command::versionInquiry(); } },
+    };
+
+    for (const auto& builder : builders) {
+        bench(std::string("Command::") + builder.name, [&builder](size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                Command cmd = builder.build();
+                keep(cmd);
+            }
+        });
+    }
+}
+
+void benchResponses()
+{
+    const struct {
+        const char* name;
+        std::vector<uint8_t> frame;
+    } frames[] = {
+        { "ack", { 0x90, 0x41, 0xFF } },
+        { "completion", { 0x90, 0x51, 0xFF } },
+        { "error", { 0x90, 0x61, 0x41, 0xFF } },
+        { "zoom reply", { 0x90, 0x50, 0x01, 0x02, 0x03, 0x04, 0xFF } },
+        { "version reply", { 0x90, 0x50, 0x00, 0x20, 0x07, 0x13, 0x01, 0x00, 0x02, 0xFF } },
+    };
+
+    for (const auto& frame : frames) {
+        bench(std::string("Response::parse ") + frame.name, [&frame](size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                Response response;
+                bool ok = response.parse(frame.frame);
+                keep(ok);
+            }
+        });
+    }
+
+    Response zoom;
+    zoom.parse(frames[3].frame);
+    bench("Response::getZoomPosition", [&zoom](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            uint16_t position = zoom.getZoomPosition();
+            keep(position);
+        }
+    });
+    bench("Response::getValue<uint32_t>", [&zoom](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t value = zoom.getValue<uint32_t>(2);
+            keep(value);
+        }
+    });
+
+    Response error;
+    error.parse(frames[2].frame);
+    bench("Response::errorString", [&error](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            std::string text = error.errorString();
+            keep(text);
+        }
+    });
+}
+
+/**
+ * @brief Items through one RingBuffer shared by producers and consumers, ns per item.
+ */
+void benchRingBufferContention(size_t producers, size_t consumers)
+{
+    std::string name = "RingBuffer " + std::to_string(producers) + "P/" + std::to_string(consumers) + "C per item";
+    bench(name, [producers, consumers](size_t n) {
+        RingBuffer<std::vector<uint8_t>, 64> buffer;
+        std::atomic<size_t> consumed { 0 };
+        size_t perProducer = (n + producers - 1) / producers;
+        size_t total = perProducer * producers;
+
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&buffer, perProducer] {
+                for (size_t i = 0; i < perProducer; ++i) {
+                    std::vector<uint8_t> frame { 0x90, 0x41, 0xFF };
+                    while (!buffer.push(std::move(frame)))
+                        std::this_thread::yield();
+                }
+            });
+        }
+        for (size_t c = 0; c < consumers; ++c) {
+            threads.emplace_back([&buffer, &consumed, total] {
+                std::vector<uint8_t> frame;
+                while (consumed.load(std::memory_order_relaxed) < total) {
+                    if (buffer.pop(frame))
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    else
+                        std::this_thread::yield();
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+    });
+}
+
+void benchRingBuffer()
+{
+    RingBuffer<std::vector<uint8_t>, 64> buffer;
+    bench("RingBuffer push+pop", [&buffer](size_t n) {
+        std::vector<uint8_t> frame;
+        for (size_t i = 0; i < n; ++i) {
+            buffer.push(std::vector<uint8_t> { 0x90, 0x41, 0xFF });
+            buffer.pop(frame);
+        }
+        keep(frame);
+    });
+
+    benchRingBufferContention(1, 1);
+    benchRingBufferContention(2, 2);
+    benchRingBufferContention(4, 1);
+}
+
+void benchUtils()
+{
+    std::vector<uint8_t> packet { 0x81, 0x01, 0x04, 0x47, 0x01, 0x02, 0x03, 0x04, 0xFF };
+
+    bench("UtilsCommon::SerializeNumericValues<u32>", [](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            auto bytes = UtilsCommon::SerializeNumericValues<uint32_t>(static_cast<uint32_t>(i), true);
+            keep(bytes);
+        }
+    });
+    bench("UtilsCommon::SerializeNumericValueAppend", [](size_t n) {
+        std::vector<uint8_t> out;
+        out.reserve(64);
+        for (size_t i = 0; i < n; ++i) {
+            out.clear();
+            UtilsCommon::SerializeNumericValueAppendToVector<uint16_t>(static_cast<uint16_t>(i), out, true);
+            keep(out);
+        }
+    });
+    bench("UtilsCommon::DeserializeNumericValues<u32>", [&packet](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t value = UtilsCommon::DeserializeNumericValues<uint32_t>(packet, true);
+            keep(value);
+        }
+    });
+    bench("UtilsCommon::bytesToHex 9 bytes", [&packet](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            std::string text = UtilsCommon::bytesToHex(packet);
+            keep(text);
+        }
+    });
+    bench("UtilsCommon::toHex<u16>", [](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            std::string text = UtilsCommon::toHex(static_cast<uint16_t>(i));
+            keep(text);
+        }
+    });
+    bench("UtilsCommon::UnsignedNumberToHexString", [](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            std::string text = UtilsCommon::UnsignedNumberToHexString(static_cast<uint32_t>(i));
+            keep(text);
+        }
+    });
+}
+
+void benchLogger()
+{
+    NullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+    Logger& logger = Logger::instance();
+    logger.setOutput(&nullStream);
+
+    logger.setLevel(LogLevel::Info);
+    bench("Logger debug line, filtered", [](size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            VISCALOG_DEBUG("Received: " << i << " bytes");
+    });
+
+    logger.setLevel(LogLevel::Debug);
+    bench("Logger debug line, written", [](size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            VISCALOG_DEBUG("Received: " << i << " bytes");
+    });
+    bench("Logger::log preformatted, written", [&logger](size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            logger.log(LogLevel::Debug, __FILE__, __FUNCTION__, __LINE__, std::string("Received: 3 bytes"));
+    });
+
+    logger.setOutputToConsole();
+    logger.setLevel(LogLevel::Info);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        g_filter = argv[1];
+    if (argc > 2)
+        g_budget = std::chrono::milliseconds(std::atoi(argv[2]));
+
+    std::printf("%-40s %10s\n", "case", "ns/op");
+    benchCommands();
+    benchResponses();
+    benchRingBuffer();
+    benchUtils();
+    benchLogger();
+    return 0;
+}
@@ -0,0 +1,364 @@
+/**
+ * @file RoundTripBenchmark.cpp
+ * @brief What ViscaController delivers end to end against simulated cameras over loopback TCP, UDP and ptys.
+ *
+ * A SimulatorServer thread serves one camera per client thread; each client owns a ViscaController on its own camera
+ * and runs execute() back to back for the duration of the case. The sweep covers the transports, the number of
+ * concurrent controllers, the command mix (zoom stop: ACK and completion, zoom position inquiry: one reply, or both
+ * in turn) and an emulated serial line: at a non-zero baud rate every packet and reply takes its wire time (10 bit
+ * times per byte) on top of the transport. The cameras answer at once unless --camera-delay-us is given, so the
+ * numbers are the library's and the kernel's.
+ *
+ * Each case prints one line, JSON (default) or CSV, with commands/s, latency percentiles of execute() and the CPU
+ * time per command of the process without the simulator thread, so the output of two builds can be compared.
+ *
+ * Usage: RoundTripBenchmark [--seconds S] [--transports tcp,udp,pty] [--concurrency 1,4,16]
+ *                           [--mix command,inquiry,mixed] [--baud 0,38400] [--camera-delay-us US]
+ *                           [--port N] [--format json|csv]
+ */
+
+#include "Commands.h"
+#include "ControllerMetrics.h"
+#include "Logger.h"
+#include "SerialCommunicator.h"
+#include "SimulatorServer.h"
+#include "TcpCommunicator.h"
+#include "UdpCommunicator.h"
+#include "ViscaController.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+enum class Mix { Command, Inquiry, Mixed };
+
+struct Case {
+    SimulatorServer::Transport transport;
+    size_t concurrency;
+    Mix mix;
+    uint32_t baudRate;
+};
+
+struct Settings {
+    std::chrono::milliseconds duration { 2000 };
+    std::chrono::microseconds cameraDelay { 0 };
+    uint16_t port { 25678 };
+    bool csv { false };
+};
+
+const char* mixName(Mix mix)
+{
+    switch (mix) {
+    case Mix::Command:
+        return "command";
+    case Mix::Inquiry:
+        return "inquiry";
+    default:
+        return "mixed";
+    }
+}
+
+std::vector<std::string> split(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+        items.push_back(item);
+    return items;
+}
+
+uint64_t cpuNs(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @brief Decorator holding packets and replies for their wire time, like a serial line at baudRate.
+ *
+ * send() sleeps until the previous packet and this one are through the line, so the camera gets the packet when its
+ * last byte would arrive; receive() releases bytes once they would have come in after the ones before them.
+ */
+class PacedCommunicator : public ICommunicator {
+public:
+    PacedCommunicator(std::unique_ptr<ICommunicator> inner, uint32_t baudRate)
+        : m_inner(std::move(inner))
+        , m_baudRate(baudRate)
+    {
+    }
+
+    bool open() override { return m_inner->open(); }
+
+    using ICommunicator::send;
+    bool send(Span<const uint8_t> data) override
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        m_txFreeAt = std::max(m_txFreeAt, Clock::now()) + wireTime(data.size());
+        std::this_thread::sleep_until(m_txFreeAt);
+        return m_inner->send(data);
+    }
+
+    size_t receive(uint8_t* buffer, size_t maxSize) override
+    {
+        size_t received = m_inner->receive(buffer, maxSize);
+        if (received > 0) {
+            m_rxFreeAt = std::max(m_rxFreeAt, Clock::now()) + wireTime(received);
+            std::this_thread::sleep_until(m_rxFreeAt);
+        }
+        return received;
+    }
+
+    int nativeHandle() const override { return m_inner->nativeHandle(); }
+    bool isOpen() const override { return m_inner->isOpen(); }
+    void close() override { m_inner->close(); }
+
+private:
+    Clock::duration wireTime(size_t bytes) const
+    {
+        return std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(bytes) * 10.0 / m_baudRate));
+    }
+
+    std::unique_ptr<ICommunicator> m_inner;
+    uint32_t m_baudRate;
+    std::mutex m_sendMutex;
+    Clock::time_point m_txFreeAt {};
+    Clock::time_point m_rxFreeAt {}; ///< Receive thread only
+};
+
+std::unique_ptr<ICommunicator> makeCommunicator(
+    const Case& c, const SimulatorServer::CameraStats& camera, uint16_t port)
+{
+    std::unique_ptr<ICommunicator> communicator;
+    switch (c.transport) {
+    case SimulatorServer::Transport::Tcp:
+        communicator.reset(new TcpCommunicator("127.0.0.1", port, NetworkMode::Client));
+        break;
+    case SimulatorServer::Transport::Udp:
+        communicator.reset(new UdpCommunicator("127.0.0.1", port, NetworkMode::Client));
+        break;
+    default:
+        communicator.reset(new SerialCommunicator(camera.endpoint, c.baudRate > 0 ? c.baudRate : 9600));
+        break;
+    }
+    if (c.baudRate > 0)
+        communicator.reset(new PacedCommunicator(std::move(communicator), c.baudRate));
+    return communicator;
+}
+
+bool run(const Case& c, const Settings& settings, uint16_t port)
+{
+    SimulatorServer::Options options;
+    options.camera.ackDelay = settings.cameraDelay;
+    options.camera.commandTime = settings.cameraDelay;
+    options.camera.maxSocket = 2;
+    if (c.transport == SimulatorServer::Transport::Tcp) {
+        options.tcpCount = c.concurrency;
+        options.tcpPort = port;
+    } else if (c.transport == SimulatorServer::Transport::Udp) {
+        options.udpCount = c.concurrency;
+        options.udpPort = port;
+    } else {
+        options.ptyCount = c.concurrency;
+    }
+
+    SimulatorServer server(options);
+    if (!server.start()) {
+        std::cerr << "Cannot start the simulator for " << SimulatorServer::transportName(c.transport) << std::endl;
+        return false;
+    }
+
+    std::atomic<bool> serving { true };
+    std::thread simulator([&server, &serving] {
+        while (serving)
+            server.poll(10);
+    });
+    clockid_t simulatorClock;
+    pthread_getcpuclockid(simulator.native_handle(), &simulatorClock);
+
+    std::vector<std::unique_ptr<ViscaController>> controllers;
+    bool connected = true;
+    for (size_t i = 0; i < c.concurrency && connected; ++i) {
+        auto cameraPort = static_cast<uint16_t>(port + i);
+        controllers.emplace_back(new ViscaController(makeCommunicator(c, server.stats(i), cameraPort)));
+        controllers.back()->setFailureDumpFrames(0);
+        connected = controllers.back()->connect();
+        // Warm up the link and the camera
+        for (int w = 0; w < 10 && connected; ++w)
+            controllers.back()->execute(Command::zoomStop());
+    }
+
+    HdrHistogram latency;
+    std::atomic<uint64_t> commands { 0 };
+    std::atomic<uint64_t> errors { 0 };
+    std::atomic<bool> go { false };
+    auto wallStart = Clock::now();
+    uint64_t cpuStart = cpuNs(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t simulatorCpuStart = cpuNs(simulatorClock);
+
+    std::vector<std::thread> clients;
+    if (connected) {
+        for (auto& controller : controllers) {
+            clients.emplace_back([&, camera = controller.get()] {
+                while (!go)
+                    std::this_thread::yield();
+                auto deadline = Clock::now() + settings.duration;
+                for (uint64_t n = 0; Clock::now() < deadline; ++n) {
+                    bool inquiry = c.mix == Mix::Inquiry || (c.mix == Mix::Mixed && n % 2 == 1);
+                    auto start = Clock::now();
+                    bool ok = camera->execute(inquiry ? Command::zoomPositionInquiry() : Command::zoomStop());
+                    latency.record(Clock::now() - start);
+                    commands.fetch_add(1, std::memory_order_relaxed);
+                    if (!ok)
+                        errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+        wallStart = Clock::now();
+        cpuStart = cpuNs(CLOCK_PROCESS_CPUTIME_ID);
+        simulatorCpuStart = cpuNs(simulatorClock);
+        go = true;
+        for (auto& client : clients)
+            client.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - wallStart).count();
+    uint64_t cpuUsed = cpuNs(CLOCK_PROCESS_CPUTIME_ID) - cpuStart;
+    uint64_t simulatorCpu = cpuNs(simulatorClock) - simulatorCpuStart;
+
+    for (auto& controller : controllers)
+        controller->disconnect();
+    serving = false;
+    simulator.join();
+
+    if (!connected) {
+        std::cerr << "Cannot connect over " << SimulatorServer::transportName(c.transport) << std::endl;
+        return false;
+    }
+
+    uint64_t clientCpu = cpuUsed > simulatorCpu ? cpuUsed - simulatorCpu : 0;
+    auto snapshot = latency.snapshot();
+    uint64_t count = commands.load();
+    double rate = seconds > 0 ? static_cast<double>(count) / seconds : 0;
+    double cpuPerCommandUs = count ? static_cast<double>(clientCpu) / static_cast<double>(count) / 1000.0 : 0;
+
+    const char* format = settings.csv
+        ? "%s,%zu,%s,%u,%.3f,%llu,%llu,%.0f,%.1f,%.1f,%.1f,%.1f,%.2f\n"
+        : "{\"transport\":\"%s\",\"concurrency\":%zu,\"mix\":\"%s\",\"baud\":%u,\"seconds\":%.3f,\"commands\":%llu,"
+          "\"errors\":%llu,\"commands_per_s\":%.0f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f,"
+          "\"cpu_us_per_command\":%.2f}\n";
+    std::printf(format, SimulatorServer::transportName(c.transport), c.concurrency, mixName(c.mix), c.baudRate,
+        seconds, static_cast<unsigned long long>(count), static_cast<unsigned long long>(errors.load()), rate,
+        snapshot.percentileNs(0.50) / 1000.0, snapshot.percentileNs(0.99) / 1000.0,
+        snapshot.percentileNs(0.999) / 1000.0, snapshot.maxNs / 1000.0, cpuPerCommandUs);
+    std::fflush(stdout);
+    return true;
+}
+
+void printUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --seconds S           Duration of each case (default 2)\n"
+              << "  --transports LIST     Of tcp, udp, pty (default tcp,udp,pty)\n"
+              << "  --concurrency LIST    Controllers running at once, one camera each (default 1,4,16)\n"
+              << "  --mix LIST            Of command, inquiry, mixed (default mixed)\n"
+              << "  --baud LIST           Emulated serial line, 0 for none (default 0)\n"
+              << "  --camera-delay-us US  Camera time to ACK, reply and completion (default 0)\n"
+              << "  --port N              First TCP/UDP port of the cameras (default 25678)\n"
+              << "  --format json|csv     Output format (default json, one object per line)\n";
+}
+}
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+    std::vector<std::string> transports { "tcp", "udp", "pty" };
+    std::vector<std::string> concurrency { "1", "4", "16" };
+    std::vector<std::string> mixes { "mixed" };
+    std::vector<std::string> bauds { "0" };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else if (arg == "--seconds") {
+            settings.duration = std::chrono::milliseconds(static_cast<int>(std::atof(argv[++i]) * 1000));
+        } else if (arg == "--transports") {
+            transports = split(argv[++i]);
+        } else if (arg == "--concurrency") {
+            concurrency = split(argv[++i]);
+        } else if (arg == "--mix") {
+            mixes = split(argv[++i]);
+        } else if (arg == "--baud") {
+            bauds = split(argv[++i]);
+        } else if (arg == "--camera-delay-us") {
+            settings.cameraDelay = std::chrono::microseconds(std::atoi(argv[++i]));
+        } else if (arg == "--port") {
+            settings.port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (arg == "--format") {
+            settings.csv = std::string(argv[++i]) == "csv";
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Case> cases;
+    for (const auto& transport : transports) {
+        SimulatorServer::Transport t;
+        if (transport == "tcp")
+            t = SimulatorServer::Transport::Tcp;
+        else if (transport == "udp")
+            t = SimulatorServer::Transport::Udp;
+        else if (transport == "pty")
+            t = SimulatorServer::Transport::Pty;
+        else {
+            std::cerr << "Unknown transport: " << transport << std::endl;
+            return 1;
+        }
+        for (const auto& mix : mixes) {
+            Mix m = mix == "command" ? Mix::Command : mix == "inquiry" ? Mix::Inquiry : Mix::Mixed;
+            for (const auto& baud : bauds) {
+                for (const auto& n : concurrency)
+                    cases.push_back({ t, std::stoul(n), m, static_cast<uint32_t>(std::stoul(baud)) });
+            }
+        }
+    }
+
+    Logger::instance().setLevel(LogLevel::Error);
+    if (settings.csv)
+        std::printf("transport,concurrency,mix,baud,seconds,commands,errors,commands_per_s,p50_us,p99_us,p999_us,"
+                    "max_us,cpu_us_per_command\n");
+
+    // Every case gets fresh ports, sockets of the previous one may linger
+    uint16_t port = settings.port;
+    bool ok = true;
+    for (const auto& c : cases) {
+        ok = run(c, settings, port) && ok;
+        port = static_cast<uint16_t>(port + c.concurrency);
+    }
+    return ok ? 0 : 1;
+}
@@ -6,6 +6,14 @@ if(BUILD_TESTS)
     find_package(GTest QUIET)
     find_package(GMock QUIET)
 
+    # Newer CMake FindGTest provides GTest::gmock itself, there is no separate GMock package then
+    if(GTEST_FOUND AND NOT GMOCK_FOUND AND TARGET GTest::gmock)
+        set(GMOCK_FOUND TRUE)
+        set(VISCA_GMOCK_TARGET GTest::gmock)
+    else()
+        set(VISCA_GMOCK_TARGET GMock::GMock)
+    endif()
+
     if(GTEST_FOUND AND GMOCK_FOUND)
         message(STATUS "Using system GoogleTest")
         # Add the same function as above but using system libraries
@@ -16,7 +24,7 @@ if(BUILD_TESTS)
                     ${LINK_LIBRARIES}
                     GTest::GTest
                     GTest::Main
-                    GMock::GMock
+                    ${VISCA_GMOCK_TARGET}
             )
             target_include_directories(${TEST_NAME}
                 PRIVATE
@@ -0,0 +1,119 @@
+#include "BaudDetector.h"
+#include "Commands.h"
+#include "Discovery.h"
+#include "Logger.h"
+#include "SerialCommunicator.h"
+
+#include <algorithm>
+
+namespace Visca {
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t MaxReplySize = 16;
+    constexpr size_t VersionReplySize = 10;
+}
+
+BaudDetector::BaudDetector(const Options& options)
+    : m_options(options)
+{
+}
+
+BaudDetector::Result BaudDetector::run(SerialCommunicator& port) const
+{
+    Result result;
+    const auto start = Clock::now();
+    const uint32_t original = port.baudRate();
+
+    for (uint32_t baudRate : m_options.baudRates) {
+        if (!port.setBaudRate(baudRate))
+            continue;
+
+        for (int attempt = 0; attempt < std::max(m_options.attempts, 1); ++attempt) {
+            ++result.probes;
+            if (!probe(port, result.reply))
+                continue;
+
+            result.found = true;
+            result.baudRate = baudRate;
+            DiscoveredCamera camera;
+            if (Discovery::parseVersionReply(result.reply.data(), result.reply.size(), camera)) {
+                result.versionReply = true;
+                result.vendorId = camera.vendorId;
+                result.modelId = camera.modelId;
+                result.romRevision = camera.romRevision;
+            }
+            break;
+        }
+        if (result.found)
+            break;
+        VISCALOG_DEBUG("BaudDetector: No answer at " << baudRate << " baud");
+    }
+
+    if (!result.found) {
+        port.setBaudRate(original);
+        result.baudRate = original;
+        result.reply.clear();
+    }
+    result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+    return result;
+}
+
+bool BaudDetector::probe(SerialCommunicator& port, std::vector<uint8_t>& reply) const
+{
+    const auto packet = Command::versionInquiry(m_options.cameraAddress).packet();
+    if (!port.send(packet))
+        return false;
+
+    const auto deadline = Clock::now() + std::chrono::milliseconds(probeTimeoutMs(port.baudRate()));
+    uint8_t buffer[64];
+    std::vector<uint8_t> frame;
+
+    for (auto now = Clock::now(); now < deadline; now = Clock::now()) {
+        int remaining = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count());
+        size_t received = port.receive(buffer, sizeof(buffer), remaining);
+
+        // Bytes at a wrong rate are noise, which may contain 0xFF; only a well-formed reply ends the search
+        for (size_t i = 0; i < received; ++i) {
+            frame.push_back(buffer[i]);
+            if (buffer[i] != 0xFF) {
+                if (frame.size() >= MaxReplySize)
+                    frame.clear();
+                continue;
+            }
+            if (isReply(frame.data(), frame.size(), m_options.cameraAddress)) {
+                reply = frame;
+                return true;
+            }
+            frame.clear();
+        }
+    }
+    return false;
+}
+
+int BaudDetector::probeTimeoutMs(uint32_t baudRate) const
+{
+    if (baudRate == 0)
+        return m_options.replyMarginMs;
+
+    // 10 bit times per byte, for the inquiry and its reply
+    const size_t bytes = Command::versionInquiry(m_options.cameraAddress).packet().size() + VersionReplySize;
+    const auto wireMs = static_cast<int>((bytes * 10 * 1000 + baudRate - 1) / baudRate);
+    return wireMs + m_options.replyMarginMs;
+}
+
+bool BaudDetector::isReply(const uint8_t* frame, size_t size, uint8_t address)
+{
+    if (!frame || size < 3 || size > MaxReplySize || frame[size - 1] != 0xFF)
+        return false;
+    if (frame[0] != static_cast<uint8_t>((address + 8) << 4))
+        return false;
+
+    // ACK, completion or inquiry reply, error
+    const uint8_t type = frame[1] & 0xF0;
+    if (type != 0x40 && type != 0x50 && type != 0x60)
+        return false;
+    return std::find(frame, frame + size - 1, 0xFF) == frame + size - 1;
+}
+
+}
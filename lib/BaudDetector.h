@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Export.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Visca {
+
+class SerialCommunicator;
+
+/**
+ * @brief Finds the baud rate of a serial camera and whether one is connected at all.
+ *
+ * Each candidate rate gets one version inquiry (8x 09 00 02 FF). The wait for the answer is as short as the line
+ * allows: the wire time of the inquiry and of its 10 byte reply at that rate plus a fixed margin for the camera to
+ * respond, and the search ends on the first well-formed reply. A camera that was sent garbage at a wrong rate may
+ * answer with a syntax error instead, that counts as found too. Trying all common rates takes a few hundred
+ * milliseconds at most, the usual 9600 baud camera is found in about 40.
+ */
+class VISCA_EXPORT BaudDetector {
+public:
+    struct Options {
+        std::vector<uint32_t> baudRates { 9600, 38400, 19200, 115200, 4800, 57600, 2400 }; ///< Tried in this order
+        uint8_t cameraAddress { 1 };
+        int replyMarginMs { 30 }; ///< Camera response time added to the wire time of probe and reply
+        int attempts { 1 }; ///< Probes per rate
+    };
+
+    struct Result {
+        bool found { false };
+        uint32_t baudRate { 0 }; ///< The port is left at this rate, or at its original one if nothing answered
+        std::vector<uint8_t> reply; ///< The frame that answered the probe
+        bool versionReply { false }; ///< reply is a version inquiry reply, the ids below are valid
+        uint16_t vendorId { 0 };
+        uint16_t modelId { 0 };
+        uint32_t romRevision { 0 };
+        size_t probes { 0 };
+        std::chrono::milliseconds elapsed { 0 };
+    };
+
+    BaudDetector() = default;
+    explicit BaudDetector(const Options& options);
+
+    void setOptions(const Options& options) { m_options = options; }
+    const Options& options() const { return m_options; }
+
+    /**
+     * @brief Probe the candidate rates on an open port.
+     */
+    Result run(SerialCommunicator& port) const;
+
+    /**
+     * @brief Presence check: one probe at the port's current rate.
+     * @param reply Receives the answering frame.
+     * @return true if a camera answered.
+     */
+    bool probe(SerialCommunicator& port, std::vector<uint8_t>& reply) const;
+
+    /**
+     * @brief Time to wait for the answer to a probe at a baud rate.
+     */
+    int probeTimeoutMs(uint32_t baudRate) const;
+
+    /**
+     * @brief Whether frame is a reply of the camera at address: y0 followed by 1-14 bytes and the 0xFF terminator.
+     */
+    static bool isReply(const uint8_t* frame, size_t size, uint8_t address);
+
+private:
+    Options m_options;
+};
+
+}
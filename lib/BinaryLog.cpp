@@ -0,0 +1,593 @@
+#include "BinaryLog.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+
+namespace Visca {
+
+namespace {
+    std::atomic<uint32_t> s_nextSiteId { 0 };
+
+    void putLe(uint8_t* out, uint64_t value, size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i)
+            out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+
+    uint64_t getLe(const uint8_t* in, size_t bytes)
+    {
+        uint64_t value = 0;
+        for (size_t i = bytes; i > 0; --i)
+            value = (value << 8) | in[i - 1];
+        return value;
+    }
+
+    uint64_t monotonicNs()
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    void appendLe(std::vector<uint8_t>& out, uint64_t value, size_t bytes)
+    {
+        size_t at = out.size();
+        out.resize(at + bytes);
+        putLe(out.data() + at, value, bytes);
+    }
+
+    void appendString(std::vector<uint8_t>& out, const char* text)
+    {
+        size_t length = std::min<size_t>(std::strlen(text), 0xFFFF);
+        appendLe(out, length, 2);
+        out.insert(out.end(), text, text + length);
+    }
+
+    /**
+     * @brief Bounds-checked walk over a record.
+     */
+    class Cursor {
+    public:
+        Cursor(const uint8_t* data, size_t size)
+            : m_data(data)
+            , m_size(size)
+        {
+        }
+
+        bool read(uint64_t& value, size_t bytes)
+        {
+            if (m_offset + bytes > m_size)
+                return false;
+            value = getLe(m_data + m_offset, bytes);
+            m_offset += bytes;
+            return true;
+        }
+
+        bool readBytes(const uint8_t*& data, size_t& size)
+        {
+            uint64_t length = 0;
+            if (!read(length, 2) || m_offset + length > m_size)
+                return false;
+            data = m_data + m_offset;
+            size = static_cast<size_t>(length);
+            m_offset += size;
+            return true;
+        }
+
+        bool readString(std::string& text)
+        {
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+            if (!readBytes(data, size))
+                return false;
+            text.assign(reinterpret_cast<const char*>(data), size);
+            return true;
+        }
+
+        bool atEnd() const { return m_offset >= m_size; }
+        size_t offset() const { return m_offset; }
+
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+        size_t m_offset { 0 };
+    };
+
+    const char* baseName(const std::string& path)
+    {
+        size_t slash = path.find_last_of("/\\");
+        return path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+    }
+}
+
+LogSite::LogSite(LogLevel level, const char* file, const char* function, int line)
+    : level(level)
+    , file(file)
+    , function(function)
+    , line(line)
+    , id(s_nextSiteId.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+BinaryLogRecord::BinaryLogRecord(const LogSite& site)
+    : m_site(&site)
+    , m_timestampNs(monotonicNs())
+{
+}
+
+BinaryLogRecord& BinaryLogRecord::operator<<(const char* text)
+{
+    if (!text)
+        text = "(null)";
+    return putBytes(BinaryLogFormat::ArgType::String, text, std::strlen(text));
+}
+
+BinaryLogRecord& BinaryLogRecord::operator<<(const void* pointer)
+{
+    if (reserve(9)) {
+        m_args[m_size] = static_cast<uint8_t>(BinaryLogFormat::ArgType::Pointer);
+        putLe(m_args + m_size + 1, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pointer)), 8);
+        m_size += 9;
+    }
+    return *this;
+}
+
+BinaryLogRecord& BinaryLogRecord::operator<<(const LogHex& hex)
+{
+    return putBytes(BinaryLogFormat::ArgType::Bytes, hex.data, hex.size);
+}
+
+BinaryLogRecord& BinaryLogRecord::operator<<(std::ios_base& (*manipulator)(std::ios_base&))
+{
+    // Only the integer base is kept, other flags change nothing in the decoded text
+    if (manipulator == static_cast<std::ios_base& (*)(std::ios_base&)>(std::hex))
+        m_hex = true;
+    else if (manipulator == static_cast<std::ios_base& (*)(std::ios_base&)>(std::dec))
+        m_hex = false;
+    return *this;
+}
+
+BinaryLogRecord& BinaryLogRecord::operator<<(std::ostream& (*manipulator)(std::ostream&))
+{
+    if (manipulator == static_cast<std::ostream& (*)(std::ostream&)>(std::endl))
+        return putChar('\n');
+    return *this;
+}
+
+BinaryLogRecord& BinaryLogRecord::putInteger(BinaryLogFormat::ArgType type, uint64_t value)
+{
+    if (reserve(9)) {
+        m_args[m_size] = static_cast<uint8_t>(static_cast<uint8_t>(type) | (m_hex ? BinaryLogFormat::Hex : 0));
+        putLe(m_args + m_size + 1, value, 8);
+        m_size += 9;
+    }
+    return *this;
+}
+
+BinaryLogRecord& BinaryLogRecord::putDouble(double value)
+{
+    if (reserve(9)) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        m_args[m_size] = static_cast<uint8_t>(BinaryLogFormat::ArgType::Double);
+        putLe(m_args + m_size + 1, bits, 8);
+        m_size += 9;
+    }
+    return *this;
+}
+
+BinaryLogRecord& BinaryLogRecord::putChar(uint8_t value)
+{
+    if (reserve(2)) {
+        m_args[m_size] = static_cast<uint8_t>(BinaryLogFormat::ArgType::Char);
+        m_args[m_size + 1] = value;
+        m_size += 2;
+    }
+    return *this;
+}
+
+BinaryLogRecord& BinaryLogRecord::putBytes(BinaryLogFormat::ArgType type, const void* data, size_t size)
+{
+    // A string that does not fit is cut, whatever follows it is dropped
+    if (m_truncated || static_cast<size_t>(m_size) + 3 > BinaryLogFormat::MaxArgsSize) {
+        m_truncated = true;
+        return *this;
+    }
+    size_t room = BinaryLogFormat::MaxArgsSize - m_size - 3;
+    if (size > room) {
+        size = room;
+        m_truncated = true;
+    }
+
+    m_args[m_size] = static_cast<uint8_t>(type);
+    putLe(m_args + m_size + 1, size, 2);
+    std::memcpy(m_args + m_size + 3, data, size);
+    m_size = static_cast<uint16_t>(m_size + 3 + size);
+    return *this;
+}
+
+bool BinaryLogRecord::reserve(size_t size)
+{
+    if (m_truncated || m_size + size > BinaryLogFormat::MaxArgsSize) {
+        m_truncated = true;
+        return false;
+    }
+    return true;
+}
+
+BinaryLogWriter::BinaryLogWriter()
+    : BinaryLogWriter(Options())
+{
+}
+
+BinaryLogWriter::BinaryLogWriter(const Options& options)
+    : m_options(options)
+    , m_queue(options.capacity)
+{
+}
+
+BinaryLogWriter::~BinaryLogWriter() { close(); }
+
+bool BinaryLogWriter::open(const std::string& path)
+{
+    close();
+    if (!m_file.open(path, MappedFile::Mode::Write))
+        return false;
+
+    uint8_t header[BinaryLogFormat::HeaderSize] = {};
+    std::memcpy(header, BinaryLogFormat::Magic, sizeof(BinaryLogFormat::Magic));
+    putLe(header + 4, BinaryLogFormat::Version, 2);
+    putLe(header + 6, BinaryLogFormat::HeaderSize, 2);
+    putLe(header + 8, monotonicNs(), 8);
+    putLe(header + 16,
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+                .count()),
+        8);
+    if (!m_file.append(header, sizeof(header))) {
+        m_file.close();
+        return false;
+    }
+
+    // Whatever a thread pushed after the last close() belongs to no file
+    BinaryLogRecord stale;
+    while (m_queue.pop(stale)) { }
+    m_queued = 0;
+    m_written = 0;
+
+    m_sites.clear();
+    m_reportedDrops = m_dropped.load(std::memory_order_relaxed);
+    m_running = true;
+    m_writer = std::thread(&BinaryLogWriter::writerThread, this);
+    return true;
+}
+
+bool BinaryLogWriter::push(BinaryLogRecord&& record)
+{
+    bool urgent = record.m_site && record.m_site->level == LogLevel::Error;
+    if (!m_queue.push(std::move(record))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_queued.fetch_add(1, std::memory_order_relaxed);
+
+    // Same wake-up rule as the asynchronous text logger: the writer comes round by itself unless it is urgent
+    if (!urgent && m_queue.size() < m_queue.capacity() / 2)
+        return true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_writerIdle.load(std::memory_order_relaxed))
+        wake();
+    return true;
+}
+
+bool BinaryLogWriter::push(LogLevel level, const char* file, const char* function, int line, const std::string& message)
+{
+    BinaryLogRecord record;
+    record.m_timestampNs = monotonicNs();
+    record << static_cast<unsigned>(level) << line << (file ? file : "") << (function ? function : "") << message;
+    return push(std::move(record));
+}
+
+void BinaryLogWriter::flush()
+{
+    uint64_t target = m_queued.load(std::memory_order_relaxed);
+    while (m_written.load(std::memory_order_acquire) < target && m_running) {
+        wake();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void BinaryLogWriter::close()
+{
+    if (!m_writer.joinable())
+        return;
+
+    m_running = false;
+    wake();
+    m_writer.join();
+
+    // Records pushed while the writer was finishing
+    BinaryLogRecord record;
+    uint64_t count = 0;
+    for (; m_queue.pop(record); ++count)
+        write(record);
+    writeDropped();
+    m_written.fetch_add(count, std::memory_order_release);
+    m_file.close();
+}
+
+void BinaryLogWriter::wake()
+{
+    m_writerIdle.store(false, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_writerMutex);
+    m_writerCond.notify_one();
+}
+
+void BinaryLogWriter::write(const BinaryLogRecord& record)
+{
+    std::vector<uint8_t> out;
+    out.reserve(32 + record.m_size);
+
+    if (!record.m_site) {
+        out.push_back(static_cast<uint8_t>(BinaryLogFormat::RecordType::Text));
+        appendLe(out, record.m_timestampNs, 8);
+    } else {
+        const LogSite& site = *record.m_site;
+        if (site.id >= m_sites.size())
+            m_sites.resize(site.id + 1, false);
+        if (!m_sites[site.id]) {
+            out.push_back(static_cast<uint8_t>(BinaryLogFormat::RecordType::Site));
+            appendLe(out, site.id, 4);
+            out.push_back(static_cast<uint8_t>(site.level));
+            appendLe(out, static_cast<uint32_t>(site.line), 4);
+            appendString(out, site.file ? site.file : "");
+            appendString(out, site.function ? site.function : "");
+            m_sites[site.id] = true;
+        }
+
+        out.push_back(static_cast<uint8_t>(BinaryLogFormat::RecordType::Message));
+        appendLe(out, site.id, 4);
+        appendLe(out, record.m_timestampNs, 8);
+        out.push_back(record.m_truncated ? 1 : 0);
+    }
+    appendLe(out, record.m_size, 2);
+    out.insert(out.end(), record.m_args, record.m_args + record.m_size);
+    m_file.append(out.data(), out.size());
+}
+
+void BinaryLogWriter::writeDropped()
+{
+    uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped == m_reportedDrops)
+        return;
+
+    uint8_t out[9];
+    out[0] = static_cast<uint8_t>(BinaryLogFormat::RecordType::Dropped);
+    putLe(out + 1, dropped - m_reportedDrops, 8);
+    m_file.append(out, sizeof(out));
+    m_reportedDrops = dropped;
+}
+
+void BinaryLogWriter::writerThread()
+{
+    for (;;) {
+        BinaryLogRecord record;
+        uint64_t count = 0;
+        while (m_queue.pop(record)) {
+            write(record);
+            ++count;
+        }
+        writeDropped();
+
+        if (count > 0) {
+            m_written.fetch_add(count, std::memory_order_release);
+            continue;
+        }
+
+        if (!m_running)
+            break;
+
+        // Announce the wait before the last look at the queue, producers check the flag after pushing
+        std::unique_lock<std::mutex> lock(m_writerMutex);
+        m_writerIdle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_queue.empty() && m_running)
+            m_writerCond.wait_for(lock, std::chrono::milliseconds(m_options.flushIntervalMs));
+        m_writerIdle.store(false, std::memory_order_relaxed);
+    }
+}
+
+bool BinaryLogReader::open(const std::string& path)
+{
+    if (!m_file.open(path, MappedFile::Mode::Read))
+        return false;
+
+    const uint8_t* header = m_file.data();
+    if (m_file.size() < BinaryLogFormat::HeaderSize
+        || std::memcmp(header, BinaryLogFormat::Magic, sizeof(BinaryLogFormat::Magic)) != 0) {
+        VISCALOG_ERROR("BinaryLogReader: " << path << " is not a binary log");
+        m_file.close();
+        return false;
+    }
+
+    uint16_t version = static_cast<uint16_t>(getLe(header + 4, 2));
+    size_t headerSize = static_cast<size_t>(getLe(header + 6, 2));
+    if (version != BinaryLogFormat::Version || headerSize != BinaryLogFormat::HeaderSize) {
+        VISCALOG_ERROR("BinaryLogReader: " << path << " has unsupported version " << version);
+        m_file.close();
+        return false;
+    }
+
+    m_startMonotonicNs = getLe(header + 8, 8);
+    m_startWallClockNs = getLe(header + 16, 8);
+    m_lastTimestampNs = m_startMonotonicNs;
+    m_offset = BinaryLogFormat::HeaderSize;
+    m_sites.clear();
+    return true;
+}
+
+bool BinaryLogReader::next(BinaryLogEntry& entry)
+{
+    using BinaryLogFormat::RecordType;
+
+    while (m_file.isOpen() && m_offset < m_file.size()) {
+        Cursor cursor(m_file.data() + m_offset + 1, m_file.size() - m_offset - 1);
+        auto type = static_cast<RecordType>(m_file.data()[m_offset]);
+        uint64_t id = 0, level = 0, line = 0, timestamp = 0, flags = 0, count = 0;
+        const uint8_t* args = nullptr;
+        size_t size = 0;
+
+        if (type == RecordType::Site) {
+            Site site;
+            if (!cursor.read(id, 4) || !cursor.read(level, 1) || !cursor.read(line, 4) || !cursor.readString(site.file)
+                || !cursor.readString(site.function) || id > 0xFFFFFF)
+                return false;
+            site.defined = true;
+            site.level = static_cast<LogLevel>(level);
+            site.line = static_cast<int>(line);
+            if (id >= m_sites.size())
+                m_sites.resize(static_cast<size_t>(id) + 1);
+            m_sites[static_cast<size_t>(id)] = std::move(site);
+            m_offset += 1 + cursor.offset();
+            continue;
+        }
+
+        if (type == RecordType::Message) {
+            if (!cursor.read(id, 4) || !cursor.read(timestamp, 8) || !cursor.read(flags, 1)
+                || !cursor.readBytes(args, size) || id >= m_sites.size() || !m_sites[static_cast<size_t>(id)].defined)
+                return false;
+            const Site& site = m_sites[static_cast<size_t>(id)];
+            entry.level = site.level;
+            entry.file = site.file;
+            entry.function = site.function;
+            entry.line = site.line;
+            if (!decodeArgs(args, size, entry.message))
+                return false;
+            if (flags & 1)
+                entry.message += " [truncated]";
+        } else if (type == RecordType::Text) {
+            if (!cursor.read(timestamp, 8) || !cursor.readBytes(args, size))
+                return false;
+
+            // Level, line, file, function and message, each with its type byte
+            Cursor fields(args, size);
+            uint64_t tag = 0;
+            if (!fields.read(tag, 1) || !fields.read(level, 8) || !fields.read(tag, 1) || !fields.read(line, 8)
+                || !fields.read(tag, 1) || !fields.readString(entry.file) || !fields.read(tag, 1)
+                || !fields.readString(entry.function) || !fields.read(tag, 1) || !fields.readString(entry.message))
+                return false;
+            entry.level = static_cast<LogLevel>(level);
+            entry.line = static_cast<int>(line);
+        } else if (type == RecordType::Dropped) {
+            if (!cursor.read(count, 8))
+                return false;
+            entry.level = LogLevel::Warning;
+            entry.file.clear();
+            entry.function.clear();
+            entry.line = 0;
+            entry.message = "Logger: " + std::to_string(count) + " messages dropped, queue full";
+            timestamp = m_lastTimestampNs; // Drops carry no time of their own
+        } else {
+            return false; // End marker or damage
+        }
+
+        m_lastTimestampNs = timestamp;
+        entry.timestampNs = timestamp;
+        entry.wallClockNs = m_startWallClockNs + (timestamp - m_startMonotonicNs);
+        m_offset += 1 + cursor.offset();
+        return true;
+    }
+    return false;
+}
+
+bool BinaryLogReader::decodeArgs(const uint8_t* data, size_t size, std::string& text) const
+{
+    using BinaryLogFormat::ArgType;
+
+    text.clear();
+    Cursor cursor(data, size);
+    char number[32];
+    while (!cursor.atEnd()) {
+        uint64_t tag = 0, value = 0;
+        if (!cursor.read(tag, 1))
+            return false;
+        bool hex = (tag & BinaryLogFormat::Hex) != 0;
+        auto type = static_cast<ArgType>(tag & ~BinaryLogFormat::Hex);
+
+        if (type == ArgType::String || type == ArgType::Bytes) {
+            const uint8_t* bytes = nullptr;
+            size_t length = 0;
+            if (!cursor.readBytes(bytes, length))
+                return false;
+            if (type == ArgType::String) {
+                text.append(reinterpret_cast<const char*>(bytes), length);
+            } else {
+                std::ostringstream oss;
+                oss << LogHex(bytes, length);
+                text += oss.str();
+            }
+            continue;
+        }
+
+        if (!cursor.read(value, type == ArgType::Char ? 1 : 8))
+            return false;
+        switch (type) {
+        case ArgType::Int:
+            if (hex)
+                std::snprintf(number, sizeof(number), "%" PRIx64, value);
+            else
+                std::snprintf(number, sizeof(number), "%" PRId64, static_cast<int64_t>(value));
+            text += number;
+            break;
+        case ArgType::UInt:
+            std::snprintf(number, sizeof(number), hex ? "%" PRIx64 : "%" PRIu64, value);
+            text += number;
+            break;
+        case ArgType::Pointer:
+            std::snprintf(number, sizeof(number), "0x%" PRIx64, value);
+            text += number;
+            break;
+        case ArgType::Double: {
+            double real;
+            std::memcpy(&real, &value, sizeof(real));
+            std::snprintf(number, sizeof(number), "%g", real);
+            text += number;
+            break;
+        }
+        case ArgType::Char:
+            text += static_cast<char>(value);
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string BinaryLogReader::format(const BinaryLogEntry& entry, bool showLocation)
+{
+    std::time_t second = static_cast<std::time_t>(entry.wallClockNs / 1000000000);
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &second);
+#else
+    localtime_r(&second, &tm);
+#endif
+    char clock[16];
+    std::strftime(clock, sizeof(clock), "%H:%M:%S", &tm);
+
+    char prefix[160];
+    int ms = static_cast<int>(entry.wallClockNs / 1000000 % 1000);
+    if (showLocation && !entry.file.empty())
+        std::snprintf(prefix, sizeof(prefix), "[%s.%03d] [%s] [%s:%d %s] ", clock, ms,
+            Logger::levelToString(entry.level), baseName(entry.file), entry.line, entry.function.c_str());
+    else
+        std::snprintf(prefix, sizeof(prefix), "[%s.%03d] [%s] ", clock, ms, Logger::levelToString(entry.level));
+    return prefix + entry.message;
+}
+
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include "Export.h"
+#include "LockFreeQueue.h"
+#include "MappedFile.h"
+#include "Span.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <ios>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Visca {
+
+enum class VISCA_EXPORT LogLevel;
+struct LogHex;
+
+/**
+ * @brief On-disk layout of a binary log, all integers little-endian.
+ *
+ * File header: "VLOG", u16 version, u16 header size, u64 monotonic start ns, u64 wall clock start ns (Unix epoch).
+ * Then records back to back, each starting with a u8 RecordType:
+ * - Site: u32 id, u8 level, u32 line, u16 length + file, u16 length + function. Written before the first message of
+ *   the call site.
+ * - Message: u32 site id, u64 monotonic ns, u8 flags (1 = arguments truncated), u16 length + arguments.
+ * - Text: u64 monotonic ns, u16 length + arguments (level, line, file, function, message), for messages logged
+ *   without a call site (Logger::log called directly).
+ * - Dropped: u64 number of messages lost to a full queue.
+ * Type 0 marks the end, which is how the zero-filled tail of a file left by a crash reads.
+ *
+ * Arguments are a u8 ArgType, the Hex bit set for integers streamed after std::hex, followed by an i64 (Int), u64
+ * (UInt, Pointer), IEEE 754 f64 (Double), u8 (Char) or u16 length + bytes (String, Bytes).
+ */
+namespace BinaryLogFormat {
+    constexpr uint8_t Magic[4] = { 'V', 'L', 'O', 'G' };
+    constexpr uint16_t Version = 1;
+    constexpr size_t HeaderSize = 24;
+    constexpr size_t MaxArgsSize = 192; ///< Per message, longer ones are truncated
+
+    enum class RecordType : uint8_t { End = 0, Site = 1, Message = 2, Text = 3, Dropped = 4 };
+    enum class ArgType : uint8_t { Int = 1, UInt = 2, Double = 3, Char = 4, String = 5, Bytes = 6, Pointer = 7 };
+    constexpr uint8_t Hex = 0x80;
+}
+
+/**
+ * @brief A log statement in the source: its level and location, registered once per process with a unique id. The
+ * binary log stores the id in place of the location.
+ */
+struct VISCA_EXPORT LogSite {
+    LogSite(LogLevel level, const char* file, const char* function, int line);
+
+    LogLevel level;
+    const char* file;
+    const char* function;
+    int line;
+    uint32_t id;
+};
+
+/**
+ * @brief One message of the binary log: the call site, a monotonic timestamp and the streamed arguments encoded raw.
+ *
+ * Streams like std::ostream, so the VISCALOG_* macros feed it the same expressions: integers, floating point,
+ * characters and strings are stored as values, LogHex as bytes, anything else is formatted with an ostringstream on
+ * the spot. Formatting to text happens when the log is decoded.
+ */
+class VISCA_EXPORT BinaryLogRecord {
+public:
+    BinaryLogRecord() = default;
+    explicit BinaryLogRecord(const LogSite& site);
+
+    BinaryLogRecord& operator<<(bool value) { return putInteger(BinaryLogFormat::ArgType::UInt, value ? 1 : 0); }
+    BinaryLogRecord& operator<<(char value) { return putChar(static_cast<uint8_t>(value)); }
+    BinaryLogRecord& operator<<(signed char value) { return putChar(static_cast<uint8_t>(value)); }
+    BinaryLogRecord& operator<<(unsigned char value) { return putChar(value); }
+    BinaryLogRecord& operator<<(const char* text);
+    BinaryLogRecord& operator<<(const std::string& text)
+    {
+        return putBytes(BinaryLogFormat::ArgType::String, text.data(), text.size());
+    }
+    BinaryLogRecord& operator<<(const void* pointer);
+    BinaryLogRecord& operator<<(const LogHex& hex);
+    BinaryLogRecord& operator<<(std::ios_base& (*manipulator)(std::ios_base&));
+    BinaryLogRecord& operator<<(std::ostream& (*manipulator)(std::ostream&));
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    BinaryLogRecord& operator<<(T value)
+    {
+        if (std::is_signed<T>::value)
+            return putInteger(BinaryLogFormat::ArgType::Int, static_cast<uint64_t>(static_cast<int64_t>(value)));
+        return putInteger(BinaryLogFormat::ArgType::UInt, static_cast<uint64_t>(value));
+    }
+
+    template <typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+    BinaryLogRecord& operator<<(T value)
+    {
+        return putDouble(static_cast<double>(value));
+    }
+
+    // Everything else goes through its ostream operator
+    template <typename T,
+        typename std::enable_if<!std::is_arithmetic<T>::value && !std::is_convertible<const T&, const char*>::value,
+            int>::type
+        = 0>
+    BinaryLogRecord& operator<<(const T& value)
+    {
+        std::ostringstream oss;
+        oss << value;
+        return *this << oss.str();
+    }
+
+    const LogSite* site() const { return m_site; }
+    uint64_t timestampNs() const { return m_timestampNs; }
+    Span<const uint8_t> args() const { return Span<const uint8_t>(m_args, m_size); }
+    bool truncated() const { return m_truncated; }
+
+private:
+    friend class BinaryLogWriter;
+
+    BinaryLogRecord& putInteger(BinaryLogFormat::ArgType type, uint64_t value);
+    BinaryLogRecord& putDouble(double value);
+    BinaryLogRecord& putChar(uint8_t value);
+    BinaryLogRecord& putBytes(BinaryLogFormat::ArgType type, const void* data, size_t size);
+    bool reserve(size_t size);
+
+    const LogSite* m_site { nullptr };
+    uint64_t m_timestampNs { 0 };
+    uint16_t m_size { 0 };
+    bool m_truncated { false };
+    bool m_hex { false };
+    uint8_t m_args[BinaryLogFormat::MaxArgsSize];
+};
+
+/**
+ * @brief Background writer of a binary log file.
+ *
+ * push() copies the record into a bounded lock-free queue and returns; a full queue drops the record and counts it.
+ * The writer thread comes round every flush interval (sooner for errors or a half full queue), writes the site of
+ * every call site it has not seen yet, then the messages, into a MappedFile. The file keeps what was written if the
+ * process dies; messages still queued are lost.
+ */
+class VISCA_EXPORT BinaryLogWriter {
+public:
+    struct Options {
+        size_t capacity { 8192 }; ///< Queued messages, rounded up to a power of two
+        int flushIntervalMs { 10 };
+    };
+
+    BinaryLogWriter();
+    explicit BinaryLogWriter(const Options& options);
+    ~BinaryLogWriter();
+
+    BinaryLogWriter(const BinaryLogWriter&) = delete;
+    BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+    bool open(const std::string& path);
+    bool isOpen() const { return m_running.load(std::memory_order_relaxed); }
+
+    bool push(BinaryLogRecord&& record);
+
+    /**
+     * @brief Queue a message that has no call site, stored with its location and text.
+     */
+    bool push(LogLevel level, const char* file, const char* function, int line, const std::string& message);
+
+    /**
+     * @brief Block until every message queued so far is in the file.
+     */
+    void flush();
+
+    /**
+     * @brief Write what is queued, stop the writer and trim the file.
+     */
+    void close();
+
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void writerThread();
+    void wake();
+    void write(const BinaryLogRecord& record);
+    void writeDropped();
+
+    Options m_options;
+    LockFreeQueue<BinaryLogRecord> m_queue;
+    MappedFile m_file;
+    std::vector<bool> m_sites; ///< Writer thread only, site ids already in the file
+    uint64_t m_reportedDrops { 0 }; ///< Writer thread only
+
+    std::thread m_writer;
+    std::mutex m_writerMutex;
+    std::condition_variable m_writerCond;
+    std::atomic<bool> m_running { false };
+    std::atomic<bool> m_writerIdle { false };
+    std::atomic<uint64_t> m_queued { 0 };
+    std::atomic<uint64_t> m_written { 0 };
+    std::atomic<uint64_t> m_dropped { 0 };
+};
+
+/**
+ * @brief A decoded message of a binary log.
+ */
+struct BinaryLogEntry {
+    LogLevel level {};
+    uint64_t timestampNs { 0 }; ///< Monotonic clock of the writing process
+    uint64_t wallClockNs { 0 }; ///< Unix epoch
+    std::string file;
+    std::string function;
+    int line { 0 };
+    std::string message;
+};
+
+/**
+ * @brief Reads a binary log sequentially and formats its messages. Reports lost messages as a warning entry, like the
+ * text logger does.
+ */
+class VISCA_EXPORT BinaryLogReader {
+public:
+    bool open(const std::string& path);
+    bool isOpen() const { return m_file.isOpen(); }
+    void close() { m_file.close(); }
+
+    /**
+     * @return false at the end of the log or at a truncated record.
+     */
+    bool next(BinaryLogEntry& entry);
+
+    /**
+     * @brief The entry as the text logger would have written it, without the trailing newline.
+     */
+    static std::string format(const BinaryLogEntry& entry, bool showLocation = true);
+
+private:
+    struct Site {
+        bool defined { false };
+        LogLevel level {};
+        int line { 0 };
+        std::string file;
+        std::string function;
+    };
+
+    bool decodeArgs(const uint8_t* data, size_t size, std::string& text) const;
+
+    MappedFile m_file;
+    size_t m_offset { 0 };
+    uint64_t m_startMonotonicNs { 0 };
+    uint64_t m_startWallClockNs { 0 };
+    uint64_t m_lastTimestampNs { 0 };
+    std::vector<Site> m_sites;
+};
+
+}
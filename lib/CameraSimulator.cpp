@@ -0,0 +1,471 @@
+#include "CameraSimulator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Visca {
+
+namespace {
+    constexpr size_t MaxPacketSize = 16;
+
+    constexpr uint8_t ErrorMessageLength = 0x01;
+    constexpr uint8_t ErrorSyntax = 0x02;
+    constexpr uint8_t ErrorBufferFull = 0x03;
+    constexpr uint8_t ErrorCancelled = 0x04;
+    constexpr uint8_t ErrorNoSocket = 0x05;
+    constexpr uint8_t ErrorNotExecutable = 0x41;
+
+    constexpr uint8_t StandardSpeed = 3;
+    constexpr uint8_t MaxSpeed = 7;
+
+    uint16_t readNibbles(const uint8_t* data)
+    {
+        return static_cast<uint16_t>(
+            ((data[0] & 0x0F) << 12) | ((data[1] & 0x0F) << 8) | ((data[2] & 0x0F) << 4) | (data[3] & 0x0F));
+    }
+}
+
+CameraSimulator::CameraSimulator()
+    : CameraSimulator(Config())
+{
+}
+
+CameraSimulator::CameraSimulator(const Config& config)
+    : m_config(config)
+    , m_address(config.address)
+    , m_poweredOn(config.poweredOn)
+{
+    m_zoom.position = config.zoomMin;
+    m_zoom.min = config.zoomMin;
+    m_zoom.max = config.zoomMax;
+    m_zoom.fullTravel = config.zoomFullTravel;
+
+    m_focus.position = config.focusMax;
+    m_focus.min = config.focusMin;
+    m_focus.max = config.focusMax;
+    m_focus.fullTravel = config.focusFullTravel;
+
+    if (m_config.maxSocket < 1)
+        m_config.maxSocket = 1;
+    if (m_config.maxSocket > 2)
+        m_config.maxSocket = 2;
+}
+
+void CameraSimulator::process(const uint8_t* packet, size_t size, Clock::time_point now)
+{
+    if (!packet || size < 3 || packet[size - 1] != 0xFF || (packet[0] & 0xF0) != 0x80)
+        return;
+
+    advance(now);
+
+    uint8_t destination = packet[0] & 0x0F;
+    if (destination == 0x08) {
+        processBroadcast(packet, size, now);
+        return;
+    }
+    if (destination != m_address)
+        return;
+
+    if (size > MaxPacketSize) {
+        queueError(now + m_config.ackDelay, 0, ErrorMessageLength);
+        return;
+    }
+
+    if ((packet[1] & 0xF0) == 0x20 && size == 3) {
+        processCancel(packet[1] & 0x0F, now);
+        return;
+    }
+
+    switch (packet[1]) {
+    case 0x01:
+        processCommand(packet, size, now);
+        break;
+    case 0x09:
+        processInquiry(packet, size, now);
+        break;
+    default:
+        queueError(now + m_config.ackDelay, 0, ErrorSyntax);
+        break;
+    }
+}
+
+bool CameraSimulator::nextReplyTime(Clock::time_point& due) const
+{
+    if (m_pending.empty())
+        return false;
+
+    due = m_pending.front().due;
+    for (const auto& pending : m_pending)
+        due = std::min(due, pending.due);
+    return true;
+}
+
+size_t CameraSimulator::collectReplies(Clock::time_point now, std::vector<Reply>& replies)
+{
+    auto firstDue = std::stable_partition(
+        m_pending.begin(), m_pending.end(), [now](const PendingReply& pending) { return pending.due > now; });
+    if (firstDue == m_pending.end())
+        return 0;
+
+    std::sort(firstDue, m_pending.end(), [](const PendingReply& a, const PendingReply& b) {
+        return a.due != b.due ? a.due < b.due : a.order < b.order;
+    });
+
+    size_t collected = 0;
+    for (auto it = firstDue; it != m_pending.end(); ++it) {
+        replies.push_back({ it->due, std::move(it->data) });
+        ++collected;
+    }
+    m_pending.erase(firstDue, m_pending.end());
+    return collected;
+}
+
+void CameraSimulator::advance(Clock::time_point now)
+{
+    advanceMotor(m_zoom, now);
+    advanceMotor(m_focus, now);
+}
+
+void CameraSimulator::advanceMotor(Motor& motor, Clock::time_point now)
+{
+    if (now <= motor.lastUpdate)
+        return;
+
+    double elapsed = std::chrono::duration<double>(now - motor.lastUpdate).count();
+    motor.lastUpdate = now;
+    if (motor.velocity == 0.0)
+        return;
+
+    motor.position += motor.velocity * elapsed;
+
+    double low = motor.min;
+    double high = motor.max;
+    if (motor.target >= 0) {
+        if (motor.velocity > 0)
+            high = motor.target;
+        else
+            low = motor.target;
+    }
+
+    if (motor.position >= high) {
+        motor.position = high;
+        motor.velocity = 0;
+        motor.target = -1;
+    } else if (motor.position <= low) {
+        motor.position = low;
+        motor.velocity = 0;
+        motor.target = -1;
+    }
+}
+
+double CameraSimulator::motorSpeed(const Motor& motor, uint8_t speed) const
+{
+    double fullTravel = std::chrono::duration<double>(motor.fullTravel).count();
+    if (fullTravel <= 0)
+        return 1e12;
+
+    double range = motor.max - motor.min;
+    return range / fullTravel * (std::min(speed, MaxSpeed) + 1) / (MaxSpeed + 1);
+}
+
+void CameraSimulator::stopMotor(Motor& motor, Clock::time_point now)
+{
+    advanceMotor(motor, now);
+    motor.velocity = 0;
+    motor.target = -1;
+}
+
+void CameraSimulator::moveContinuous(Motor& motor, bool up, uint8_t speed, Clock::time_point now)
+{
+    advanceMotor(motor, now);
+    double velocity = motorSpeed(motor, speed);
+    motor.velocity = up ? velocity : -velocity;
+    motor.target = -1;
+}
+
+CameraSimulator::Clock::time_point CameraSimulator::moveDirect(Motor& motor, uint16_t target, Clock::time_point now)
+{
+    advanceMotor(motor, now);
+
+    double clamped = std::min(std::max(static_cast<double>(target), motor.min), motor.max);
+    double distance = clamped - motor.position;
+    if (distance == 0.0) {
+        motor.velocity = 0;
+        motor.target = -1;
+        return now;
+    }
+
+    double speed = motorSpeed(motor, MaxSpeed);
+    motor.velocity = distance > 0 ? speed : -speed;
+    motor.target = clamped;
+
+    auto travel = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(std::abs(distance) / speed));
+    return now + travel;
+}
+
+void CameraSimulator::processCommand(const uint8_t* packet, size_t size, Clock::time_point now)
+{
+    ++m_commandCount;
+
+    Clock::time_point ackTime = now + m_config.ackDelay;
+    if (size < 5) {
+        queueError(ackTime, 0, ErrorSyntax);
+        return;
+    }
+
+    uint8_t category = packet[2];
+    uint8_t command = packet[3];
+    const uint8_t* params = packet + 4;
+    size_t paramCount = size - 5;
+
+    // CAM_IF_Clear addressed to this camera: no socket, direct completion
+    if (category == 0x00 && command == 0x01 && paramCount == 0) {
+        for (auto it = m_pending.begin(); it != m_pending.end();) {
+            it = it->socket >= 0 ? m_pending.erase(it) : it + 1;
+        }
+        queueCompletion(ackTime, 0);
+        return;
+    }
+
+    if (category != 0x04 || paramCount == 0) {
+        queueError(ackTime, 0, ErrorSyntax);
+        return;
+    }
+
+    // Validate the command before taking a socket
+    enum class Action { Power, Zoom, ZoomDirect, Focus, FocusDirect, FocusMode, OnePush } action;
+    switch (command) {
+    case 0x00:
+        if (paramCount != 1 || (params[0] != 0x02 && params[0] != 0x03)) {
+            queueError(ackTime, 0, ErrorSyntax);
+            return;
+        }
+        action = Action::Power;
+        break;
+    case 0x07:
+    case 0x08:
+        if (paramCount != 1
+            || (params[0] > 0x03 && (params[0] & 0xF0) != 0x20 && (params[0] & 0xF0) != 0x30) || params[0] == 0x01) {
+            queueError(ackTime, 0, ErrorSyntax);
+            return;
+        }
+        action = command == 0x07 ? Action::Zoom : Action::Focus;
+        break;
+    case 0x47:
+    case 0x48:
+        if (paramCount != 4) {
+            queueError(ackTime, 0, ErrorSyntax);
+            return;
+        }
+        action = command == 0x47 ? Action::ZoomDirect : Action::FocusDirect;
+        break;
+    case 0x38:
+        if (paramCount != 1 || (params[0] != 0x02 && params[0] != 0x03 && params[0] != 0x10)) {
+            queueError(ackTime, 0, ErrorSyntax);
+            return;
+        }
+        action = Action::FocusMode;
+        break;
+    case 0x18:
+        if (paramCount != 1 || params[0] != 0x01) {
+            queueError(ackTime, 0, ErrorSyntax);
+            return;
+        }
+        action = Action::OnePush;
+        break;
+    default:
+        queueError(ackTime, 0, ErrorSyntax);
+        return;
+    }
+
+    int socket = freeSocket(now);
+    if (socket < 0) {
+        queueError(ackTime, 0, ErrorBufferFull);
+        return;
+    }
+
+    // While powered off only power on is accepted, manual focus moves need manual focus mode
+    bool executable = m_poweredOn || action == Action::Power;
+    if ((action == Action::Focus || action == Action::FocusDirect || action == Action::OnePush) && m_autoFocus)
+        executable = false;
+    if (!executable) {
+        queueError(ackTime, static_cast<uint8_t>(socket), ErrorNotExecutable);
+        return;
+    }
+
+    queueReply(ackTime, { replyHeader(), static_cast<uint8_t>(0x40 | socket), 0xFF });
+    Clock::time_point completion = ackTime + m_config.commandTime;
+
+    switch (action) {
+    case Action::Power: {
+        bool on = params[0] == 0x02;
+        if (on != m_poweredOn) {
+            m_poweredOn = on;
+            completion = ackTime + m_config.powerTime;
+            if (!on) {
+                stopMotor(m_zoom, now);
+                stopMotor(m_focus, now);
+            }
+        }
+        queueCompletion(completion, socket);
+        return;
+    }
+    case Action::Zoom:
+    case Action::Focus: {
+        Motor& motor = action == Action::Zoom ? m_zoom : m_focus;
+        uint8_t param = params[0];
+        if (param == 0x00)
+            stopMotor(motor, now);
+        else if (param == 0x02 || param == 0x03)
+            moveContinuous(motor, param == 0x02, StandardSpeed, now);
+        else
+            moveContinuous(motor, (param & 0xF0) == 0x20, param & 0x07, now);
+        queueCompletion(completion, socket);
+        return;
+    }
+    case Action::ZoomDirect:
+    case Action::FocusDirect: {
+        Motor& motor = action == Action::ZoomDirect ? m_zoom : m_focus;
+        Clock::time_point arrival = moveDirect(motor, readNibbles(params), now);
+        queueCompletion(std::max(completion, arrival), socket,
+            action == Action::ZoomDirect ? MotorId::Zoom : MotorId::Focus);
+        return;
+    }
+    case Action::FocusMode:
+        if (params[0] == 0x10)
+            m_autoFocus = !m_autoFocus;
+        else
+            m_autoFocus = params[0] == 0x02;
+        if (m_autoFocus)
+            stopMotor(m_focus, now);
+        queueCompletion(completion, socket);
+        return;
+    case Action::OnePush:
+        queueCompletion(ackTime + m_config.onePushTime, socket);
+        return;
+    }
+}
+
+void CameraSimulator::processInquiry(const uint8_t* packet, size_t size, Clock::time_point now)
+{
+    ++m_inquiryCount;
+
+    Clock::time_point due = now + m_config.ackDelay;
+    if (size != 5) {
+        queueError(due, 0, ErrorSyntax);
+        return;
+    }
+
+    std::vector<uint8_t> data { replyHeader(), 0x50 };
+    uint8_t category = packet[2];
+    uint8_t inquiry = packet[3];
+
+    if (category == 0x00 && inquiry == 0x02) {
+        data.push_back(static_cast<uint8_t>(m_config.vendorId >> 8));
+        data.push_back(static_cast<uint8_t>(m_config.vendorId & 0xFF));
+        data.push_back(static_cast<uint8_t>(m_config.modelId >> 8));
+        data.push_back(static_cast<uint8_t>(m_config.modelId & 0xFF));
+        data.push_back(static_cast<uint8_t>(m_config.romRevision >> 8));
+        data.push_back(static_cast<uint8_t>(m_config.romRevision & 0xFF));
+        data.push_back(m_config.maxSocket);
+    } else if (category == 0x04 && inquiry == 0x00) {
+        data.push_back(m_poweredOn ? 0x02 : 0x03);
+    } else if (category == 0x04 && inquiry == 0x47) {
+        appendNibbles(data, zoomPosition());
+    } else if (category == 0x04 && inquiry == 0x48) {
+        appendNibbles(data, focusPosition());
+    } else if (category == 0x04 && inquiry == 0x38) {
+        data.push_back(m_autoFocus ? 0x02 : 0x03);
+    } else {
+        queueError(due, 0, ErrorSyntax);
+        return;
+    }
+
+    data.push_back(0xFF);
+    queueReply(due, std::move(data));
+}
+
+void CameraSimulator::processBroadcast(const uint8_t* packet, size_t size, Clock::time_point now)
+{
+    Clock::time_point due = now + m_config.ackDelay;
+
+    // IF_Clear broadcast: 88 01 00 01 FF, cancels everything in progress and is passed on unchanged
+    if (size == 5 && packet[1] == 0x01 && packet[2] == 0x00 && packet[3] == 0x01) {
+        for (auto it = m_pending.begin(); it != m_pending.end();) {
+            it = it->socket >= 0 ? m_pending.erase(it) : it + 1;
+        }
+        queueReply(due, std::vector<uint8_t>(packet, packet + size));
+        return;
+    }
+
+    // AddressSet: 88 30 0p FF, take address p and pass p + 1 on to the next camera in the chain
+    if (size == 4 && packet[1] == 0x30) {
+        uint8_t address = packet[2] & 0x0F;
+        if (address >= 1 && address <= 7) {
+            m_address = address;
+            queueReply(due, { 0x88, 0x30, static_cast<uint8_t>(address + 1), 0xFF });
+        }
+    }
+}
+
+void CameraSimulator::processCancel(uint8_t socket, Clock::time_point now)
+{
+    Clock::time_point due = now + m_config.ackDelay;
+
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        if (it->socket != socket || it->due <= now)
+            continue;
+
+        if (it->motor != MotorId::None)
+            stopMotor(it->motor == MotorId::Zoom ? m_zoom : m_focus, now);
+        m_pending.erase(it);
+        queueError(due, socket, ErrorCancelled);
+        return;
+    }
+
+    queueError(due, socket, ErrorNoSocket);
+}
+
+int CameraSimulator::freeSocket(Clock::time_point now) const
+{
+    for (int socket = 1; socket <= m_config.maxSocket; ++socket) {
+        bool busy = std::any_of(m_pending.begin(), m_pending.end(),
+            [socket, now](const PendingReply& pending) { return pending.socket == socket && pending.due > now; });
+        if (!busy)
+            return socket;
+    }
+    return -1;
+}
+
+void CameraSimulator::queueReply(Clock::time_point due, std::vector<uint8_t>&& data)
+{
+    PendingReply pending;
+    pending.due = due;
+    pending.order = m_order++;
+    pending.data = std::move(data);
+    m_pending.push_back(std::move(pending));
+}
+
+void CameraSimulator::queueCompletion(Clock::time_point due, int socket, MotorId motor)
+{
+    queueReply(due, { replyHeader(), static_cast<uint8_t>(0x50 | socket), 0xFF });
+    if (socket > 0) {
+        m_pending.back().socket = socket;
+        m_pending.back().motor = motor;
+    }
+}
+
+void CameraSimulator::queueError(Clock::time_point due, uint8_t socket, uint8_t code)
+{
+    ++m_errorCount;
+    queueReply(due, { replyHeader(), static_cast<uint8_t>(0x60 | (socket & 0x0F)), code, 0xFF });
+}
+
+void CameraSimulator::appendNibbles(std::vector<uint8_t>& data, uint16_t value)
+{
+    data.push_back(static_cast<uint8_t>((value >> 12) & 0x0F));
+    data.push_back(static_cast<uint8_t>((value >> 8) & 0x0F));
+    data.push_back(static_cast<uint8_t>((value >> 4) & 0x0F));
+    data.push_back(static_cast<uint8_t>(value & 0x0F));
+}
+
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "Export.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief Simulated Sony FCB camera: the VISCA state machine without any transport.
+ *
+ * Packets are fed with the time they reach the camera and replies are queued with the time the camera emits them,
+ * to be collected once that time has come. Time is always passed in, never read from a clock, so a given sequence of
+ * packets and timestamps always produces the same replies.
+ *
+ * Modelled behaviour:
+ * - Commands take one of the two command sockets: ACK (y0 4z FF), then completion (y0 5z FF) when done. A command
+ *   arriving while both sockets are busy gets "command buffer full" (y0 60 03 FF).
+ * - Inquiries answer directly (y0 50 ... FF) and do not use a socket.
+ * - Zoom and focus motors move at a speed depending on the variable speed parameter. Continuous moves complete
+ *   immediately and keep going until stopped or a limit is reached, direct moves complete on arrival.
+ * - Cancel (8x 2z FF), IF_Clear and AddressSet broadcasts, syntax and "not executable" errors.
+ */
+class VISCA_EXPORT CameraSimulator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        uint8_t address { 1 };
+        uint16_t vendorId { 0x0020 };
+        uint16_t modelId { 0x0713 };
+        uint16_t romRevision { 0x0100 };
+        uint8_t maxSocket { 2 };
+        bool poweredOn { true };
+
+        uint16_t zoomMin { 0x0000 };
+        uint16_t zoomMax { 0x4000 };
+        uint16_t focusMin { 0x1000 };
+        uint16_t focusMax { 0xF000 };
+
+        Clock::duration ackDelay { std::chrono::milliseconds(1) }; ///< Packet received to ACK/inquiry reply
+        Clock::duration commandTime { std::chrono::milliseconds(5) }; ///< ACK to completion of instant commands
+        Clock::duration powerTime { std::chrono::milliseconds(500) }; ///< Duration of power on/off
+        Clock::duration onePushTime { std::chrono::milliseconds(300) }; ///< Duration of one push AF
+        Clock::duration zoomFullTravel { std::chrono::milliseconds(2500) }; ///< Wide to tele at speed 7
+        Clock::duration focusFullTravel { std::chrono::milliseconds(2000) }; ///< Far to near at speed 7
+    };
+
+    struct Reply {
+        Clock::time_point due;
+        std::vector<uint8_t> data;
+    };
+
+    CameraSimulator();
+    explicit CameraSimulator(const Config& config);
+
+    /**
+     * @brief Process one complete VISCA packet (terminated by 0xFF) and queue the replies.
+     * @param packet The packet bytes.
+     * @param size Size of the packet.
+     * @param now Time the packet reached the camera.
+     */
+    void process(const uint8_t* packet, size_t size, Clock::time_point now);
+
+    /**
+     * @brief Time of the earliest queued reply.
+     * @return false if no reply is queued.
+     */
+    bool nextReplyTime(Clock::time_point& due) const;
+
+    /**
+     * @brief Move the replies due at or before now to replies, in emission order.
+     * @return Number of replies collected.
+     */
+    size_t collectReplies(Clock::time_point now, std::vector<Reply>& replies);
+
+    /**
+     * @brief Move the motors up to now.
+     */
+    void advance(Clock::time_point now);
+
+    const Config& config() const { return m_config; }
+    uint8_t address() const { return m_address; }
+    bool isPoweredOn() const { return m_poweredOn; }
+    bool isAutoFocus() const { return m_autoFocus; }
+    uint16_t zoomPosition() const { return static_cast<uint16_t>(m_zoom.position); }
+    uint16_t focusPosition() const { return static_cast<uint16_t>(m_focus.position); }
+    bool isZoomMoving() const { return m_zoom.velocity != 0.0; }
+    bool isFocusMoving() const { return m_focus.velocity != 0.0; }
+
+    uint64_t commandCount() const { return m_commandCount; }
+    uint64_t inquiryCount() const { return m_inquiryCount; }
+    uint64_t errorCount() const { return m_errorCount; }
+
+private:
+    struct Motor {
+        double position { 0 };
+        double velocity { 0 }; ///< Units per second, signed
+        double target { -1 }; ///< Direct move target, negative for continuous moves
+        double min { 0 };
+        double max { 0 };
+        Clock::duration fullTravel { 0 };
+        Clock::time_point lastUpdate {};
+    };
+
+    /// Names a motor without pointing into this simulator, so copies keep their own
+    enum class MotorId { None, Zoom, Focus };
+
+    void advanceMotor(Motor& motor, Clock::time_point now);
+    double motorSpeed(const Motor& motor, uint8_t speed) const;
+    void stopMotor(Motor& motor, Clock::time_point now);
+    void moveContinuous(Motor& motor, bool up, uint8_t speed, Clock::time_point now);
+    Clock::time_point moveDirect(Motor& motor, uint16_t target, Clock::time_point now);
+
+    struct PendingReply {
+        Clock::time_point due;
+        uint64_t order { 0 };
+        int socket { -1 }; ///< Socket whose completion this is, -1 otherwise
+        MotorId motor { MotorId::None }; ///< Motor driven by the command, stopped on cancel
+        std::vector<uint8_t> data;
+    };
+
+    void processCommand(const uint8_t* packet, size_t size, Clock::time_point now);
+    void processInquiry(const uint8_t* packet, size_t size, Clock::time_point now);
+    void processBroadcast(const uint8_t* packet, size_t size, Clock::time_point now);
+    void processCancel(uint8_t socket, Clock::time_point now);
+
+    uint8_t replyHeader() const { return static_cast<uint8_t>((m_address + 8) << 4); }
+    int freeSocket(Clock::time_point now) const;
+    void queueReply(Clock::time_point due, std::vector<uint8_t>&& data);
+    void queueCompletion(Clock::time_point due, int socket, MotorId motor = MotorId::None);
+    void queueError(Clock::time_point due, uint8_t socket, uint8_t code);
+    static void appendNibbles(std::vector<uint8_t>& data, uint16_t value);
+
+    Config m_config;
+    uint8_t m_address { 1 };
+    bool m_poweredOn { true };
+    bool m_autoFocus { true };
+    Motor m_zoom;
+    Motor m_focus;
+    std::vector<PendingReply> m_pending;
+    uint64_t m_order { 0 };
+    uint64_t m_commandCount { 0 };
+    uint64_t m_inquiryCount { 0 };
+    uint64_t m_errorCount { 0 };
+};
+
+}
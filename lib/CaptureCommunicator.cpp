@@ -0,0 +1,77 @@
+#include "CaptureCommunicator.h"
+#include "Logger.h"
+
+namespace Visca {
+
+CaptureCommunicator::CaptureCommunicator(std::unique_ptr<ICommunicator> inner, const std::string& path)
+    : m_inner(std::move(inner))
+    , m_path(path)
+{
+}
+
+CaptureCommunicator::~CaptureCommunicator() { close(); }
+
+bool CaptureCommunicator::open()
+{
+    m_partial.clear();
+    if (!m_writer.open(m_path)) {
+        VISCALOG_ERROR("CaptureCommunicator: Cannot create capture " << m_path);
+        return false;
+    }
+    return m_inner && m_inner->open();
+}
+
+bool CaptureCommunicator::send(Span<const uint8_t> data)
+{
+    recordSent(data);
+    return m_inner->send(data);
+}
+
+bool CaptureCommunicator::sendv(Span<const Span<const uint8_t>> packets)
+{
+    for (const auto& packet : packets)
+        recordSent(packet);
+    return m_inner->sendv(packets);
+}
+
+size_t CaptureCommunicator::receive(uint8_t* buffer, size_t maxSize)
+{
+    size_t received = m_inner->receive(buffer, maxSize);
+
+    // Only the receiving thread touches m_partial
+    for (size_t i = 0; i < received; ++i) {
+        m_partial.push_back(buffer[i]);
+        if (buffer[i] == 0xFF || m_partial.size() >= CaptureFormat::MaxFrameSize) {
+            m_writer.record(CaptureDirection::Received, Span<const uint8_t>(m_partial));
+            m_partial.clear();
+        }
+    }
+    return received;
+}
+
+int CaptureCommunicator::nativeHandle() const { return m_inner ? m_inner->nativeHandle() : -1; }
+
+bool CaptureCommunicator::isOpen() const { return m_inner && m_inner->isOpen(); }
+
+void CaptureCommunicator::close()
+{
+    if (m_inner)
+        m_inner->close();
+    m_writer.close();
+}
+
+void CaptureCommunicator::recordSent(Span<const uint8_t> data)
+{
+    size_t start = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (data[i] == 0xFF) {
+            m_writer.record(CaptureDirection::Sent, data.subspan(start, i + 1 - start));
+            start = i + 1;
+        }
+    }
+    // An unterminated tail is recorded as it went out
+    if (start < data.size())
+        m_writer.record(CaptureDirection::Sent, data.subspan(start));
+}
+
+}
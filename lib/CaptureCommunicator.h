@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ICommunicator.h"
+#include "TrafficCapture.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief Decorator that records all traffic of another communicator into a capture file.
+ *
+ * Sent data is recorded per VISCA frame (split on 0xFF) when it is handed to the wrapped communicator, received data
+ * is reassembled into frames and each frame is recorded when its terminator arrives. Recording is a memcpy into the
+ * mapped file, cheap enough to leave on for a camera in the field. The file is created by open() and completed by
+ * close(); read it back with CaptureReader, ReplayCommunicator or ViscaCaptureDump.
+ */
+class VISCA_EXPORT CaptureCommunicator : public ICommunicator {
+public:
+    CaptureCommunicator(std::unique_ptr<ICommunicator> inner, const std::string& path);
+    ~CaptureCommunicator() override;
+
+    bool open() override;
+    using ICommunicator::send;
+    bool send(Span<const uint8_t> data) override;
+    bool sendv(Span<const Span<const uint8_t>> packets) override;
+    size_t receive(uint8_t* buffer, size_t maxSize) override;
+    int nativeHandle() const override;
+    bool isOpen() const override;
+    void close() override;
+
+    ICommunicator& inner() { return *m_inner; }
+    const CaptureWriter& writer() const { return m_writer; }
+
+private:
+    void recordSent(Span<const uint8_t> data);
+
+    std::unique_ptr<ICommunicator> m_inner;
+    std::string m_path;
+    CaptureWriter m_writer;
+    std::vector<uint8_t> m_partial; ///< Received bytes of a frame not terminated yet
+};
+
+}
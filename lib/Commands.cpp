@@ -52,6 +52,17 @@ Command Command::versionInquiry(uint8_t address)
     return Command(std::move(packet));
 }
 
+Command Command::fromPacket(const std::vector<uint8_t>& packet)
+{
+    if (packet.size() < 3 || packet.size() > 16 || (packet.front() & 0xF0) != 0x80 || packet.back() != 0xFF)
+        return Command();
+    for (size_t i = 0; i + 1 < packet.size(); ++i) {
+        if (packet[i] == 0xFF)
+            return Command();
+    }
+    return Command(std::vector<uint8_t>(packet));
+}
+
 // Zoom commands
 Command Command::zoomStop(uint8_t address) { return create(address, 0x04, 0x07, { 0x00 }); }
 
@@ -40,9 +40,16 @@ public:
     // Version inquiry
     static Command versionInquiry(uint8_t address = 1);
 
+    /**
+     * @brief A packet given as bytes, e.g. read from a script.
+     * @return An empty Command unless packet is 3 to 16 bytes, starts with a 0x8X header and ends with its only 0xFF.
+     */
+    static Command fromPacket(const std::vector<uint8_t>& packet);
+
     const std::vector<uint8_t>& packet() const { return m_packet; }
     size_t size() const { return m_packet.size(); }
     bool empty() const { return m_packet.empty(); }
+    bool isInquiry() const { return m_packet.size() > 1 && m_packet[1] == 0x09; } // Answered directly, no ACK
 
 private:
     explicit Command(std::vector<uint8_t>&& packet);
@@ -0,0 +1,310 @@
+#include "ControllerMetrics.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace Visca {
+
+namespace {
+    unsigned highestBit(uint64_t value)
+    {
+        unsigned bit = 0;
+        for (unsigned step = 32; step > 0; step >>= 1) {
+            if (value >> (bit + step))
+                bit += step;
+        }
+        return bit;
+    }
+
+    // Prometheus bucket bounds in seconds, from the speed of a local socket to a slow pan
+    constexpr double BucketBoundsSeconds[] = { 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1,
+        0.25, 0.5, 1.0, 2.5, 5.0, 10.0 };
+
+    void appendSample(std::string& out, const char* name, const std::string& labels, const std::string& extra,
+        double value)
+    {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.9g", value);
+        out += name;
+        std::string all = labels;
+        if (!extra.empty())
+            all += (all.empty() ? "" : ",") + extra;
+        if (!all.empty())
+            out += "{" + all + "}";
+        out += " ";
+        out += number;
+        out += "\n";
+    }
+
+    void appendHeader(std::string& out, const char* name, const char* type, const char* help)
+    {
+        out += std::string("# HELP ") + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+    }
+
+    void appendHistogram(std::string& out, const std::string& name, const std::string& labels,
+        const HistogramSnapshot& histogram)
+    {
+        std::string bucket = name + "_bucket";
+        char bound[32];
+        for (double seconds : BucketBoundsSeconds) {
+            std::snprintf(bound, sizeof(bound), "le=\"%g\"", seconds);
+            appendSample(out, bucket.c_str(), labels, bound,
+                static_cast<double>(histogram.countAtOrBelow(static_cast<uint64_t>(seconds * 1e9))));
+        }
+        appendSample(out, bucket.c_str(), labels, "le=\"+Inf\"", static_cast<double>(histogram.count));
+        appendSample(out, (name + "_sum").c_str(), labels, "", static_cast<double>(histogram.sumNs) / 1e9);
+        appendSample(out, (name + "_count").c_str(), labels, "", static_cast<double>(histogram.count));
+    }
+}
+
+uint64_t HistogramSnapshot::percentileNs(double p) const
+{
+    if (count == 0)
+        return 0;
+
+    auto target = static_cast<uint64_t>(p * static_cast<double>(count) + 0.5);
+    target = std::max<uint64_t>(1, std::min(target, count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= target)
+            return std::min(HdrHistogram::bucketUpperBound(i), maxNs);
+    }
+    return maxNs;
+}
+
+uint64_t HistogramSnapshot::countAtOrBelow(uint64_t ns) const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < buckets.size() && HdrHistogram::bucketUpperBound(i) <= ns; ++i)
+        total += buckets[i];
+    return total;
+}
+
+size_t HdrHistogram::bucketIndex(uint64_t ns)
+{
+    constexpr uint64_t SubBuckets = uint64_t(1) << SubBucketBits;
+    ns = std::min(ns, MaxValueNs);
+    if (ns < SubBuckets)
+        return static_cast<size_t>(ns);
+
+    unsigned exponent = highestBit(ns);
+    uint64_t sub = (ns >> (exponent - SubBucketBits)) & (SubBuckets - 1);
+    return static_cast<size_t>((exponent - SubBucketBits + 1) * SubBuckets + sub);
+}
+
+uint64_t HdrHistogram::bucketUpperBound(size_t index)
+{
+    constexpr uint64_t SubBuckets = uint64_t(1) << SubBucketBits;
+    if (index < SubBuckets)
+        return index;
+
+    unsigned exponent = static_cast<unsigned>(index / SubBuckets) + SubBucketBits - 1;
+    uint64_t sub = index % SubBuckets;
+    uint64_t width = uint64_t(1) << (exponent - SubBucketBits);
+    return ((SubBuckets + sub) << (exponent - SubBucketBits)) + width - 1;
+}
+
+void HdrHistogram::record(uint64_t ns)
+{
+    m_buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = m_maxNs.load(std::memory_order_relaxed);
+    while (ns > max && !m_maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot HdrHistogram::snapshot() const
+{
+    // The count is summed from the buckets, so it always matches them even while others record
+    HistogramSnapshot snapshot;
+    snapshot.buckets.resize(Buckets);
+    for (size_t i = 0; i < Buckets; ++i) {
+        snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.buckets[i];
+    }
+    snapshot.sumNs = m_sumNs.load(std::memory_order_relaxed);
+    snapshot.maxNs = m_maxNs.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+CommandCategory commandCategory(const Command& cmd)
+{
+    const auto& packet = cmd.packet();
+    if (cmd.isInquiry())
+        return CommandCategory::Inquiry;
+    if (packet.size() < 4)
+        return CommandCategory::Other;
+    if (packet[2] == 0x06)
+        return CommandCategory::PanTilt;
+    if (packet[2] != 0x04)
+        return CommandCategory::Other;
+
+    switch (packet[3]) {
+    case 0x00:
+        return CommandCategory::Power;
+    case 0x07:
+    case 0x47:
+        return CommandCategory::Zoom;
+    case 0x08:
+    case 0x18:
+    case 0x38:
+    case 0x48:
+        return CommandCategory::Focus;
+    default:
+        return CommandCategory::Other;
+    }
+}
+
+const char* commandCategoryName(CommandCategory category)
+{
+    switch (category) {
+    case CommandCategory::Power:
+        return "power";
+    case CommandCategory::Zoom:
+        return "zoom";
+    case CommandCategory::Focus:
+        return "focus";
+    case CommandCategory::PanTilt:
+        return "pan_tilt";
+    case CommandCategory::Inquiry:
+        return "inquiry";
+    default:
+        return "other";
+    }
+}
+
+void ControllerMetrics::recordError(CommandCategory category, uint8_t code)
+{
+    counters(category).errors.fetch_add(1, std::memory_order_relaxed);
+    m_errorsByCode[code & 0x7F].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ControllerMetrics::recordSent(size_t bytes)
+{
+    m_framesOut.fetch_add(1, std::memory_order_relaxed);
+    m_bytesOut.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ControllerMetrics::recordReceived(size_t bytes)
+{
+    m_framesIn.fetch_add(1, std::memory_order_relaxed);
+    m_bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+ControllerMetrics::Snapshot ControllerMetrics::snapshot() const
+{
+    Snapshot snapshot;
+    for (size_t i = 0; i < CommandCategoryCount; ++i) {
+        auto& category = snapshot.categories[i];
+        category.commands = m_counters[i].commands.load(std::memory_order_relaxed);
+        category.timeouts = m_counters[i].timeouts.load(std::memory_order_relaxed);
+        category.errors = m_counters[i].errors.load(std::memory_order_relaxed);
+        category.ack = m_histograms[i].ack.snapshot();
+        category.completion = m_histograms[i].completion.snapshot();
+    }
+    for (size_t code = 0; code < m_errorsByCode.size(); ++code) {
+        uint64_t count = m_errorsByCode[code].load(std::memory_order_relaxed);
+        if (count > 0)
+            snapshot.errorsByCode[static_cast<uint8_t>(code)] = count;
+    }
+    snapshot.linkErrors = m_linkErrors.load(std::memory_order_relaxed);
+    snapshot.staleReplies = m_staleReplies.load(std::memory_order_relaxed);
+    snapshot.receiveDrops = m_receiveDrops.load(std::memory_order_relaxed);
+    snapshot.framesOut = m_framesOut.load(std::memory_order_relaxed);
+    snapshot.framesIn = m_framesIn.load(std::memory_order_relaxed);
+    snapshot.bytesOut = m_bytesOut.load(std::memory_order_relaxed);
+    snapshot.bytesIn = m_bytesIn.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+std::string ControllerMetrics::prometheus(const Snapshot& snapshot, const std::string& labels)
+{
+    std::string out;
+    auto categoryLabel = [](size_t index) {
+        return std::string("category=\"") + commandCategoryName(static_cast<CommandCategory>(index)) + "\"";
+    };
+    auto withCategory = [&](size_t index) {
+        return labels.empty() ? categoryLabel(index) : labels + "," + categoryLabel(index);
+    };
+
+    appendHeader(out, "visca_commands_total", "counter", "Commands and inquiries executed.");
+    for (size_t i = 0; i < CommandCategoryCount; ++i)
+        appendSample(out, "visca_commands_total", labels, categoryLabel(i),
+            static_cast<double>(snapshot.categories[i].commands));
+
+    appendHeader(out, "visca_command_timeouts_total", "counter", "Commands without ACK, completion or reply in time.");
+    for (size_t i = 0; i < CommandCategoryCount; ++i)
+        appendSample(out, "visca_command_timeouts_total", labels, categoryLabel(i),
+            static_cast<double>(snapshot.categories[i].timeouts));
+
+    appendHeader(out, "visca_command_errors_total", "counter", "Error replies by command category.");
+    for (size_t i = 0; i < CommandCategoryCount; ++i)
+        appendSample(out, "visca_command_errors_total", labels, categoryLabel(i),
+            static_cast<double>(snapshot.categories[i].errors));
+
+    appendHeader(out, "visca_errors_by_code_total", "counter", "Error replies by VISCA error code.");
+    for (const auto& error : snapshot.errorsByCode) {
+        char code[24];
+        std::snprintf(code, sizeof(code), "code=\"0x%02X\"", error.first);
+        appendSample(out, "visca_errors_by_code_total", labels, code, static_cast<double>(error.second));
+    }
+
+    appendHeader(out, "visca_command_ack_seconds", "histogram", "Time from sending a command to its ACK, for "
+                                                                "inquiries to the reply.");
+    for (size_t i = 0; i < CommandCategoryCount; ++i)
+        appendHistogram(out, "visca_command_ack_seconds", withCategory(i), snapshot.categories[i].ack);
+
+    appendHeader(out, "visca_command_completion_seconds", "histogram", "Time from the ACK to the completion.");
+    for (size_t i = 0; i < CommandCategoryCount; ++i)
+        appendHistogram(out, "visca_command_completion_seconds", withCategory(i), snapshot.categories[i].completion);
+
+    const struct {
+        const char* name;
+        const char* type;
+        const char* help;
+        double value;
+    } scalars[] = {
+        { "visca_link_errors_total", "counter", "Packets the communicator failed to send.",
+            static_cast<double>(snapshot.linkErrors) },
+        { "visca_stale_replies_total", "counter", "Replies to earlier commands discarded.",
+            static_cast<double>(snapshot.staleReplies) },
+        { "visca_receive_dropped_frames_total", "counter", "Frames lost to a full receive buffer.",
+            static_cast<double>(snapshot.receiveDrops) },
+        { "visca_frames_sent_total", "counter", "Packets sent.", static_cast<double>(snapshot.framesOut) },
+        { "visca_frames_received_total", "counter", "Frames received.", static_cast<double>(snapshot.framesIn) },
+        { "visca_bytes_sent_total", "counter", "Bytes sent.", static_cast<double>(snapshot.bytesOut) },
+        { "visca_bytes_received_total", "counter", "Bytes received.", static_cast<double>(snapshot.bytesIn) },
+        { "visca_receive_queue_depth", "gauge", "Frames waiting for a reader.",
+            static_cast<double>(snapshot.receiveQueueDepth) },
+        { "visca_receive_queue_capacity", "gauge", "Frames the receive buffer holds.",
+            static_cast<double>(snapshot.receiveQueueCapacity) },
+    };
+    for (const auto& scalar : scalars) {
+        appendHeader(out, scalar.name, scalar.type, scalar.help);
+        appendSample(out, scalar.name, labels, "", scalar.value);
+    }
+    return out;
+}
+
+bool ControllerMetrics::writePrometheusFile(const std::string& path, const Snapshot& snapshot,
+    const std::string& labels)
+{
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::out | std::ios::trunc);
+        if (!file)
+            return false;
+        file << prometheus(snapshot, labels);
+        if (!file.flush())
+            return false;
+    }
+
+    // POSIX rename() swaps the file atomically, a scraper never finds it missing; Windows' refuses to replace one
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "Commands.h"
+#include "Export.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief Copy of an HdrHistogram at one moment.
+ */
+struct VISCA_EXPORT HistogramSnapshot {
+    uint64_t count { 0 };
+    uint64_t sumNs { 0 };
+    uint64_t maxNs { 0 };
+    std::vector<uint64_t> buckets; ///< Indexed like HdrHistogram::bucketIndex()
+
+    /**
+     * @return Upper bound of the bucket holding the percentile p (0..1), never more than maxNs; 0 when empty.
+     */
+    uint64_t percentileNs(double p) const;
+
+    /**
+     * @brief Samples in buckets whose upper bound is at most ns, what a Prometheus bucket le=ns counts.
+     */
+    uint64_t countAtOrBelow(uint64_t ns) const;
+
+    double meanNs() const { return count ? static_cast<double>(sumNs) / static_cast<double>(count) : 0.0; }
+};
+
+/**
+ * @brief Latency histogram in the manner of HdrHistogram, safe to record into from any number of threads.
+ *
+ * Values below 16 ns get a bucket each, above that every power of two is split into 16 linear sub-buckets, so a
+ * bucket is never wider than 1/16 of its values (6 %) from nanoseconds to the 18 minutes where it saturates. record()
+ * is a few relaxed atomic increments, no lock, no allocation.
+ */
+class VISCA_EXPORT HdrHistogram {
+public:
+    static constexpr unsigned SubBucketBits = 4;
+    static constexpr uint64_t MaxValueNs = (uint64_t(1) << 40) - 1; ///< Larger values count as this
+    static constexpr size_t Buckets = (40 - SubBucketBits + 1) << SubBucketBits;
+
+    void record(uint64_t ns);
+    void record(std::chrono::nanoseconds latency)
+    {
+        record(static_cast<uint64_t>(std::max<int64_t>(static_cast<int64_t>(latency.count()), 0)));
+    }
+
+    HistogramSnapshot snapshot() const;
+
+    static size_t bucketIndex(uint64_t ns);
+    static uint64_t bucketUpperBound(size_t index); ///< Largest value of the bucket
+
+private:
+    std::array<std::atomic<uint64_t>, Buckets> m_buckets {};
+    std::atomic<uint64_t> m_sumNs { 0 };
+    std::atomic<uint64_t> m_maxNs { 0 };
+};
+
+/**
+ * @brief What a command does, the grouping of the per-command metrics.
+ */
+enum class CommandCategory : uint8_t { Power, Zoom, Focus, PanTilt, Inquiry, Other };
+
+constexpr size_t CommandCategoryCount = 6;
+
+VISCA_EXPORT CommandCategory commandCategory(const Command& cmd);
+VISCA_EXPORT const char* commandCategoryName(CommandCategory category);
+
+/**
+ * @brief Counters and latency histograms of one ViscaController.
+ *
+ * The controller records from the threads calling execute() and from its receive thread, every record call is a
+ * relaxed atomic update. snapshot() copies everything out for display; prometheus() renders a snapshot in the
+ * Prometheus text exposition format, for a node_exporter textfile (writePrometheusFile()) or a MetricsEndpoint.
+ */
+class VISCA_EXPORT ControllerMetrics {
+public:
+    struct CategorySnapshot {
+        uint64_t commands { 0 }; ///< execute() calls
+        uint64_t timeouts { 0 }; ///< No ACK, completion or inquiry reply in time
+        uint64_t errors { 0 }; ///< Error replies
+        HistogramSnapshot ack; ///< Send to ACK; inquiries: send to reply
+        HistogramSnapshot completion; ///< ACK to completion
+    };
+
+    struct Snapshot {
+        std::array<CategorySnapshot, CommandCategoryCount> categories;
+        std::map<uint8_t, uint64_t> errorsByCode; ///< Response::errorCode() to count
+        uint64_t linkErrors { 0 }; ///< Packets the communicator failed to send
+        uint64_t staleReplies { 0 }; ///< Replies of earlier, timed out commands discarded by execute()
+        uint64_t receiveDrops { 0 }; ///< Frames lost to a full receive buffer
+        uint64_t framesOut { 0 };
+        uint64_t framesIn { 0 };
+        uint64_t bytesOut { 0 };
+        uint64_t bytesIn { 0 };
+        size_t receiveQueueDepth { 0 }; ///< Frames waiting for a reader when the snapshot was taken
+        size_t receiveQueueCapacity { 0 };
+    };
+
+    void recordCommand(CommandCategory category)
+    {
+        counters(category).commands.fetch_add(1, std::memory_order_relaxed);
+    }
+    void recordAck(CommandCategory category, std::chrono::nanoseconds latency)
+    {
+        histograms(category).ack.record(latency);
+    }
+    void recordCompletion(CommandCategory category, std::chrono::nanoseconds latency)
+    {
+        histograms(category).completion.record(latency);
+    }
+    void recordTimeout(CommandCategory category)
+    {
+        counters(category).timeouts.fetch_add(1, std::memory_order_relaxed);
+    }
+    void recordError(CommandCategory category, uint8_t code);
+    void recordLinkError() { m_linkErrors.fetch_add(1, std::memory_order_relaxed); }
+    void recordStaleReply() { m_staleReplies.fetch_add(1, std::memory_order_relaxed); }
+    void recordReceiveDrop() { m_receiveDrops.fetch_add(1, std::memory_order_relaxed); }
+    void recordSent(size_t bytes);
+    void recordReceived(size_t bytes);
+
+    Snapshot snapshot() const;
+
+    /**
+     * @param labels Added to every sample, e.g. camera="studio-1"; empty for none.
+     */
+    static std::string prometheus(const Snapshot& snapshot, const std::string& labels = std::string());
+
+    /**
+     * @brief Write prometheus() to path through a temporary file and a rename, readers never see half a file.
+     */
+    static bool writePrometheusFile(const std::string& path, const Snapshot& snapshot,
+        const std::string& labels = std::string());
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> commands { 0 };
+        std::atomic<uint64_t> timeouts { 0 };
+        std::atomic<uint64_t> errors { 0 };
+    };
+
+    struct Histograms {
+        HdrHistogram ack;
+        HdrHistogram completion;
+    };
+
+    Counters& counters(CommandCategory category) { return m_counters[static_cast<size_t>(category)]; }
+    Histograms& histograms(CommandCategory category) { return m_histograms[static_cast<size_t>(category)]; }
+
+    std::array<Counters, CommandCategoryCount> m_counters;
+    std::array<Histograms, CommandCategoryCount> m_histograms;
+    std::array<std::atomic<uint64_t>, 0x80> m_errorsByCode {}; ///< VISCA error codes are below 0x80
+    std::atomic<uint64_t> m_linkErrors { 0 };
+    std::atomic<uint64_t> m_staleReplies { 0 };
+    std::atomic<uint64_t> m_receiveDrops { 0 };
+    std::atomic<uint64_t> m_framesOut { 0 };
+    std::atomic<uint64_t> m_framesIn { 0 };
+    std::atomic<uint64_t> m_bytesOut { 0 };
+    std::atomic<uint64_t> m_bytesIn { 0 };
+};
+
+}
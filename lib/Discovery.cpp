@@ -0,0 +1,139 @@
+#include "Discovery.h"
+#include "ViscaOverIp.h"
+
+#include <cstdlib>
+
+namespace Visca {
+
+Discovery::Discovery(const Options& options)
+    : m_options(options)
+{
+}
+
+std::vector<uint8_t> Discovery::networkInquiryPacket()
+{
+    static const char inquiry[] = "ENQ:network";
+
+    std::vector<uint8_t> packet;
+    packet.push_back(0x02);
+    packet.insert(packet.end(), inquiry, inquiry + sizeof(inquiry) - 1);
+    packet.push_back(0x03);
+    packet.push_back(0xFF);
+    return packet;
+}
+
+bool Discovery::parseNetworkReply(const uint8_t* data, size_t size, DiscoveredCamera& camera)
+{
+    if (!data || size < 3 || data[0] != 0x02)
+        return false;
+
+    bool any = false;
+    size_t start = 1;
+    for (size_t i = 1; i < size; ++i) {
+        if (data[i] != 0xFF && data[i] != 0x03)
+            continue;
+
+        std::string field(reinterpret_cast<const char*>(data + start), i - start);
+        start = i + 1;
+
+        size_t colon = field.find(':');
+        if (colon == std::string::npos)
+            continue;
+
+        std::string key = field.substr(0, colon);
+        std::string value = field.substr(colon + 1);
+        if (key == "MAC")
+            camera.macAddress = value;
+        else if (key == "MODEL")
+            camera.model = value;
+        else if (key == "NAME")
+            camera.name = value;
+        else if (key == "SOFTVERSION")
+            camera.softVersion = value;
+        else if (key == "IPADR" && camera.address.empty())
+            camera.address = value;
+        else if (key == "ENQ")
+            return false; // Our own broadcast looped back
+        any = true;
+    }
+
+    camera.answeredNetworkInquiry = any;
+    return any;
+}
+
+bool Discovery::parseVersionReply(const uint8_t* data, size_t size, DiscoveredCamera& camera)
+{
+    if (!data)
+        return false;
+
+    ViscaOverIp::Header header;
+    if (ViscaOverIp::decode(data, size, header)) {
+        if (header.type != ViscaOverIp::PayloadType::Reply)
+            return false;
+        data += ViscaOverIp::HeaderSize;
+        size = header.length;
+    }
+
+    // y0 50 GG GG HH HH JJ JJ KK FF
+    if (size < 10 || (data[0] & 0x8F) != 0x80 || data[1] != 0x50 || data[9] != 0xFF)
+        return false;
+
+    camera.vendorId = static_cast<uint16_t>((data[2] << 8) | data[3]);
+    camera.modelId = static_cast<uint16_t>((data[4] << 8) | data[5]);
+    camera.romRevision = static_cast<uint32_t>((data[6] << 8) | data[7]);
+    camera.answeredVersionInquiry = true;
+    return true;
+}
+
+bool Discovery::expandSubnet(const std::string& cidr, std::vector<uint32_t>& hosts)
+{
+    size_t slash = cidr.find('/');
+    std::string ip = cidr.substr(0, slash);
+    int prefix = 32;
+    if (slash != std::string::npos) {
+        char* end = nullptr;
+        long value = std::strtol(cidr.c_str() + slash + 1, &end, 10);
+        if (*end != '\0' || value < 16 || value > 32)
+            return false;
+        prefix = static_cast<int>(value);
+    }
+
+    uint32_t address = 0;
+    int octets = 0;
+    size_t pos = 0;
+    while (octets < 4) {
+        size_t dot = ip.find('.', pos);
+        std::string part = ip.substr(pos, dot == std::string::npos ? std::string::npos : dot - pos);
+        if (part.empty())
+            return false;
+        char* end = nullptr;
+        long value = std::strtol(part.c_str(), &end, 10);
+        if (*end != '\0' || value < 0 || value > 255)
+            return false;
+        address = (address << 8) | static_cast<uint32_t>(value);
+        ++octets;
+        if (dot == std::string::npos)
+            break;
+        pos = dot + 1;
+    }
+    if (octets != 4)
+        return false;
+
+    uint32_t mask = prefix == 32 ? 0xFFFFFFFFu : ~((1u << (32 - prefix)) - 1);
+    uint32_t first = address & mask;
+    uint32_t last = first | ~mask;
+
+    hosts.clear();
+    if (prefix < 31) {
+        ++first;
+        --last;
+    }
+    for (uint32_t host = first; host <= last; ++host) {
+        hosts.push_back(host);
+        if (host == 0xFFFFFFFFu)
+            break;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Export.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief A camera found on the LAN.
+ */
+struct VISCA_EXPORT DiscoveredCamera {
+    std::string address; ///< IPv4 address the reply came from
+    std::string macAddress; ///< From the network-setting reply ("MAC:")
+    std::string model; ///< From the network-setting reply ("MODEL:")
+    std::string name; ///< From the network-setting reply ("NAME:")
+    std::string softVersion; ///< From the network-setting reply ("SOFTVERSION:")
+    uint16_t vendorId { 0 }; ///< From the version inquiry reply
+    uint16_t modelId { 0 }; ///< From the version inquiry reply
+    uint32_t romRevision { 0 }; ///< From the version inquiry reply
+    bool answeredNetworkInquiry { false };
+    bool answeredVersionInquiry { false };
+};
+
+/**
+ * @brief Finds VISCA cameras on the LAN.
+ *
+ * A single UDP socket is used for everything. The Sony network-setting inquiry is broadcast once and, optionally,
+ * every host of a subnet is probed with a version inquiry while keeping at most maxInFlight probes outstanding.
+ * Replies are collected until the timeout window closes, so the whole scan costs one timeout instead of one per host.
+ */
+class VISCA_EXPORT Discovery {
+public:
+    struct Options {
+        bool networkInquiry { true }; ///< Broadcast the network-setting inquiry
+        std::string broadcastAddress { "255.255.255.255" };
+        uint16_t networkSettingPort { 52380 };
+
+        std::string probeSubnet; ///< CIDR to probe with versionInquiry (e.g. "192.168.1.0/24"), empty to disable
+        uint16_t probePort { 52381 };
+        bool viscaOverIp { true }; ///< Wrap probes in the VISCA-over-IP header
+        uint8_t cameraAddress { 1 };
+        size_t maxInFlight { 32 }; ///< Bounded window of outstanding probes
+        int probeTimeoutMs { 100 }; ///< Time a probe occupies the window before it is given up
+
+        int timeoutMs { 1000 }; ///< Total time window for the scan
+    };
+
+    Discovery() = default;
+    explicit Discovery(const Options& options);
+
+    void setOptions(const Options& options) { m_options = options; }
+    const Options& options() const { return m_options; }
+
+    /**
+     * @brief Runs the scan and returns once the timeout window closes or every probe was answered.
+     * @return The cameras that replied, one entry per address.
+     */
+    std::vector<DiscoveredCamera> run();
+
+    /**
+     * @brief The Sony network-setting inquiry datagram ("\x02ENQ:network\x03\xFF").
+     */
+    static std::vector<uint8_t> networkInquiryPacket();
+
+    /**
+     * @brief Parse a network-setting reply (0xFF separated KEY:VALUE fields).
+     * @return true if the datagram is a network-setting reply.
+     */
+    static bool parseNetworkReply(const uint8_t* data, size_t size, DiscoveredCamera& camera);
+
+    /**
+     * @brief Parse a version inquiry reply, with or without the VISCA-over-IP header.
+     * @return true if the datagram is a version inquiry reply.
+     */
+    static bool parseVersionReply(const uint8_t* data, size_t size, DiscoveredCamera& camera);
+
+    /**
+     * @brief Expand an IPv4 CIDR into its host addresses (host byte order).
+     *
+     * Network and broadcast addresses are skipped for prefixes shorter than /31.
+     * @return false if the CIDR is malformed or larger than a /16.
+     */
+    static bool expandSubnet(const std::string& cidr, std::vector<uint32_t>& hosts);
+
+private:
+    Options m_options;
+};
+
+}
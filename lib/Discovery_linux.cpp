@@ -0,0 +1,157 @@
+#include "Commands.h"
+#include "Discovery.h"
+#include "Logger.h"
+#include "ViscaOverIp.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace Visca {
+
+std::vector<DiscoveredCamera> Discovery::run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<uint32_t> hosts;
+    if (!m_options.probeSubnet.empty() && !expandSubnet(m_options.probeSubnet, hosts)) {
+        VISCALOG_ERROR("Discovery: Invalid subnet " + m_options.probeSubnet);
+        return {};
+    }
+
+    int sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        VISCALOG_ERROR("Discovery: Failed to create socket");
+        return {};
+    }
+
+    int on = 1;
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in localAddr;
+    memset(&localAddr, 0, sizeof(localAddr));
+    localAddr.sin_family = AF_INET;
+    localAddr.sin_addr.s_addr = INADDR_ANY;
+    localAddr.sin_port = 0;
+    if (::bind(sock, (struct sockaddr*)&localAddr, sizeof(localAddr)) < 0) {
+        VISCALOG_ERROR("Discovery: Failed to bind socket");
+        ::close(sock);
+        return {};
+    }
+
+    std::map<uint32_t, DiscoveredCamera> found;
+    std::unordered_map<uint32_t, Clock::time_point> inFlight;
+    auto startTime = Clock::now();
+    auto deadline = startTime + std::chrono::milliseconds(m_options.timeoutMs);
+    auto probeTimeout = std::chrono::milliseconds(m_options.probeTimeoutMs);
+
+    if (m_options.networkInquiry) {
+        struct sockaddr_in broadcastAddr;
+        memset(&broadcastAddr, 0, sizeof(broadcastAddr));
+        broadcastAddr.sin_family = AF_INET;
+        broadcastAddr.sin_port = htons(m_options.networkSettingPort);
+        if (inet_pton(AF_INET, m_options.broadcastAddress.c_str(), &broadcastAddr.sin_addr) <= 0) {
+            VISCALOG_ERROR("Discovery: Invalid broadcast address " + m_options.broadcastAddress);
+        } else {
+            auto inquiry = networkInquiryPacket();
+            if (::sendto(sock, inquiry.data(), inquiry.size(), 0, (struct sockaddr*)&broadcastAddr,
+                    sizeof(broadcastAddr))
+                < 0)
+                VISCALOG_WARN("Discovery: Failed to broadcast network inquiry");
+        }
+    }
+
+    auto versionPacket = Command::versionInquiry(m_options.cameraAddress).packet();
+    uint32_t sequence = 0;
+    size_t nextHost = 0;
+    size_t maxInFlight = m_options.maxInFlight > 0 ? m_options.maxInFlight : 1;
+    uint8_t buffer[1500];
+
+    while (true) {
+        auto now = Clock::now();
+
+        for (auto it = inFlight.begin(); it != inFlight.end();) {
+            if (now - it->second >= probeTimeout)
+                it = inFlight.erase(it);
+            else
+                ++it;
+        }
+
+        while (nextHost < hosts.size() && inFlight.size() < maxInFlight) {
+            uint32_t host = hosts[nextHost++];
+
+            struct sockaddr_in probeAddr;
+            memset(&probeAddr, 0, sizeof(probeAddr));
+            probeAddr.sin_family = AF_INET;
+            probeAddr.sin_port = htons(m_options.probePort);
+            probeAddr.sin_addr.s_addr = htonl(host);
+
+            std::vector<uint8_t> probe = m_options.viscaOverIp
+                ? ViscaOverIp::encode(ViscaOverIp::PayloadType::Inquiry, sequence++, versionPacket.data(),
+                      versionPacket.size())
+                : versionPacket;
+
+            if (::sendto(sock, probe.data(), probe.size(), 0, (struct sockaddr*)&probeAddr, sizeof(probeAddr)) >= 0)
+                inFlight[host] = now;
+        }
+
+        bool probesDone = nextHost >= hosts.size() && inFlight.empty();
+        if (now >= deadline || (probesDone && !m_options.networkInquiry))
+            break;
+
+        auto wakeUp = deadline;
+        for (const auto& probe : inFlight)
+            wakeUp = std::min(wakeUp, probe.second + probeTimeout);
+        auto waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(wakeUp - now).count();
+
+        struct pollfd pfd;
+        pfd.fd = sock;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, static_cast<int>(std::max<long long>(waitMs, 1))) <= 0)
+            continue;
+
+        while (true) {
+            struct sockaddr_in src;
+            socklen_t len = sizeof(src);
+            ssize_t received = ::recvfrom(sock, buffer, sizeof(buffer), 0, (struct sockaddr*)&src, &len);
+            if (received <= 0)
+                break;
+
+            uint32_t host = ntohl(src.sin_addr.s_addr);
+            DiscoveredCamera camera = found.count(host) ? found[host] : DiscoveredCamera {};
+            size_t size = static_cast<size_t>(received);
+
+            if (parseVersionReply(buffer, size, camera)) {
+                inFlight.erase(host);
+            } else if (!parseNetworkReply(buffer, size, camera)) {
+                continue;
+            }
+
+            char text[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &src.sin_addr, text, sizeof(text));
+            camera.address = text;
+            found[host] = camera;
+        }
+    }
+
+    ::close(sock);
+
+    std::vector<DiscoveredCamera> cameras;
+    cameras.reserve(found.size());
+    for (auto& entry : found)
+        cameras.push_back(std::move(entry.second));
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime);
+    VISCALOG_INFO("Discovery: Found " << cameras.size() << " camera(s) in " << elapsed.count() << " ms");
+    return cameras;
+}
+
+}
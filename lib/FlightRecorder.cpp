@@ -0,0 +1,252 @@
+#include "FlightRecorder.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Visca {
+
+namespace {
+    constexpr size_t MaxRecorders = 32;
+    std::atomic<FlightRecorder*> s_recorders[MaxRecorders];
+
+    void writeAll(int fd, const char* data, size_t size)
+    {
+        while (size > 0) {
+#ifdef _WIN32
+            int written = ::_write(fd, data, static_cast<unsigned int>(size));
+#else
+            ssize_t written = ::write(fd, data, size);
+#endif
+            if (written <= 0)
+                return;
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    // Output of format() into a string
+    struct StringOutput {
+        std::string text;
+        void append(const char* data, size_t size) { text.append(data, size); }
+    };
+
+    // Output of format() straight to a file descriptor through a stack buffer
+    struct FdOutput {
+        explicit FdOutput(int descriptor)
+            : fd(descriptor)
+        {
+        }
+        ~FdOutput() { writeAll(fd, buffer, length); }
+
+        void append(const char* data, size_t size)
+        {
+            if (length + size > sizeof(buffer)) {
+                writeAll(fd, buffer, length);
+                length = 0;
+            }
+            std::memcpy(buffer + length, data, std::min(size, sizeof(buffer)));
+            length += std::min(size, sizeof(buffer));
+        }
+
+        int fd;
+        char buffer[512];
+        size_t length { 0 };
+    };
+
+    // Decimal and hex without snprintf, which is not async-signal-safe
+    size_t putUnsigned(char* out, uint64_t value, size_t minDigits = 1)
+    {
+        char digits[20];
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (count < minDigits)
+            digits[count++] = '0';
+        for (size_t i = 0; i < count; ++i)
+            out[i] = digits[count - 1 - i];
+        return count;
+    }
+
+    void onSignal(int)
+    {
+        static const char Header[] = "Flight recorder:\n";
+        for (auto& slot : s_recorders) {
+            const FlightRecorder* recorder = slot.load(std::memory_order_acquire);
+            if (!recorder)
+                continue;
+            writeAll(2, Header, sizeof(Header) - 1);
+            recorder->dumpTo(2);
+        }
+    }
+}
+
+FlightRecorder::FlightRecorder(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+
+    m_slots.reset(new Slot[size]);
+    m_mask = size - 1;
+
+    for (auto& slot : s_recorders) {
+        FlightRecorder* empty = nullptr;
+        if (slot.compare_exchange_strong(empty, this))
+            break;
+    }
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    for (auto& slot : s_recorders) {
+        FlightRecorder* self = this;
+        if (slot.compare_exchange_strong(self, nullptr))
+            break;
+    }
+}
+
+void FlightRecorder::record(CaptureDirection direction, Span<const uint8_t> frame)
+{
+    size_t size = std::min(frame.size(), FlightRecord::MaxFrameSize);
+    uint8_t socket = 0;
+    if (frame.size() >= 2) {
+        uint8_t kind = frame[1] & 0xF0;
+        bool reply = direction == CaptureDirection::Received && (kind == 0x40 || kind == 0x50 || kind == 0x60);
+        bool cancel = direction == CaptureDirection::Sent && kind == 0x20;
+        if (reply || cancel)
+            socket = frame[1] & 0x0F;
+    }
+
+    uint64_t words[FlightRecord::MaxFrameSize / 8] = {};
+    std::memcpy(words, frame.data(), size);
+    uint64_t header = static_cast<uint64_t>(direction) | static_cast<uint64_t>(socket) << 8
+        | static_cast<uint64_t>(size) << 16 | static_cast<uint64_t>(frame.size() > size ? 1 : 0) << 24;
+
+    uint64_t index = m_next.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = m_slots[index & m_mask];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestampNs.store(CaptureFormat::monotonicNs(), std::memory_order_relaxed);
+    slot.header.store(header, std::memory_order_relaxed);
+    for (size_t i = 0; i < FlightRecord::MaxFrameSize / 8; ++i)
+        slot.data[i].store(words[i], std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+bool FlightRecorder::read(uint64_t index, FlightRecord& record) const
+{
+    const Slot& slot = m_slots[index & m_mask];
+    uint64_t expected = 2 * index + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected)
+        return false;
+
+    uint64_t timestamp = slot.timestampNs.load(std::memory_order_relaxed);
+    uint64_t header = slot.header.load(std::memory_order_relaxed);
+    uint64_t words[FlightRecord::MaxFrameSize / 8];
+    for (size_t i = 0; i < FlightRecord::MaxFrameSize / 8; ++i)
+        words[i] = slot.data[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != expected)
+        return false; // Overwritten while copying
+
+    record.index = index;
+    record.timestampNs = timestamp;
+    record.direction = static_cast<CaptureDirection>(header & 0xFF);
+    record.socket = static_cast<uint8_t>(header >> 8);
+    record.size = static_cast<uint8_t>(std::min<uint64_t>((header >> 16) & 0xFF, FlightRecord::MaxFrameSize));
+    record.truncated = ((header >> 24) & 1) != 0;
+    std::memcpy(record.data, words, FlightRecord::MaxFrameSize);
+    return true;
+}
+
+std::vector<FlightRecord> FlightRecorder::snapshot(size_t maxFrames) const
+{
+    uint64_t end = m_next.load(std::memory_order_acquire);
+    uint64_t begin = end > capacity() ? end - capacity() : 0;
+    if (maxFrames > 0 && end - begin > maxFrames)
+        begin = end - maxFrames;
+
+    std::vector<FlightRecord> records;
+    records.reserve(static_cast<size_t>(end - begin));
+    FlightRecord record;
+    for (uint64_t index = begin; index < end; ++index) {
+        if (read(index, record))
+            records.push_back(record);
+    }
+    return records;
+}
+
+template <typename Output> void FlightRecorder::format(Output& output, size_t maxFrames) const
+{
+    static const char Digits[] = "0123456789ABCDEF";
+
+    uint64_t now = CaptureFormat::monotonicNs();
+    uint64_t end = m_next.load(std::memory_order_acquire);
+    uint64_t begin = end > capacity() ? end - capacity() : 0;
+    if (maxFrames > 0 && end - begin > maxFrames)
+        begin = end - maxFrames;
+
+    // "  -1234.567 ms TX socket 1  81 21 FF"
+    FlightRecord record;
+    char line[128];
+    for (uint64_t index = begin; index < end; ++index) {
+        if (!read(index, record))
+            continue;
+
+        uint64_t ago = now > record.timestampNs ? (now - record.timestampNs) / 1000 : 0; // us
+        size_t length = 0;
+        line[length++] = ' ';
+        line[length++] = ' ';
+        line[length++] = '-';
+        length += putUnsigned(line + length, ago / 1000);
+        line[length++] = '.';
+        length += putUnsigned(line + length, ago % 1000, 3);
+        std::memcpy(line + length, record.direction == CaptureDirection::Sent ? " ms TX " : " ms RX ", 7);
+        length += 7;
+        if (record.socket != 0) {
+            std::memcpy(line + length, "socket ", 7);
+            length += 7;
+            line[length++] = Digits[record.socket & 0x0F];
+        } else {
+            std::memset(line + length, ' ', 8);
+            length += 8;
+        }
+        line[length++] = ' ';
+        for (size_t i = 0; i < record.size; ++i) {
+            line[length++] = ' ';
+            line[length++] = Digits[record.data[i] >> 4];
+            line[length++] = Digits[record.data[i] & 0x0F];
+        }
+        if (record.truncated) {
+            std::memcpy(line + length, " ...", 4);
+            length += 4;
+        }
+        line[length++] = '\n';
+        output.append(line, length);
+    }
+}
+
+std::string FlightRecorder::dump(size_t maxFrames) const
+{
+    StringOutput output;
+    format(output, maxFrames);
+    return output.text;
+}
+
+void FlightRecorder::dumpTo(int fd) const
+{
+    FdOutput output(fd);
+    format(output, 0);
+}
+
+bool FlightRecorder::installSignalHandler(int signal) { return std::signal(signal, onSignal) != SIG_ERR; }
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Export.h"
+#include "Span.h"
+#include "TrafficCapture.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief One frame kept by a FlightRecorder.
+ */
+struct FlightRecord {
+    static constexpr size_t MaxFrameSize = 16; ///< Longest VISCA packet, longer frames keep their first bytes
+
+    uint64_t index { 0 }; ///< Position in the order frames were recorded
+    uint64_t timestampNs { 0 }; ///< CaptureFormat::monotonicNs()
+    CaptureDirection direction { CaptureDirection::Sent };
+    uint8_t socket { 0 }; ///< Socket of replies and cancels, 0 for the rest
+    uint8_t size { 0 }; ///< Bytes kept in data
+    bool truncated { false };
+    uint8_t data[MaxFrameSize] {};
+};
+
+/**
+ * @brief Always-on trace of the last frames on a link, kept in memory.
+ *
+ * A fixed ring of slots allocated once: record() claims the next slot with one atomic increment and writes the frame
+ * under the slot's sequence number, no lock and no allocation, so it can stay enabled in production. Readers copy the
+ * slots out at any time and drop the ones overwritten while they read. A writer held up for a whole lap of the ring
+ * can still mix its frame with a newer one in the same slot; the ring is sized so that does not happen in practice.
+ *
+ * Every recorder is listed for installSignalHandler(), which dumps them all to stderr on a signal (e.g. SIGUSR1) of a
+ * process that looks stuck.
+ */
+class VISCA_EXPORT FlightRecorder {
+public:
+    explicit FlightRecorder(size_t capacity = 256);
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    void record(CaptureDirection direction, Span<const uint8_t> frame);
+
+    /**
+     * @brief The frames still in the ring, oldest first.
+     * @param maxFrames Only the newest ones, 0 for all.
+     */
+    std::vector<FlightRecord> snapshot(size_t maxFrames = 0) const;
+
+    /**
+     * @brief The frames as text, one line each: time relative to the newest frame, direction, socket and bytes.
+     */
+    std::string dump(size_t maxFrames = 0) const;
+
+    /**
+     * @brief Write dump() to a file descriptor without allocating or locking, usable in a signal handler.
+     */
+    void dumpTo(int fd) const;
+
+    uint64_t recorded() const { return m_next.load(std::memory_order_relaxed); }
+    size_t capacity() const { return m_mask + 1; }
+
+    /**
+     * @brief Dump every live recorder to stderr when the process receives signal.
+     */
+    static bool installSignalHandler(int signal);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence { 0 }; ///< 2 * index + 1 while written, 2 * index + 2 once complete
+        std::atomic<uint64_t> timestampNs { 0 };
+        std::atomic<uint64_t> header { 0 }; ///< Direction, socket, size and truncation
+        std::atomic<uint64_t> data[FlightRecord::MaxFrameSize / 8];
+    };
+
+    bool read(uint64_t index, FlightRecord& record) const;
+
+    template <typename Output> void format(Output& output, size_t maxFrames) const;
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask { 0 };
+    alignas(64) std::atomic<uint64_t> m_next { 0 };
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Export.h"
+#include "Span.h"
 
 #include <cstddef>
 #include <cstdint>
@@ -16,6 +17,15 @@ enum class NetworkMode {
     Server ///< Listens for incoming connections on a local Port
 };
 
+/**
+ * @brief A caller-provided slot that receives one frame (or one read) in receivev().
+ */
+struct FrameSlot {
+    uint8_t* data { nullptr }; ///< Destination buffer, owned by the caller
+    size_t capacity { 0 }; ///< Size of the destination buffer
+    size_t size { 0 }; ///< Bytes written by the communicator
+};
+
 /**
  * @brief Interface for communication hardware/protocols.
  */
@@ -33,7 +43,30 @@ public:
      * @brief Sends raw data.
      * @return true if successful.
      */
-    virtual bool send(const std::vector<uint8_t>& data) = 0;
+    virtual bool send(Span<const uint8_t> data) = 0;
+
+    /**
+     * @brief Sends raw data held in a vector. Kept for compatibility, forwards to send(Span).
+     * @return true if successful.
+     */
+    bool send(const std::vector<uint8_t>& data) { return send(Span<const uint8_t>(data)); }
+
+    /**
+     * @brief Sends several packets at once.
+     *
+     * Implementations hand all packets to the kernel in a single call where the platform allows it (writev/sendmmsg
+     * on Linux). Datagram transports keep one datagram per packet. The default implementation sends them one by one.
+     * @param packets The packets to send, in order.
+     * @return true if every packet was sent.
+     */
+    virtual bool sendv(Span<const Span<const uint8_t>> packets)
+    {
+        for (const auto& packet : packets) {
+            if (!send(packet))
+                return false;
+        }
+        return true;
+    }
 
     /**
      * @brief Receives raw data into a buffer.
@@ -43,6 +76,29 @@ public:
      */
     virtual size_t receive(uint8_t* buffer, size_t maxSize) = 0;
 
+    /**
+     * @brief Receives into caller-provided frame slots.
+     *
+     * Datagram transports fill one slot per datagram and may fill several slots per call (recvmmsg on Linux).
+     * Stream transports fill the first slot with whatever bytes are available. The default implementation
+     * performs a single receive() into the first slot.
+     * @param slots The slots to fill. size is set for every filled slot.
+     * @return Number of slots filled.
+     */
+    virtual size_t receivev(Span<FrameSlot> slots)
+    {
+        if (slots.empty())
+            return 0;
+        slots[0].size = receive(slots[0].data, slots[0].capacity);
+        return slots[0].size > 0 ? 1 : 0;
+    }
+
+    /**
+     * @brief The OS handle (file descriptor or socket) of the open channel, for use with event loops.
+     * @return -1 if the channel is closed or the communicator has no OS handle.
+     */
+    virtual int nativeHandle() const { return -1; }
+
     /**
      * @brief Checks if the communication channel is open/connected.
      */
@@ -0,0 +1,163 @@
+#include "ImpairedCommunicator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace Visca {
+
+ImpairedCommunicator::ImpairedCommunicator(std::unique_ptr<ICommunicator> inner, const Config& config)
+    : m_inner(std::move(inner))
+    , m_config(config)
+    , m_readBuffer(1024)
+    , m_random(config.seed)
+{
+}
+
+ImpairedCommunicator::~ImpairedCommunicator() = default;
+
+bool ImpairedCommunicator::open()
+{
+    m_partial.clear();
+    m_pending.clear();
+    return m_inner && m_inner->open();
+}
+
+bool ImpairedCommunicator::send(Span<const uint8_t> data) { return m_inner->send(data); }
+
+bool ImpairedCommunicator::sendv(Span<const Span<const uint8_t>> packets) { return m_inner->sendv(packets); }
+
+size_t ImpairedCommunicator::receive(uint8_t* buffer, size_t maxSize)
+{
+    while (true) {
+        size_t delivered = deliver(buffer, maxSize, false);
+        if (delivered > 0)
+            return delivered;
+
+        // Something is held back by jitter, wait for it rather than reading more
+        if (!m_pending.empty() && m_pending.front().due > Clock::now()) {
+            std::this_thread::sleep_until(m_pending.front().due);
+            continue;
+        }
+
+        size_t received = m_inner->receive(m_readBuffer.data(), m_readBuffer.size());
+        if (received == 0) {
+            // Nothing followed a frame waiting to be merged, hand it out alone
+            return deliver(buffer, maxSize, true);
+        }
+
+        for (size_t i = 0; i < received; ++i) {
+            m_partial.push_back(m_readBuffer[i]);
+            if (m_readBuffer[i] == 0xFF) {
+                impair(std::move(m_partial));
+                m_partial.clear();
+            }
+        }
+    }
+}
+
+bool ImpairedCommunicator::isOpen() const { return m_inner && m_inner->isOpen(); }
+
+void ImpairedCommunicator::close()
+{
+    if (m_inner)
+        m_inner->close();
+}
+
+ImpairedCommunicator::Stats ImpairedCommunicator::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+void ImpairedCommunicator::impair(std::vector<uint8_t>&& frame)
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    ++m_stats.frames;
+
+    if (chance(m_config.dropRate)) {
+        ++m_stats.dropped;
+        return;
+    }
+
+    bool isAck = frame.size() == 3 && (frame[1] & 0xF0) == 0x40;
+
+    if (m_config.bitErrorRate > 0) {
+        std::uniform_int_distribution<int> bit(0, 7);
+        for (auto& byte : frame) {
+            if (chance(m_config.bitErrorRate)) {
+                byte ^= static_cast<uint8_t>(1 << bit(m_random));
+                ++m_stats.corruptedBytes;
+            }
+        }
+    }
+
+    int copies = 1;
+    if (isAck && chance(m_config.duplicateAckRate)) {
+        ++m_stats.duplicated;
+        copies = 2;
+    }
+
+    for (int copy = 0; copy < copies; ++copy) {
+        if (frame.size() > 1 && chance(m_config.splitRate)) {
+            ++m_stats.split;
+            std::uniform_int_distribution<size_t> cut(1, frame.size() - 1);
+            size_t at = cut(m_random);
+            queue(std::vector<uint8_t>(frame.begin(), frame.begin() + static_cast<std::ptrdiff_t>(at)), false);
+            queue(std::vector<uint8_t>(frame.begin() + static_cast<std::ptrdiff_t>(at), frame.end()), false);
+            continue;
+        }
+
+        bool merge = chance(m_config.mergeRate);
+        if (merge)
+            ++m_stats.merged;
+        queue(std::vector<uint8_t>(frame), merge);
+    }
+}
+
+void ImpairedCommunicator::queue(std::vector<uint8_t>&& data, bool mergeWithNext)
+{
+    Clock::time_point due = Clock::now();
+    if (m_config.jitter > Clock::duration::zero()) {
+        std::uniform_int_distribution<Clock::rep> delay(0, m_config.jitter.count());
+        due += Clock::duration(delay(m_random));
+    }
+
+    // Jitter delays frames but never reorders them
+    due = std::max(due, m_lastDue);
+    m_lastDue = due;
+    m_pending.push_back({ due, std::move(data), mergeWithNext });
+}
+
+size_t ImpairedCommunicator::deliver(uint8_t* buffer, size_t maxSize, bool flushMerged)
+{
+    auto now = Clock::now();
+    size_t size = 0;
+
+    while (!m_pending.empty()) {
+        Chunk& chunk = m_pending.front();
+        if (chunk.due > now || size + chunk.data.size() > maxSize)
+            break;
+        // A frame to be merged waits for its successor
+        if (chunk.mergeWithNext && m_pending.size() == 1 && size == 0 && !flushMerged)
+            break;
+
+        std::memcpy(buffer + size, chunk.data.data(), chunk.data.size());
+        size += chunk.data.size();
+        bool merge = chunk.mergeWithNext;
+        m_pending.pop_front();
+        if (!merge)
+            break;
+    }
+
+    return size;
+}
+
+bool ImpairedCommunicator::chance(double rate)
+{
+    if (rate <= 0)
+        return false;
+    return std::uniform_real_distribution<double>(0.0, 1.0)(m_random) < rate;
+}
+
+}
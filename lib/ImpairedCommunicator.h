@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ICommunicator.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief Decorator that degrades the replies of another communicator like a bad link would.
+ *
+ * Replies read from the wrapped communicator are cut into 0xFF-terminated frames and each frame independently may be
+ * dropped, hit by bit errors, duplicated (ACKs only), split over two reads, merged with the following frame into one
+ * read, or held back by a random jitter. Frames keep their order. A frame to be merged waits for the next one like
+ * behind the packing timer of a serial device server, if none comes it is delivered alone once the wrapped
+ * communicator's receive times out. All decisions come from one RNG seeded from the
+ * config, so a seed reproduces the same impairment pattern for the same reply stream. Sends pass through unchanged.
+ *
+ * receive() must not be called from more than one thread at a time, which is how ViscaController uses it.
+ */
+class VISCA_EXPORT ImpairedCommunicator : public ICommunicator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        uint64_t seed { 1 };
+        double dropRate { 0 }; ///< Probability a reply frame is lost
+        double duplicateAckRate { 0 }; ///< Probability an ACK frame is delivered twice
+        double splitRate { 0 }; ///< Probability a frame arrives in two reads
+        double mergeRate { 0 }; ///< Probability a frame is held back and arrives in the same read as the next one
+        double bitErrorRate { 0 }; ///< Probability per byte of one flipped bit
+        Clock::duration jitter { 0 }; ///< Maximum extra delay per frame, uniformly distributed
+    };
+
+    struct Stats {
+        uint64_t frames { 0 }; ///< Frames read from the wrapped communicator
+        uint64_t dropped { 0 };
+        uint64_t duplicated { 0 };
+        uint64_t split { 0 };
+        uint64_t merged { 0 };
+        uint64_t corruptedBytes { 0 };
+    };
+
+    ImpairedCommunicator(std::unique_ptr<ICommunicator> inner, const Config& config);
+    ~ImpairedCommunicator() override;
+
+    bool open() override;
+    using ICommunicator::send;
+    bool send(Span<const uint8_t> data) override;
+    bool sendv(Span<const Span<const uint8_t>> packets) override;
+    size_t receive(uint8_t* buffer, size_t maxSize) override;
+    bool isOpen() const override;
+    void close() override;
+
+    ICommunicator& inner() { return *m_inner; }
+    Stats stats() const;
+
+private:
+    struct Chunk {
+        Clock::time_point due;
+        std::vector<uint8_t> data;
+        bool mergeWithNext { false };
+    };
+
+    void impair(std::vector<uint8_t>&& frame);
+    void queue(std::vector<uint8_t>&& data, bool mergeWithNext);
+    size_t deliver(uint8_t* buffer, size_t maxSize, bool flushMerged);
+    bool chance(double rate);
+
+    std::unique_ptr<ICommunicator> m_inner;
+    Config m_config;
+
+    std::vector<uint8_t> m_readBuffer;
+    std::vector<uint8_t> m_partial; ///< Bytes of a frame not terminated yet
+    std::deque<Chunk> m_pending; ///< Chunks waiting for delivery, in order
+    Clock::time_point m_lastDue {};
+    std::mt19937_64 m_random;
+    Stats m_stats;
+    mutable std::mutex m_statsMutex;
+};
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Export.h"
+#include "ICommunicator.h"
+#include "Span.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace Visca {
+
+/**
+ * @brief Batched I/O for many communicators driven from a single thread.
+ *
+ * Open communicators are registered by their native handle. Sends are queued and handed to the kernel together on
+ * the next poll(), received bytes are dispatched to the per-endpoint handler from inside poll(). Two backends exist
+ * on Linux: io_uring (batched submission, multishot receives into a shared pool of provided buffers) when it is
+ * available at build and run time, and epoll as the fallback.
+ *
+ * Stream sockets (TCP) and character devices (serial ports) are supported. The engine is not thread-safe: add(),
+ * remove(), send() and poll() must be called from the thread that drives the engine.
+ */
+class VISCA_EXPORT IoEngine {
+public:
+    enum class Backend { Auto, Epoll, IoUring };
+
+    /**
+     * @brief Called with the bytes received on an endpoint. A size of 0 means the peer closed the connection.
+     */
+    using ReceiveHandler = std::function<void(int endpoint, const uint8_t* data, size_t size)>;
+
+    struct Options {
+        unsigned queueDepth { 256 }; ///< Submission queue entries (io_uring)
+        size_t bufferCount { 256 }; ///< Receive buffers shared by all endpoints
+        size_t bufferSize { 256 }; ///< Size of one receive buffer
+    };
+
+    virtual ~IoEngine() = default;
+
+    /**
+     * @brief Create an engine. Auto picks io_uring when available and falls back to epoll.
+     * @return nullptr if the requested backend is not available.
+     */
+    static std::unique_ptr<IoEngine> create(Backend backend, const Options& options);
+    static std::unique_ptr<IoEngine> create(Backend backend = Backend::Auto);
+
+    static std::unique_ptr<IoEngine> createEpoll(const Options& options);
+
+    /**
+     * @brief Create an io_uring engine.
+     * @return nullptr if the library was built without io_uring support or the kernel refuses it.
+     */
+    static std::unique_ptr<IoEngine> createIoUring(const Options& options);
+
+    static const char* backendName(Backend backend);
+
+    virtual Backend backend() const = 0;
+
+    /**
+     * @brief Register an open communicator.
+     * @return The endpoint id, or -1 if the communicator is closed or of an unsupported kind.
+     */
+    virtual int add(ICommunicator& communicator, ReceiveHandler handler) = 0;
+
+    /**
+     * @brief Stop receiving on an endpoint. Queued sends are discarded.
+     */
+    virtual void remove(int endpoint) = 0;
+
+    /**
+     * @brief Queue data for an endpoint. The data is copied and leaves on the next poll().
+     * @return false if the endpoint is unknown or removed.
+     */
+    virtual bool send(int endpoint, Span<const uint8_t> data) = 0;
+
+    /**
+     * @brief Submit queued sends and dispatch completed receives.
+     * @param timeoutMs Maximum wait for events, 0 to return immediately, negative to wait forever.
+     * @return Number of receive events dispatched, or -1 on error.
+     */
+    virtual int poll(int timeoutMs) = 0;
+};
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "IoEngine.h"
+
+namespace Visca {
+
+/**
+ * @brief Hooks for the IoEngine tests, not meant for applications.
+ */
+namespace IoEngineTesting {
+    /**
+     * @brief Create an io_uring engine whose multishot receives the kernel refuses, as a kernel without them does.
+     * @return nullptr where createIoUring() would return nullptr.
+     */
+    VISCA_EXPORT std::unique_ptr<IoEngine> createIoUringRejectingMultishot(const IoEngine::Options& options);
+}
+
+}
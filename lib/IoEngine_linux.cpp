@@ -0,0 +1,233 @@
+#include "IoEngine.h"
+#include "Logger.h"
+
+#include <cerrno>
+#include <deque>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace Visca {
+namespace {
+    /**
+     * @brief Readiness based engine: one epoll_wait() per poll(), then a read()/write() per ready endpoint.
+     */
+    class EpollIoEngine : public IoEngine {
+    public:
+        explicit EpollIoEngine(const Options& options)
+            : m_buffer(options.bufferSize > 0 ? options.bufferSize : 256)
+        {
+            m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        }
+
+        ~EpollIoEngine() override
+        {
+            if (m_epollFd >= 0)
+                ::close(m_epollFd);
+        }
+
+        bool isValid() const { return m_epollFd >= 0; }
+
+        Backend backend() const override { return Backend::Epoll; }
+
+        int add(ICommunicator& communicator, ReceiveHandler handler) override
+        {
+            int fd = communicator.nativeHandle();
+            if (fd < 0)
+                return -1;
+
+            Endpoint endpoint;
+            endpoint.fd = fd;
+            int type = 0;
+            socklen_t len = sizeof(type);
+            if (::getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) == 0) {
+                if (type != SOCK_STREAM) {
+                    VISCALOG_ERROR("IoEngine: Only stream sockets and character devices are supported");
+                    return -1;
+                }
+                endpoint.socket = true;
+            }
+            endpoint.handler = std::move(handler);
+
+            int id = static_cast<int>(m_endpoints.size());
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.u32 = static_cast<uint32_t>(id);
+            if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+                VISCALOG_ERROR("IoEngine: epoll_ctl failed for fd " << fd);
+                return -1;
+            }
+
+            m_endpoints.push_back(std::move(endpoint));
+            return id;
+        }
+
+        void remove(int id) override
+        {
+            if (!isActive(id))
+                return;
+            Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+            ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, endpoint.fd, nullptr);
+            endpoint.active = false;
+            endpoint.pending.clear();
+            endpoint.waitingWritable = false;
+        }
+
+        bool send(int id, Span<const uint8_t> data) override
+        {
+            if (!isActive(id))
+                return false;
+            Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+            // An endpoint waiting for EPOLLOUT is flushed from poll() when it becomes writable
+            if (endpoint.pending.empty() && !endpoint.waitingWritable)
+                m_dirty.push_back(id);
+            endpoint.pending.insert(endpoint.pending.end(), data.begin(), data.end());
+            return true;
+        }
+
+        int poll(int timeoutMs) override
+        {
+            flushSends();
+
+            struct epoll_event events[64];
+            int ready = ::epoll_wait(m_epollFd, events, 64, timeoutMs);
+            if (ready < 0)
+                return errno == EINTR ? 0 : -1;
+
+            int dispatched = 0;
+            for (int i = 0; i < ready; ++i) {
+                int id = static_cast<int>(events[i].data.u32);
+                if (!isActive(id))
+                    continue;
+
+                if ((events[i].events & EPOLLOUT) && m_endpoints[static_cast<size_t>(id)].waitingWritable)
+                    flush(id);
+                if (!(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) || !isActive(id))
+                    continue;
+
+                Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+                ssize_t received = endpoint.socket ? ::recv(endpoint.fd, m_buffer.data(), m_buffer.size(), MSG_DONTWAIT)
+                                                   : ::read(endpoint.fd, m_buffer.data(), m_buffer.size());
+                if (received > 0) {
+                    endpoint.handler(id, m_buffer.data(), static_cast<size_t>(received));
+                    ++dispatched;
+                } else if (received == 0 && endpoint.socket) {
+                    remove(id);
+                    m_endpoints[static_cast<size_t>(id)].handler(id, nullptr, 0);
+                    ++dispatched;
+                }
+            }
+            return dispatched;
+        }
+
+    private:
+        struct Endpoint {
+            int fd { -1 };
+            bool socket { false };
+            bool active { true };
+            bool waitingWritable { false }; ///< Registered for EPOLLOUT with pending bytes the kernel did not take
+            ReceiveHandler handler;
+            std::vector<uint8_t> pending;
+        };
+
+        bool isActive(int id) const
+        {
+            return id >= 0 && static_cast<size_t>(id) < m_endpoints.size() && m_endpoints[static_cast<size_t>(id)].active;
+        }
+
+        void flushSends()
+        {
+            for (int id : m_dirty) {
+                if (isActive(id))
+                    flush(id);
+            }
+            m_dirty.clear();
+        }
+
+        /**
+         * @brief Write as much of the pending bytes as the kernel takes without blocking.
+         *
+         * The unsent tail stays queued and the endpoint waits for EPOLLOUT; only a failed write drops it.
+         */
+        void flush(int id)
+        {
+            Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+            size_t offset = 0;
+            bool full = false;
+            while (offset < endpoint.pending.size()) {
+                const uint8_t* data = endpoint.pending.data() + offset;
+                size_t size = endpoint.pending.size() - offset;
+                ssize_t written = endpoint.socket ? ::send(endpoint.fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT)
+                                                  : ::write(endpoint.fd, data, size);
+                if (written < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        full = true;
+                        break;
+                    }
+                    VISCALOG_ERROR("IoEngine: write failed on endpoint " << id);
+                    offset = endpoint.pending.size();
+                    break;
+                }
+                offset += static_cast<size_t>(written);
+            }
+            auto sent = endpoint.pending.begin() + static_cast<std::ptrdiff_t>(offset);
+            endpoint.pending.erase(endpoint.pending.begin(), sent);
+
+            if (full != endpoint.waitingWritable) {
+                struct epoll_event event;
+                event.events = full ? EPOLLIN | EPOLLOUT : EPOLLIN;
+                event.data.u32 = static_cast<uint32_t>(id);
+                ::epoll_ctl(m_epollFd, EPOLL_CTL_MOD, endpoint.fd, &event);
+                endpoint.waitingWritable = full;
+            }
+        }
+
+        int m_epollFd { -1 };
+        std::deque<Endpoint> m_endpoints; ///< A deque so add() from inside a handler leaves the running one in place
+        std::vector<int> m_dirty;
+        std::vector<uint8_t> m_buffer;
+    };
+}
+
+std::unique_ptr<IoEngine> IoEngine::create(Backend backend, const Options& options)
+{
+    if (backend == Backend::IoUring || backend == Backend::Auto) {
+        auto engine = createIoUring(options);
+        if (engine || backend == Backend::IoUring)
+            return engine;
+        VISCALOG_INFO("IoEngine: io_uring not available, falling back to epoll");
+    }
+    return createEpoll(options);
+}
+
+std::unique_ptr<IoEngine> IoEngine::create(Backend backend) { return create(backend, Options()); }
+
+std::unique_ptr<IoEngine> IoEngine::createEpoll(const Options& options)
+{
+    auto engine = std::make_unique<EpollIoEngine>(options);
+    if (!engine->isValid()) {
+        VISCALOG_ERROR("IoEngine: epoll_create1 failed");
+        return nullptr;
+    }
+    return engine;
+}
+
+const char* IoEngine::backendName(Backend backend)
+{
+    switch (backend) {
+    case Backend::Auto:
+        return "auto";
+    case Backend::Epoll:
+        return "epoll";
+    case Backend::IoUring:
+        return "io_uring";
+    default:
+        return "unknown";
+    }
+}
+
+}
@@ -0,0 +1,11 @@
+#include "IoEngine.h"
+#include "IoEngineTesting.h"
+
+namespace Visca {
+
+// Built when the kernel headers lack the io_uring features the engine needs
+std::unique_ptr<IoEngine> IoEngine::createIoUring(const Options&) { return nullptr; }
+
+std::unique_ptr<IoEngine> IoEngineTesting::createIoUringRejectingMultishot(const IoEngine::Options&) { return nullptr; }
+
+}
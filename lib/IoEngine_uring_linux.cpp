@@ -0,0 +1,519 @@
+#include "IoEngine.h"
+#include "IoEngineTesting.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+namespace Visca {
+namespace {
+    enum class Op : uint32_t { Receive = 1, Send = 2, ProvideBuffers = 3, Cancel = 4 };
+
+    constexpr uint16_t BufferGroup = 0;
+
+    uint64_t makeUserData(Op op, uint32_t value) { return (static_cast<uint64_t>(op) << 32) | value; }
+
+    Op userDataOp(uint64_t userData) { return static_cast<Op>(userData >> 32); }
+
+    uint32_t userDataValue(uint64_t userData) { return static_cast<uint32_t>(userData & 0xFFFFFFFFu); }
+
+    /**
+     * @brief Completion based engine on top of the raw io_uring system calls.
+     *
+     * All queued sends and receive re-arms of one poll() leave in a single io_uring_enter(), which also waits for
+     * completions. Sockets use multishot recv (one SQE keeps producing completions), character devices use a read
+     * that is re-armed on completion. Both pick their destination from a pool of provided buffers so no memory is
+     * pinned per endpoint.
+     */
+    class UringIoEngine : public IoEngine {
+    public:
+        explicit UringIoEngine(const Options& options, bool rejectMultishot = false)
+            : m_options(options)
+            , m_rejectMultishot(rejectMultishot)
+        {
+            if (m_options.bufferCount == 0 || m_options.bufferCount > 0x8000)
+                m_options.bufferCount = 256;
+            if (m_options.bufferSize == 0)
+                m_options.bufferSize = 256;
+            if (m_options.queueDepth == 0)
+                m_options.queueDepth = 256;
+        }
+
+        ~UringIoEngine() override
+        {
+            if (m_sqes)
+                ::munmap(m_sqes, m_sqesSize);
+            if (m_cqRing && m_cqRing != m_sqRing)
+                ::munmap(m_cqRing, m_cqRingSize);
+            if (m_sqRing)
+                ::munmap(m_sqRing, m_sqRingSize);
+            if (m_ringFd >= 0)
+                ::close(m_ringFd);
+        }
+
+        bool init()
+        {
+            struct io_uring_params params;
+            memset(&params, 0, sizeof(params));
+            m_ringFd = static_cast<int>(::syscall(__NR_io_uring_setup, m_options.queueDepth, &params));
+            if (m_ringFd < 0) {
+                VISCALOG_INFO("IoEngine: io_uring_setup failed: " << strerror(errno));
+                return false;
+            }
+
+            if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP)) {
+                VISCALOG_INFO("IoEngine: Kernel io_uring lacks required features");
+                return false;
+            }
+
+            m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+            bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (singleMmap) {
+                m_sqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+                m_cqRingSize = m_sqRingSize;
+            }
+
+            m_sqRing = ::mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd,
+                IORING_OFF_SQ_RING);
+            if (m_sqRing == MAP_FAILED) {
+                m_sqRing = nullptr;
+                return false;
+            }
+
+            if (singleMmap) {
+                m_cqRing = m_sqRing;
+            } else {
+                m_cqRing = ::mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd,
+                    IORING_OFF_CQ_RING);
+                if (m_cqRing == MAP_FAILED) {
+                    m_cqRing = nullptr;
+                    return false;
+                }
+            }
+
+            m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+            void* sqes = ::mmap(
+                nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED)
+                return false;
+            m_sqes = static_cast<struct io_uring_sqe*>(sqes);
+
+            auto* sq = static_cast<uint8_t*>(m_sqRing);
+            m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            m_sqEntries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+            m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            m_sqLocalTail = *m_sqTail;
+
+            auto* cq = static_cast<uint8_t*>(m_cqRing);
+            m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            // Hand the whole buffer pool to the kernel and wait until it has been accepted
+            m_buffers.resize(m_options.bufferCount * m_options.bufferSize);
+            struct io_uring_sqe* sqe = nextSqe();
+            sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+            sqe->fd = static_cast<int>(m_options.bufferCount);
+            sqe->addr = reinterpret_cast<uint64_t>(m_buffers.data());
+            sqe->len = static_cast<uint32_t>(m_options.bufferSize);
+            sqe->off = 0;
+            sqe->buf_group = BufferGroup;
+            sqe->user_data = makeUserData(Op::ProvideBuffers, 0);
+
+            if (enter(1, -1) < 0)
+                return false;
+            reap();
+            return m_providedOk;
+        }
+
+        Backend backend() const override { return Backend::IoUring; }
+
+        int add(ICommunicator& communicator, ReceiveHandler handler) override
+        {
+            int fd = communicator.nativeHandle();
+            if (fd < 0)
+                return -1;
+
+            Endpoint endpoint;
+            endpoint.fd = fd;
+            int type = 0;
+            socklen_t len = sizeof(type);
+            if (::getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) == 0) {
+                if (type != SOCK_STREAM) {
+                    VISCALOG_ERROR("IoEngine: Only stream sockets and character devices are supported");
+                    return -1;
+                }
+                endpoint.socket = true;
+                endpoint.multishot = true;
+            }
+            endpoint.handler = std::move(handler);
+
+            int id = static_cast<int>(m_endpoints.size());
+            m_endpoints.push_back(std::move(endpoint));
+            armReceive(id);
+            return id;
+        }
+
+        void remove(int id) override
+        {
+            if (!isActive(id))
+                return;
+            Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+            endpoint.active = false;
+            endpoint.pending.clear();
+
+            if (endpoint.receiveArmed) {
+                struct io_uring_sqe* sqe = nextSqe();
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->fd = -1;
+                sqe->addr = makeUserData(Op::Receive, static_cast<uint32_t>(id));
+                sqe->user_data = makeUserData(Op::Cancel, static_cast<uint32_t>(id));
+            }
+        }
+
+        bool send(int id, Span<const uint8_t> data) override
+        {
+            if (!isActive(id))
+                return false;
+            Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+            if (endpoint.pending.empty() && !endpoint.sending)
+                m_dirty.push_back(id);
+            endpoint.pending.insert(endpoint.pending.end(), data.begin(), data.end());
+            return true;
+        }
+
+        int poll(int timeoutMs) override
+        {
+            for (int id : m_dirty)
+                submitSend(id);
+            m_dirty.clear();
+
+            m_dispatched = 0;
+            if (cqReady() == 0) {
+                if (enter(timeoutMs == 0 ? 0 : 1, timeoutMs) < 0)
+                    return -1;
+            } else if (pendingSubmissions() > 0 && enter(0, 0) < 0) {
+                return -1;
+            }
+            reap();
+
+            // Re-arms and re-provided buffers queued while reaping leave with the next poll()
+            return m_dispatched;
+        }
+
+    private:
+        struct Endpoint {
+            int fd { -1 };
+            bool socket { false };
+            bool multishot { false };
+            bool active { true };
+            bool receiveArmed { false };
+            bool sending { false };
+            ReceiveHandler handler;
+            std::vector<uint8_t> pending; ///< Queued by send(), not yet submitted
+            std::vector<uint8_t> inFlight; ///< Owned by the kernel until the send completes
+            size_t inFlightOffset { 0 };
+        };
+
+        bool isActive(int id) const
+        {
+            return id >= 0 && static_cast<size_t>(id) < m_endpoints.size() && m_endpoints[static_cast<size_t>(id)].active;
+        }
+
+        unsigned pendingSubmissions() const { return m_sqLocalTail - __atomic_load_n(m_sqTail, __ATOMIC_RELAXED); }
+
+        unsigned cqReady() const
+        {
+            return __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE) - __atomic_load_n(m_cqHead, __ATOMIC_RELAXED);
+        }
+
+        /**
+         * @brief Next free SQE, zeroed. Flushes the queue to the kernel first when it is full.
+         */
+        struct io_uring_sqe* nextSqe()
+        {
+            while (m_sqLocalTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries)
+                enter(0, 0);
+
+            unsigned index = m_sqLocalTail & m_sqMask;
+            struct io_uring_sqe* sqe = &m_sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            m_sqArray[index] = index;
+            ++m_sqLocalTail;
+            return sqe;
+        }
+
+        /**
+         * @brief Publish queued SQEs and optionally wait for completions in one system call.
+         */
+        int enter(unsigned minComplete, int timeoutMs)
+        {
+            unsigned toSubmit = pendingSubmissions();
+            __atomic_store_n(m_sqTail, m_sqLocalTail, __ATOMIC_RELEASE);
+
+            unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+            struct __kernel_timespec ts;
+            struct io_uring_getevents_arg arg;
+            memset(&arg, 0, sizeof(arg));
+            void* argPtr = nullptr;
+            size_t argSize = 0;
+            if (minComplete > 0 && timeoutMs > 0) {
+                ts.tv_sec = timeoutMs / 1000;
+                ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+                arg.ts = reinterpret_cast<uint64_t>(&ts);
+                flags |= IORING_ENTER_EXT_ARG;
+                argPtr = &arg;
+                argSize = sizeof(arg);
+            }
+
+            while (true) {
+                long ret = ::syscall(__NR_io_uring_enter, m_ringFd, toSubmit, minComplete, flags, argPtr, argSize);
+                if (ret >= 0)
+                    return static_cast<int>(ret);
+                if (errno == ETIME || errno == EINTR)
+                    return 0;
+                if (errno == EAGAIN || errno == EBUSY) {
+                    // Completion queue is backed up, drain it before submitting more
+                    reap();
+                    continue;
+                }
+                VISCALOG_ERROR("IoEngine: io_uring_enter failed: " << strerror(errno));
+                return -1;
+            }
+        }
+
+        void armReceive(int id)
+        {
+            Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+            struct io_uring_sqe* sqe = nextSqe();
+            sqe->opcode = endpoint.socket ? IORING_OP_RECV : IORING_OP_READ;
+            sqe->fd = endpoint.fd;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = BufferGroup;
+            if (endpoint.socket) {
+                // Multishot recv takes its length from the provided buffer. With MSG_WAITALL it is refused the
+                // way a kernel without multishot refuses it.
+                if (endpoint.multishot) {
+                    sqe->ioprio = IORING_RECV_MULTISHOT;
+                    if (m_rejectMultishot)
+                        sqe->msg_flags = MSG_WAITALL;
+                } else {
+                    sqe->len = static_cast<uint32_t>(m_options.bufferSize);
+                }
+            } else {
+                sqe->len = static_cast<uint32_t>(m_options.bufferSize);
+                sqe->off = static_cast<uint64_t>(-1);
+            }
+            sqe->user_data = makeUserData(Op::Receive, static_cast<uint32_t>(id));
+            endpoint.receiveArmed = true;
+        }
+
+        void provideBuffer(uint16_t bufferId)
+        {
+            struct io_uring_sqe* sqe = nextSqe();
+            sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+            sqe->fd = 1;
+            sqe->addr = reinterpret_cast<uint64_t>(m_buffers.data() + bufferId * m_options.bufferSize);
+            sqe->len = static_cast<uint32_t>(m_options.bufferSize);
+            sqe->off = bufferId;
+            sqe->buf_group = BufferGroup;
+            sqe->user_data = makeUserData(Op::ProvideBuffers, bufferId);
+        }
+
+        void submitSend(int id)
+        {
+            if (!isActive(id))
+                return;
+            Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+            if (endpoint.sending || endpoint.pending.empty())
+                return;
+
+            // One send per endpoint in flight keeps the byte stream ordered
+            endpoint.inFlight.swap(endpoint.pending);
+            endpoint.pending.clear();
+            endpoint.inFlightOffset = 0;
+            endpoint.sending = true;
+            prepSend(id);
+        }
+
+        void prepSend(int id)
+        {
+            Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+            struct io_uring_sqe* sqe = nextSqe();
+            sqe->opcode = endpoint.socket ? IORING_OP_SEND : IORING_OP_WRITE;
+            sqe->fd = endpoint.fd;
+            sqe->addr = reinterpret_cast<uint64_t>(endpoint.inFlight.data() + endpoint.inFlightOffset);
+            sqe->len = static_cast<uint32_t>(endpoint.inFlight.size() - endpoint.inFlightOffset);
+            if (endpoint.socket)
+                sqe->msg_flags = MSG_NOSIGNAL;
+            else
+                sqe->off = static_cast<uint64_t>(-1);
+            sqe->user_data = makeUserData(Op::Send, static_cast<uint32_t>(id));
+        }
+
+        void reap()
+        {
+            unsigned head = __atomic_load_n(m_cqHead, __ATOMIC_RELAXED);
+            unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+
+            while (head != tail) {
+                struct io_uring_cqe cqe = m_cqes[head & m_cqMask];
+                ++head;
+                __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+                handleCompletion(cqe);
+                tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+            }
+        }
+
+        void handleCompletion(const struct io_uring_cqe& cqe)
+        {
+            uint32_t value = userDataValue(cqe.user_data);
+
+            switch (userDataOp(cqe.user_data)) {
+            case Op::ProvideBuffers:
+                if (cqe.res < 0)
+                    VISCALOG_ERROR("IoEngine: Failed to provide buffers: " << strerror(-cqe.res));
+                else
+                    m_providedOk = true;
+                break;
+            case Op::Receive:
+                handleReceive(static_cast<int>(value), cqe);
+                break;
+            case Op::Send:
+                handleSend(static_cast<int>(value), cqe.res);
+                break;
+            case Op::Cancel:
+                break;
+            default:
+                break;
+            }
+        }
+
+        void handleReceive(int id, const struct io_uring_cqe& cqe)
+        {
+            bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+            if (!more)
+                m_endpoints[static_cast<size_t>(id)].receiveArmed = false;
+
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                auto bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                if (isActive(id) && cqe.res > 0) {
+                    m_endpoints[static_cast<size_t>(id)].handler(
+                        id, m_buffers.data() + bufferId * m_options.bufferSize, static_cast<size_t>(cqe.res));
+                    ++m_dispatched;
+                }
+                provideBuffer(bufferId);
+            }
+
+            // Looked up after the handler, which may have added or removed endpoints
+            if (!isActive(id))
+                return;
+            Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+
+            if (cqe.res == 0 && endpoint.socket) {
+                // Orderly shutdown by the peer
+                endpoint.active = false;
+                endpoint.handler(id, nullptr, 0);
+                ++m_dispatched;
+                return;
+            }
+
+            if (cqe.res < 0) {
+                if (cqe.res == -EINVAL && endpoint.multishot) {
+                    // Re-armed below as a plain recv; multishot is not tried again on this endpoint
+                    VISCALOG_INFO("IoEngine: Multishot recv not supported, using single-shot receives");
+                    endpoint.multishot = false;
+                } else if (cqe.res != -ENOBUFS && cqe.res != -EINTR && cqe.res != -EAGAIN
+                    && cqe.res != -ECANCELED) {
+                    VISCALOG_ERROR("IoEngine: Receive failed on endpoint " << id << ": " << strerror(-cqe.res));
+                    endpoint.active = false;
+                    return;
+                }
+            }
+
+            if (!endpoint.receiveArmed)
+                armReceive(id);
+        }
+
+        void handleSend(int id, int result)
+        {
+            Endpoint& endpoint = m_endpoints[static_cast<size_t>(id)];
+            endpoint.sending = false;
+
+            if (result < 0 && result != -EINTR && result != -EAGAIN) {
+                VISCALOG_ERROR("IoEngine: Send failed on endpoint " << id << ": " << strerror(-result));
+                endpoint.inFlight.clear();
+            } else {
+                endpoint.inFlightOffset += static_cast<size_t>(result > 0 ? result : 0);
+                if (endpoint.inFlightOffset < endpoint.inFlight.size() && endpoint.active) {
+                    endpoint.sending = true;
+                    prepSend(id);
+                    return;
+                }
+                endpoint.inFlight.clear();
+            }
+
+            if (endpoint.active && !endpoint.pending.empty())
+                submitSend(id);
+        }
+
+        Options m_options;
+        bool m_rejectMultishot { false };
+        int m_ringFd { -1 };
+
+        void* m_sqRing { nullptr };
+        void* m_cqRing { nullptr };
+        size_t m_sqRingSize { 0 };
+        size_t m_cqRingSize { 0 };
+        struct io_uring_sqe* m_sqes { nullptr };
+        size_t m_sqesSize { 0 };
+
+        unsigned* m_sqHead { nullptr };
+        unsigned* m_sqTail { nullptr };
+        unsigned* m_sqArray { nullptr };
+        unsigned m_sqMask { 0 };
+        unsigned m_sqEntries { 0 };
+        unsigned m_sqLocalTail { 0 };
+
+        unsigned* m_cqHead { nullptr };
+        unsigned* m_cqTail { nullptr };
+        unsigned m_cqMask { 0 };
+        struct io_uring_cqe* m_cqes { nullptr };
+
+        std::vector<uint8_t> m_buffers;
+        bool m_providedOk { false };
+        std::deque<Endpoint> m_endpoints; ///< A deque so add() from inside a handler leaves the running one in place
+        std::vector<int> m_dirty;
+        int m_dispatched { 0 };
+    };
+}
+
+std::unique_ptr<IoEngine> IoEngine::createIoUring(const Options& options)
+{
+    auto engine = std::make_unique<UringIoEngine>(options);
+    if (!engine->init())
+        return nullptr;
+    return engine;
+}
+
+std::unique_ptr<IoEngine> IoEngineTesting::createIoUringRejectingMultishot(const IoEngine::Options& options)
+{
+    auto engine = std::make_unique<UringIoEngine>(options, true);
+    if (!engine->init())
+        return nullptr;
+    return engine;
+}
+
+}
@@ -0,0 +1,165 @@
+#include "LineScheduler.h"
+
+#include <algorithm>
+
+namespace Visca {
+
+LineScheduler::LineScheduler()
+    : LineScheduler(Config())
+{
+}
+
+LineScheduler::LineScheduler(const Config& config)
+    : m_config(config)
+{
+}
+
+void LineScheduler::setBudget(uint8_t address, const Budget& budget) { m_budgets[address] = budget; }
+
+bool LineScheduler::admit(const uint8_t* packet, size_t size, Clock::time_point now, Clock::time_point& sendAt)
+{
+    if (!packet || size == 0)
+        return false;
+
+    const Class cls = classify(packet, size);
+    const uint8_t address = packet[0] & 0x0F;
+    const auto request = wireTime(size, m_config.baudRate);
+    const auto reply = wireTime(
+        cls == Class::Telemetry ? m_config.inquiryReplyBytes : m_config.commandReplyBytes, m_config.baudRate);
+    const auto cost = std::max(request, reply);
+    const double share = shareOf(address, cls);
+
+    Account& account = m_accounts[static_cast<uint16_t>(address << 8 | static_cast<uint8_t>(cls))];
+    refill(account, share, now);
+
+    // The request needs the transmit side, its reply must find the receive side free once the request is out
+    Clock::time_point start = std::max({ now, m_transmitFreeAt, m_receiveFreeAt - request });
+    const bool overBudget = account.tokens < Clock::duration::zero();
+    if (overBudget)
+        start = std::max(start, now + Clock::duration(static_cast<Clock::rep>(-account.tokens.count() / share)));
+    const auto delay = start - now;
+
+    // Telemetry over budget would hold the line for everybody else while it waits for its tokens
+    Stats& total = m_stats[static_cast<size_t>(cls)];
+    if (cls == Class::Telemetry && (overBudget || delay > m_config.maxTelemetryDelay)) {
+        ++account.stats.shed;
+        ++total.shed;
+        return false;
+    }
+
+    account.tokens -= cost;
+    m_transmitFreeAt = start + request;
+    m_receiveFreeAt = std::max(m_receiveFreeAt, m_transmitFreeAt) + reply;
+    book(m_transmitted, start, m_transmitFreeAt, now);
+
+    for (Stats* stats : { &account.stats, &total }) {
+        ++stats->admitted;
+        if (delay > Clock::duration::zero())
+            ++stats->deferred;
+        stats->bytes += size;
+        stats->wireTime += cost;
+        stats->totalDelay += delay;
+        stats->maxDelay = std::max(stats->maxDelay, delay);
+    }
+
+    sendAt = start;
+    return true;
+}
+
+void LineScheduler::onReceived(size_t bytes, Clock::time_point now)
+{
+    if (bytes == 0)
+        return;
+
+    // Bytes read together arrived back to back, but not before the previous ones
+    Clock::time_point start = now - wireTime(bytes, m_config.baudRate);
+    if (!m_received.empty())
+        start = std::max(start, m_received.back().end);
+    book(m_received, start, std::max(start, now), now);
+    m_receiveFreeAt = std::max(m_receiveFreeAt, now);
+}
+
+LineScheduler::Clock::duration LineScheduler::backlog(Clock::time_point now) const
+{
+    return std::max(std::max(m_transmitFreeAt, m_receiveFreeAt) - now, Clock::duration::zero());
+}
+
+LineScheduler::Utilisation LineScheduler::utilisation(Clock::time_point now) const
+{
+    Utilisation result;
+    result.transmit = busyFraction(m_transmitted, now);
+    result.receive = busyFraction(m_received, now);
+    return result;
+}
+
+LineScheduler::Stats LineScheduler::cameraStats(uint8_t address, Class cls) const
+{
+    auto it = m_accounts.find(static_cast<uint16_t>(address << 8 | static_cast<uint8_t>(cls)));
+    return it != m_accounts.end() ? it->second.stats : Stats();
+}
+
+LineScheduler::Class LineScheduler::classify(const uint8_t* packet, size_t size)
+{
+    // 8x 09 .. FF asks, everything else (8x 01 commands, 8x 2z cancels, 88 broadcasts) changes the camera
+    return size >= 3 && packet[1] == 0x09 ? Class::Telemetry : Class::Control;
+}
+
+LineScheduler::Clock::duration LineScheduler::wireTime(size_t bytes, uint32_t baudRate)
+{
+    if (baudRate == 0)
+        return Clock::duration::zero();
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::nanoseconds(static_cast<int64_t>(bytes) * 10 * 1000000000LL / baudRate));
+}
+
+double LineScheduler::clampShare(double share) { return std::min(std::max(share, 0.01), 1.0); }
+
+double LineScheduler::shareOf(uint8_t address, Class cls) const
+{
+    auto it = m_budgets.find(address);
+    const Budget& budget = it != m_budgets.end() ? it->second : m_config.budget;
+    return clampShare(cls == Class::Telemetry ? budget.telemetry : budget.control);
+}
+
+void LineScheduler::refill(Account& account, double share, Clock::time_point now) const
+{
+    const auto capacity = Clock::duration(static_cast<Clock::rep>(m_config.burst.count() * share));
+    if (!account.primed) {
+        account.tokens = capacity;
+        account.refilled = now;
+        account.primed = true;
+        return;
+    }
+    if (now <= account.refilled)
+        return;
+
+    const auto earned = Clock::duration(static_cast<Clock::rep>((now - account.refilled).count() * share));
+    account.tokens = std::min(account.tokens + earned, capacity);
+    account.refilled = now;
+}
+
+void LineScheduler::book(
+    std::deque<Interval>& history, Clock::time_point start, Clock::time_point end, Clock::time_point now)
+{
+    while (!history.empty() && history.front().end < now - m_config.window)
+        history.pop_front();
+    history.push_back({ start, end });
+}
+
+double LineScheduler::busyFraction(const std::deque<Interval>& history, Clock::time_point now) const
+{
+    if (m_config.window <= Clock::duration::zero())
+        return 0.0;
+
+    const Clock::time_point from = now - m_config.window;
+    Clock::duration busy { 0 };
+    for (const auto& interval : history) {
+        auto start = std::max(interval.start, from);
+        auto end = std::min(interval.end, now);
+        if (end > start)
+            busy += end - start;
+    }
+    return static_cast<double>(busy.count()) / static_cast<double>(m_config.window.count());
+}
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "Export.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+
+namespace Visca {
+
+/**
+ * @brief Budgets the wire time of a serial VISCA line.
+ *
+ * At 9600 baud a byte takes about 1 ms, so a few cameras polled for their position together with operator commands
+ * can ask for more than the line carries and the queue in front of it grows without bound. The scheduler books every
+ * packet on a model of the line before it is written: the request on the transmit side, the reply it will cause
+ * (configured sizes) on the receive side, whichever of the two is busier decides when it can go.
+ *
+ * Packets are control (commands, cancels, broadcasts) or telemetry (inquiries). Each camera address has a budget per
+ * class, a share of the line enforced with a token bucket. Control is never refused, it is deferred until the line
+ * and its budget allow it. Telemetry over its budget, or that would have to wait for the line longer than
+ * maxTelemetryDelay, is shed; a poller simply asks again later, so control keeps at least the part of the line the
+ * telemetry budgets leave over.
+ *
+ * The scheduler does no I/O and takes the time as a parameter. Not thread-safe.
+ */
+class VISCA_EXPORT LineScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Class : uint8_t {
+        Control,
+        Telemetry
+    };
+
+    /**
+     * @brief Shares of the line (0.01 .. 1) one camera may use per class.
+     */
+    struct Budget {
+        double control { 1.0 };
+        double telemetry { 0.5 };
+    };
+
+    struct Config {
+        uint32_t baudRate { 9600 };
+        Budget budget; ///< For cameras without their own budget
+        Clock::duration burst { std::chrono::milliseconds(100) }; ///< Wire time a bucket saves up at its share
+        Clock::duration maxTelemetryDelay { std::chrono::milliseconds(20) }; ///< Longer waits shed the inquiry
+        size_t inquiryReplyBytes { 7 }; ///< Expected reply to an inquiry, y0 50 p q r s FF
+        size_t commandReplyBytes { 6 }; ///< ACK and completion
+        Clock::duration window { std::chrono::seconds(1) }; ///< Span of utilisation()
+    };
+
+    struct Stats {
+        uint64_t admitted { 0 };
+        uint64_t deferred { 0 }; ///< Admitted, but not for immediate sending
+        uint64_t shed { 0 };
+        uint64_t bytes { 0 }; ///< Of admitted packets
+        Clock::duration wireTime { 0 }; ///< Line time booked, request or reply side
+        Clock::duration totalDelay { 0 };
+        Clock::duration maxDelay { 0 };
+    };
+
+    /**
+     * @brief Busy fraction of each direction over the last window.
+     */
+    struct Utilisation {
+        double transmit { 0.0 };
+        double receive { 0.0 };
+    };
+
+    LineScheduler();
+    explicit LineScheduler(const Config& config);
+
+    /**
+     * @brief Budget of one camera address (1-7), replacing the default one.
+     */
+    void setBudget(uint8_t address, const Budget& budget);
+
+    /**
+     * @brief Book a packet on the line.
+     * @param sendAt Receives the time the packet should be written.
+     * @return false if the packet is shed, nothing is booked then.
+     */
+    bool admit(const uint8_t* packet, size_t size, Clock::time_point now, Clock::time_point& sendAt);
+
+    /**
+     * @brief Account bytes read from the line, they end at now.
+     */
+    void onReceived(size_t bytes, Clock::time_point now);
+
+    /**
+     * @brief How far ahead of now the line is booked.
+     */
+    Clock::duration backlog(Clock::time_point now) const;
+
+    Utilisation utilisation(Clock::time_point now) const;
+    const Stats& stats(Class cls) const { return m_stats[static_cast<size_t>(cls)]; }
+    Stats cameraStats(uint8_t address, Class cls) const;
+    const Config& config() const { return m_config; }
+
+    static Class classify(const uint8_t* packet, size_t size);
+
+    /**
+     * @brief Time a number of bytes occupies a serial line at the given baud rate (10 bits per byte, 8N1).
+     */
+    static Clock::duration wireTime(size_t bytes, uint32_t baudRate);
+
+private:
+    struct Account {
+        Clock::duration tokens { 0 }; ///< Negative while the class is in debt
+        Clock::time_point refilled {};
+        bool primed { false };
+        Stats stats;
+    };
+
+    struct Interval {
+        Clock::time_point start;
+        Clock::time_point end;
+    };
+
+    static double clampShare(double share);
+    double shareOf(uint8_t address, Class cls) const;
+    void refill(Account& account, double share, Clock::time_point now) const;
+    void book(std::deque<Interval>& history, Clock::time_point start, Clock::time_point end, Clock::time_point now);
+    double busyFraction(const std::deque<Interval>& history, Clock::time_point now) const;
+
+    Config m_config;
+    std::map<uint8_t, Budget> m_budgets;
+    std::map<uint16_t, Account> m_accounts; ///< Address << 8 | class
+    Clock::time_point m_transmitFreeAt {};
+    Clock::time_point m_receiveFreeAt {};
+    std::deque<Interval> m_transmitted;
+    std::deque<Interval> m_received;
+    Stats m_stats[2];
+};
+
+}
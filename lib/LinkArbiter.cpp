@@ -0,0 +1,241 @@
+#include "LinkArbiter.h"
+
+#include <algorithm>
+
+namespace Visca {
+
+LinkArbiter::LinkArbiter()
+    : LinkArbiter(Config())
+{
+}
+
+LinkArbiter::LinkArbiter(const Config& config)
+    : m_config(config)
+{
+}
+
+bool LinkArbiter::submit(
+    ClientId client, uint32_t tag, const uint8_t* packet, size_t size, Clock::time_point now, std::vector<Output>& out)
+{
+    if (size < 3)
+        return false;
+
+    auto& queue = m_queues[client];
+    if (queue.size() >= m_config.maxQueued) {
+        ++m_stats.rejected;
+        auto reply = errorReply(packet[0], 0, 0x03);
+        route(client, tag, reply.data(), reply.size(), out);
+        return false;
+    }
+
+    Packet queued;
+    queued.tag = tag;
+    queued.data.assign(packet, packet + size);
+    queued.kind = classify(queued.data);
+    queued.queued = now;
+    queue.push_back(std::move(queued));
+    ++m_stats.submitted;
+    return true;
+}
+
+bool LinkArbiter::next(Dispatch& dispatch, Clock::time_point now)
+{
+    if (m_busy || m_queues.empty())
+        return false;
+
+    // Round robin: start with the client after the one served last, wrap around once
+    auto start = m_queues.upper_bound(m_cursor);
+    for (size_t visited = 0; visited < m_queues.size(); ++visited, ++start) {
+        if (start == m_queues.end())
+            start = m_queues.begin();
+
+        auto& queue = start->second;
+        if (queue.empty() || !mayDispatch(queue.front().kind))
+            continue;
+
+        Packet& packet = queue.front();
+        dispatch.client = start->first;
+        dispatch.tag = packet.tag;
+        dispatch.data = std::move(packet.data);
+        dispatch.eligible = std::max(packet.queued, m_freeSince);
+
+        m_busy = true;
+        m_outstanding = { start->first, packet.tag, packet.kind, now };
+        m_cursor = start->first;
+        ++m_stats.dispatched;
+
+        queue.pop_front();
+        if (queue.empty())
+            m_queues.erase(start);
+        return true;
+    }
+    return false;
+}
+
+void LinkArbiter::onReply(const uint8_t* frame, size_t size, Clock::time_point now, std::vector<Output>& out)
+{
+    if (size < 3) {
+        ++m_stats.unroutable;
+        return;
+    }
+
+    // Broadcasts come back around the daisy chain, IF_Clear also empties the sockets
+    if (frame[0] == 0x88) {
+        if (m_busy && m_outstanding.kind == Kind::Broadcast) {
+            if (frame[1] == 0x01)
+                m_sockets.clear();
+            route(m_outstanding.client, m_outstanding.tag, frame, size, out);
+            finishOutstanding(now);
+        } else {
+            route(AllClients, 0, frame, size, out);
+        }
+        return;
+    }
+
+    uint8_t socket = frame[1] & 0x0F;
+    auto owner = m_sockets.find(socket);
+
+    switch (frame[1] & 0xF0) {
+    case 0x40:
+        if (m_busy && m_outstanding.kind == Kind::Command) {
+            m_sockets[socket] = { m_outstanding.client, m_outstanding.tag, now };
+            route(m_outstanding.client, m_outstanding.tag, frame, size, out);
+            finishOutstanding(now);
+            return;
+        }
+        break;
+    case 0x50:
+        if (socket == 0 && m_busy && m_outstanding.kind == Kind::Inquiry) {
+            route(m_outstanding.client, m_outstanding.tag, frame, size, out);
+            finishOutstanding(now);
+            return;
+        }
+        if (socket != 0 && owner != m_sockets.end()) {
+            route(owner->second.client, owner->second.tag, frame, size, out);
+            m_sockets.erase(owner);
+            if (!m_busy)
+                m_freeSince = now;
+            return;
+        }
+        break;
+    case 0x60: {
+        uint8_t code = size > 3 ? frame[2] : 0;
+        // A cancel is answered by "cancelled" or "no socket", which also ends the command it cancelled
+        if (m_busy && m_outstanding.kind == Kind::Cancel && (code == 0x04 || code == 0x05)) {
+            if (owner != m_sockets.end())
+                m_sockets.erase(owner);
+            route(m_outstanding.client, m_outstanding.tag, frame, size, out);
+            finishOutstanding(now);
+            return;
+        }
+        // Any other error on a socket holding a running command ends that command, whoever's packet is outstanding
+        if (socket != 0 && owner != m_sockets.end()) {
+            route(owner->second.client, owner->second.tag, frame, size, out);
+            m_sockets.erase(owner);
+            if (!m_busy)
+                m_freeSince = now;
+            return;
+        }
+        // Otherwise it is the first reply to the outstanding packet; "cancelled" never is
+        if (m_busy && code != 0x04) {
+            route(m_outstanding.client, m_outstanding.tag, frame, size, out);
+            finishOutstanding(now);
+            return;
+        }
+        break;
+    }
+    default:
+        // Notifications such as network change (x0 38 FF) concern every client
+        route(AllClients, 0, frame, size, out);
+        return;
+    }
+
+    ++m_stats.unroutable;
+}
+
+void LinkArbiter::expire(Clock::time_point now)
+{
+    if (m_busy && now - m_outstanding.sent >= m_config.replyTimeout) {
+        ++m_stats.replyTimeouts;
+        finishOutstanding(now);
+    }
+
+    for (auto it = m_sockets.begin(); it != m_sockets.end();) {
+        if (now - it->second.since >= m_config.completionTimeout) {
+            ++m_stats.completionTimeouts;
+            it = m_sockets.erase(it);
+            if (!m_busy)
+                m_freeSince = now;
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool LinkArbiter::nextDeadline(Clock::time_point& deadline) const
+{
+    bool any = false;
+    if (m_busy) {
+        deadline = m_outstanding.sent + m_config.replyTimeout;
+        any = true;
+    }
+    for (const auto& socket : m_sockets) {
+        auto due = socket.second.since + m_config.completionTimeout;
+        if (!any || due < deadline)
+            deadline = due;
+        any = true;
+    }
+    return any;
+}
+
+void LinkArbiter::removeClient(ClientId client) { m_queues.erase(client); }
+
+bool LinkArbiter::isIdle() const { return !m_busy && m_queues.empty() && m_sockets.empty(); }
+
+size_t LinkArbiter::queued() const
+{
+    size_t count = 0;
+    for (const auto& queue : m_queues)
+        count += queue.second.size();
+    return count;
+}
+
+LinkArbiter::Kind LinkArbiter::classify(const std::vector<uint8_t>& packet)
+{
+    if (packet[0] == 0x88)
+        return Kind::Broadcast;
+    if ((packet[1] & 0xF0) == 0x20)
+        return Kind::Cancel;
+    if (packet[1] == 0x09)
+        return Kind::Inquiry;
+    return Kind::Command;
+}
+
+std::vector<uint8_t> LinkArbiter::errorReply(uint8_t header, uint8_t socket, uint8_t code)
+{
+    // Reply header of camera x is (x + 8) << 4
+    uint8_t address = header & 0x07;
+    return { static_cast<uint8_t>((address + 8) << 4), static_cast<uint8_t>(0x60 | socket), code, 0xFF };
+}
+
+bool LinkArbiter::mayDispatch(Kind kind) const
+{
+    return kind != Kind::Command || m_sockets.size() < m_config.sockets;
+}
+
+void LinkArbiter::finishOutstanding(Clock::time_point now)
+{
+    m_busy = false;
+    m_freeSince = now;
+}
+
+void LinkArbiter::route(ClientId client, uint32_t tag, const uint8_t* frame, size_t size, std::vector<Output>& out)
+{
+    if (client == AllClients)
+        ++m_stats.broadcast;
+    else
+        ++m_stats.routed;
+    out.push_back({ client, tag, std::vector<uint8_t>(frame, frame + size) });
+}
+
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Export.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief Shares one VISCA link (a serial camera) between many clients.
+ *
+ * Each client has its own queue, the queues are served round robin. Exactly one packet is outstanding on the link
+ * until its first reply (ACK, inquiry reply, error, broadcast echo) arrives, because those replies carry nothing that
+ * identifies the packet they answer. A command that was ACKed keeps its socket until completion, and commands wait
+ * while all camera sockets are busy, but inquiries and cancels pass them so both sockets stay filled and inquiries
+ * are answered in the meantime. Replies are routed to the client whose packet caused them; anything the arbiter
+ * cannot attribute (network change notifications) goes to all clients.
+ *
+ * The arbiter does no I/O and takes the time as a parameter, the caller writes what next() returns to the link and
+ * feeds every frame read from the link into onReply(). Not thread-safe.
+ */
+class VISCA_EXPORT LinkArbiter {
+public:
+    using Clock = std::chrono::steady_clock;
+    using ClientId = uint32_t;
+
+    static constexpr ClientId AllClients = 0xFFFFFFFF;
+
+    struct Config {
+        uint8_t sockets { 2 }; ///< Command buffers of the camera
+        size_t maxQueued { 32 }; ///< Per client, further packets are answered with "buffer full"
+        Clock::duration replyTimeout { std::chrono::milliseconds(200) }; ///< Wait for the first reply
+        Clock::duration completionTimeout { std::chrono::seconds(10) }; ///< A socket is reclaimed after this
+    };
+
+    struct Stats {
+        uint64_t submitted { 0 };
+        uint64_t dispatched { 0 }; ///< Packets handed to the link
+        uint64_t routed { 0 }; ///< Replies delivered to one client
+        uint64_t broadcast { 0 }; ///< Replies delivered to all clients
+        uint64_t unroutable { 0 }; ///< Replies nobody was waiting for
+        uint64_t rejected { 0 }; ///< Packets refused because the client queue was full
+        uint64_t replyTimeouts { 0 };
+        uint64_t completionTimeouts { 0 };
+    };
+
+    /**
+     * @brief A packet to write to the link.
+     */
+    struct Dispatch {
+        ClientId client { 0 };
+        uint32_t tag { 0 };
+        std::vector<uint8_t> data;
+        Clock::time_point eligible {}; ///< When the packet could have been sent, queued or link becoming free
+    };
+
+    /**
+     * @brief A reply for a client.
+     */
+    struct Output {
+        ClientId client { 0 };
+        uint32_t tag { 0 }; ///< Tag of the packet the reply belongs to
+        std::vector<uint8_t> data;
+    };
+
+    LinkArbiter();
+    explicit LinkArbiter(const Config& config);
+
+    /**
+     * @brief Queue a packet from a client.
+     * @param tag Opaque value returned with the replies, e.g. a VISCA-over-IP sequence number.
+     * @param out Receives a "buffer full" error if the client's queue is full.
+     * @return false if the packet was rejected.
+     */
+    bool submit(ClientId client, uint32_t tag, const uint8_t* packet, size_t size, Clock::time_point now,
+        std::vector<Output>& out);
+
+    /**
+     * @brief Take the next packet to write, if the link is free and a queued packet may go.
+     */
+    bool next(Dispatch& dispatch, Clock::time_point now);
+
+    /**
+     * @brief Route a 0xFF-terminated frame read from the link.
+     */
+    void onReply(const uint8_t* frame, size_t size, Clock::time_point now, std::vector<Output>& out);
+
+    /**
+     * @brief Give up on a missing first reply and reclaim sockets whose completion never came.
+     */
+    void expire(Clock::time_point now);
+
+    /**
+     * @brief Earliest time expire() has something to do.
+     * @return false if nothing is outstanding.
+     */
+    bool nextDeadline(Clock::time_point& deadline) const;
+
+    /**
+     * @brief Drop the queue of a client that went away. Commands it already started keep their socket until they
+     * complete, their replies are still returned for the departed client.
+     */
+    void removeClient(ClientId client);
+
+    bool isIdle() const; ///< Nothing queued or outstanding
+    size_t queued() const;
+    size_t busySockets() const { return m_sockets.size(); }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    enum class Kind { Command, Inquiry, Cancel, Broadcast };
+
+    struct Packet {
+        uint32_t tag { 0 };
+        Kind kind { Kind::Command };
+        std::vector<uint8_t> data;
+        Clock::time_point queued {};
+    };
+
+    struct Outstanding {
+        ClientId client { 0 };
+        uint32_t tag { 0 };
+        Kind kind { Kind::Command };
+        Clock::time_point sent {};
+    };
+
+    struct Socket {
+        ClientId client { 0 };
+        uint32_t tag { 0 };
+        Clock::time_point since {};
+    };
+
+    static Kind classify(const std::vector<uint8_t>& packet);
+    static std::vector<uint8_t> errorReply(uint8_t header, uint8_t socket, uint8_t code);
+    bool mayDispatch(Kind kind) const;
+    void finishOutstanding(Clock::time_point now);
+    void route(ClientId client, uint32_t tag, const uint8_t* frame, size_t size, std::vector<Output>& out);
+
+    Config m_config;
+    std::map<ClientId, std::deque<Packet>> m_queues;
+    ClientId m_cursor { 0 }; ///< Round robin position, the client served last
+    bool m_busy { false }; ///< A packet waits for its first reply
+    Outstanding m_outstanding;
+    std::map<uint8_t, Socket> m_sockets; ///< Camera sockets holding a running command
+    Clock::time_point m_freeSince {}; ///< When the link last became free for more packets
+    Stats m_stats;
+};
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Export.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace Visca {
+
+/**
+ * @brief Bounded lock-free queue for any number of producers and consumers.
+ *
+ * Each cell carries a sequence number telling whose turn it is: a producer claims the cell at the enqueue position
+ * with one compare-and-swap and publishes the item by bumping the cell's sequence, a consumer does the same at the
+ * dequeue position. Neither side ever waits for the other; push() fails when full, pop() when empty. The capacity is
+ * rounded up to a power of two.
+ */
+template <typename T> class VISCA_EXPORT LockFreeQueue {
+public:
+    explicit LockFreeQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        m_cells.reset(new Cell[size]);
+        m_mask = size - 1;
+        for (size_t i = 0; i < size; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    bool push(T&& item)
+    {
+        size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = m_cells[position & m_mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+            if (difference == 0) {
+                if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.item = std::move(item);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false; // Full, the cell still holds an item from the previous lap
+            } else {
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T& item)
+    {
+        size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = m_cells[position & m_mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+            if (difference == 0) {
+                if (m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    item = std::move(cell.item);
+                    cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false; // Empty
+            } else {
+                position = m_dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Approximate number of queued items, exact only while no one pushes or pops.
+     */
+    size_t size() const
+    {
+        size_t enqueued = m_enqueuePosition.load(std::memory_order_relaxed);
+        size_t dequeued = m_dequeuePosition.load(std::memory_order_relaxed);
+        return enqueued >= dequeued ? enqueued - dequeued : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask { 0 };
+    alignas(64) std::atomic<size_t> m_enqueuePosition { 0 };
+    alignas(64) std::atomic<size_t> m_dequeuePosition { 0 };
+};
+
+}
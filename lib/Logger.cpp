@@ -1,12 +1,37 @@
 #include "Logger.h"
+#include <algorithm>
 #include <chrono>
 #include <cstdarg>
+#include <cstdio>
 #include <cstring>
 #include <ctime>
-#include <iomanip>
 
 namespace Visca {
 
+namespace {
+    thread_local bool s_writingOutputs = false;
+}
+
+std::ostream& operator<<(std::ostream& os, const LogHex& hex)
+{
+    static const char Digits[] = "0123456789ABCDEF";
+
+    char buffer[3 * 64];
+    size_t length = 0;
+    for (size_t i = 0; i < hex.size; ++i) {
+        if (length + 3 > sizeof(buffer)) {
+            os.write(buffer, static_cast<std::streamsize>(length));
+            length = 0;
+        }
+        if (i > 0)
+            buffer[length++] = ' ';
+        buffer[length++] = Digits[hex.data[i] >> 4];
+        buffer[length++] = Digits[hex.data[i] & 0x0F];
+    }
+    os.write(buffer, static_cast<std::streamsize>(length));
+    return os;
+}
+
 Logger& Logger::instance()
 {
     static Logger s_instance;
@@ -15,29 +40,19 @@ Logger& Logger::instance()
 
 Logger::Logger() { }
 
-void Logger::setLevel(LogLevel level)
+Logger::~Logger()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_currentLevel = level;
+    stopAsync();
+    closeBinary();
 }
 
-LogLevel Logger::getLevel() const
-{
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_currentLevel;
-}
+void Logger::setLevel(LogLevel level) { m_currentLevel.store(level, std::memory_order_relaxed); }
 
-void Logger::enableLogging(bool enable)
-{
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_loggingEnabled = enable;
-}
+LogLevel Logger::getLevel() const { return m_currentLevel.load(std::memory_order_relaxed); }
 
-bool Logger::isLoggingEnabled() const
-{
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_loggingEnabled;
-}
+void Logger::enableLogging(bool enable) { m_loggingEnabled.store(enable, std::memory_order_relaxed); }
+
+bool Logger::isLoggingEnabled() const { return m_loggingEnabled.load(std::memory_order_relaxed); }
 
 void Logger::setOutput(std::ostream* output)
 {
@@ -46,10 +61,27 @@ void Logger::setOutput(std::ostream* output)
     m_useConsole = true;
 }
 
-bool Logger::setOutputFile(const std::string& filename, bool append)
+bool Logger::setOutputFile(const std::string& filename, bool append, LogFormat format)
 {
+    closeBinary();
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    if (format == LogFormat::Binary) {
+        if (!m_binaryWriter)
+            m_binaryWriter = std::make_unique<BinaryLogWriter>();
+        if (!m_binaryWriter->open(filename))
+            return false;
+        if (m_fileOutput) {
+            m_fileOutput->close();
+            m_fileOutput.reset();
+        }
+        m_rotatingOutput.reset();
+        m_useFile = false;
+        m_useConsole = false;
+        m_binary.store(true, std::memory_order_release);
+        return true;
+    }
+
     try {
         auto fileStream = std::make_unique<std::ofstream>();
         std::ios_base::openmode mode = std::ios_base::out;
@@ -60,6 +92,7 @@ bool Logger::setOutputFile(const std::string& filename, bool append)
         fileStream->open(filename, mode);
         if (fileStream->is_open()) {
             m_fileOutput = std::move(fileStream);
+            m_rotatingOutput.reset();
             m_useFile = true;
             m_useConsole = false;
             return true;
@@ -71,8 +104,33 @@ bool Logger::setOutputFile(const std::string& filename, bool append)
     return false;
 }
 
+bool Logger::setRotatingOutputFile(const std::string& filename)
+{
+    return setRotatingOutputFile(filename, RotatingFile::Options());
+}
+
+bool Logger::setRotatingOutputFile(const std::string& filename, const RotatingFile::Options& options)
+{
+    closeBinary();
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto file = std::make_unique<RotatingFile>(options);
+    if (!file->open(filename))
+        return false;
+
+    if (m_fileOutput) {
+        m_fileOutput->close();
+        m_fileOutput.reset();
+    }
+    m_rotatingOutput = std::move(file);
+    m_useFile = true;
+    m_useConsole = false;
+    return true;
+}
+
 void Logger::setOutputToConsole()
 {
+    closeBinary();
     std::lock_guard<std::mutex> lock(m_mutex);
     m_useConsole = true;
     m_useFile = false;
@@ -80,10 +138,12 @@ void Logger::setOutputToConsole()
         m_fileOutput->close();
         m_fileOutput.reset();
     }
+    m_rotatingOutput.reset();
 }
 
 void Logger::setOutputToBoth(std::ostream* consoleOutput, const std::string& filename, bool append)
 {
+    closeBinary();
     std::lock_guard<std::mutex> lock(m_mutex);
 
     m_consoleOutput = consoleOutput;
@@ -99,6 +159,7 @@ void Logger::setOutputToBoth(std::ostream* consoleOutput, const std::string& fil
         fileStream->open(filename, mode);
         if (fileStream->is_open()) {
             m_fileOutput = std::move(fileStream);
+            m_rotatingOutput.reset();
             m_useFile = true;
         }
     } catch (...) {
@@ -108,34 +169,32 @@ void Logger::setOutputToBoth(std::ostream* consoleOutput, const std::string& fil
 
 void Logger::closeFile()
 {
+    closeBinary();
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_fileOutput) {
         m_fileOutput->close();
         m_fileOutput.reset();
     }
+    m_rotatingOutput.reset();
     m_useFile = false;
 }
 
-void Logger::enableLocationInfo(bool enable)
-{
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_showLocation = enable;
-}
+void Logger::enableLocationInfo(bool enable) { m_showLocation.store(enable, std::memory_order_relaxed); }
 
-bool Logger::isLocationInfoEnabled() const
-{
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_showLocation;
-}
+bool Logger::isLocationInfoEnabled() const { return m_showLocation.load(std::memory_order_relaxed); }
 
-bool Logger::shouldLog(LogLevel level) const
+void Logger::closeBinary()
 {
-    // Check if logging is globally enabled and if the level meets the threshold
-    return m_loggingEnabled && (level <= m_currentLevel);
+    if (!m_binary.exchange(false))
+        return;
+    m_binaryWriter->close();
 }
 
-void Logger::writeToOutputs(const std::string& formattedMessage)
+void Logger::writeToOutputs(const std::string& formattedMessage, bool durable)
 {
+    // A failing output logs its error from in here, that line goes to stderr instead of deadlocking on m_mutex
+    s_writingOutputs = true;
+
     if (m_useConsole && m_consoleOutput) {
         *m_consoleOutput << formattedMessage;
     }
@@ -144,6 +203,14 @@ void Logger::writeToOutputs(const std::string& formattedMessage)
         *m_fileOutput << formattedMessage;
         m_fileOutput->flush();
     }
+
+    if (m_useFile && m_rotatingOutput) {
+        m_rotatingOutput->write(formattedMessage.data(), formattedMessage.size());
+        if (durable)
+            m_rotatingOutput->sync();
+    }
+
+    s_writingOutputs = false;
 }
 
 const char* Logger::extractFileName(const char* filePath)
@@ -160,44 +227,104 @@ const char* Logger::extractFileName(const char* filePath)
     return (lastSlash != nullptr) ? lastSlash + 1 : filePath;
 }
 
+void Logger::format(const Record& record, std::string& out) const
+{
+    // localtime_r is only needed when the second changes, the writer thread formats many lines per second
+    thread_local std::time_t s_second = -1;
+    thread_local char s_clock[16];
+
+    auto since = record.time.time_since_epoch();
+    std::time_t second = std::chrono::system_clock::to_time_t(record.time);
+    if (second != s_second) {
+        std::tm tm;
+#ifdef _WIN32
+        localtime_s(&tm, &second);
+#else
+        localtime_r(&second, &tm);
+#endif
+        std::strftime(s_clock, sizeof(s_clock), "%H:%M:%S", &tm);
+        s_second = second;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(since).count() % 1000;
+
+    char prefix[160];
+    int length;
+    if (m_showLocation.load(std::memory_order_relaxed) && record.file && record.function)
+        length = std::snprintf(prefix, sizeof(prefix), "[%s.%03d] [%s] [%s:%d %s] ", s_clock, static_cast<int>(ms),
+            levelToString(record.level), extractFileName(record.file), record.line, record.function);
+    else
+        length = std::snprintf(
+            prefix, sizeof(prefix), "[%s.%03d] [%s] ", s_clock, static_cast<int>(ms), levelToString(record.level));
+
+    out.append(prefix, static_cast<size_t>(std::min(std::max(length, 0), static_cast<int>(sizeof(prefix) - 1))));
+    out.append(record.message);
+    out.push_back('\n');
+}
+
 void Logger::log(LogLevel level, const char* file, const char* function, int line, const std::string& message)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    if (isEnabled(level))
+        log(level, file, function, line, std::string(message));
+}
 
-    if (!shouldLog(level))
+void Logger::log(LogLevel level, const char* file, const char* function, int line, std::string&& message)
+{
+    if (!isEnabled(level))
         return;
 
-    auto now = std::chrono::system_clock::now();
-    auto timeT = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-
-    std::tm tm = *std::localtime(&timeT);
-
-    std::ostringstream formattedMessage;
-
-    // Timestamp
-    formattedMessage << "[" << std::put_time(&tm, "%H:%M:%S") << "." << std::setfill('0') << std::setw(3) << ms.count()
-                     << "]";
+    if (s_writingOutputs) {
+        std::cerr << levelToString(level) << ": " << message << std::endl;
+        return;
+    }
 
-    // Log level
-    formattedMessage << " [" << levelToString(level) << "]";
+    if (m_binary.load(std::memory_order_acquire)) {
+        m_binaryWriter->push(level, file, function, line, message);
+        return;
+    }
 
-    // Location info (if enabled)
-    if (m_showLocation && file && function) {
-        formattedMessage << " [" << extractFileName(file) << ":" << line << " " << function << "]";
+    Record record;
+    record.level = level;
+    record.file = file;
+    record.function = function;
+    record.line = line;
+    record.time = std::chrono::system_clock::now();
+
+    record.message = std::move(message);
+
+    if (m_async.load(std::memory_order_acquire)) {
+        if (!m_queue->push(std::move(record))) {
+            if (m_asyncOptions.overflow == LogOverflow::Drop) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            wakeWriter();
+            while (!m_queue->push(std::move(record)))
+                std::this_thread::yield();
+        }
+        m_queued.fetch_add(1, std::memory_order_relaxed);
+
+        // The writer comes round every flush interval by itself, waking it costs a system call and, on a busy
+        // machine, a context switch on the logging thread
+        if (level != LogLevel::Error && m_queue->size() < m_queue->capacity() / 2)
+            return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_writerIdle.load(std::memory_order_relaxed))
+            wakeWriter();
+        return;
     }
 
-    // Actual message
-    formattedMessage << " " << message << std::endl;
+    std::string formattedMessage;
+    format(record, formattedMessage);
 
-    writeToOutputs(formattedMessage.str());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    writeToOutputs(formattedMessage, level == LogLevel::Error);
+    if (m_useConsole && m_consoleOutput)
+        m_consoleOutput->flush();
 }
 
 void Logger::log(LogLevel level, const char* file, const char* function, int line, const char* format, ...)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    if (!shouldLog(level))
+    if (!isEnabled(level))
         return;
 
     char buffer[2048];
@@ -209,6 +336,133 @@ void Logger::log(LogLevel level, const char* file, const char* function, int lin
     log(level, file, function, line, std::string(buffer));
 }
 
+void Logger::log(BinaryLogRecord& record)
+{
+    if (m_binary.load(std::memory_order_acquire))
+        m_binaryWriter->push(std::move(record));
+}
+
+bool Logger::startAsync() { return startAsync(AsyncOptions()); }
+
+bool Logger::startAsync(const AsyncOptions& options)
+{
+    stopAsync();
+
+    m_asyncOptions = options;
+    if (m_asyncOptions.batchSize == 0)
+        m_asyncOptions.batchSize = 1;
+    m_queue = std::make_unique<LockFreeQueue<Record>>(options.capacity);
+    m_queued = 0;
+    m_written = 0;
+    m_writerRunning = true;
+    m_writer = std::thread(&Logger::writerThread, this);
+    m_async.store(true, std::memory_order_release);
+    return true;
+}
+
+void Logger::stopAsync()
+{
+    if (!m_writer.joinable())
+        return;
+
+    m_async.store(false, std::memory_order_release);
+    m_writerRunning = false;
+    wakeWriter();
+    m_writer.join();
+
+    // Messages of threads that saw the asynchronous mode just before it ended
+    Record record;
+    std::string lines;
+    bool durable = false;
+    while (m_queue->pop(record)) {
+        format(record, lines);
+        durable = durable || record.level == LogLevel::Error;
+    }
+    if (!lines.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        writeToOutputs(lines, durable);
+    }
+}
+
+void Logger::flush()
+{
+    if (m_binary.load(std::memory_order_acquire))
+        m_binaryWriter->flush();
+    if (!m_async.load(std::memory_order_acquire))
+        return;
+
+    uint64_t target = m_queued.load(std::memory_order_relaxed);
+    while (m_written.load(std::memory_order_acquire) < target && m_writerRunning) {
+        wakeWriter();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+uint64_t Logger::droppedMessages() const
+{
+    uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (m_binaryWriter)
+        dropped += m_binaryWriter->dropped();
+    return dropped;
+}
+
+void Logger::wakeWriter()
+{
+    m_writerIdle.store(false, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_writerMutex);
+    m_writerCond.notify_one();
+}
+
+void Logger::writerThread()
+{
+    std::string batch;
+    uint64_t reportedDrops = m_dropped.load(std::memory_order_relaxed);
+
+    for (;;) {
+        Record record;
+        size_t count = 0;
+        bool durable = false;
+        batch.clear();
+        while (count < m_asyncOptions.batchSize && m_queue->pop(record)) {
+            format(record, batch);
+            durable = durable || record.level == LogLevel::Error;
+            ++count;
+        }
+
+        uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if (dropped != reportedDrops) {
+            Record notice;
+            notice.level = LogLevel::Warning;
+            notice.time = std::chrono::system_clock::now();
+            notice.message = "Logger: " + std::to_string(dropped - reportedDrops) + " messages dropped, queue full";
+            format(notice, batch);
+            reportedDrops = dropped;
+        }
+
+        if (!batch.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                writeToOutputs(batch, durable);
+                if (m_useConsole && m_consoleOutput)
+                    m_consoleOutput->flush();
+            }
+            m_written.fetch_add(count, std::memory_order_release);
+            continue;
+        }
+
+        if (!m_writerRunning)
+            break;
+
+        // Announce the wait before the last look at the queue, producers check the flag after pushing
+        std::unique_lock<std::mutex> lock(m_writerMutex);
+        m_writerIdle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_queue->empty() && m_writerRunning)
+            m_writerCond.wait_for(lock, std::chrono::milliseconds(m_asyncOptions.flushIntervalMs));
+        m_writerIdle.store(false, std::memory_order_relaxed);
+    }
+}
+
 const char* Logger::levelToString(LogLevel level)
 {
     switch (level) {
@@ -1,17 +1,57 @@
 #pragma once
 
+#include "BinaryLog.h"
 #include "Export.h"
+#include "LockFreeQueue.h"
+#include "RotatingFile.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 
 namespace Visca {
 
 enum class VISCA_EXPORT LogLevel { Error, Warning, Info, Debug };
 
+/**
+ * @brief What log() does in asynchronous mode when the queue is full.
+ */
+enum class VISCA_EXPORT LogOverflow {
+    Drop, ///< Discard the message and count it, the writer reports the count
+    Block ///< Wait for the writer to make room
+};
+
+/**
+ * @brief How setOutputFile() writes the log file.
+ */
+enum class VISCA_EXPORT LogFormat {
+    Text, ///< One formatted line per message
+    Binary ///< Call site ids and raw arguments, formatted later by ViscaLogDump
+};
+
+/**
+ * @brief Streams bytes as space separated hex pairs ("81 01 04 07 00 FF"), formatted in one pass.
+ */
+struct LogHex {
+    LogHex(const uint8_t* bytes, size_t count)
+        : data(bytes)
+        , size(count)
+    {
+    }
+
+    const uint8_t* data;
+    size_t size;
+};
+
+VISCA_EXPORT std::ostream& operator<<(std::ostream& os, const LogHex& hex);
+
 class VISCA_EXPORT Logger {
 public:
     static Logger& instance();
@@ -20,123 +60,176 @@ public:
     void setLevel(LogLevel level);
     LogLevel getLevel() const;
 
+    // Whether a message of this level would be written, lock-free
+    bool isEnabled(LogLevel level) const
+    {
+        return m_loggingEnabled.load(std::memory_order_relaxed)
+            && level <= m_currentLevel.load(std::memory_order_relaxed);
+    }
+
     // Global enable/disable
     void enableLogging(bool enable);
     bool isLoggingEnabled() const;
 
     // Output configuration
     void setOutput(std::ostream* output);
-    bool setOutputFile(const std::string& filename, bool append = true);
+
+    /**
+     * @brief Write the log to a file instead of the console. LogFormat::Binary always starts a new file (append is
+     * ignored): the VISCALOG_* macros then only copy their arguments into a queue, a background thread writes them
+     * and nothing is formatted until ViscaLogDump decodes the file. Switch at start-up, not while other threads log.
+     */
+    bool setOutputFile(const std::string& filename, bool append = true, LogFormat format = LogFormat::Text);
+
+    /**
+     * @brief Write text lines to a size-bounded set of rotating files instead of the console, see RotatingFile. Lines
+     * are copied into a memory mapping, no system call per line; Error lines are synced to the storage before log()
+     * (or, asynchronously, the writer's batch) returns.
+     */
+    bool setRotatingOutputFile(const std::string& filename);
+    bool setRotatingOutputFile(const std::string& filename, const RotatingFile::Options& options);
     void setOutputToConsole();
     void setOutputToBoth(std::ostream* consoleOutput, const std::string& filename, bool append = true);
     void closeFile();
 
     // Core logging methods with location info
     void log(LogLevel level, const char* file, const char* function, int line, const std::string& message);
+    void log(LogLevel level, const char* file, const char* function, int line, std::string&& message);
     void log(LogLevel level, const char* file, const char* function, int line, const char* format, ...);
+    void log(BinaryLogRecord& record);
+
+    // Whether the log goes to a binary file, the macros then fill a BinaryLogRecord instead of a stream
+    bool isBinary() const { return m_binary.load(std::memory_order_relaxed); }
+
+    static const char* levelToString(LogLevel level);
 
     // Configuration
     void enableLocationInfo(bool enable);
     bool isLocationInfoEnabled() const;
 
+    struct AsyncOptions {
+        size_t capacity { 8192 }; ///< Queued messages, rounded up to a power of two
+        LogOverflow overflow { LogOverflow::Drop };
+        size_t batchSize { 256 }; ///< Messages formatted and written per write, the file is flushed once per batch
+        int flushIntervalMs { 10 }; ///< Longest a message waits for the writer; errors and a half full queue wake it
+    };
+
+    /**
+     * @brief Asynchronous mode: log() only stamps the message and queues it on a lock-free queue, a background
+     * thread formats, batches and writes. Meant to be switched at start-up and shutdown, not while other threads log.
+     * Messages still queued when the process dies are lost.
+     */
+    bool startAsync();
+    bool startAsync(const AsyncOptions& options);
+
+    /**
+     * @brief Write everything queued and go back to writing on the caller's thread.
+     */
+    void stopAsync();
+    bool isAsync() const { return m_async.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Block until every message queued so far is written (asynchronous mode).
+     */
+    void flush();
+
+    // Messages lost to a full queue, asynchronous and binary mode together
+    uint64_t droppedMessages() const;
+
 private:
+    struct Record {
+        LogLevel level { LogLevel::Info };
+        const char* file { nullptr };
+        const char* function { nullptr };
+        int line { 0 };
+        std::chrono::system_clock::time_point time;
+        std::string message;
+    };
+
     Logger();
-    ~Logger() = default;
+    ~Logger();
 
-    static const char* levelToString(LogLevel level);
+    void closeBinary();
+
+    // Helper method to write to all active outputs, durable forces file output to the storage
+    void writeToOutputs(const std::string& formattedMessage, bool durable = false);
 
-    // Helper method to write to all active outputs
-    void writeToOutputs(const std::string& formattedMessage);
+    // Append one formatted line
+    void format(const Record& record, std::string& out) const;
+
+    void writerThread();
+    void wakeWriter();
 
     // Helper to extract filename from path
     static const char* extractFileName(const char* filePath);
 
-    // Helper to check if logging should occur
-    bool shouldLog(LogLevel level) const;
-
-    mutable std::mutex m_mutex;
-    LogLevel m_currentLevel { LogLevel::Info };
+    mutable std::mutex m_mutex; // Guards the outputs
+    std::atomic<LogLevel> m_currentLevel { LogLevel::Info };
     std::ostream* m_consoleOutput { &std::cout };
     std::unique_ptr<std::ofstream> m_fileOutput;
+    std::unique_ptr<RotatingFile> m_rotatingOutput;
     bool m_useConsole { true };
     bool m_useFile { false };
-    bool m_showLocation { true };
-    bool m_loggingEnabled { true }; // Global logging switch
+    std::atomic<bool> m_showLocation { true };
+    std::atomic<bool> m_loggingEnabled { true }; // Global logging switch
+
+    // Asynchronous mode
+    std::atomic<bool> m_async { false };
+    AsyncOptions m_asyncOptions;
+    std::unique_ptr<LockFreeQueue<Record>> m_queue;
+    std::thread m_writer;
+    std::mutex m_writerMutex;
+    std::condition_variable m_writerCond;
+    std::atomic<bool> m_writerRunning { false };
+    std::atomic<bool> m_writerIdle { false };
+    std::atomic<uint64_t> m_queued { 0 };
+    std::atomic<uint64_t> m_written { 0 };
+    std::atomic<uint64_t> m_dropped { 0 };
+
+    // Binary file, kept once created so a thread racing closeFile() still pushes into a live queue
+    std::atomic<bool> m_binary { false };
+    std::unique_ptr<BinaryLogWriter> m_binaryWriter;
 };
 
-// Updated macros that check if logging is enabled
-#define VISCALOG_ERROR(msg)                                                                                            \
-    do {                                                                                                               \
-        if (Visca::Logger::instance().isLoggingEnabled()) {                                                            \
-            std::ostringstream oss;                                                                                    \
-            oss << msg;                                                                                                \
-            Visca::Logger::instance().log(Visca::LogLevel::Error, __FILE__, __FUNCTION__, __LINE__, oss.str());        \
-        }                                                                                                              \
-    } while (0)
-
-#define VISCALOG_WARN(msg)                                                                                             \
-    do {                                                                                                               \
-        if (Visca::Logger::instance().isLoggingEnabled()) {                                                            \
-            std::ostringstream oss;                                                                                    \
-            oss << msg;                                                                                                \
-            Visca::Logger::instance().log(Visca::LogLevel::Warning, __FILE__, __FUNCTION__, __LINE__, oss.str());      \
-        }                                                                                                              \
-    } while (0)
+// Least severe level compiled in: 0 Error, 1 Warning, 2 Info, 3 Debug (set with -DVISCA_LOG_MIN_LEVEL=N). Statements
+// above it still compile, so their arguments stay checked, but the constant condition leaves no code behind.
+#ifndef VISCA_LOG_MIN_LEVEL
+#define VISCA_LOG_MIN_LEVEL 3
+#endif
 
-#define VISCALOG_INFO(msg)                                                                                             \
+// The level is checked with two atomic loads before the message is formatted, filtered statements build no stream
+// and evaluate none of their arguments. With a binary log file each statement registers its call site once and
+// streams its arguments raw into a BinaryLogRecord.
+#define VISCALOG_AT(level, condition, msg)                                                                             \
     do {                                                                                                               \
-        if (Visca::Logger::instance().isLoggingEnabled()) {                                                            \
-            std::ostringstream oss;                                                                                    \
-            oss << msg;                                                                                                \
-            Visca::Logger::instance().log(Visca::LogLevel::Info, __FILE__, __FUNCTION__, __LINE__, oss.str());         \
+        if (static_cast<int>(level) <= VISCA_LOG_MIN_LEVEL && Visca::Logger::instance().isEnabled(level)               \
+            && (condition)) {                                                                                          \
+            if (Visca::Logger::instance().isBinary()) {                                                                \
+                static const Visca::LogSite viscaLogSite_(level, __FILE__, __FUNCTION__, __LINE__);                    \
+                Visca::BinaryLogRecord viscaLogRecord_(viscaLogSite_);                                                 \
+                viscaLogRecord_ << msg;                                                                                \
+                Visca::Logger::instance().log(viscaLogRecord_);                                                        \
+            } else {                                                                                                   \
+                std::ostringstream oss;                                                                                \
+                oss << msg;                                                                                            \
+                Visca::Logger::instance().log(level, __FILE__, __FUNCTION__, __LINE__, oss.str());                     \
+            }                                                                                                          \
         }                                                                                                              \
     } while (0)
 
-#define VISCALOG_DEBUG(msg)                                                                                            \
-    do {                                                                                                               \
-        if (Visca::Logger::instance().isLoggingEnabled()) {                                                            \
-            std::ostringstream oss;                                                                                    \
-            oss << msg;                                                                                                \
-            Visca::Logger::instance().log(Visca::LogLevel::Debug, __FILE__, __FUNCTION__, __LINE__, oss.str());        \
-        }                                                                                                              \
-    } while (0)
+#define VISCALOG_ERROR(msg) VISCALOG_AT(Visca::LogLevel::Error, true, msg)
+#define VISCALOG_WARN(msg) VISCALOG_AT(Visca::LogLevel::Warning, true, msg)
+#define VISCALOG_INFO(msg) VISCALOG_AT(Visca::LogLevel::Info, true, msg)
+#define VISCALOG_DEBUG(msg) VISCALOG_AT(Visca::LogLevel::Debug, true, msg)
 
-// Conditional logging macros
-#define VISCALOG_ERROR_IF(condition, msg)                                                                              \
-    do {                                                                                                               \
-        if (Visca::Logger::instance().isLoggingEnabled() && (condition)) {                                             \
-            std::ostringstream oss;                                                                                    \
-            oss << msg;                                                                                                \
-            Visca::Logger::instance().log(Visca::LogLevel::Error, __FILE__, __FUNCTION__, __LINE__, oss.str());        \
-        }                                                                                                              \
-    } while (0)
+// Conditional logging macros, the condition is only evaluated when the level is enabled
+#define VISCALOG_ERROR_IF(condition, msg) VISCALOG_AT(Visca::LogLevel::Error, condition, msg)
+#define VISCALOG_WARN_IF(condition, msg) VISCALOG_AT(Visca::LogLevel::Warning, condition, msg)
+#define VISCALOG_INFO_IF(condition, msg) VISCALOG_AT(Visca::LogLevel::Info, condition, msg)
+#define VISCALOG_DEBUG_IF(condition, msg) VISCALOG_AT(Visca::LogLevel::Debug, condition, msg)
 
-#define VISCALOG_WARN_IF(condition, msg)                                                                               \
-    do {                                                                                                               \
-        if (Visca::Logger::instance().isLoggingEnabled() && (condition)) {                                             \
-            std::ostringstream oss;                                                                                    \
-            oss << msg;                                                                                                \
-            Visca::Logger::instance().log(Visca::LogLevel::Warning, __FILE__, __FUNCTION__, __LINE__, oss.str());      \
-        }                                                                                                              \
-    } while (0)
-
-#define VISCALOG_INFO_IF(condition, msg)                                                                               \
-    do {                                                                                                               \
-        if (Visca::Logger::instance().isLoggingEnabled() && (condition)) {                                             \
-            std::ostringstream oss;                                                                                    \
-            oss << msg;                                                                                                \
-            Visca::Logger::instance().log(Visca::LogLevel::Info, __FILE__, __FUNCTION__, __LINE__, oss.str());         \
-        }                                                                                                              \
-    } while (0)
-
-#define VISCALOG_DEBUG_IF(condition, msg)                                                                              \
-    do {                                                                                                               \
-        if (Visca::Logger::instance().isLoggingEnabled() && (condition)) {                                             \
-            std::ostringstream oss;                                                                                    \
-            oss << msg;                                                                                                \
-            Visca::Logger::instance().log(Visca::LogLevel::Debug, __FILE__, __FUNCTION__, __LINE__, oss.str());        \
-        }                                                                                                              \
-    } while (0)
+// A whole packet as hex bytes in one statement, e.g. VISCALOG_DEBUG_HEX("Sending:", data.data(), data.size())
+#define VISCALOG_DEBUG_HEX(msg, data, size) VISCALOG_DEBUG(msg << Visca::LogHex(data, size))
 
 // Macros that always log regardless of global setting (useful for critical errors)
 #define VISCALOG_FORCE_ERROR(msg)                                                                                      \
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Export.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Visca {
+
+/**
+ * @brief A file mapped into memory, either read-only or as an append-only write target.
+ *
+ * In Write mode the file is created (or truncated) and mapped with room to spare. append() copies into the mapping
+ * and grows file and mapping in steps of growBy when the room runs out, so the hot path is a memcpy. The disk blocks
+ * of each step are reserved as it is taken, so a full disk fails append() instead of faulting the memcpy. close()
+ * trims the file to the bytes actually written; after a crash the file keeps its zero-filled tail, readers of formats
+ * written through this class must treat zeros as the end.
+ *
+ * Not thread-safe, callers serialise access.
+ */
+class VISCA_EXPORT MappedFile {
+public:
+    enum class Mode { Read, Write };
+
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @param growBy Write mode: initial size of the mapping and step by which it grows.
+     * @return true if the file is open and mapped.
+     */
+    bool open(const std::string& path, Mode mode, size_t growBy = 1 << 20);
+
+    /**
+     * @brief Append bytes at the end of the written data (Write mode).
+     * @return false if the file is not open for writing or could not grow, also when the disk is full.
+     */
+    bool append(const void* data, size_t size);
+
+    /**
+     * @brief Flush written pages to the file.
+     * @param wait Block until the data is on disk instead of only scheduling the write-back.
+     */
+    bool sync(bool wait);
+
+    /**
+     * @brief Unmap and close. In Write mode the file is truncated to size() first.
+     */
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; } ///< Bytes written (Write) or file size (Read)
+    const std::string& path() const { return m_path; }
+
+private:
+    bool grow(size_t required);
+
+    std::string m_path;
+    Mode m_mode { Mode::Read };
+    uint8_t* m_data { nullptr };
+    size_t m_size { 0 };
+    size_t m_capacity { 0 };
+    size_t m_growBy { 1 << 20 };
+#ifdef _WIN32
+    void* m_file { nullptr };
+    void* m_mapping { nullptr };
+#else
+    int m_fd { -1 };
+#endif
+};
+
+}
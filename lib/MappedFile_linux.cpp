@@ -0,0 +1,137 @@
+#include "MappedFile.h"
+#include "Logger.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Visca {
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string& path, Mode mode, size_t growBy)
+{
+    close();
+
+    m_path = path;
+    m_mode = mode;
+    m_growBy = growBy > 0 ? growBy : 1 << 20;
+
+    if (mode == Mode::Read) {
+        m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (m_fd < 0) {
+            VISCALOG_ERROR("MappedFile: Cannot open " << path << ": " << std::strerror(errno));
+            return false;
+        }
+
+        struct stat st;
+        if (::fstat(m_fd, &st) < 0 || st.st_size == 0) {
+            VISCALOG_ERROR("MappedFile: " << path << " is empty or unreadable");
+            close();
+            return false;
+        }
+
+        void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, m_fd, 0);
+        if (data == MAP_FAILED) {
+            VISCALOG_ERROR("MappedFile: mmap failed for " << path << ": " << std::strerror(errno));
+            close();
+            return false;
+        }
+
+        m_data = static_cast<uint8_t*>(data);
+        m_size = static_cast<size_t>(st.st_size);
+        m_capacity = m_size;
+        return true;
+    }
+
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        VISCALOG_ERROR("MappedFile: Cannot create " << path << ": " << std::strerror(errno));
+        return false;
+    }
+
+    m_size = 0;
+    if (!grow(m_growBy)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::append(const void* data, size_t size)
+{
+    if (!m_data || m_mode != Mode::Write)
+        return false;
+    if (m_size + size > m_capacity && !grow(m_size + size))
+        return false;
+
+    std::memcpy(m_data + m_size, data, size);
+    m_size += size;
+    return true;
+}
+
+bool MappedFile::sync(bool wait)
+{
+    if (!m_data || m_mode != Mode::Write || m_size == 0)
+        return m_data != nullptr;
+
+    // msync wants a page aligned start, the whole written range is flushed
+    return ::msync(m_data, m_size, wait ? MS_SYNC : MS_ASYNC) == 0;
+}
+
+void MappedFile::close()
+{
+    if (m_data) {
+        ::munmap(m_data, m_capacity);
+        m_data = nullptr;
+    }
+
+    if (m_fd >= 0) {
+        if (m_mode == Mode::Write && ::ftruncate(m_fd, static_cast<off_t>(m_size)) < 0)
+            VISCALOG_WARN("MappedFile: Cannot trim " << m_path << ": " << std::strerror(errno));
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    m_size = 0;
+    m_capacity = 0;
+}
+
+bool MappedFile::grow(size_t required)
+{
+    size_t capacity = m_capacity;
+    while (capacity < required)
+        capacity += m_growBy;
+
+    // Reserve the blocks now: a page of a sparse file that the disk cannot back raises SIGBUS on the memcpy
+    int error;
+    do {
+        error = ::posix_fallocate(m_fd, static_cast<off_t>(m_capacity), static_cast<off_t>(capacity - m_capacity));
+    } while (error == EINTR);
+    if (error == EOPNOTSUPP && ::ftruncate(m_fd, static_cast<off_t>(capacity)) < 0)
+        error = errno;
+    else if (error == EOPNOTSUPP)
+        error = 0;
+    if (error != 0) {
+        VISCALOG_ERROR("MappedFile: Cannot grow " << m_path << ": " << std::strerror(error));
+        if (::ftruncate(m_fd, static_cast<off_t>(m_capacity)) < 0)
+            VISCALOG_WARN("MappedFile: Cannot trim " << m_path << ": " << std::strerror(errno));
+        return false;
+    }
+
+    void* data = m_data ? ::mremap(m_data, m_capacity, capacity, MREMAP_MAYMOVE)
+                        : ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        VISCALOG_ERROR("MappedFile: Cannot map " << m_path << ": " << std::strerror(errno));
+        return false;
+    }
+
+    m_data = static_cast<uint8_t*>(data);
+    m_capacity = capacity;
+    return true;
+}
+
+}
@@ -0,0 +1,155 @@
+#include "Logger.h"
+#include "MappedFile.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <cstring>
+
+namespace Visca {
+
+namespace {
+    bool mapView(HANDLE file, size_t size, bool writable, HANDLE& mapping, uint8_t*& data)
+    {
+        ULARGE_INTEGER mappingSize;
+        mappingSize.QuadPart = size;
+        mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, mappingSize.HighPart,
+            mappingSize.LowPart, NULL);
+        if (!mapping)
+            return false;
+
+        data = static_cast<uint8_t*>(MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+        if (!data) {
+            CloseHandle(mapping);
+            mapping = NULL;
+            return false;
+        }
+        return true;
+    }
+
+    void unmapView(HANDLE& mapping, uint8_t*& data)
+    {
+        if (data) {
+            UnmapViewOfFile(data);
+            data = nullptr;
+        }
+        if (mapping) {
+            CloseHandle(mapping);
+            mapping = NULL;
+        }
+    }
+}
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string& path, Mode mode, size_t growBy)
+{
+    close();
+
+    m_path = path;
+    m_mode = mode;
+    m_growBy = growBy > 0 ? growBy : 1 << 20;
+
+    DWORD access = mode == Mode::Read ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+    DWORD disposition = mode == Mode::Read ? OPEN_EXISTING : CREATE_ALWAYS;
+    HANDLE file = CreateFileA(
+        path.c_str(), access, FILE_SHARE_READ, NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        VISCALOG_ERROR("MappedFile: Cannot open " << path);
+        return false;
+    }
+    m_file = file;
+
+    if (mode == Mode::Read) {
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            VISCALOG_ERROR("MappedFile: " << path << " is empty or unreadable");
+            close();
+            return false;
+        }
+
+        HANDLE mapping = NULL;
+        if (!mapView(file, static_cast<size_t>(fileSize.QuadPart), false, mapping, m_data)) {
+            VISCALOG_ERROR("MappedFile: Cannot map " << path);
+            close();
+            return false;
+        }
+        m_mapping = mapping;
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+        m_capacity = m_size;
+        return true;
+    }
+
+    m_size = 0;
+    if (!grow(m_growBy)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::append(const void* data, size_t size)
+{
+    if (!m_data || m_mode != Mode::Write)
+        return false;
+    if (m_size + size > m_capacity && !grow(m_size + size))
+        return false;
+
+    std::memcpy(m_data + m_size, data, size);
+    m_size += size;
+    return true;
+}
+
+bool MappedFile::sync(bool wait)
+{
+    if (!m_data || m_mode != Mode::Write || m_size == 0)
+        return m_data != nullptr;
+
+    if (!FlushViewOfFile(m_data, m_size))
+        return false;
+    return !wait || FlushFileBuffers(static_cast<HANDLE>(m_file));
+}
+
+void MappedFile::close()
+{
+    HANDLE mapping = static_cast<HANDLE>(m_mapping);
+    unmapView(mapping, m_data);
+    m_mapping = nullptr;
+
+    if (m_file) {
+        HANDLE file = static_cast<HANDLE>(m_file);
+        if (m_mode == Mode::Write) {
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(m_size);
+            if (!SetFilePointerEx(file, end, NULL, FILE_BEGIN) || !SetEndOfFile(file))
+                VISCALOG_WARN("MappedFile: Cannot trim " << m_path);
+        }
+        CloseHandle(file);
+        m_file = nullptr;
+    }
+
+    m_size = 0;
+    m_capacity = 0;
+}
+
+bool MappedFile::grow(size_t required)
+{
+    size_t capacity = m_capacity;
+    while (capacity < required)
+        capacity += m_growBy;
+
+    // A view cannot be resized, map the grown file again
+    HANDLE mapping = static_cast<HANDLE>(m_mapping);
+    unmapView(mapping, m_data);
+    m_mapping = nullptr;
+
+    if (!mapView(static_cast<HANDLE>(m_file), capacity, true, mapping, m_data)) {
+        VISCALOG_ERROR("MappedFile: Cannot grow " << m_path);
+        return false;
+    }
+    m_mapping = mapping;
+    m_capacity = capacity;
+    return true;
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Export.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace Visca {
+
+/**
+ * @brief Serves Prometheus text on a local Unix domain socket.
+ *
+ * Every connection gets one HTTP/1.0 response with the text returned by the render function, whatever it asked for,
+ * so a scraper or `curl --unix-socket <path> http://localhost/metrics` can read it without a network port. Rendering
+ * runs on the endpoint's own thread. Linux only.
+ */
+class VISCA_EXPORT MetricsEndpoint {
+public:
+    using Render = std::function<std::string()>;
+
+    MetricsEndpoint() = default;
+    ~MetricsEndpoint();
+
+    MetricsEndpoint(const MetricsEndpoint&) = delete;
+    MetricsEndpoint& operator=(const MetricsEndpoint&) = delete;
+
+    /**
+     * @brief Listen on path, replacing a socket file left there, and answer connections with render().
+     */
+    bool start(const std::string& path, Render render);
+    void stop();
+
+    bool isRunning() const { return m_listenFd >= 0; }
+    const std::string& path() const { return m_path; }
+
+private:
+    void acceptThread();
+    void answer(int fd);
+
+    std::string m_path;
+    Render m_render;
+    int m_listenFd { -1 };
+    std::atomic<bool> m_running { false };
+    std::thread m_thread;
+};
+
+}
@@ -0,0 +1,111 @@
+#include "Logger.h"
+#include "MetricsEndpoint.h"
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Visca {
+
+MetricsEndpoint::~MetricsEndpoint() { stop(); }
+
+bool MetricsEndpoint::start(const std::string& path, Render render)
+{
+    stop();
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        VISCALOG_ERROR("MetricsEndpoint: Invalid socket path " << path);
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.data(), path.size());
+
+    // A socket file left behind by an earlier run would make bind() fail
+    ::unlink(path.c_str());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 8) < 0) {
+        VISCALOG_ERROR("MetricsEndpoint: Cannot listen on " << path << ": " << std::strerror(errno));
+        if (fd >= 0)
+            ::close(fd);
+        return false;
+    }
+
+    m_path = path;
+    m_render = std::move(render);
+    m_listenFd = fd;
+    m_running = true;
+    m_thread = std::thread(&MetricsEndpoint::acceptThread, this);
+    return true;
+}
+
+void MetricsEndpoint::stop()
+{
+    m_running = false;
+    if (m_thread.joinable())
+        m_thread.join();
+    if (m_listenFd >= 0) {
+        ::close(m_listenFd);
+        ::unlink(m_path.c_str());
+        m_listenFd = -1;
+    }
+}
+
+void MetricsEndpoint::acceptThread()
+{
+    while (m_running) {
+        // Short poll timeout for responsive shutdown
+        struct pollfd pfd = { m_listenFd, POLLIN, 0 };
+        if (::poll(&pfd, 1, 100) <= 0)
+            continue;
+
+        int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+        answer(fd);
+        ::close(fd);
+    }
+}
+
+void MetricsEndpoint::answer(int fd)
+{
+    struct timeval tv;
+    tv.tv_sec = 1;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    // Read the request head so the client does not see a reset, its content does not matter
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos
+        && request.size() < 8192) {
+        ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+            break;
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    std::string body = m_render ? m_render() : std::string();
+    std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+        + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+    const char* data = response.data();
+    size_t size = response.size();
+    while (size > 0) {
+        ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return;
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+}
+
+}
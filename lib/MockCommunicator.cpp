@@ -0,0 +1,152 @@
+#include "MockCommunicator.h"
+#include "LineScheduler.h"
+#include "Logger.h"
+#include "Tracing.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Visca {
+
+MockCommunicator::MockCommunicator()
+    : MockCommunicator(Config())
+{
+}
+
+MockCommunicator::MockCommunicator(const Config& config)
+    : m_config(config)
+    , m_camera(config.camera)
+{
+}
+
+MockCommunicator::~MockCommunicator() { close(); }
+
+bool MockCommunicator::open()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_open = true;
+    VISCALOG_INFO("Mock camera " << static_cast<int>(m_camera.address()) << " opened");
+    return true;
+}
+
+bool MockCommunicator::send(Span<const uint8_t> data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open)
+        return false;
+
+    auto now = Clock::now();
+    m_txFreeAt = std::max(m_txFreeAt, now);
+
+    for (uint8_t byte : data) {
+        m_partial.push_back(byte);
+        m_txFreeAt += wireTime(1, m_config.baudRate);
+        if (byte != 0xFF)
+            continue;
+
+        // The camera sees the packet once its last byte is on the wire
+        m_camera.process(m_partial.data(), m_partial.size(), m_txFreeAt + m_config.latency);
+        ++m_stats.framesSent;
+        m_stats.bytesSent += m_partial.size();
+        m_partial.clear();
+    }
+
+    VISCA_TRACE(TraceEvent::BytesWritten, 0, data.size());
+    m_cond.notify_all();
+    return true;
+}
+
+size_t MockCommunicator::receive(uint8_t* buffer, size_t maxSize)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto deadline = Clock::now() + std::chrono::milliseconds(m_config.receiveTimeoutMs);
+
+    while (m_open) {
+        auto now = Clock::now();
+        collectReplies(now);
+
+        if (!m_inFlight.empty() && m_inFlight.front().arrival <= now) {
+            size_t received = 0;
+            while (!m_inFlight.empty() && m_inFlight.front().arrival <= now) {
+                const auto& frame = m_inFlight.front().data;
+                if (received + frame.size() > maxSize)
+                    break;
+                std::memcpy(buffer + received, frame.data(), frame.size());
+                received += frame.size();
+                ++m_stats.framesReceived;
+                m_stats.bytesReceived += frame.size();
+                m_inFlight.pop_front();
+            }
+            if (received > 0)
+                return received;
+            VISCALOG_ERROR("MockCommunicator: Receive buffer too small for a " << m_inFlight.front().data.size()
+                                                                               << " byte frame");
+            return 0;
+        }
+
+        if (now >= deadline)
+            return 0;
+
+        // Sleep until the next frame lands, the camera emits its next reply, or a send wakes us up
+        auto wake = deadline;
+        if (!m_inFlight.empty())
+            wake = std::min(wake, m_inFlight.front().arrival);
+        Clock::time_point due;
+        if (m_camera.nextReplyTime(due))
+            wake = std::min(wake, due);
+        m_cond.wait_until(lock, wake);
+    }
+
+    return 0;
+}
+
+bool MockCommunicator::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_open;
+}
+
+void MockCommunicator::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open)
+        return;
+
+    m_open = false;
+    m_cond.notify_all();
+    VISCALOG_INFO("Mock camera " << static_cast<int>(m_camera.address()) << " closed");
+}
+
+CameraSimulator MockCommunicator::camera() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CameraSimulator camera = m_camera;
+    camera.advance(Clock::now());
+    return camera;
+}
+
+MockCommunicator::Stats MockCommunicator::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+MockCommunicator::Clock::duration MockCommunicator::wireTime(size_t bytes, uint32_t baudRate)
+{
+    return LineScheduler::wireTime(bytes, baudRate);
+}
+
+void MockCommunicator::collectReplies(Clock::time_point now)
+{
+    m_replies.clear();
+    if (m_camera.collectReplies(now, m_replies) == 0)
+        return;
+
+    // Replies leave the camera in order and queue behind each other on the line
+    for (auto& reply : m_replies) {
+        m_rxFreeAt = std::max(m_rxFreeAt, reply.due) + wireTime(reply.data.size(), m_config.baudRate);
+        m_inFlight.push_back({ m_rxFreeAt + m_config.latency, std::move(reply.data) });
+    }
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CameraSimulator.h"
+#include "ICommunicator.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief In-process communicator talking to a CameraSimulator instead of a real camera.
+ *
+ * Every frame is delayed by a fixed one-way latency. With a baud rate set, each direction of the link also behaves
+ * like a serial line: bytes take 10 bit times each (8N1) and frames queue behind each other, so a burst of commands
+ * or replies takes as long as it would on the wire. send() never blocks, receive() waits until a reply frame has
+ * fully arrived or the receive timeout expires, and returns whole frames only.
+ */
+class VISCA_EXPORT MockCommunicator : public ICommunicator {
+public:
+    using Clock = CameraSimulator::Clock;
+
+    struct Config {
+        CameraSimulator::Config camera;
+        Clock::duration latency { 0 }; ///< One-way delay added to every frame
+        uint32_t baudRate { 0 }; ///< Serial line emulation, 0 for an infinitely fast link
+        int receiveTimeoutMs { 100 };
+    };
+
+    struct Stats {
+        uint64_t framesSent { 0 };
+        uint64_t bytesSent { 0 };
+        uint64_t framesReceived { 0 };
+        uint64_t bytesReceived { 0 };
+    };
+
+    MockCommunicator();
+    explicit MockCommunicator(const Config& config);
+    ~MockCommunicator() override;
+
+    bool open() override;
+    using ICommunicator::send;
+    bool send(Span<const uint8_t> data) override;
+    size_t receive(uint8_t* buffer, size_t maxSize) override;
+    bool isOpen() const override;
+    void close() override;
+
+    /**
+     * @brief Copy of the simulated camera, with its motors advanced to now.
+     */
+    CameraSimulator camera() const;
+
+    Stats stats() const;
+
+    /**
+     * @brief Time a number of bytes occupies a serial line at the given baud rate (10 bits per byte).
+     */
+    static Clock::duration wireTime(size_t bytes, uint32_t baudRate);
+
+private:
+    struct Frame {
+        Clock::time_point arrival;
+        std::vector<uint8_t> data;
+    };
+
+    void collectReplies(Clock::time_point now);
+
+    Config m_config;
+    CameraSimulator m_camera;
+    bool m_open { false };
+
+    std::vector<uint8_t> m_partial; ///< Bytes of a packet not terminated yet
+    Clock::time_point m_txFreeAt {}; ///< Host to camera line busy until
+    Clock::time_point m_rxFreeAt {}; ///< Camera to host line busy until
+    std::deque<Frame> m_inFlight; ///< Replies on their way to the host, in arrival order
+    std::vector<CameraSimulator::Reply> m_replies;
+    Stats m_stats;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+};
+
+}
@@ -0,0 +1,151 @@
+#include "ReplayCommunicator.h"
+#include "Logger.h"
+#include "TrafficCapture.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Visca {
+
+ReplayCommunicator::ReplayCommunicator(const Config& config)
+    : m_config(config)
+{
+}
+
+ReplayCommunicator::~ReplayCommunicator() { close(); }
+
+bool ReplayCommunicator::open()
+{
+    CaptureReader reader;
+    if (!reader.open(m_config.path))
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_initial.clear();
+    m_exchanges.clear();
+    m_nextExchange = 0;
+    m_partial.clear();
+    m_ready.clear();
+    m_lastDue = Clock::time_point {};
+    m_stats = Stats {};
+
+    uint64_t base = reader.startMonotonicNs();
+    CaptureRecord record;
+    while (reader.next(record)) {
+        std::vector<uint8_t> data(record.data.begin(), record.data.end());
+        if (record.direction == CaptureDirection::Sent) {
+            m_exchanges.push_back({ std::move(data), {} });
+            base = record.timestampNs;
+            continue;
+        }
+
+        auto offset = std::chrono::nanoseconds(record.timestampNs > base ? record.timestampNs - base : 0);
+        auto& replies = m_exchanges.empty() ? m_initial : m_exchanges.back().replies;
+        replies.push_back({ std::chrono::duration_cast<Clock::duration>(offset), std::move(data) });
+    }
+
+    VISCALOG_INFO("ReplayCommunicator: Loaded " << m_exchanges.size() << " exchanges from " << m_config.path);
+
+    m_open = true;
+    schedule(m_initial, Clock::now());
+    m_cond.notify_all();
+    return true;
+}
+
+bool ReplayCommunicator::send(Span<const uint8_t> data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open)
+        return false;
+
+    auto now = Clock::now();
+    for (uint8_t byte : data) {
+        m_partial.push_back(byte);
+        if (byte != 0xFF)
+            continue;
+
+        ++m_stats.framesSent;
+        if (m_nextExchange >= m_exchanges.size()) {
+            ++m_stats.unexpected;
+        } else {
+            const Exchange& exchange = m_exchanges[m_nextExchange++];
+            if (exchange.sent != m_partial)
+                ++m_stats.mismatched;
+            schedule(exchange.replies, now);
+        }
+        m_partial.clear();
+    }
+
+    m_cond.notify_all();
+    return true;
+}
+
+size_t ReplayCommunicator::receive(uint8_t* buffer, size_t maxSize)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto deadline = Clock::now() + std::chrono::milliseconds(m_config.receiveTimeoutMs);
+
+    while (m_open) {
+        auto now = Clock::now();
+        if (!m_ready.empty() && m_ready.front().due <= now) {
+            size_t size = 0;
+            while (!m_ready.empty() && m_ready.front().due <= now
+                && size + m_ready.front().data.size() <= maxSize) {
+                std::memcpy(buffer + size, m_ready.front().data.data(), m_ready.front().data.size());
+                size += m_ready.front().data.size();
+                ++m_stats.framesReplayed;
+                m_ready.pop_front();
+            }
+            return size;
+        }
+
+        if (now >= deadline)
+            return 0;
+
+        auto wakeup = m_ready.empty() ? deadline : std::min(deadline, m_ready.front().due);
+        m_cond.wait_until(lock, wakeup);
+    }
+    return 0;
+}
+
+bool ReplayCommunicator::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_open;
+}
+
+void ReplayCommunicator::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_open = false;
+    m_ready.clear();
+    m_cond.notify_all();
+}
+
+bool ReplayCommunicator::finished() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextExchange >= m_exchanges.size() && m_ready.empty();
+}
+
+ReplayCommunicator::Stats ReplayCommunicator::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void ReplayCommunicator::schedule(const std::vector<Reply>& replies, Clock::time_point base)
+{
+    for (const auto& reply : replies) {
+        Clock::time_point due = base;
+        if (m_config.speed > 0)
+            due += std::chrono::duration_cast<Clock::duration>(reply.offset / m_config.speed);
+
+        // Replies keep their captured order even when a later send releases them earlier
+        due = std::max(due, m_lastDue);
+        m_lastDue = due;
+        m_ready.push_back({ due, reply.data });
+    }
+}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ICommunicator.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief Plays the camera side of a capture file back to the host.
+ *
+ * Received frames of the capture are tied to the last frame sent before them. When the host sends its n-th frame,
+ * the replies that followed the n-th sent frame of the capture are released after the same delays, divided by the
+ * speed factor. A speed of 0 releases them immediately, which turns real field traffic into a deterministic
+ * regression test for the host side. Frames received before the first send are released relative to open().
+ *
+ * Sent frames are compared with the capture, differences are counted in the stats but do not stop the replay.
+ * receive() waits until a frame is due or the receive timeout expires, and returns whole frames only.
+ */
+class VISCA_EXPORT ReplayCommunicator : public ICommunicator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        std::string path;
+        double speed { 1.0 }; ///< 1 for original timing, 10 for ten times faster, 0 for no delays
+        int receiveTimeoutMs { 100 };
+    };
+
+    struct Stats {
+        uint64_t framesSent { 0 }; ///< Frames sent by the host
+        uint64_t framesReplayed { 0 }; ///< Frames delivered to the host
+        uint64_t mismatched { 0 }; ///< Sent frames differing from the capture
+        uint64_t unexpected { 0 }; ///< Sent frames beyond the end of the capture
+    };
+
+    explicit ReplayCommunicator(const Config& config);
+    ~ReplayCommunicator() override;
+
+    /**
+     * @brief Load the capture and start the replay.
+     */
+    bool open() override;
+    using ICommunicator::send;
+    bool send(Span<const uint8_t> data) override;
+    size_t receive(uint8_t* buffer, size_t maxSize) override;
+    bool isOpen() const override;
+    void close() override;
+
+    /**
+     * @brief true once every sent frame of the capture has been matched and all replies were delivered.
+     */
+    bool finished() const;
+
+    Stats stats() const;
+
+private:
+    struct Reply {
+        Clock::duration offset; ///< Delay after the sent frame it follows
+        std::vector<uint8_t> data;
+    };
+
+    struct Exchange {
+        std::vector<uint8_t> sent;
+        std::vector<Reply> replies;
+    };
+
+    struct Frame {
+        Clock::time_point due;
+        std::vector<uint8_t> data;
+    };
+
+    void schedule(const std::vector<Reply>& replies, Clock::time_point base);
+
+    Config m_config;
+    bool m_open { false };
+
+    std::vector<Reply> m_initial; ///< Replies captured before the first sent frame
+    std::vector<Exchange> m_exchanges;
+    size_t m_nextExchange { 0 };
+
+    std::vector<uint8_t> m_partial; ///< Sent bytes of a frame not terminated yet
+    std::deque<Frame> m_ready; ///< Replies scheduled for delivery, in order
+    Clock::time_point m_lastDue {};
+    Stats m_stats;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+};
+
+}
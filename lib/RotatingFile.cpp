@@ -0,0 +1,83 @@
+#include "RotatingFile.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace Visca {
+
+RotatingFile::RotatingFile()
+    : RotatingFile(Options())
+{
+}
+
+RotatingFile::RotatingFile(const Options& options)
+    : m_options(options)
+{
+    m_options.maxFileSize = std::max<size_t>(m_options.maxFileSize, 1);
+    m_options.maxFiles = std::max<size_t>(m_options.maxFiles, 1);
+    m_options.growBy = std::max<size_t>(std::min(m_options.growBy, m_options.maxFileSize), 1);
+}
+
+RotatingFile::~RotatingFile() { close(); }
+
+bool RotatingFile::open(const std::string& path)
+{
+    close();
+    m_path = path;
+
+    // Keep the log of the previous run
+    if (std::FILE* existing = std::fopen(path.c_str(), "rb")) {
+        std::fclose(existing);
+        shiftOldFiles();
+    }
+
+    if (!m_file.open(path, MappedFile::Mode::Write, m_options.growBy))
+        return false;
+    m_opened = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool RotatingFile::write(const void* data, size_t size)
+{
+    if (!m_file.isOpen())
+        return false;
+
+    bool full = m_file.size() > 0 && m_file.size() + size > m_options.maxFileSize;
+    bool old = m_options.maxAge.count() > 0 && std::chrono::steady_clock::now() - m_opened >= m_options.maxAge;
+    if ((full || old) && !rotate())
+        return false;
+    return m_file.append(data, size);
+}
+
+bool RotatingFile::sync() { return m_file.sync(true); }
+
+void RotatingFile::close() { m_file.close(); }
+
+bool RotatingFile::rotate()
+{
+    m_file.close();
+    shiftOldFiles();
+    ++m_rotations;
+    if (!m_file.open(m_path, MappedFile::Mode::Write, m_options.growBy))
+        return false;
+    m_opened = std::chrono::steady_clock::now();
+    return true;
+}
+
+void RotatingFile::shiftOldFiles()
+{
+    if (m_options.maxFiles < 2) {
+        std::remove(m_path.c_str());
+        return;
+    }
+
+    // Windows' rename does not replace an existing file, make room first
+    std::remove(olderPath(m_options.maxFiles - 1).c_str());
+    for (size_t index = m_options.maxFiles - 1; index > 1; --index)
+        std::rename(olderPath(index - 1).c_str(), olderPath(index).c_str());
+    std::rename(m_path.c_str(), olderPath(1).c_str());
+}
+
+std::string RotatingFile::olderPath(size_t index) const { return m_path + "." + std::to_string(index); }
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Export.h"
+#include "MappedFile.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Visca {
+
+/**
+ * @brief Append-only file that rotates by size and age and keeps a bounded number of old files.
+ *
+ * The current file is always path; older ones are path.1 (newest) to path.N-1, the oldest deleted when another
+ * would exceed maxFiles. A file left at path by an earlier run is rotated out on open() rather than overwritten.
+ *
+ * Writes go through a MappedFile, a memcpy into the page cache without system calls except when the mapping grows.
+ * They survive a crash of the process as they are; sync() also forces them to the storage, for lines that must
+ * survive a power cut. A crashed process leaves the current file with a zero-filled tail (up to one grow step).
+ *
+ * Not thread-safe, callers serialise access.
+ */
+class VISCA_EXPORT RotatingFile {
+public:
+    struct Options {
+        size_t maxFileSize { 10 << 20 }; ///< Rotate before a write would take the file past this
+        size_t maxFiles { 5 }; ///< Current file included, at least 1
+        std::chrono::milliseconds maxAge { 0 }; ///< Rotate files older than this, 0 never
+        size_t growBy { 1 << 20 }; ///< Mapping step, capped to maxFileSize
+    };
+
+    RotatingFile();
+    explicit RotatingFile(const Options& options);
+    ~RotatingFile();
+
+    RotatingFile(const RotatingFile&) = delete;
+    RotatingFile& operator=(const RotatingFile&) = delete;
+
+    bool open(const std::string& path);
+
+    /**
+     * @return false if the file is not open, or could neither grow nor rotate.
+     */
+    bool write(const void* data, size_t size);
+
+    /**
+     * @brief Block until everything written is on the storage.
+     */
+    bool sync();
+
+    /**
+     * @brief Close the current file, trimmed to what was written.
+     */
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    const std::string& path() const { return m_path; }
+    size_t size() const { return m_file.size(); } ///< Bytes in the current file
+    uint64_t rotations() const { return m_rotations; }
+
+private:
+    bool rotate();
+    void shiftOldFiles();
+    std::string olderPath(size_t index) const;
+
+    Options m_options;
+    std::string m_path;
+    MappedFile m_file;
+    std::chrono::steady_clock::time_point m_opened;
+    uint64_t m_rotations { 0 };
+};
+
+}
@@ -0,0 +1,127 @@
+#include "ScheduledCommunicator.h"
+#include "Logger.h"
+
+#include <thread>
+#include <vector>
+
+namespace Visca {
+
+ScheduledCommunicator::ScheduledCommunicator(std::unique_ptr<ICommunicator> inner, const LineScheduler::Config& config)
+    : m_inner(std::move(inner))
+    , m_scheduler(config)
+{
+}
+
+bool ScheduledCommunicator::open() { return m_inner && m_inner->open(); }
+
+bool ScheduledCommunicator::send(Span<const uint8_t> data)
+{
+    // Booked per VISCA packet, an unterminated tail counts as one
+    std::vector<Span<const uint8_t>> packets;
+    size_t start = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (data[i] == 0xFF) {
+            packets.push_back(data.subspan(start, i + 1 - start));
+            start = i + 1;
+        }
+    }
+    if (start < data.size())
+        packets.push_back(data.subspan(start));
+
+    return sendv(Span<const Span<const uint8_t>>(packets));
+}
+
+bool ScheduledCommunicator::sendv(Span<const Span<const uint8_t>> packets)
+{
+    struct Booked {
+        Span<const uint8_t> packet;
+        LineScheduler::Clock::time_point sendAt;
+        LineScheduler::Clock::time_point end;
+    };
+
+    std::vector<Booked> booked;
+    booked.reserve(packets.size());
+    bool result = true;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto now = LineScheduler::Clock::now();
+        for (const auto& packet : packets) {
+            LineScheduler::Clock::time_point sendAt;
+            if (!m_scheduler.admit(packet.data(), packet.size(), now, sendAt)) {
+                if (packet.empty())
+                    VISCALOG_WARN("ScheduledCommunicator: Empty packet rejected");
+                else
+                    VISCALOG_WARN("ScheduledCommunicator: Line saturated, inquiry to camera "
+                        << static_cast<int>(packet[0] & 0x0F) << " shed");
+                result = false;
+                continue;
+            }
+            booked.push_back(
+                { packet, sendAt, sendAt + LineScheduler::wireTime(packet.size(), m_scheduler.config().baudRate) });
+        }
+    }
+
+    // Packets following each other on the line go out together, the driver serialises them anyway
+    std::vector<Span<const uint8_t>> run;
+    size_t first = 0;
+    while (first < booked.size()) {
+        size_t last = first + 1;
+        while (last < booked.size() && booked[last].sendAt <= booked[last - 1].end)
+            ++last;
+
+        std::this_thread::sleep_until(booked[first].sendAt);
+        run.clear();
+        for (size_t i = first; i < last; ++i)
+            run.push_back(booked[i].packet);
+        if (!m_inner->sendv(Span<const Span<const uint8_t>>(run)))
+            return false;
+        first = last;
+    }
+    return result;
+}
+
+size_t ScheduledCommunicator::receive(uint8_t* buffer, size_t maxSize)
+{
+    size_t received = m_inner->receive(buffer, maxSize);
+    if (received > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_scheduler.onReceived(received, LineScheduler::Clock::now());
+    }
+    return received;
+}
+
+int ScheduledCommunicator::nativeHandle() const { return m_inner ? m_inner->nativeHandle() : -1; }
+
+bool ScheduledCommunicator::isOpen() const { return m_inner && m_inner->isOpen(); }
+
+void ScheduledCommunicator::close()
+{
+    if (m_inner)
+        m_inner->close();
+}
+
+void ScheduledCommunicator::setBudget(uint8_t address, const LineScheduler::Budget& budget)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_scheduler.setBudget(address, budget);
+}
+
+LineScheduler::Stats ScheduledCommunicator::stats(LineScheduler::Class cls) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_scheduler.stats(cls);
+}
+
+LineScheduler::Stats ScheduledCommunicator::cameraStats(uint8_t address, LineScheduler::Class cls) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_scheduler.cameraStats(address, cls);
+}
+
+LineScheduler::Utilisation ScheduledCommunicator::utilisation() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_scheduler.utilisation(LineScheduler::Clock::now());
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ICommunicator.h"
+#include "LineScheduler.h"
+
+#include <memory>
+#include <mutex>
+
+namespace Visca {
+
+/**
+ * @brief Decorator that paces the packets of a serial communicator with a LineScheduler.
+ *
+ * Every packet is booked before it is written: send() sleeps until the line and the camera's budget allow it, so
+ * the queue in the driver stays at about one packet, and fails for inquiries the scheduler sheds. Packets that end up
+ * back to back on the line are handed to the wrapped communicator in one sendv(). Received bytes are accounted for
+ * the utilisation of the receive direction. Safe to use from several sending threads.
+ */
+class VISCA_EXPORT ScheduledCommunicator : public ICommunicator {
+public:
+    ScheduledCommunicator(std::unique_ptr<ICommunicator> inner, const LineScheduler::Config& config);
+
+    bool open() override;
+    using ICommunicator::send;
+    bool send(Span<const uint8_t> data) override;
+    bool sendv(Span<const Span<const uint8_t>> packets) override;
+    size_t receive(uint8_t* buffer, size_t maxSize) override;
+    int nativeHandle() const override;
+    bool isOpen() const override;
+    void close() override;
+
+    ICommunicator& inner() { return *m_inner; }
+
+    void setBudget(uint8_t address, const LineScheduler::Budget& budget);
+    LineScheduler::Stats stats(LineScheduler::Class cls) const;
+    LineScheduler::Stats cameraStats(uint8_t address, LineScheduler::Class cls) const;
+    LineScheduler::Utilisation utilisation() const;
+
+private:
+    std::unique_ptr<ICommunicator> m_inner;
+    LineScheduler m_scheduler;
+    mutable std::mutex m_mutex; ///< Guards m_scheduler, never held while sleeping or writing
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ICommunicator.h"
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <string>
@@ -16,15 +17,32 @@ public:
     ~SerialCommunicator() override;
 
     bool open() override;
-    bool send(const std::vector<uint8_t>& data) override;
+    using ICommunicator::send;
+    bool send(Span<const uint8_t> data) override;
+    bool sendv(Span<const Span<const uint8_t>> packets) override;
     size_t receive(uint8_t* buffer, size_t maxSize) override;
+    int nativeHandle() const override;
     bool isOpen() const override;
     void close() override;
 
+    /**
+     * @brief Like receive(), but returns as soon as bytes arrive or after timeoutMs.
+     */
+    size_t receive(uint8_t* buffer, size_t maxSize, int timeoutMs);
+
+    /**
+     * @brief Change the baud rate. An open port switches once pending output is sent, input received so far is
+     * discarded because it was read at the old rate.
+     * @return false if the rate is not supported.
+     */
+    bool setBaudRate(uint32_t baudRate);
+
+    uint32_t baudRate() const;
+
 private:
-    int m_fd { -1 };
+    std::atomic<int> m_fd { -1 }; ///< Read without the lock by the receive calls
     std::string m_device;
     uint32_t m_baudRate;
-    mutable std::mutex m_mutex;
+    mutable std::mutex m_mutex; ///< Guards open, close and sending
 };
 }
@@ -1,12 +1,52 @@
 #include "Logger.h"
 #include "SerialCommunicator.h"
+#include "Tracing.h"
+#include "WriteAll.h"
 
+#include <cerrno>
 #include <cstring>
 #include <fcntl.h>
+#include <poll.h>
 #include <termios.h>
 #include <unistd.h>
 
 namespace Visca {
+namespace {
+    bool toSpeed(uint32_t baudRate, speed_t& speed)
+    {
+        switch (baudRate) {
+        case 1200:
+            speed = B1200;
+            return true;
+        case 2400:
+            speed = B2400;
+            return true;
+        case 4800:
+            speed = B4800;
+            return true;
+        case 9600:
+            speed = B9600;
+            return true;
+        case 19200:
+            speed = B19200;
+            return true;
+        case 38400:
+            speed = B38400;
+            return true;
+        case 57600:
+            speed = B57600;
+            return true;
+        case 115200:
+            speed = B115200;
+            return true;
+        case 230400:
+            speed = B230400;
+            return true;
+        default:
+            return false;
+        }
+    }
+}
 
 SerialCommunicator::SerialCommunicator(const std::string& device, uint32_t baudRate)
     : m_device(device)
@@ -38,13 +78,19 @@ bool SerialCommunicator::open()
         return false;
     }
 
-    // Set Baud Rate (Assuming 115200 for Helios)
-    speed_t speed = B115200;
+    speed_t speed;
+    if (!toSpeed(m_baudRate, speed)) {
+        VISCALOG_ERROR("Serial: Unsupported baud rate " << m_baudRate);
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
     cfsetospeed(&tty, speed);
     cfsetispeed(&tty, speed);
 
     tty.c_cflag = (tty.c_cflag & ~CSIZE) | CS8;
-    tty.c_iflag &= ~IGNBRK;
+    // Raw input, VISCA bytes such as 0x0D must not be translated
+    tty.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL);
     tty.c_lflag = 0;
     tty.c_oflag = 0;
     tty.c_cc[VMIN] = 0;
@@ -67,24 +113,88 @@ bool SerialCommunicator::open()
     return true;
 }
 
-bool SerialCommunicator::send(const std::vector<uint8_t>& data)
+bool SerialCommunicator::send(Span<const uint8_t> data)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_fd < 0)
         return false;
     ssize_t written = ::write(m_fd, data.data(), data.size());
-    return written == static_cast<ssize_t>(data.size());
+    if (written != static_cast<ssize_t>(data.size()))
+        return false;
+    VISCA_TRACE(TraceEvent::BytesWritten, m_fd, written);
+    return true;
 }
 
-size_t SerialCommunicator::receive(uint8_t* buffer, size_t maxSize)
+bool SerialCommunicator::sendv(Span<const Span<const uint8_t>> packets)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_fd < 0)
+        return false;
+    return writevAll(m_fd, packets);
+}
+
+size_t SerialCommunicator::receive(uint8_t* buffer, size_t maxSize)
+{
+    // Not under the lock: the receive thread blocks here for up to VTIME, sends must not wait on it
+    int fd = m_fd;
+    if (fd < 0)
+        return 0;
+    ssize_t bytesRead = ::read(fd, buffer, maxSize);
+    return (bytesRead > 0) ? static_cast<size_t>(bytesRead) : 0;
+}
+
+size_t SerialCommunicator::receive(uint8_t* buffer, size_t maxSize, int timeoutMs)
+{
+    int fd = m_fd;
+    if (fd < 0)
+        return 0;
+
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if (::poll(&pfd, 1, timeoutMs) <= 0)
         return 0;
-    ssize_t bytesRead = ::read(m_fd, buffer, maxSize);
+    ssize_t bytesRead = ::read(fd, buffer, maxSize);
     return (bytesRead > 0) ? static_cast<size_t>(bytesRead) : 0;
 }
 
+bool SerialCommunicator::setBaudRate(uint32_t baudRate)
+{
+    speed_t speed;
+    if (!toSpeed(baudRate, speed)) {
+        VISCALOG_ERROR("Serial: Unsupported baud rate " << baudRate);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd >= 0) {
+        struct termios tty;
+        if (tcgetattr(m_fd, &tty) != 0) {
+            VISCALOG_ERROR("Serial: Error from tcgetattr");
+            return false;
+        }
+        cfsetospeed(&tty, speed);
+        cfsetispeed(&tty, speed);
+        if (tcsetattr(m_fd, TCSADRAIN, &tty) != 0) {
+            VISCALOG_ERROR("Serial: Error from tcsetattr");
+            return false;
+        }
+        tcflush(m_fd, TCIFLUSH);
+    }
+    m_baudRate = baudRate;
+    return true;
+}
+
+uint32_t SerialCommunicator::baudRate() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_baudRate;
+}
+
+int SerialCommunicator::nativeHandle() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fd;
+}
+
 bool SerialCommunicator::isOpen() const
 {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -94,9 +204,9 @@ bool SerialCommunicator::isOpen() const
 void SerialCommunicator::close()
 {
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_fd >= 0) {
-        ::close(m_fd);
-        m_fd = -1;
+    int fd = m_fd.exchange(-1);
+    if (fd >= 0) {
+        ::close(fd);
         VISCALOG_INFO("Serial port closed.");
     }
 }
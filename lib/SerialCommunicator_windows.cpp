@@ -1,5 +1,6 @@
 #include "Logger.h"
 #include "SerialCommunicator.h"
+#include "Tracing.h"
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -39,7 +40,7 @@ bool SerialCommunicator::open()
         return false;
     }
 
-    dcbSerialParams.BaudRate = CBR_115200;
+    dcbSerialParams.BaudRate = m_baudRate;
     dcbSerialParams.ByteSize = 8;
     dcbSerialParams.StopBits = ONESTOPBIT;
     dcbSerialParams.Parity = NOPARITY;
@@ -63,14 +64,36 @@ bool SerialCommunicator::open()
     return true;
 }
 
-bool SerialCommunicator::send(const std::vector<uint8_t>& data)
+bool SerialCommunicator::send(Span<const uint8_t> data)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_fd == -1)
         return false;
     DWORD bytesWritten;
-    return WriteFile(
-        reinterpret_cast<HANDLE>(static_cast<intptr_t>(m_fd)), data.data(), (DWORD)data.size(), &bytesWritten, NULL);
+    if (!WriteFile(reinterpret_cast<HANDLE>(static_cast<intptr_t>(m_fd)), data.data(), (DWORD)data.size(),
+            &bytesWritten, NULL))
+        return false;
+    VISCA_TRACE(TraceEvent::BytesWritten, m_fd, bytesWritten);
+    return true;
+}
+
+bool SerialCommunicator::sendv(Span<const Span<const uint8_t>> packets)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd == -1)
+        return false;
+
+    // Coalesce into one WriteFile so the packets leave back to back
+    std::vector<uint8_t> batch;
+    for (const auto& packet : packets)
+        batch.insert(batch.end(), packet.begin(), packet.end());
+
+    DWORD bytesWritten;
+    if (!WriteFile(reinterpret_cast<HANDLE>(static_cast<intptr_t>(m_fd)), batch.data(), (DWORD)batch.size(),
+            &bytesWritten, NULL))
+        return false;
+    VISCA_TRACE(TraceEvent::BytesWritten, m_fd, bytesWritten);
+    return true;
 }
 
 size_t SerialCommunicator::receive(uint8_t* buffer, size_t maxSize)
@@ -85,6 +108,61 @@ size_t SerialCommunicator::receive(uint8_t* buffer, size_t maxSize)
     return 0;
 }
 
+size_t SerialCommunicator::receive(uint8_t* buffer, size_t maxSize, int timeoutMs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd == -1)
+        return 0;
+    HANDLE handle = reinterpret_cast<HANDLE>(static_cast<intptr_t>(m_fd));
+
+    // Return with the first bytes, or after timeoutMs if none come
+    COMMTIMEOUTS original;
+    GetCommTimeouts(handle, &original);
+    COMMTIMEOUTS timeouts = original;
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+    timeouts.ReadTotalTimeoutConstant = static_cast<DWORD>(timeoutMs > 0 ? timeoutMs : 1);
+    SetCommTimeouts(handle, &timeouts);
+
+    DWORD bytesRead = 0;
+    BOOL ok = ReadFile(handle, buffer, (DWORD)maxSize, &bytesRead, NULL);
+    SetCommTimeouts(handle, &original);
+    return ok ? (size_t)bytesRead : 0;
+}
+
+bool SerialCommunicator::setBaudRate(uint32_t baudRate)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd != -1) {
+        HANDLE handle = reinterpret_cast<HANDLE>(static_cast<intptr_t>(m_fd));
+        DCB dcbSerialParams = { 0 };
+        dcbSerialParams.DCBlength = sizeof(dcbSerialParams);
+        if (!GetCommState(handle, &dcbSerialParams))
+            return false;
+        FlushFileBuffers(handle);
+        dcbSerialParams.BaudRate = baudRate;
+        if (!SetCommState(handle, &dcbSerialParams)) {
+            VISCALOG_ERROR("WinSerial: Unsupported baud rate " << baudRate);
+            return false;
+        }
+        PurgeComm(handle, PURGE_RXCLEAR);
+    }
+    m_baudRate = baudRate;
+    return true;
+}
+
+uint32_t SerialCommunicator::baudRate() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_baudRate;
+}
+
+int SerialCommunicator::nativeHandle() const
+{
+    // m_fd holds a truncated HANDLE which cannot be waited on like a socket
+    return -1;
+}
+
 bool SerialCommunicator::isOpen() const { return m_fd != -1; }
 
 void SerialCommunicator::close()
@@ -0,0 +1,71 @@
+#include "SharedCameraState.h"
+
+#include <cstring>
+#include <thread>
+
+namespace Visca {
+
+void CameraStatePublisher::initialise()
+{
+    // A segment taken over from a publisher that died mid-update would otherwise stay odd forever
+    m_segment->magic.store(0, std::memory_order_relaxed);
+    m_segment->version = CameraStateSegment::Version;
+    m_segment->stateSize = sizeof(CameraState);
+    m_segment->reserved = 0;
+    uint64_t sequence = m_segment->sequence.load(std::memory_order_relaxed);
+    m_segment->sequence.store((sequence + 1) & ~uint64_t(1), std::memory_order_relaxed);
+    publish(CameraState());
+    m_segment->magic.store(CameraStateSegment::Magic, std::memory_order_release);
+}
+
+void CameraStatePublisher::publish(const CameraState& state)
+{
+    if (!m_segment)
+        return;
+
+    uint64_t words[CameraStateSegment::Words] = {};
+    std::memcpy(words, &state, sizeof(state));
+
+    uint64_t sequence = m_segment->sequence.load(std::memory_order_relaxed);
+    m_segment->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < CameraStateSegment::Words; ++i)
+        m_segment->words[i].store(words[i], std::memory_order_relaxed);
+    m_segment->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool CameraStateReader::read(CameraState& state) const
+{
+    constexpr int Attempts = 1000;
+
+    if (!m_segment)
+        return false;
+
+    uint64_t words[CameraStateSegment::Words];
+    for (int attempt = 0; attempt < Attempts; ++attempt) {
+        uint64_t before = m_segment->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            // An update takes well under a microsecond, unless the publisher was preempted in the middle
+            if (attempt >= 100)
+                std::this_thread::yield();
+            continue;
+        }
+
+        for (size_t i = 0; i < CameraStateSegment::Words; ++i)
+            words[i] = m_segment->words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (m_segment->sequence.load(std::memory_order_relaxed) == before) {
+            std::memcpy(&state, words, sizeof(state));
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t CameraStateReader::sequence() const
+{
+    return m_segment ? m_segment->sequence.load(std::memory_order_acquire) & ~uint64_t(1) : 0;
+}
+
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "Export.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace Visca {
+
+/**
+ * @brief Latest known state of one camera, as published by ViscaController.
+ *
+ * Plain data with fixed-width fields, it is copied in and out of shared memory as is. Timestamps are nanoseconds of
+ * std::chrono::steady_clock (CLOCK_MONOTONIC on Linux), comparable between processes on the same machine; 0 means the
+ * value was never seen.
+ */
+struct CameraState {
+    uint16_t zoomPosition { 0 };
+    uint16_t focusPosition { 0 };
+    uint8_t power { 0 }; ///< 0x02 on, 0x03 standby, 0 unknown (as in the power inquiry reply)
+    uint8_t focusMode { 0 }; ///< 0x02 auto, 0x03 manual, 0 unknown
+    uint8_t address { 0 }; ///< Camera address
+    uint8_t connected { 0 }; ///< 1 while the controller is connected
+    int64_t zoomUpdatedNs { 0 };
+    int64_t focusUpdatedNs { 0 };
+    int64_t powerUpdatedNs { 0 };
+    int64_t focusModeUpdatedNs { 0 };
+    int64_t updatedNs { 0 }; ///< Last change of any field
+    uint64_t commands { 0 }; ///< Commands and inquiries executed
+    uint64_t errors { 0 }; ///< Error replies from the camera
+    uint64_t timeouts { 0 }; ///< Missing ACK, completion or inquiry reply
+    uint64_t linkErrors { 0 }; ///< Packets the communicator failed to send
+};
+
+static_assert(std::is_trivially_copyable<CameraState>::value, "CameraState is copied through shared memory");
+
+/**
+ * @brief Layout of the shared-memory segment: a seqlock around the state.
+ *
+ * The sequence is odd while the publisher writes and bumped to the next even value when done. The state is stored as
+ * relaxed atomic words, so a reader racing the publisher sees a torn copy at worst, never undefined behaviour, and
+ * notices it because the sequence changed. The header fields are written once before the magic, readers refuse a
+ * segment whose magic, version or state size differ from their own.
+ */
+struct CameraStateSegment {
+    static constexpr uint32_t Magic = 0x56435353; // "VCSS"
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t Words = (sizeof(CameraState) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t stateSize;
+    uint32_t reserved;
+    alignas(64) std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> words[Words];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Lock-free 64-bit atomics are needed across processes");
+
+/**
+ * @brief Publishes a CameraState into a named shared-memory segment (POSIX shm_open on Linux, a named file mapping on
+ * Windows).
+ *
+ * The name is a plain identifier like "visca-cam1", one publisher per name. open() creates the segment or takes over
+ * one left behind by a process that died, close() removes the name; readers already attached keep their mapping.
+ * publish() never blocks and never waits for readers. Not thread-safe, callers serialise publish().
+ */
+class VISCA_EXPORT CameraStatePublisher {
+public:
+    CameraStatePublisher() = default;
+    ~CameraStatePublisher();
+
+    CameraStatePublisher(const CameraStatePublisher&) = delete;
+    CameraStatePublisher& operator=(const CameraStatePublisher&) = delete;
+
+    bool open(const std::string& name);
+    void publish(const CameraState& state);
+    void close();
+
+    bool isOpen() const { return m_segment != nullptr; }
+    const std::string& name() const { return m_name; }
+
+private:
+    void initialise();
+
+    std::string m_name;
+    CameraStateSegment* m_segment { nullptr };
+#ifdef _WIN32
+    void* m_mapping { nullptr };
+#endif
+};
+
+/**
+ * @brief Reads the state a CameraStatePublisher publishes, from any process.
+ *
+ * read() copies the state out of the segment without locks or system calls; it only retries while the publisher is
+ * in the middle of an update. Any number of readers may share a segment. Not thread-safe per instance, each thread
+ * opens its own reader or serialises access.
+ */
+class VISCA_EXPORT CameraStateReader {
+public:
+    CameraStateReader() = default;
+    ~CameraStateReader();
+
+    CameraStateReader(const CameraStateReader&) = delete;
+    CameraStateReader& operator=(const CameraStateReader&) = delete;
+
+    /**
+     * @return false if the segment does not exist (yet) or has another layout.
+     */
+    bool open(const std::string& name);
+
+    /**
+     * @brief Copy a consistent snapshot of the state.
+     * @return false if not open, or the publisher kept the segment busy for every attempt (it died mid-update).
+     */
+    bool read(CameraState& state) const;
+
+    /**
+     * @brief Even number that grows with every publish, to see whether anything changed without copying the state.
+     */
+    uint64_t sequence() const;
+
+    void close();
+
+    bool isOpen() const { return m_segment != nullptr; }
+
+private:
+    const CameraStateSegment* m_segment { nullptr };
+#ifdef _WIN32
+    void* m_mapping { nullptr };
+#endif
+};
+
+}
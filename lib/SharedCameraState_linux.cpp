@@ -0,0 +1,99 @@
+#include "Logger.h"
+#include "SharedCameraState.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Visca {
+
+namespace {
+    std::string shmName(const std::string& name) { return name.empty() || name[0] != '/' ? "/" + name : name; }
+}
+
+CameraStatePublisher::~CameraStatePublisher() { close(); }
+
+bool CameraStatePublisher::open(const std::string& name)
+{
+    close();
+
+    std::string path = shmName(name);
+    int fd = ::shm_open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        VISCALOG_ERROR("CameraStatePublisher: Cannot create " << path << ": " << std::strerror(errno));
+        return false;
+    }
+
+    if (::ftruncate(fd, sizeof(CameraStateSegment)) < 0) {
+        VISCALOG_ERROR("CameraStatePublisher: Cannot size " << path << ": " << std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, sizeof(CameraStateSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the segment
+    if (data == MAP_FAILED) {
+        VISCALOG_ERROR("CameraStatePublisher: Cannot map " << path << ": " << std::strerror(errno));
+        return false;
+    }
+
+    m_name = name;
+    m_segment = static_cast<CameraStateSegment*>(data);
+    initialise();
+    return true;
+}
+
+void CameraStatePublisher::close()
+{
+    if (!m_segment)
+        return;
+
+    ::munmap(m_segment, sizeof(CameraStateSegment));
+    m_segment = nullptr;
+    ::shm_unlink(shmName(m_name).c_str());
+}
+
+CameraStateReader::~CameraStateReader() { close(); }
+
+bool CameraStateReader::open(const std::string& name)
+{
+    close();
+
+    std::string path = shmName(name);
+    int fd = ::shm_open(path.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(CameraStateSegment))
+        data = ::mmap(nullptr, sizeof(CameraStateSegment), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    auto segment = static_cast<const CameraStateSegment*>(data);
+    if (segment->magic.load(std::memory_order_acquire) != CameraStateSegment::Magic
+        || segment->version != CameraStateSegment::Version || segment->stateSize != sizeof(CameraState)) {
+        VISCALOG_DEBUG("CameraStateReader: " << path << " is not ready or has another layout");
+        ::munmap(data, sizeof(CameraStateSegment));
+        return false;
+    }
+
+    m_segment = segment;
+    return true;
+}
+
+void CameraStateReader::close()
+{
+    if (!m_segment)
+        return;
+
+    ::munmap(const_cast<CameraStateSegment*>(m_segment), sizeof(CameraStateSegment));
+    m_segment = nullptr;
+}
+
+}
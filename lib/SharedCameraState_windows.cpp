@@ -0,0 +1,101 @@
+#include "Logger.h"
+#include "SharedCameraState.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+namespace Visca {
+
+namespace {
+    // Session-local names need no privileges, unlike Global\ ones
+    std::string mappingName(const std::string& name)
+    {
+        return "Local\\" + (name.empty() || name[0] != '/' ? name : name.substr(1));
+    }
+}
+
+CameraStatePublisher::~CameraStatePublisher() { close(); }
+
+bool CameraStatePublisher::open(const std::string& name)
+{
+    close();
+
+    std::string path = mappingName(name);
+    HANDLE mapping = CreateFileMappingA(
+        INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, static_cast<DWORD>(sizeof(CameraStateSegment)), path.c_str());
+    if (!mapping) {
+        VISCALOG_ERROR("CameraStatePublisher: Cannot create " << path);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, sizeof(CameraStateSegment));
+    if (!data) {
+        VISCALOG_ERROR("CameraStatePublisher: Cannot map " << path);
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_name = name;
+    m_mapping = mapping;
+    m_segment = static_cast<CameraStateSegment*>(data);
+    initialise();
+    return true;
+}
+
+void CameraStatePublisher::close()
+{
+    // The mapping goes away with its last handle, there is no name to unlink
+    if (m_segment) {
+        UnmapViewOfFile(m_segment);
+        m_segment = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+}
+
+CameraStateReader::~CameraStateReader() { close(); }
+
+bool CameraStateReader::open(const std::string& name)
+{
+    close();
+
+    std::string path = mappingName(name);
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, path.c_str());
+    if (!mapping)
+        return false;
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(CameraStateSegment));
+    if (!data) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    auto segment = static_cast<const CameraStateSegment*>(data);
+    if (segment->magic.load(std::memory_order_acquire) != CameraStateSegment::Magic
+        || segment->version != CameraStateSegment::Version || segment->stateSize != sizeof(CameraState)) {
+        VISCALOG_DEBUG("CameraStateReader: " << path << " is not ready or has another layout");
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_segment = segment;
+    return true;
+}
+
+void CameraStateReader::close()
+{
+    if (m_segment) {
+        UnmapViewOfFile(const_cast<CameraStateSegment*>(m_segment));
+        m_segment = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+}
+
+}
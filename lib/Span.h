@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace Visca {
+
+/**
+ * @brief Minimal non-owning view over a contiguous sequence, a C++17 stand-in for std::span.
+ *
+ * A Span can be built from a pointer and a size, a C array or any container exposing data() and size()
+ * (std::vector, std::array, std::string...). It never allocates and is cheap to pass by value.
+ */
+template <typename T> class Span {
+public:
+    using element_type = T;
+    using value_type = typename std::remove_cv<T>::type;
+    using iterator = T*;
+
+    constexpr Span() noexcept = default;
+
+    constexpr Span(T* data, size_t size) noexcept
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    template <size_t N>
+    constexpr Span(T (&array)[N]) noexcept
+        : m_data(array)
+        , m_size(N)
+    {
+    }
+
+    template <typename Container,
+        typename = typename std::enable_if<
+            !std::is_same<typename std::decay<Container>::type, Span>::value
+            && std::is_convertible<decltype(std::declval<Container&>().data()), T*>::value>::type>
+    constexpr Span(Container&& container) noexcept
+        : m_data(container.data())
+        , m_size(container.size())
+    {
+    }
+
+    constexpr T* data() const noexcept { return m_data; }
+    constexpr size_t size() const noexcept { return m_size; }
+    constexpr bool empty() const noexcept { return m_size == 0; }
+
+    constexpr T& operator[](size_t index) const noexcept { return m_data[index]; }
+
+    constexpr iterator begin() const noexcept { return m_data; }
+    constexpr iterator end() const noexcept { return m_data + m_size; }
+
+    /**
+     * @brief A view over count elements starting at offset, clamped to the end of this span.
+     */
+    constexpr Span subspan(size_t offset, size_t count = static_cast<size_t>(-1)) const noexcept
+    {
+        if (offset > m_size)
+            offset = m_size;
+        if (count > m_size - offset)
+            count = m_size - offset;
+        return Span(m_data + offset, count);
+    }
+
+private:
+    T* m_data { nullptr };
+    size_t m_size { 0 };
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ICommunicator.h"
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <string>
@@ -18,17 +19,20 @@ public:
     ~TcpCommunicator() override;
 
     bool open() override;
-    bool send(const std::vector<uint8_t>& data) override;
+    using ICommunicator::send;
+    bool send(Span<const uint8_t> data) override;
+    bool sendv(Span<const Span<const uint8_t>> packets) override;
     size_t receive(uint8_t* buffer, size_t maxSize) override;
+    int nativeHandle() const override;
     bool isOpen() const override;
     void close() override;
 
 private:
-    int m_socket { -1 };
+    std::atomic<int> m_socket { -1 }; ///< Read without the lock by receive()
     int m_serverFd { -1 };
     std::string m_ip;
     uint16_t m_port;
     NetworkMode m_mode;
-    mutable std::mutex m_mutex;
+    mutable std::mutex m_mutex; ///< Guards open, close and sending
 };
 }
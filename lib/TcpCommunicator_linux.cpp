@@ -1,7 +1,10 @@
 #include "Logger.h"
 #include "TcpCommunicator.h"
+#include "Tracing.h"
+#include "WriteAll.h"
 
 #include <arpa/inet.h>
+#include <cerrno>
 #include <cstring>
 #include <sys/socket.h>
 #include <sys/time.h>
@@ -74,45 +77,57 @@ bool TcpCommunicator::open()
     return m_socket >= 0;
 }
 
-bool TcpCommunicator::send(const std::vector<uint8_t>& data)
+bool TcpCommunicator::send(Span<const uint8_t> data)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_socket < 0)
         return false;
     ssize_t sent = ::send(m_socket, data.data(), data.size(), 0);
-    return sent == static_cast<ssize_t>(data.size());
+    if (sent != static_cast<ssize_t>(data.size()))
+        return false;
+    VISCA_TRACE(TraceEvent::BytesWritten, m_socket, sent);
+    return true;
 }
 
-size_t TcpCommunicator::receive(uint8_t* buffer, size_t maxSize)
+bool TcpCommunicator::sendv(Span<const Span<const uint8_t>> packets)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_socket < 0)
+        return false;
+    return writevAll(m_socket, packets);
+}
+
+size_t TcpCommunicator::receive(uint8_t* buffer, size_t maxSize)
+{
+    // Not under the lock: the receive thread blocks here for up to the receive timeout, sends must not wait on it
+    int fd = m_socket;
+    if (fd < 0)
         return 0;
 
-    ssize_t received = ::recv(m_socket, buffer, maxSize, 0);
+    ssize_t received = ::recv(fd, buffer, maxSize, 0);
 
     if (received == 0) // Peer disconnected
     {
-        ::close(m_socket);
-        m_socket = -1;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_socket == fd) {
+            ::close(fd);
+            m_socket = -1;
+        }
         return 0;
     }
     return (received > 0) ? static_cast<size_t>(received) : 0;
 }
 
-bool TcpCommunicator::isOpen() const
-{
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_socket >= 0;
-}
+int TcpCommunicator::nativeHandle() const { return m_socket; }
+
+bool TcpCommunicator::isOpen() const { return m_socket >= 0; }
 
 void TcpCommunicator::close()
 {
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_socket >= 0) {
-        ::close(m_socket);
-        m_socket = -1;
-    }
+    int fd = m_socket.exchange(-1);
+    if (fd >= 0)
+        ::close(fd);
     if (m_serverFd >= 0) {
         ::close(m_serverFd);
         m_serverFd = -1;
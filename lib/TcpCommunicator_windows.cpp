@@ -1,5 +1,6 @@
 #include "Logger.h"
 #include "TcpCommunicator.h"
+#include "Tracing.h"
 
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -69,12 +70,43 @@ bool TcpCommunicator::open()
     return m_socket != -1;
 }
 
-bool TcpCommunicator::send(const std::vector<uint8_t>& data)
+bool TcpCommunicator::send(Span<const uint8_t> data)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_socket == -1)
         return false;
-    return ::send(m_socket, (const char*)data.data(), (int)data.size(), 0) != SOCKET_ERROR;
+    int sent = ::send(m_socket, (const char*)data.data(), (int)data.size(), 0);
+    if (sent == SOCKET_ERROR)
+        return false;
+    VISCA_TRACE(TraceEvent::BytesWritten, m_socket, sent);
+    return true;
+}
+
+bool TcpCommunicator::sendv(Span<const Span<const uint8_t>> packets)
+{
+    constexpr size_t MaxBuffers = 64;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_socket == -1)
+        return false;
+
+    WSABUF buffers[MaxBuffers];
+    size_t index = 0;
+    while (index < packets.size()) {
+        DWORD count = 0;
+        for (size_t i = index; i < packets.size() && count < MaxBuffers; ++i, ++count) {
+            buffers[count].buf = (CHAR*)packets[i].data();
+            buffers[count].len = (ULONG)packets[i].size();
+        }
+
+        // Blocking WSASend only returns once every buffer has been sent
+        DWORD sent = 0;
+        if (WSASend(m_socket, buffers, count, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+            return false;
+        VISCA_TRACE(TraceEvent::BytesWritten, m_socket, sent);
+        index += count;
+    }
+    return true;
 }
 
 size_t TcpCommunicator::receive(uint8_t* buffer, size_t maxSize)
@@ -94,6 +126,12 @@ size_t TcpCommunicator::receive(uint8_t* buffer, size_t maxSize)
     return (res > 0) ? (size_t)res : 0;
 }
 
+int TcpCommunicator::nativeHandle() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_socket;
+}
+
 bool TcpCommunicator::isOpen() const
 {
     std::lock_guard<std::mutex> lock(m_mutex);
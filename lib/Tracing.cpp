@@ -0,0 +1,177 @@
+#include "Tracing.h"
+#include "TrafficCapture.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+
+namespace Visca {
+
+namespace {
+    std::atomic<uint64_t> s_nextId { 1 };
+    std::atomic<uint32_t> s_nextThread { 1 };
+
+    // Small per-thread numbers read better than std::thread::id in the viewer
+    uint32_t threadNumber()
+    {
+        thread_local uint32_t number = s_nextThread.fetch_add(1, std::memory_order_relaxed);
+        return number;
+    }
+}
+
+std::atomic<ITracer*> Tracing::activeTracer { nullptr };
+
+void Tracing::setTracer(ITracer* tracer) { activeTracer.store(tracer, std::memory_order_release); }
+
+bool Tracing::compiledIn()
+{
+#if defined(VISCA_TRACING) && VISCA_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t Tracing::newId() { return s_nextId.fetch_add(1, std::memory_order_relaxed); }
+
+const char* traceEventName(TraceEvent event)
+{
+    switch (event) {
+    case TraceEvent::CommandEnqueued:
+        return "command_enqueued";
+    case TraceEvent::BytesWritten:
+        return "bytes_written";
+    case TraceEvent::FrameReassembled:
+        return "frame_reassembled";
+    case TraceEvent::AckMatched:
+        return "ack_matched";
+    case TraceEvent::CompletionMatched:
+        return "completion_matched";
+    case TraceEvent::CommandFailed:
+        return "command_failed";
+    case TraceEvent::TimeoutFired:
+        return "timeout_fired";
+    }
+    return "unknown";
+}
+
+ChromeTraceWriter::ChromeTraceWriter(size_t capacity)
+    : m_entries(new Entry[capacity > 0 ? capacity : 1])
+    , m_capacity(capacity > 0 ? capacity : 1)
+{
+}
+
+ChromeTraceWriter::~ChromeTraceWriter()
+{
+    ITracer* self = this;
+    Tracing::activeTracer.compare_exchange_strong(self, nullptr);
+}
+
+void ChromeTraceWriter::trace(TraceEvent event, uint64_t id, uint64_t value)
+{
+    uint64_t index = m_next.fetch_add(1, std::memory_order_relaxed);
+    if (index >= m_capacity)
+        return;
+
+    Entry& entry = m_entries[index];
+    entry.timestampNs = CaptureFormat::monotonicNs();
+    entry.id = id;
+    entry.value = value;
+    entry.thread = threadNumber();
+    entry.event = event;
+    entry.ready.store(true, std::memory_order_release);
+}
+
+size_t ChromeTraceWriter::size() const
+{
+    uint64_t next = m_next.load(std::memory_order_relaxed);
+    return next < m_capacity ? static_cast<size_t>(next) : m_capacity;
+}
+
+uint64_t ChromeTraceWriter::dropped() const
+{
+    uint64_t next = m_next.load(std::memory_order_relaxed);
+    return next > m_capacity ? next - m_capacity : 0;
+}
+
+std::string ChromeTraceWriter::json() const
+{
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    char line[256];
+    bool first = true;
+    for (size_t i = 0; i < size(); ++i) {
+        const Entry& entry = m_entries[i];
+        if (!entry.ready.load(std::memory_order_acquire))
+            continue;
+
+        // Microseconds with nanosecond decimals
+        uint64_t us = entry.timestampNs / 1000;
+        unsigned ns = static_cast<unsigned>(entry.timestampNs % 1000);
+        const char* result = nullptr;
+        const char* field = "value";
+        switch (entry.event) {
+        case TraceEvent::CommandEnqueued:
+        case TraceEvent::BytesWritten:
+        case TraceEvent::FrameReassembled:
+            field = "bytes";
+            break;
+        case TraceEvent::AckMatched:
+            field = "socket";
+            break;
+        case TraceEvent::CompletionMatched:
+            field = "socket";
+            result = "completed";
+            break;
+        case TraceEvent::CommandFailed:
+            field = "error";
+            result = "failed";
+            break;
+        case TraceEvent::TimeoutFired:
+            result = "timeout";
+            break;
+        }
+
+        int length;
+        if (entry.id != 0 && entry.event == TraceEvent::CommandEnqueued) {
+            length = std::snprintf(line, sizeof(line),
+                "{\"name\":\"command\",\"cat\":\"visca\",\"ph\":\"b\",\"id\":\"0x%" PRIx64 "\",\"ts\":%" PRIu64
+                ".%03u,\"pid\":1,\"tid\":%u,\"args\":{\"%s\":%" PRIu64 "}}",
+                entry.id, us, ns, entry.thread, field, entry.value);
+        } else if (entry.id != 0 && entry.event == TraceEvent::AckMatched) {
+            length = std::snprintf(line, sizeof(line),
+                "{\"name\":\"ack\",\"cat\":\"visca\",\"ph\":\"n\",\"id\":\"0x%" PRIx64 "\",\"ts\":%" PRIu64
+                ".%03u,\"pid\":1,\"tid\":%u,\"args\":{\"%s\":%" PRIu64 "}}",
+                entry.id, us, ns, entry.thread, field, entry.value);
+        } else if (entry.id != 0 && result) {
+            length = std::snprintf(line, sizeof(line),
+                "{\"name\":\"command\",\"cat\":\"visca\",\"ph\":\"e\",\"id\":\"0x%" PRIx64 "\",\"ts\":%" PRIu64
+                ".%03u,\"pid\":1,\"tid\":%u,\"args\":{\"result\":\"%s\",\"%s\":%" PRIu64 "}}",
+                entry.id, us, ns, entry.thread, result, field, entry.value);
+        } else {
+            length = std::snprintf(line, sizeof(line),
+                "{\"name\":\"%s\",\"cat\":\"visca\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%" PRIu64
+                ".%03u,\"pid\":1,\"tid\":%u,\"args\":{\"id\":%" PRIu64 ",\"%s\":%" PRIu64 "}}",
+                traceEventName(entry.event), us, ns, entry.thread, entry.id, field, entry.value);
+        }
+        if (length <= 0)
+            continue;
+
+        if (!first)
+            out += ",\n";
+        first = false;
+        out.append(line, static_cast<size_t>(length));
+    }
+    out += "]}\n";
+    return out;
+}
+
+bool ChromeTraceWriter::writeFile(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file)
+        return false;
+    file << json();
+    return static_cast<bool>(file.flush());
+}
+
+}
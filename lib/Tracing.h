@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Export.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Visca {
+
+/**
+ * @brief Hot-path points of the controller and the communicators a tracer can attach to.
+ */
+enum class TraceEvent : uint8_t {
+    CommandEnqueued, ///< execute() or sendAsync() is about to send a packet; value: packet size
+    BytesWritten, ///< A communicator wrote to its link; id: native handle, value: bytes
+    FrameReassembled, ///< The receive thread completed a 0xFF-terminated frame; value: frame size
+    AckMatched, ///< execute() got the ACK of its command; value: socket
+    CompletionMatched, ///< execute() got the completion or inquiry reply; value: socket
+    CommandFailed, ///< execute() got an error reply or could not send; value: error code, 0 for the link
+    TimeoutFired ///< execute() gave up waiting for the ACK or completion
+};
+
+VISCA_EXPORT const char* traceEventName(TraceEvent event);
+
+/**
+ * @brief Receiver of trace events, e.g. a shim firing LTTng or perf user probes, or ChromeTraceWriter.
+ *
+ * trace() runs inline on the thread hitting the event, often with the link's send lock held, and must be quick and
+ * thread-safe.
+ */
+class VISCA_EXPORT ITracer {
+public:
+    virtual ~ITracer() = default;
+
+    /**
+     * @param id Events of one execute() share an id (from Tracing::newId()), 0 for events not tied to a command.
+     */
+    virtual void trace(TraceEvent event, uint64_t id, uint64_t value) = 0;
+};
+
+namespace Tracing {
+    VISCA_EXPORT extern std::atomic<ITracer*> activeTracer;
+
+    /**
+     * @brief Send the events of every controller and communicator of the process to tracer, nullptr to stop.
+     *
+     * The tracer must outlive the calls already inside it: stop tracing and let the controllers go idle (or
+     * disconnect them) before destroying it. Without VISCA_TRACING the library has no hooks and nothing is traced.
+     */
+    VISCA_EXPORT void setTracer(ITracer* tracer);
+
+    inline ITracer* tracer() { return activeTracer.load(std::memory_order_acquire); }
+
+    /// Whether the library was built with its tracing hooks (VISCA_TRACING)
+    VISCA_EXPORT bool compiledIn();
+
+    VISCA_EXPORT uint64_t newId();
+}
+
+/**
+ * @brief Tracer writing the Chrome trace-event JSON format, for chrome://tracing, Perfetto or speedscope.
+ *
+ * Events go into a buffer allocated up front: trace() claims a slot with one atomic increment and fills it, no lock
+ * and no allocation; events past the capacity are counted as dropped. Each execute() shows as an async slice from
+ * CommandEnqueued to its completion, failure or timeout with the ACK as a mark, the other events as instants on the
+ * thread that hit them. Write the file once tracing has stopped.
+ */
+class VISCA_EXPORT ChromeTraceWriter : public ITracer {
+public:
+    explicit ChromeTraceWriter(size_t capacity = 1 << 16);
+    ~ChromeTraceWriter() override;
+
+    ChromeTraceWriter(const ChromeTraceWriter&) = delete;
+    ChromeTraceWriter& operator=(const ChromeTraceWriter&) = delete;
+
+    void trace(TraceEvent event, uint64_t id, uint64_t value) override;
+
+    std::string json() const;
+    bool writeFile(const std::string& path) const;
+
+    size_t size() const;
+    size_t capacity() const { return m_capacity; }
+    uint64_t dropped() const;
+
+private:
+    struct Entry {
+        std::atomic<bool> ready { false };
+        uint64_t timestampNs { 0 };
+        uint64_t id { 0 };
+        uint64_t value { 0 };
+        uint32_t thread { 0 };
+        TraceEvent event { TraceEvent::CommandEnqueued };
+    };
+
+    std::unique_ptr<Entry[]> m_entries;
+    size_t m_capacity;
+    std::atomic<uint64_t> m_next { 0 };
+};
+
+}
+
+// Hooks in the library. Built with VISCA_TRACING=1 (CMake ENABLE_TRACING) each one is a load of the active tracer
+// and one branch, predicted not taken, while no tracer is set. Built without, the arguments still compile but leave
+// no code behind.
+#if defined(__GNUC__)
+#define VISCA_TRACE_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define VISCA_TRACE_UNLIKELY(x) (x)
+#endif
+
+#if defined(VISCA_TRACING) && VISCA_TRACING
+#define VISCA_TRACE(event, id, value)                                                                                  \
+    do {                                                                                                               \
+        Visca::ITracer* viscaTracer_ = Visca::Tracing::tracer();                                                       \
+        if (VISCA_TRACE_UNLIKELY(viscaTracer_ != nullptr))                                                             \
+            viscaTracer_->trace(event, static_cast<uint64_t>(id), static_cast<uint64_t>(value));                       \
+    } while (0)
+#define VISCA_TRACE_ID() (VISCA_TRACE_UNLIKELY(Visca::Tracing::tracer() != nullptr) ? Visca::Tracing::newId() : 0)
+#else
+#define VISCA_TRACE(event, id, value)                                                                                  \
+    do {                                                                                                               \
+        if (false) {                                                                                                   \
+            (void)(event);                                                                                             \
+            (void)(id);                                                                                                \
+            (void)(value);                                                                                             \
+        }                                                                                                              \
+    } while (0)
+#define VISCA_TRACE_ID() uint64_t(0)
+#endif
@@ -0,0 +1,147 @@
+#include "TrafficCapture.h"
+#include "Logger.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace Visca {
+
+namespace {
+    void putLe(uint8_t* out, uint64_t value, size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i)
+            out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+
+    uint64_t getLe(const uint8_t* in, size_t bytes)
+    {
+        uint64_t value = 0;
+        for (size_t i = bytes; i > 0; --i)
+            value = (value << 8) | in[i - 1];
+        return value;
+    }
+}
+
+uint64_t CaptureFormat::monotonicNs()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+CaptureWriter::~CaptureWriter() { close(); }
+
+bool CaptureWriter::open(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file.open(path, MappedFile::Mode::Write))
+        return false;
+
+    uint8_t header[CaptureFormat::HeaderSize] = {};
+    std::memcpy(header, CaptureFormat::Magic, sizeof(CaptureFormat::Magic));
+    putLe(header + 4, CaptureFormat::Version, 2);
+    putLe(header + 6, CaptureFormat::HeaderSize, 2);
+    putLe(header + 8, CaptureFormat::monotonicNs(), 8);
+    putLe(header + 16,
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+                .count()),
+        8);
+
+    m_records = 0;
+    return m_file.append(header, sizeof(header));
+}
+
+bool CaptureWriter::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_file.isOpen();
+}
+
+bool CaptureWriter::record(CaptureDirection direction, Span<const uint8_t> frame)
+{
+    return record(direction, CaptureFormat::monotonicNs(), frame);
+}
+
+bool CaptureWriter::record(CaptureDirection direction, uint64_t timestampNs, Span<const uint8_t> frame)
+{
+    // Length 0 is the end marker, a longer frame cannot be a VISCA frame
+    if (frame.empty() || frame.size() > CaptureFormat::MaxFrameSize)
+        return false;
+
+    uint8_t header[CaptureFormat::RecordHeaderSize];
+    putLe(header, timestampNs, 8);
+    header[8] = static_cast<uint8_t>(direction);
+    header[9] = 0;
+    putLe(header + 10, frame.size(), 2);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file.append(header, sizeof(header)) || !m_file.append(frame.data(), frame.size()))
+        return false;
+    ++m_records;
+    return true;
+}
+
+void CaptureWriter::flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file.sync(false);
+}
+
+void CaptureWriter::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file.close();
+}
+
+uint64_t CaptureWriter::records() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_records;
+}
+
+bool CaptureReader::open(const std::string& path)
+{
+    if (!m_file.open(path, MappedFile::Mode::Read))
+        return false;
+
+    const uint8_t* header = m_file.data();
+    if (m_file.size() < CaptureFormat::HeaderSize
+        || std::memcmp(header, CaptureFormat::Magic, sizeof(CaptureFormat::Magic)) != 0) {
+        VISCALOG_ERROR("CaptureReader: " << path << " is not a capture file");
+        m_file.close();
+        return false;
+    }
+
+    uint16_t version = static_cast<uint16_t>(getLe(header + 4, 2));
+    size_t headerSize = static_cast<size_t>(getLe(header + 6, 2));
+    if (version != CaptureFormat::Version || headerSize != CaptureFormat::HeaderSize) {
+        VISCALOG_ERROR("CaptureReader: " << path << " has unsupported version " << version);
+        m_file.close();
+        return false;
+    }
+
+    m_startMonotonicNs = getLe(header + 8, 8);
+    m_startWallClockNs = getLe(header + 16, 8);
+    m_offset = CaptureFormat::HeaderSize;
+    return true;
+}
+
+bool CaptureReader::next(CaptureRecord& record)
+{
+    if (!m_file.isOpen() || m_offset + CaptureFormat::RecordHeaderSize > m_file.size())
+        return false;
+
+    const uint8_t* header = m_file.data() + m_offset;
+    size_t length = static_cast<size_t>(getLe(header + 10, 2));
+    if (length == 0 || m_offset + CaptureFormat::RecordHeaderSize + length > m_file.size())
+        return false;
+
+    record.timestampNs = getLe(header, 8);
+    record.direction = header[8] == 0 ? CaptureDirection::Sent : CaptureDirection::Received;
+    record.data = Span<const uint8_t>(header + CaptureFormat::RecordHeaderSize, length);
+    m_offset += CaptureFormat::RecordHeaderSize + length;
+    return true;
+}
+
+}
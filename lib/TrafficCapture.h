@@ -0,0 +1,110 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "Span.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace Visca {
+
+/**
+ * @brief Direction of a captured frame, seen from the host.
+ */
+enum class CaptureDirection : uint8_t {
+    Sent = 0, ///< Host to camera
+    Received = 1 ///< Camera to host
+};
+
+/**
+ * @brief One frame of a capture. data points into the mapped file and stays valid while the reader is open.
+ */
+struct CaptureRecord {
+    uint64_t timestampNs { 0 }; ///< Monotonic clock
+    CaptureDirection direction { CaptureDirection::Sent };
+    Span<const uint8_t> data;
+};
+
+/**
+ * @brief On-disk layout of a capture file, all integers little-endian.
+ *
+ * File header: "VCAP", u16 version, u16 header size, u64 monotonic start ns, u64 wall clock start ns (Unix epoch).
+ * Then records back to back: u64 monotonic timestamp ns, u8 direction, u8 reserved, u16 length, length bytes.
+ * A record of length 0 marks the end, which is how the zero-filled tail of a file left by a crash reads.
+ */
+namespace CaptureFormat {
+    constexpr uint8_t Magic[4] = { 'V', 'C', 'A', 'P' };
+    constexpr uint16_t Version = 1;
+    constexpr size_t HeaderSize = 24;
+    constexpr size_t RecordHeaderSize = 12;
+    constexpr size_t MaxFrameSize = 0xFFFF;
+
+    /**
+     * @brief Current time of the monotonic clock the timestamps use, in ns.
+     */
+    VISCA_EXPORT uint64_t monotonicNs();
+}
+
+/**
+ * @brief Appends frames to a capture file. Thread-safe, send and receive paths may record concurrently.
+ */
+class VISCA_EXPORT CaptureWriter {
+public:
+    CaptureWriter() = default;
+    ~CaptureWriter();
+
+    bool open(const std::string& path);
+    bool isOpen() const;
+
+    /**
+     * @brief Record a frame stamped with the current time.
+     */
+    bool record(CaptureDirection direction, Span<const uint8_t> frame);
+    bool record(CaptureDirection direction, uint64_t timestampNs, Span<const uint8_t> frame);
+
+    /**
+     * @brief Schedule written data for write-back without waiting for it.
+     */
+    void flush();
+    void close();
+
+    uint64_t records() const;
+
+private:
+    MappedFile m_file;
+    uint64_t m_records { 0 };
+    mutable std::mutex m_mutex;
+};
+
+/**
+ * @brief Reads a capture file sequentially through a read-only mapping.
+ */
+class VISCA_EXPORT CaptureReader {
+public:
+    bool open(const std::string& path);
+    bool isOpen() const { return m_file.isOpen(); }
+    void close() { m_file.close(); }
+
+    /**
+     * @brief Read the next record.
+     * @return false at the end of the capture or at a truncated record.
+     */
+    bool next(CaptureRecord& record);
+
+    /**
+     * @brief Go back to the first record.
+     */
+    void rewind() { m_offset = CaptureFormat::HeaderSize; }
+
+    uint64_t startMonotonicNs() const { return m_startMonotonicNs; }
+    uint64_t startWallClockNs() const { return m_startWallClockNs; }
+
+private:
+    MappedFile m_file;
+    size_t m_offset { 0 };
+    uint64_t m_startMonotonicNs { 0 };
+    uint64_t m_startWallClockNs { 0 };
+};
+
+}
@@ -1,9 +1,14 @@
 #include "Logger.h"
+#include "Tracing.h"
 #include "UdpCommunicator.h"
 
+#include <algorithm>
 #include <arpa/inet.h>
+#include <cerrno>
 #include <cstring>
 #include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace Visca {
@@ -31,6 +36,11 @@ bool UdpCommunicator::open()
     if (m_socket < 0)
         return false;
 
+    struct timeval tv;
+    tv.tv_sec = 1; // 1-second timeout for responsive shutdown
+    tv.tv_usec = 0;
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+
     memset(&m_pImpl->remoteAddr, 0, sizeof(m_pImpl->remoteAddr));
     m_pImpl->remoteAddr.sin_family = AF_INET;
     m_pImpl->remoteAddr.sin_port = htons(m_port);
@@ -58,31 +68,120 @@ bool UdpCommunicator::open()
     return true;
 }
 
-bool UdpCommunicator::send(const std::vector<uint8_t>& data)
+bool UdpCommunicator::send(Span<const uint8_t> data)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_socket < 0)
         return false;
     ssize_t sent = ::sendto(
         m_socket, data.data(), data.size(), 0, (struct sockaddr*)&m_pImpl->remoteAddr, sizeof(m_pImpl->remoteAddr));
-    return sent == static_cast<ssize_t>(data.size());
+    if (sent != static_cast<ssize_t>(data.size()))
+        return false;
+    VISCA_TRACE(TraceEvent::BytesWritten, m_socket, sent);
+    return true;
 }
 
-size_t UdpCommunicator::receive(uint8_t* buffer, size_t maxSize)
+bool UdpCommunicator::sendv(Span<const Span<const uint8_t>> packets)
 {
+    constexpr size_t MaxMessages = 64;
+
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_socket < 0)
+        return false;
+
+    struct mmsghdr messages[MaxMessages];
+    struct iovec iov[MaxMessages];
+    size_t index = 0;
+
+    // One datagram per packet, up to MaxMessages datagrams per sendmmsg() call
+    while (index < packets.size()) {
+        unsigned int count = 0;
+        for (size_t i = index; i < packets.size() && count < MaxMessages; ++i, ++count) {
+            iov[count].iov_base = const_cast<uint8_t*>(packets[i].data());
+            iov[count].iov_len = packets[i].size();
+            memset(&messages[count], 0, sizeof(messages[count]));
+            messages[count].msg_hdr.msg_name = &m_pImpl->remoteAddr;
+            messages[count].msg_hdr.msg_namelen = sizeof(m_pImpl->remoteAddr);
+            messages[count].msg_hdr.msg_iov = &iov[count];
+            messages[count].msg_hdr.msg_iovlen = 1;
+        }
+
+        int sent = ::sendmmsg(m_socket, messages, count, 0);
+        if (sent < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        for (int i = 0; i < sent; ++i)
+            VISCA_TRACE(TraceEvent::BytesWritten, m_socket, messages[i].msg_len);
+        index += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+size_t UdpCommunicator::receive(uint8_t* buffer, size_t maxSize)
+{
+    // Not under the lock: the receive thread blocks here for up to the receive timeout, sends must not wait on it
+    int fd = m_socket;
+    if (fd < 0)
         return 0;
     struct sockaddr_in src;
     socklen_t len = sizeof(src);
-    ssize_t received = ::recvfrom(m_socket, buffer, maxSize, 0, (struct sockaddr*)&src, &len);
+    ssize_t received = ::recvfrom(fd, buffer, maxSize, 0, (struct sockaddr*)&src, &len);
     // In Server mode, we update remoteAddr to reply to the last sender
     if (m_mode == NetworkMode::Server && received > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
         m_pImpl->remoteAddr = src;
     }
     return (received > 0) ? static_cast<size_t>(received) : 0;
 }
 
+size_t UdpCommunicator::receivev(Span<FrameSlot> slots)
+{
+    constexpr size_t MaxMessages = 16;
+
+    int fd = m_socket;
+    if (fd < 0 || slots.empty())
+        return 0;
+
+    size_t count = std::min(slots.size(), MaxMessages);
+    struct mmsghdr messages[MaxMessages];
+    struct iovec iov[MaxMessages];
+    struct sockaddr_in sources[MaxMessages];
+
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = slots[i].data;
+        iov[i].iov_len = slots[i].capacity;
+        memset(&messages[i], 0, sizeof(messages[i]));
+        messages[i].msg_hdr.msg_name = &sources[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(sources[i]);
+        messages[i].msg_hdr.msg_iov = &iov[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // Block for the first datagram only, then take whatever else is already queued
+    int received = ::recvmmsg(fd, messages, static_cast<unsigned int>(count), MSG_WAITFORONE, nullptr);
+    if (received <= 0)
+        return 0;
+
+    for (int i = 0; i < received; ++i)
+        slots[i].size = messages[i].msg_len;
+
+    // In Server mode, we update remoteAddr to reply to the last sender
+    if (m_mode == NetworkMode::Server) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pImpl->remoteAddr = sources[received - 1];
+    }
+
+    return static_cast<size_t>(received);
+}
+
+int UdpCommunicator::nativeHandle() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_socket;
+}
+
 bool UdpCommunicator::isOpen() const
 {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -92,9 +191,9 @@ bool UdpCommunicator::isOpen() const
 void UdpCommunicator::close()
 {
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_socket >= 0) {
-        ::close(m_socket);
-        m_socket = -1;
+    int fd = m_socket.exchange(-1);
+    if (fd >= 0) {
+        ::close(fd);
         VISCALOG_INFO("UDP socket closed.");
     }
 }
@@ -1,5 +1,6 @@
 #include "Logger.h"
 #include "UdpCommunicator.h"
+#include "Tracing.h"
 
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -54,14 +55,34 @@ bool UdpCommunicator::open()
     return true;
 }
 
-bool UdpCommunicator::send(const std::vector<uint8_t>& data)
+bool UdpCommunicator::send(Span<const uint8_t> data)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_socket == -1)
         return false;
-    return sendto(m_socket, (const char*)data.data(), (int)data.size(), 0, (sockaddr*)&m_pImpl->remoteAddr,
-               sizeof(m_pImpl->remoteAddr))
-        != SOCKET_ERROR;
+    int sent = sendto(m_socket, (const char*)data.data(), (int)data.size(), 0, (sockaddr*)&m_pImpl->remoteAddr,
+        sizeof(m_pImpl->remoteAddr));
+    if (sent == SOCKET_ERROR)
+        return false;
+    VISCA_TRACE(TraceEvent::BytesWritten, m_socket, sent);
+    return true;
+}
+
+bool UdpCommunicator::sendv(Span<const Span<const uint8_t>> packets)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_socket == -1)
+        return false;
+
+    // One datagram per packet, there is no sendmmsg on Windows
+    for (const auto& packet : packets) {
+        if (sendto(m_socket, (const char*)packet.data(), (int)packet.size(), 0, (sockaddr*)&m_pImpl->remoteAddr,
+                sizeof(m_pImpl->remoteAddr))
+            == SOCKET_ERROR)
+            return false;
+        VISCA_TRACE(TraceEvent::BytesWritten, m_socket, packet.size());
+    }
+    return true;
 }
 
 size_t UdpCommunicator::receive(uint8_t* buffer, size_t maxSize)
@@ -78,6 +99,20 @@ size_t UdpCommunicator::receive(uint8_t* buffer, size_t maxSize)
     return (res > 0) ? (size_t)res : 0;
 }
 
+size_t UdpCommunicator::receivev(Span<FrameSlot> slots)
+{
+    if (slots.empty())
+        return 0;
+    slots[0].size = receive(slots[0].data, slots[0].capacity);
+    return slots[0].size > 0 ? 1 : 0;
+}
+
+int UdpCommunicator::nativeHandle() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_socket;
+}
+
 bool UdpCommunicator::isOpen() const
 {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ICommunicator.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace Visca {
+
+/**
+ * @brief Wire format between local processes and the daemon owning the cameras.
+ *
+ * A SOCK_SEQPACKET Unix domain socket keeps message boundaries, so a message is one type byte followed by one VISCA
+ * packet (client to daemon) or one reply frame (daemon to client), nothing else. Receivers ignore types they do not
+ * know.
+ */
+namespace LocalProtocol {
+    enum class MessageType : uint8_t {
+        Packet = 0x01, ///< VISCA packet for the camera
+        Reply = 0x02 ///< VISCA frame from the camera
+    };
+
+    constexpr size_t MaxMessageSize = 256; ///< Type byte included
+}
+
+/**
+ * @brief Talks to a local daemon (e.g. ViscaGateway --unix) over a Unix domain socket.
+ *
+ * Client mode connects to the daemon's socket, server mode listens on the path and accepts one peer, mostly for tests
+ * and tools standing in for the daemon. send() splits its data on 0xFF and sends one message per packet, receive()
+ * returns the frame of one message. Receiving does not take the lock senders use, a thread waiting for replies never
+ * holds up a command. Linux only.
+ */
+class VISCA_EXPORT UnixSocketCommunicator : public ICommunicator {
+public:
+    /**
+     * @param path Socket path of the daemon, or to listen on in server mode.
+     * @param mode Client or Server.
+     */
+    UnixSocketCommunicator(const std::string& path, NetworkMode mode = NetworkMode::Client);
+    ~UnixSocketCommunicator() override;
+
+    bool open() override;
+    using ICommunicator::send;
+    bool send(Span<const uint8_t> data) override;
+    bool sendv(Span<const Span<const uint8_t>> packets) override;
+    size_t receive(uint8_t* buffer, size_t maxSize) override;
+    size_t receivev(Span<FrameSlot> slots) override;
+    int nativeHandle() const override;
+    bool isOpen() const override;
+    void close() override;
+
+    const std::string& path() const { return m_path; }
+
+private:
+    LocalProtocol::MessageType outgoing() const;
+    LocalProtocol::MessageType incoming() const;
+
+    std::atomic<int> m_socket { -1 };
+    int m_serverFd { -1 };
+    std::string m_path;
+    NetworkMode m_mode;
+    mutable std::mutex m_mutex; ///< Guards open, close and sending
+};
+
+}
@@ -0,0 +1,234 @@
+#include "Logger.h"
+#include "Tracing.h"
+#include "UnixSocketCommunicator.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace Visca {
+namespace {
+    bool toAddress(const std::string& path, struct sockaddr_un& addr)
+    {
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path))
+            return false;
+        std::memcpy(addr.sun_path, path.data(), path.size());
+        return true;
+    }
+
+    void setReceiveTimeout(int fd)
+    {
+        struct timeval tv;
+        tv.tv_sec = 1; // 1-second timeout for responsive shutdown
+        tv.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+    }
+}
+
+UnixSocketCommunicator::UnixSocketCommunicator(const std::string& path, NetworkMode mode)
+    : m_path(path)
+    , m_mode(mode)
+{
+}
+
+UnixSocketCommunicator::~UnixSocketCommunicator() { close(); }
+
+bool UnixSocketCommunicator::open()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_socket >= 0)
+        return true;
+
+    struct sockaddr_un addr;
+    if (!toAddress(m_path, addr)) {
+        VISCALOG_ERROR("UnixSocket: Invalid socket path " << m_path);
+        return false;
+    }
+
+    if (m_mode == NetworkMode::Client) {
+        int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return false;
+        if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+            VISCALOG_ERROR("UnixSocket: Cannot connect to " << m_path << ": " << std::strerror(errno));
+            ::close(fd);
+            return false;
+        }
+        setReceiveTimeout(fd);
+        m_socket = fd;
+        return true;
+    }
+
+    if (m_serverFd < 0) {
+        // A socket file left behind by an earlier run would make bind() fail
+        ::unlink(m_path.c_str());
+        m_serverFd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (m_serverFd < 0 || ::bind(m_serverFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0
+            || ::listen(m_serverFd, 1) < 0) {
+            VISCALOG_ERROR("UnixSocket: Cannot listen on " << m_path << ": " << std::strerror(errno));
+            if (m_serverFd >= 0)
+                ::close(m_serverFd);
+            m_serverFd = -1;
+            return false;
+        }
+    }
+
+    int fd = ::accept4(m_serverFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd >= 0)
+        setReceiveTimeout(fd);
+    m_socket = fd;
+    return fd >= 0;
+}
+
+bool UnixSocketCommunicator::send(Span<const uint8_t> data)
+{
+    std::vector<Span<const uint8_t>> packets;
+    size_t start = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (data[i] == 0xFF) {
+            packets.push_back(data.subspan(start, i + 1 - start));
+            start = i + 1;
+        }
+    }
+    if (start < data.size())
+        packets.push_back(data.subspan(start));
+
+    return sendv(Span<const Span<const uint8_t>>(packets));
+}
+
+bool UnixSocketCommunicator::sendv(Span<const Span<const uint8_t>> packets)
+{
+    constexpr size_t MaxMessages = 32;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int fd = m_socket;
+    if (fd < 0)
+        return false;
+
+    uint8_t type = static_cast<uint8_t>(outgoing());
+    struct mmsghdr messages[MaxMessages];
+    struct iovec iov[MaxMessages][2];
+    size_t index = 0;
+
+    // One message per packet, the type byte and the packet gathered from two buffers
+    while (index < packets.size()) {
+        unsigned int count = 0;
+        for (size_t i = index; i < packets.size() && count < MaxMessages; ++i, ++count) {
+            if (packets[i].size() >= LocalProtocol::MaxMessageSize)
+                return false;
+            iov[count][0].iov_base = &type;
+            iov[count][0].iov_len = 1;
+            iov[count][1].iov_base = const_cast<uint8_t*>(packets[i].data());
+            iov[count][1].iov_len = packets[i].size();
+            std::memset(&messages[count], 0, sizeof(messages[count]));
+            messages[count].msg_hdr.msg_iov = iov[count];
+            messages[count].msg_hdr.msg_iovlen = 2;
+        }
+
+        int sent = ::sendmmsg(fd, messages, count, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        for (int i = 0; i < sent; ++i)
+            VISCA_TRACE(TraceEvent::BytesWritten, fd, messages[i].msg_len);
+        index += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+size_t UnixSocketCommunicator::receive(uint8_t* buffer, size_t maxSize)
+{
+    FrameSlot slot;
+    slot.data = buffer;
+    slot.capacity = maxSize;
+    return receivev(Span<FrameSlot>(&slot, 1)) ? slot.size : 0;
+}
+
+size_t UnixSocketCommunicator::receivev(Span<FrameSlot> slots)
+{
+    constexpr size_t MaxMessages = 16;
+
+    int fd = m_socket;
+    if (fd < 0 || slots.empty())
+        return 0;
+
+    size_t count = std::min(slots.size(), MaxMessages);
+    struct mmsghdr messages[MaxMessages];
+    struct iovec iov[MaxMessages][2];
+    uint8_t types[MaxMessages];
+
+    // The type byte is scattered aside, the frame lands directly in the caller's slot
+    for (size_t i = 0; i < count; ++i) {
+        iov[i][0].iov_base = &types[i];
+        iov[i][0].iov_len = 1;
+        iov[i][1].iov_base = slots[i].data;
+        iov[i][1].iov_len = slots[i].capacity;
+        std::memset(&messages[i], 0, sizeof(messages[i]));
+        messages[i].msg_hdr.msg_iov = iov[i];
+        messages[i].msg_hdr.msg_iovlen = 2;
+    }
+
+    int received = ::recvmmsg(fd, messages, static_cast<unsigned int>(count), MSG_WAITFORONE, nullptr);
+    if (received < 0)
+        return 0;
+    if (received == 1 && messages[0].msg_len == 0) {
+        // Orderly shutdown of the peer
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_socket == fd) {
+            ::close(fd);
+            m_socket = -1;
+        }
+        return 0;
+    }
+
+    // Keep the frames of the expected type, packed to the front
+    size_t filled = 0;
+    for (int i = 0; i < received; ++i) {
+        if (messages[i].msg_len < 1 || types[i] != static_cast<uint8_t>(incoming()))
+            continue;
+        size_t size = messages[i].msg_len - 1;
+        if (filled != static_cast<size_t>(i))
+            std::memmove(slots[filled].data, slots[i].data, std::min(size, slots[filled].capacity));
+        slots[filled].size = std::min(size, slots[filled].capacity);
+        ++filled;
+    }
+    return filled;
+}
+
+int UnixSocketCommunicator::nativeHandle() const { return m_socket; }
+
+bool UnixSocketCommunicator::isOpen() const { return m_socket >= 0; }
+
+void UnixSocketCommunicator::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int fd = m_socket.exchange(-1);
+    if (fd >= 0)
+        ::close(fd);
+    if (m_serverFd >= 0) {
+        ::close(m_serverFd);
+        m_serverFd = -1;
+        ::unlink(m_path.c_str());
+    }
+}
+
+LocalProtocol::MessageType UnixSocketCommunicator::outgoing() const
+{
+    return m_mode == NetworkMode::Client ? LocalProtocol::MessageType::Packet : LocalProtocol::MessageType::Reply;
+}
+
+LocalProtocol::MessageType UnixSocketCommunicator::incoming() const
+{
+    return m_mode == NetworkMode::Client ? LocalProtocol::MessageType::Reply : LocalProtocol::MessageType::Packet;
+}
+
+}
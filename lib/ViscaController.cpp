@@ -1,9 +1,19 @@
 #include "ViscaController.h"
 #include "Logger.h"
+#include "Tracing.h"
 #include <chrono>
 
 namespace Visca {
 
+namespace {
+    int64_t steadyNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+}
+
 ViscaController::ViscaController(std::unique_ptr<ICommunicator> communicator)
     : m_communicator(std::move(communicator))
 {
@@ -18,8 +28,16 @@ bool ViscaController::connect()
         return false;
     }
 
+    m_partialFrame.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_asyncMutex);
+        m_asyncAwaiting = 0;
+        m_asyncSockets = 0;
+        m_asyncCancels = 0;
+    }
     m_running = true;
     m_receiveThread = std::thread(&ViscaController::receiveThread, this);
+    recordConnected(true);
 
     VISCALOG_INFO("Connected to camera");
     return true;
@@ -27,27 +45,34 @@ bool ViscaController::connect()
 
 void ViscaController::disconnect()
 {
-    m_running = false;
+    {
+        std::lock_guard<std::mutex> lock(m_responseMutex);
+        m_running = false;
+    }
+    m_responseCond.notify_all();
     if (m_receiveThread.joinable())
         m_receiveThread.join();
 
     if (m_communicator)
         m_communicator->close();
+    recordConnected(false);
 
     VISCALOG_INFO("Disconnected from camera");
 }
 
 bool ViscaController::isConnected() const { return m_communicator && m_communicator->isOpen(); }
 
-bool ViscaController::sendRaw(const std::vector<uint8_t>& data)
+bool ViscaController::sendRaw(Span<const uint8_t> data)
 {
     std::lock_guard<std::mutex> lock(m_sendMutex);
 
-    VISCALOG_DEBUG("Sending: " << std::hex);
-    for (auto byte : data)
-        VISCALOG_DEBUG(" " << std::hex << static_cast<int>(byte));
+    VISCALOG_DEBUG_HEX("Sending: ", data.data(), data.size());
 
-    return m_communicator->send(data);
+    m_flightRecorder.record(CaptureDirection::Sent, data);
+    if (!m_communicator->send(data))
+        return false;
+    m_metrics.recordSent(data.size());
+    return true;
 }
 
 bool ViscaController::execute(const Command& cmd)
@@ -63,21 +88,69 @@ bool ViscaController::execute(const Command& cmd, Response& response)
         return false;
     }
 
-    if (!sendRaw(cmd.packet()))
+    // Replies still owed to pollResponse() would be taken for ours or discarded below
+    if (asyncOutstanding()) {
+        VISCALOG_ERROR("Asynchronous commands await their replies, poll them before execute()");
         return false;
+    }
 
-    // Wait for acknowledge
-    if (!waitForAck(m_timeoutMs)) {
-        VISCALOG_ERROR("No acknowledge received");
+    // Replies left over from an earlier command that timed out would be taken for ours
+    std::vector<uint8_t> stale;
+    while (m_receiveBuffer.pop(stale)) {
+        VISCALOG_DEBUG("Discarding stale reply of " << stale.size() << " bytes");
+        m_metrics.recordStaleReply();
+    }
+
+    CommandCategory category = commandCategory(cmd);
+    uint64_t traceId = VISCA_TRACE_ID();
+    VISCA_TRACE(TraceEvent::CommandEnqueued, traceId, cmd.size());
+    auto sentAt = std::chrono::steady_clock::now();
+    if (!sendRaw(cmd.packet())) {
+        VISCA_TRACE(TraceEvent::CommandFailed, traceId, 0);
+        recordOutcome(cmd, response, Outcome::LinkError);
         return false;
     }
 
+    // Wait for acknowledge, inquiries are answered directly
+    uint8_t socket = 0;
+    auto ackedAt = sentAt;
+    if (!cmd.isInquiry()) {
+        if (!waitForAck(m_timeoutMs, response)) {
+            VISCALOG_ERROR("No acknowledge received");
+            VISCA_TRACE(TraceEvent::TimeoutFired, traceId, 0);
+            recordOutcome(cmd, response, Outcome::Timeout);
+            return false;
+        }
+        if (response.isError()) {
+            VISCALOG_ERROR("Command rejected: " << response.errorString());
+            VISCA_TRACE(TraceEvent::CommandFailed, traceId, response.errorCode());
+            recordOutcome(cmd, response, Outcome::Rejected);
+            return false;
+        }
+        ackedAt = std::chrono::steady_clock::now();
+        m_metrics.recordAck(category, ackedAt - sentAt);
+        socket = response.socketNumber();
+        VISCA_TRACE(TraceEvent::AckMatched, traceId, socket);
+    }
+
     // Wait for completion
-    if (!waitForCompletion(m_timeoutMs, response)) {
+    if (!waitForCompletion(m_timeoutMs, response, socket)) {
         VISCALOG_ERROR("No completion received");
+        VISCA_TRACE(TraceEvent::TimeoutFired, traceId, 0);
+        recordOutcome(cmd, response, Outcome::Timeout);
         return false;
     }
 
+    VISCA_TRACE(response.isError() ? TraceEvent::CommandFailed : TraceEvent::CompletionMatched, traceId,
+        response.isError() ? response.errorCode() : socket);
+
+    // The reply of an inquiry takes the place of the ACK
+    if (cmd.isInquiry())
+        m_metrics.recordAck(category, std::chrono::steady_clock::now() - sentAt);
+    else
+        m_metrics.recordCompletion(category, std::chrono::steady_clock::now() - ackedAt);
+
+    recordOutcome(cmd, response, response.isError() ? Outcome::Rejected : Outcome::Completed);
     return !response.isError();
 }
 
@@ -88,67 +161,171 @@ bool ViscaController::sendAsync(const Command& cmd)
         return false;
     }
 
-    return sendRaw(cmd.packet());
+    VISCA_TRACE(TraceEvent::CommandEnqueued, 0, cmd.size());
+    // Counted first, the reply may be polled before sendRaw() returns
+    noteAsyncSent(cmd.packet());
+    if (sendRaw(cmd.packet()))
+        return true;
+    noteAsyncSent(cmd.packet(), true);
+    return false;
+}
+
+bool ViscaController::sendAsync(Span<const Command> commands)
+{
+    if (!isConnected()) {
+        VISCALOG_ERROR("Not connected");
+        return false;
+    }
+
+    std::vector<Span<const uint8_t>> packets;
+    packets.reserve(commands.size());
+    for (const auto& cmd : commands) {
+        VISCA_TRACE(TraceEvent::CommandEnqueued, 0, cmd.size());
+        packets.emplace_back(cmd.packet());
+    }
+
+    for (const auto& packet : packets)
+        noteAsyncSent(packet);
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    VISCALOG_DEBUG("Sending batch of " << packets.size() << " commands");
+    for (const auto& packet : packets)
+        m_flightRecorder.record(CaptureDirection::Sent, packet);
+    if (!m_communicator->sendv(packets)) {
+        for (const auto& packet : packets)
+            noteAsyncSent(packet, true);
+        return false;
+    }
+    for (const auto& packet : packets)
+        m_metrics.recordSent(packet.size());
+    return true;
 }
 
 bool ViscaController::pollResponse(Response& response, int timeoutMs)
 {
-    auto startTime = std::chrono::steady_clock::now();
+    if (!nextResponse(response, timeoutMs))
+        return false;
+    noteAsyncReply(response);
+    return true;
+}
+
+void ViscaController::noteAsyncSent(Span<const uint8_t> packet, bool takeBack)
+{
+    if (packet.size() < 3)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    if (packet[0] == 0x88) {
+        // Broadcasts are answered by the daisy chain, not with ACK, completion or error: nothing to owe
+    } else if ((packet[1] & 0xF0) == 0x20) {
+        auto bit = static_cast<uint16_t>(1u << (packet[1] & 0x0F));
+        if (takeBack)
+            m_asyncCancels &= static_cast<uint16_t>(~bit);
+        else
+            m_asyncCancels |= bit;
+    } else if (!takeBack) {
+        ++m_asyncAwaiting;
+    } else if (m_asyncAwaiting > 0) {
+        --m_asyncAwaiting;
+    }
+    m_asyncActivity = std::chrono::steady_clock::now();
+}
+
+void ViscaController::noteAsyncReply(const Response& response)
+{
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    uint8_t socket = response.socketNumber();
+    auto bit = static_cast<uint16_t>(1u << (socket & 0x0F));
+    if (response.isAcknowledge()) {
+        if (m_asyncAwaiting > 0)
+            --m_asyncAwaiting;
+        m_asyncSockets |= bit;
+    } else if (response.isError() && (m_asyncCancels & bit)
+        && (response.errorCode() == 0x04 || response.errorCode() == 0x05)) {
+        // The only reply to a cancel: "cancelled" also ends the command it cancelled, "no socket" ends nothing
+        m_asyncCancels &= static_cast<uint16_t>(~bit);
+        if (response.errorCode() == 0x04)
+            m_asyncSockets &= static_cast<uint16_t>(~bit);
+    } else if (response.isCompletion() || response.isError()) {
+        // Ends a running command, or is the first and only reply: an inquiry's, or an error before a socket
+        if (socket != 0 && (m_asyncSockets & bit))
+            m_asyncSockets &= static_cast<uint16_t>(~bit);
+        else if (m_asyncAwaiting > 0)
+            --m_asyncAwaiting;
+    }
+    m_asyncActivity = std::chrono::steady_clock::now();
+}
+
+bool ViscaController::asyncOutstanding()
+{
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    bool owed = m_asyncAwaiting > 0 || m_asyncSockets != 0 || m_asyncCancels != 0;
+    if (owed && std::chrono::steady_clock::now() - m_asyncActivity >= AsyncReplyWindow) {
+        VISCALOG_WARN(
+            "No replies for " << AsyncReplyWindow.count() << " s, taking those of asynchronous commands as lost");
+        m_asyncAwaiting = 0;
+        m_asyncSockets = 0;
+        m_asyncCancels = 0;
+        owed = false;
+    }
+    return owed;
+}
+
+bool ViscaController::nextResponse(Response& response, int timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
 
     while (m_running) {
         std::vector<uint8_t> data;
         if (m_receiveBuffer.pop(data)) {
             if (response.parse(data))
                 return true;
+            continue;
         }
 
-        if (timeoutMs >= 0) {
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime);
-            if (elapsed.count() >= timeoutMs)
-                break;
-        }
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::unique_lock<std::mutex> lock(m_responseMutex);
+        auto ready = [this] { return !m_receiveBuffer.empty() || !m_running; };
+        if (timeoutMs < 0)
+            m_responseCond.wait(lock, ready);
+        else if (!m_responseCond.wait_until(lock, deadline, ready))
+            break;
     }
 
     return false;
 }
 
-bool ViscaController::waitForAck(int timeoutMs)
+bool ViscaController::waitForAck(int timeoutMs, Response& response)
 {
-    auto startTime = std::chrono::steady_clock::now();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
 
     while (m_running) {
-        Response response;
-        if (pollResponse(response, 10)) {
-            if (response.isAcknowledge())
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() < 0)
+            break;
+
+        if (nextResponse(response, static_cast<int>(remaining.count()))) {
+            if (response.isAcknowledge() || response.isError())
                 return true;
         }
-
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime);
-        if (elapsed.count() >= timeoutMs)
-            break;
     }
 
     return false;
 }
 
-bool ViscaController::waitForCompletion(int timeoutMs, Response& response)
+bool ViscaController::waitForCompletion(int timeoutMs, Response& response, uint8_t socket)
 {
-    auto startTime = std::chrono::steady_clock::now();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
 
     while (m_running) {
-        if (pollResponse(response, 10)) {
-            if (response.isCompletion() || response.isError())
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() < 0)
+            break;
+
+        if (nextResponse(response, static_cast<int>(remaining.count()))) {
+            // Replies for another socket belong to another command (inquiries use socket 0), duplicated ACKs are
+            // skipped as well
+            if ((response.isCompletion() || response.isError()) && response.socketNumber() == socket)
                 return true;
         }
-
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime);
-        if (elapsed.count() >= timeoutMs)
-            break;
     }
 
     return false;
@@ -156,7 +333,15 @@ bool ViscaController::waitForCompletion(int timeoutMs, Response& response)
 
 void ViscaController::receiveThread()
 {
-    std::vector<uint8_t> buffer(256);
+    constexpr size_t SlotCount = 8;
+    constexpr size_t SlotSize = 256;
+
+    std::vector<uint8_t> storage(SlotCount * SlotSize);
+    FrameSlot slots[SlotCount];
+    for (size_t i = 0; i < SlotCount; ++i) {
+        slots[i].data = storage.data() + i * SlotSize;
+        slots[i].capacity = SlotSize;
+    }
 
     while (m_running) {
         if (!m_communicator || !m_communicator->isOpen()) {
@@ -164,12 +349,27 @@ void ViscaController::receiveThread()
             continue;
         }
 
-        size_t bytesRead = m_communicator->receive(buffer.data(), buffer.size());
-        if (bytesRead > 0) {
-            std::vector<uint8_t> data(buffer.begin(), buffer.begin() + bytesRead);
-            VISCALOG_DEBUG("Received: " << bytesRead << " bytes");
-            m_receiveBuffer.push(std::move(data));
-            m_responseCond.notify_one();
+        size_t filled = m_communicator->receivev(slots);
+        if (filled > 0) {
+            // Reads may hold several frames or part of one, queue complete 0xFF-terminated frames only
+            for (size_t i = 0; i < filled; ++i) {
+                VISCALOG_DEBUG("Received: " << slots[i].size << " bytes");
+                for (size_t j = 0; j < slots[i].size; ++j) {
+                    m_partialFrame.push_back(slots[i].data[j]);
+                    if (slots[i].data[j] == 0xFF || m_partialFrame.size() >= SlotSize) {
+                        VISCA_TRACE(TraceEvent::FrameReassembled, 0, m_partialFrame.size());
+                        m_flightRecorder.record(CaptureDirection::Received, m_partialFrame);
+                        m_metrics.recordReceived(m_partialFrame.size());
+                        if (!m_receiveBuffer.push(std::move(m_partialFrame)))
+                            m_metrics.recordReceiveDrop();
+                        m_partialFrame.clear();
+                    }
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_responseMutex);
+            }
+            m_responseCond.notify_all();
         } else {
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
@@ -218,4 +418,113 @@ ViscaController::VersionInfo ViscaController::getVersionInfo()
     return info;
 }
 
+CameraState ViscaController::state() const
+{
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    return m_state;
+}
+
+bool ViscaController::publishState(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    if (!m_statePublisher.open(name))
+        return false;
+    m_statePublisher.publish(m_state);
+    return true;
+}
+
+ControllerMetrics::Snapshot ViscaController::metrics() const
+{
+    auto snapshot = m_metrics.snapshot();
+    snapshot.receiveQueueDepth = m_receiveBuffer.size();
+    snapshot.receiveQueueCapacity = ReceiveBufferSize - 1; // One slot tells full from empty
+    return snapshot;
+}
+
+void ViscaController::stopPublishingState()
+{
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_statePublisher.close();
+}
+
+void ViscaController::recordOutcome(const Command& cmd, const Response& response, Outcome outcome)
+{
+    int64_t now = steadyNanoseconds();
+    const auto& packet = cmd.packet();
+
+    CommandCategory category = commandCategory(cmd);
+    m_metrics.recordCommand(category);
+    if (outcome == Outcome::Rejected)
+        m_metrics.recordError(category, response.errorCode());
+    else if (outcome == Outcome::Timeout)
+        m_metrics.recordTimeout(category);
+    else if (outcome == Outcome::LinkError)
+        m_metrics.recordLinkError();
+
+    size_t dumpFrames = m_failureDumpFrames.load(std::memory_order_relaxed);
+    // Straight to the logger: the dump was asked for at runtime, a VISCA_LOG_MIN_LEVEL build must not compile it out
+    Logger& logger = Logger::instance();
+    if (outcome != Outcome::Completed && dumpFrames > 0 && logger.isEnabled(LogLevel::Warning))
+        logger.log(LogLevel::Warning, __FILE__, __FUNCTION__, __LINE__,
+            "Last frames on the link:\n" + m_flightRecorder.dump(dumpFrames));
+
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_state.address = m_address;
+    m_state.updatedNs = now;
+    ++m_state.commands;
+    if (outcome == Outcome::Rejected)
+        ++m_state.errors;
+    else if (outcome == Outcome::Timeout)
+        ++m_state.timeouts;
+    else if (outcome == Outcome::LinkError)
+        ++m_state.linkErrors;
+
+    // Camera interface inquiries (8x 09 04 ..) and the commands (8x 01 04 ..) setting what they report
+    if (outcome != Outcome::Completed || packet.size() < 5 || packet[2] != 0x04) {
+        m_statePublisher.publish(m_state);
+        return;
+    }
+
+    uint8_t item = packet[3];
+    if (cmd.isInquiry()) {
+        if (item == 0x47) {
+            m_state.zoomPosition = response.getZoomPosition();
+            m_state.zoomUpdatedNs = now;
+        } else if (item == 0x48) {
+            m_state.focusPosition = response.getFocusPosition();
+            m_state.focusUpdatedNs = now;
+        } else if (item == 0x00) {
+            m_state.power = response.getPowerStatus();
+            m_state.powerUpdatedNs = now;
+        }
+    } else if ((item == 0x47 || item == 0x48) && packet.size() == 9) {
+        uint16_t position = static_cast<uint16_t>((packet[4] & 0x0F) << 12 | (packet[5] & 0x0F) << 8
+            | (packet[6] & 0x0F) << 4 | (packet[7] & 0x0F));
+        if (item == 0x47) {
+            m_state.zoomPosition = position;
+            m_state.zoomUpdatedNs = now;
+        } else {
+            m_state.focusPosition = position;
+            m_state.focusUpdatedNs = now;
+        }
+    } else if (item == 0x00 && (packet[4] == 0x02 || packet[4] == 0x03)) {
+        m_state.power = packet[4];
+        m_state.powerUpdatedNs = now;
+    } else if (item == 0x38 && (packet[4] == 0x02 || packet[4] == 0x03)) {
+        m_state.focusMode = packet[4];
+        m_state.focusModeUpdatedNs = now;
+    }
+
+    m_statePublisher.publish(m_state);
+}
+
+void ViscaController::recordConnected(bool connected)
+{
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_state.address = m_address;
+    m_state.connected = connected ? 1 : 0;
+    m_state.updatedNs = steadyNanoseconds();
+    m_statePublisher.publish(m_state);
+}
+
 }
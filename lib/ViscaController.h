@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Commands.h"
+#include "ControllerMetrics.h"
 #include "Export.h"
+#include "FlightRecorder.h"
 #include "ICommunicator.h"
 #include "RingBuffer.h"
+#include "SharedCameraState.h"
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -35,8 +38,10 @@ public:
     bool execute(const Command& cmd);
     bool execute(const Command& cmd, Response& response);
 
-    // Asynchronous command execution
+    // Asynchronous command execution. The replies of sendAsync() belong to pollResponse(): until they have been
+    // polled (or nothing arrived for AsyncReplyWindow) execute() fails rather than take or discard them
     bool sendAsync(const Command& cmd);
+    bool sendAsync(Span<const Command> commands); // Batched, handed to the communicator in one sendv()
     bool pollResponse(Response& response, int timeoutMs = 0);
 
     // Inquiry helpers
@@ -60,11 +65,53 @@ public:
     };
     VersionInfo getVersionInfo();
 
+    /**
+     * @brief Latest known camera state, kept up to date from execute() and the inquiry helpers.
+     *
+     * Positions, power and focus mode come from inquiry replies and from completed commands setting them, the
+     * counters count every execute(). Replies to sendAsync() are not paired with their commands and change nothing.
+     */
+    CameraState state() const;
+
+    /**
+     * @brief Publish the state into shared memory under name on every change, for CameraStateReader in any local
+     * process.
+     */
+    bool publishState(const std::string& name);
+    void stopPublishingState();
+
+    /**
+     * @brief The last frames sent and received, always recorded.
+     */
+    const FlightRecorder& flightRecorder() const { return m_flightRecorder; }
+
+    /**
+     * @brief Frames of the flight recorder logged as a warning when execute() fails, 0 to log none (default 32).
+     *
+     * The dump bypasses VISCA_LOG_MIN_LEVEL, only the runtime log level can silence it.
+     */
+    void setFailureDumpFrames(size_t frames) { m_failureDumpFrames = frames; }
+
+    /**
+     * @brief Latency histograms and counters of execute() per command category, and the traffic of the link.
+     *
+     * Recording is lock-free and always on; ControllerMetrics::prometheus() renders the snapshot for scraping.
+     */
+    ControllerMetrics::Snapshot metrics() const;
+
 private:
+    enum class Outcome { Completed, Rejected, Timeout, LinkError };
+
+    void recordOutcome(const Command& cmd, const Response& response, Outcome outcome);
+    void recordConnected(bool connected);
     void receiveThread();
-    bool waitForAck(int timeoutMs);
-    bool waitForCompletion(int timeoutMs, Response& response);
-    bool sendRaw(const std::vector<uint8_t>& data);
+    bool nextResponse(Response& response, int timeoutMs);
+    void noteAsyncSent(Span<const uint8_t> packet, bool takeBack = false); ///< takeBack: the packet did not go out
+    void noteAsyncReply(const Response& response);
+    bool asyncOutstanding();
+    bool waitForAck(int timeoutMs, Response& response);
+    bool waitForCompletion(int timeoutMs, Response& response, uint8_t socket);
+    bool sendRaw(Span<const uint8_t> data);
 
     std::unique_ptr<ICommunicator> m_communicator;
     uint8_t m_address { 1 };
@@ -72,12 +119,30 @@ private:
 
     std::atomic<bool> m_running { false };
     std::thread m_receiveThread;
-    RingBuffer<std::vector<uint8_t>, 64> m_receiveBuffer;
+    static constexpr size_t ReceiveBufferSize = 64;
+    RingBuffer<std::vector<uint8_t>, ReceiveBufferSize> m_receiveBuffer;
+    std::vector<uint8_t> m_partialFrame; // Receive thread only
+
+    FlightRecorder m_flightRecorder;
+    std::atomic<size_t> m_failureDumpFrames { 32 };
+    ControllerMetrics m_metrics;
 
     mutable std::mutex m_sendMutex;
+    std::mutex m_responseMutex;
     std::condition_variable m_responseCond;
     std::vector<uint8_t> m_pendingResponse;
     std::atomic<bool> m_responseAvailable { false };
+
+    static constexpr std::chrono::seconds AsyncReplyWindow { 10 }; ///< Owed replies are taken as lost after this
+    std::mutex m_asyncMutex; ///< Guards the bookkeeping of asynchronous commands below
+    size_t m_asyncAwaiting { 0 }; ///< Sent commands and inquiries without their ACK, inquiry reply or error yet
+    uint16_t m_asyncSockets { 0 }; ///< Bit per camera socket running an asynchronous command
+    uint16_t m_asyncCancels { 0 }; ///< Bit per camera socket with a cancel awaiting its single error reply
+    std::chrono::steady_clock::time_point m_asyncActivity {}; ///< Last asynchronous send or reply
+
+    mutable std::mutex m_stateMutex;
+    CameraState m_state;
+    CameraStatePublisher m_statePublisher; ///< Guarded by m_stateMutex
 };
 
 }
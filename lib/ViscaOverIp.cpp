@@ -0,0 +1,57 @@
+#include "ViscaOverIp.h"
+
+namespace Visca {
+
+std::vector<uint8_t> ViscaOverIp::encode(PayloadType type, uint32_t sequence, const uint8_t* payload, size_t size)
+{
+    std::vector<uint8_t> datagram;
+    datagram.reserve(HeaderSize + size);
+
+    uint16_t rawType = static_cast<uint16_t>(type);
+    datagram.push_back(static_cast<uint8_t>(rawType >> 8));
+    datagram.push_back(static_cast<uint8_t>(rawType & 0xFF));
+    datagram.push_back(static_cast<uint8_t>((size >> 8) & 0xFF));
+    datagram.push_back(static_cast<uint8_t>(size & 0xFF));
+    datagram.push_back(static_cast<uint8_t>(sequence >> 24));
+    datagram.push_back(static_cast<uint8_t>((sequence >> 16) & 0xFF));
+    datagram.push_back(static_cast<uint8_t>((sequence >> 8) & 0xFF));
+    datagram.push_back(static_cast<uint8_t>(sequence & 0xFF));
+
+    datagram.insert(datagram.end(), payload, payload + size);
+    return datagram;
+}
+
+bool ViscaOverIp::decode(const uint8_t* data, size_t size, Header& header)
+{
+    if (!data || size < HeaderSize)
+        return false;
+
+    uint16_t rawType = static_cast<uint16_t>((data[0] << 8) | data[1]);
+    switch (static_cast<PayloadType>(rawType)) {
+    case PayloadType::Command:
+    case PayloadType::Inquiry:
+    case PayloadType::Reply:
+    case PayloadType::DeviceSetting:
+    case PayloadType::ControlCommand:
+    case PayloadType::ControlReply:
+        break;
+    default:
+        return false;
+    }
+
+    header.type = static_cast<PayloadType>(rawType);
+    header.length = static_cast<uint16_t>((data[2] << 8) | data[3]);
+    header.sequence = (static_cast<uint32_t>(data[4]) << 24) | (static_cast<uint32_t>(data[5]) << 16)
+        | (static_cast<uint32_t>(data[6]) << 8) | data[7];
+
+    return size >= HeaderSize + header.length;
+}
+
+ViscaOverIp::PayloadType ViscaOverIp::payloadTypeFor(const uint8_t* packet, size_t size)
+{
+    if (packet && size >= 2 && packet[1] == 0x09)
+        return PayloadType::Inquiry;
+    return PayloadType::Command;
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Export.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Visca {
+
+/**
+ * @brief Helpers for the Sony VISCA-over-IP framing.
+ *
+ * Every VISCA-over-IP datagram carries an 8 byte big-endian header (payload type, payload length and sequence number)
+ * in front of a regular VISCA packet.
+ */
+class VISCA_EXPORT ViscaOverIp {
+public:
+    static constexpr size_t HeaderSize = 8;
+    static constexpr uint16_t DefaultPort = 52381;
+    static constexpr uint16_t NetworkSettingPort = 52380;
+
+    enum class PayloadType : uint16_t {
+        Command = 0x0100,
+        Inquiry = 0x0110,
+        Reply = 0x0111,
+        DeviceSetting = 0x0120,
+        ControlCommand = 0x0200,
+        ControlReply = 0x0201
+    };
+
+    struct Header {
+        PayloadType type { PayloadType::Command };
+        uint16_t length { 0 };
+        uint32_t sequence { 0 };
+    };
+
+    /**
+     * @brief Wrap a VISCA packet into a VISCA-over-IP datagram.
+     * @param type The payload type.
+     * @param sequence The sequence number.
+     * @param payload Pointer to the VISCA packet.
+     * @param size Size of the VISCA packet.
+     * @return The datagram including the header.
+     */
+    static std::vector<uint8_t> encode(PayloadType type, uint32_t sequence, const uint8_t* payload, size_t size);
+
+    /**
+     * @brief Parse the header of a VISCA-over-IP datagram.
+     * @param data Pointer to the datagram.
+     * @param size Size of the datagram.
+     * @param header The parsed header.
+     * @return true if the datagram has a valid header and the whole payload is present.
+     */
+    static bool decode(const uint8_t* data, size_t size, Header& header);
+
+    /**
+     * @brief Select the payload type for a VISCA packet (command or inquiry) from its second byte.
+     */
+    static PayloadType payloadTypeFor(const uint8_t* packet, size_t size);
+};
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Export.h"
+#include "Span.h"
+#include <cstdint>
+
+namespace Visca {
+/**
+ * @brief Write all packets to a stream descriptor with as few writev() calls as possible.
+ *
+ * Resumes after partial writes and interrupted calls. A non-blocking descriptor that is full is waited on until it
+ * is writable again. Shared by the stream communicators' sendv().
+ * @return false if a write failed; some of the packets may have been written.
+ */
+VISCA_EXPORT bool writevAll(int fd, Span<const Span<const uint8_t>> packets);
+}
@@ -0,0 +1,53 @@
+#include "WriteAll.h"
+#include "Tracing.h"
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace Visca {
+bool writevAll(int fd, Span<const Span<const uint8_t>> packets)
+{
+    constexpr size_t MaxIov = 64;
+    struct iovec iov[MaxIov];
+    size_t index = 0;
+    size_t offset = 0;
+
+    while (index < packets.size()) {
+        int count = 0;
+        for (size_t i = index; i < packets.size() && count < static_cast<int>(MaxIov); ++i) {
+            size_t skip = (i == index) ? offset : 0;
+            iov[count].iov_base = const_cast<uint8_t*>(packets[i].data() + skip);
+            iov[count].iov_len = packets[i].size() - skip;
+            ++count;
+        }
+
+        ssize_t written = ::writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd = { fd, POLLOUT, 0 };
+                if (::poll(&pfd, 1, -1) >= 0 || errno == EINTR)
+                    continue;
+            }
+            return false;
+        }
+        VISCA_TRACE(TraceEvent::BytesWritten, fd, written);
+
+        size_t remaining = static_cast<size_t>(written);
+        while (index < packets.size()) {
+            size_t left = packets[index].size() - offset;
+            if (remaining < left) {
+                offset += remaining;
+                break;
+            }
+            remaining -= left;
+            ++index;
+            offset = 0;
+        }
+    }
+    return true;
+}
+}
@@ -0,0 +1,134 @@
+#include "BaudDetector.h"
+#include "SerialCommunicator.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace Visca;
+
+namespace {
+
+/**
+ * @brief Camera on the master side of a pty. It only understands the line when the port is set to its baud rate,
+ * otherwise it answers with noise, like a UART sampling at the wrong rate.
+ */
+class PtyCamera {
+public:
+    PtyCamera(speed_t speed, bool silent = false)
+        : m_speed(speed)
+        , m_silent(silent)
+    {
+        m_master = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (m_master >= 0 && ::grantpt(m_master) == 0 && ::unlockpt(m_master) == 0 && ::ptsname(m_master))
+            m_slave = ::ptsname(m_master);
+        m_thread = std::thread([this] { run(); });
+    }
+
+    ~PtyCamera()
+    {
+        m_running = false;
+        m_thread.join();
+        if (m_master >= 0)
+            ::close(m_master);
+    }
+
+    const std::string& slave() const { return m_slave; }
+
+private:
+    void run()
+    {
+        uint8_t buffer[64];
+        while (m_running) {
+            struct pollfd pfd = { m_master, POLLIN, 0 };
+            if (::poll(&pfd, 1, 10) <= 0)
+                continue;
+            ssize_t received = ::read(m_master, buffer, sizeof(buffer));
+            if (received <= 0 || buffer[received - 1] != 0xFF || m_silent)
+                continue;
+
+            struct termios tty;
+            ::tcgetattr(m_master, &tty);
+            if (::cfgetispeed(&tty) == m_speed) {
+                const uint8_t version[] = { 0x90, 0x50, 0x00, 0x20, 0x04, 0x67, 0x01, 0x00, 0x02, 0xFF };
+                ::write(m_master, version, sizeof(version));
+            } else {
+                const uint8_t noise[] = { 0xE0, 0x00, 0xFF, 0x78, 0x80, 0xFE };
+                ::write(m_master, noise, sizeof(noise));
+            }
+        }
+    }
+
+    speed_t m_speed;
+    bool m_silent;
+    int m_master { -1 };
+    std::string m_slave;
+    std::atomic<bool> m_running { true };
+    std::thread m_thread;
+};
+}
+
+TEST(BaudDetectorTest, AcceptsOnlyWellFormedReplies)
+{
+    const uint8_t version[] = { 0x90, 0x50, 0x00, 0x20, 0x04, 0x67, 0x01, 0x00, 0x02, 0xFF };
+    const uint8_t syntaxError[] = { 0x90, 0x60, 0x02, 0xFF };
+    const uint8_t otherCamera[] = { 0xA0, 0x50, 0x00, 0xFF };
+    const uint8_t noise[] = { 0xE0, 0x00, 0xFF };
+    const uint8_t twoFrames[] = { 0x90, 0xFF, 0x41, 0xFF };
+
+    EXPECT_TRUE(BaudDetector::isReply(version, sizeof(version), 1));
+    EXPECT_TRUE(BaudDetector::isReply(syntaxError, sizeof(syntaxError), 1));
+    EXPECT_FALSE(BaudDetector::isReply(otherCamera, sizeof(otherCamera), 1));
+    EXPECT_TRUE(BaudDetector::isReply(otherCamera, sizeof(otherCamera), 2));
+    EXPECT_FALSE(BaudDetector::isReply(noise, sizeof(noise), 1));
+    EXPECT_FALSE(BaudDetector::isReply(twoFrames, sizeof(twoFrames), 1));
+}
+
+TEST(BaudDetectorTest, ProbeTimeoutFollowsWireTime)
+{
+    BaudDetector detector;
+
+    // Inquiry and reply are 15 bytes, 15.6 ms at 9600 baud
+    EXPECT_EQ(detector.probeTimeoutMs(9600), 16 + 30);
+    EXPECT_EQ(detector.probeTimeoutMs(115200), 2 + 30);
+}
+
+TEST(BaudDetectorTest, FindsCameraAtItsRate)
+{
+    PtyCamera camera(B38400);
+    ASSERT_FALSE(camera.slave().empty());
+    SerialCommunicator port(camera.slave(), 9600);
+    ASSERT_TRUE(port.open());
+
+    BaudDetector detector;
+    auto result = detector.run(port);
+    ASSERT_TRUE(result.found);
+    EXPECT_EQ(result.baudRate, 38400u);
+    EXPECT_EQ(port.baudRate(), 38400u);
+    EXPECT_EQ(result.probes, 2u);
+    EXPECT_TRUE(result.versionReply);
+    EXPECT_EQ(result.vendorId, 0x0020);
+    EXPECT_EQ(result.modelId, 0x0467);
+    EXPECT_LT(result.elapsed.count(), 1000);
+}
+
+TEST(BaudDetectorTest, GivesUpQuicklyWithoutCamera)
+{
+    PtyCamera camera(B9600, true);
+    ASSERT_FALSE(camera.slave().empty());
+    SerialCommunicator port(camera.slave(), 19200);
+    ASSERT_TRUE(port.open());
+
+    BaudDetector detector;
+    auto result = detector.run(port);
+    EXPECT_FALSE(result.found);
+    EXPECT_EQ(result.probes, detector.options().baudRates.size());
+    EXPECT_EQ(port.baudRate(), 19200u) << "the original rate is restored";
+    EXPECT_LT(result.elapsed.count(), 1000);
+}
@@ -0,0 +1,180 @@
+#include "BinaryLog.h"
+#include "Logger.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+std::string logPath(const char* name) { return testing::TempDir() + name + ".vlog"; }
+
+std::vector<BinaryLogEntry> readLog(const std::string& path)
+{
+    std::vector<BinaryLogEntry> entries;
+    BinaryLogReader reader;
+    if (!reader.open(path))
+        return entries;
+    BinaryLogEntry entry;
+    while (reader.next(entry))
+        entries.push_back(entry);
+    return entries;
+}
+
+// One call site, logged once in each format; ERROR is never compiled out
+void logSample(int position)
+{
+    static const uint8_t packet[] = { 0x81, 0x01, 0xFF };
+    static int target = 0;
+    VISCALOG_ERROR("zoom " << position << " of " << 0x4000u << ", speed " << 2.5 << ' ' << std::hex << 255 << std::dec
+                          << " " << true << " " << std::string("camera") << " [" << LogHex(packet, sizeof(packet))
+                          << "] " << -7L << " " << static_cast<const void*>(&target));
+}
+
+class BinaryLogTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        Logger::instance().setLevel(LogLevel::Info);
+        Logger::instance().enableLocationInfo(false);
+    }
+
+    void TearDown() override
+    {
+        Logger::instance().closeFile();
+        Logger::instance().setOutput(&std::cout);
+        Logger::instance().enableLocationInfo(true);
+        Logger::instance().setLevel(LogLevel::Warning);
+    }
+
+    static std::string messageOf(const std::string& line)
+    {
+        const std::string level = "[ERROR] ";
+        size_t at = line.find(level);
+        return at == std::string::npos ? line : line.substr(at + level.size());
+    }
+};
+}
+
+TEST_F(BinaryLogTest, DecodesToTheTextLoggerMessage)
+{
+    std::ostringstream text;
+    Logger::instance().setOutput(&text);
+    logSample(1234);
+    std::string expected = messageOf(text.str());
+    ASSERT_FALSE(expected.empty());
+    expected.pop_back(); // Newline
+
+    std::string path = logPath("BinaryLogTest_Decodes");
+    ASSERT_TRUE(Logger::instance().setOutputFile(path, false, LogFormat::Binary));
+    EXPECT_TRUE(Logger::instance().isBinary());
+    logSample(1234);
+    logSample(1234);
+    Logger::instance().closeFile();
+    EXPECT_FALSE(Logger::instance().isBinary());
+
+    auto entries = readLog(path);
+    ASSERT_EQ(entries.size(), 2u);
+    for (const auto& entry : entries) {
+        EXPECT_EQ(entry.level, LogLevel::Error);
+        EXPECT_EQ(entry.message, expected);
+        EXPECT_EQ(entry.function, "logSample");
+        EXPECT_NE(entry.file.find("BinaryLogTest.cpp"), std::string::npos);
+        EXPECT_EQ(messageOf(BinaryLogReader::format(entry, false)), expected);
+    }
+    EXPECT_LE(entries[0].timestampNs, entries[1].timestampNs);
+}
+
+TEST_F(BinaryLogTest, FilteredAndDirectMessages)
+{
+    std::string path = logPath("BinaryLogTest_Direct");
+    ASSERT_TRUE(Logger::instance().setOutputFile(path, false, LogFormat::Binary));
+    VISCALOG_DEBUG("filtered");
+    Logger::instance().log(LogLevel::Warning, "dir/Source.cpp", "caller", 42, "formatted %d", 7);
+    Logger::instance().closeFile();
+
+    auto entries = readLog(path);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].level, LogLevel::Warning);
+    EXPECT_EQ(entries[0].file, "dir/Source.cpp");
+    EXPECT_EQ(entries[0].function, "caller");
+    EXPECT_EQ(entries[0].line, 42);
+    EXPECT_EQ(entries[0].message, "formatted 7");
+    EXPECT_NE(BinaryLogReader::format(entries[0]).find("[WARN] [Source.cpp:42 caller] formatted 7"), std::string::npos);
+}
+
+TEST_F(BinaryLogTest, LongArgumentsAreTruncated)
+{
+    std::string path = logPath("BinaryLogTest_Truncated");
+    ASSERT_TRUE(Logger::instance().setOutputFile(path, false, LogFormat::Binary));
+    VISCALOG_ERROR(std::string(300, 'x') << " never stored " << 1);
+    Logger::instance().closeFile();
+
+    auto entries = readLog(path);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].message, std::string(BinaryLogFormat::MaxArgsSize - 3, 'x') + " [truncated]");
+}
+
+TEST_F(BinaryLogTest, ReaderStopsAtZeroFilledTail)
+{
+    // A process that dies leaves the file at its mapped size, zeros after the last record
+    std::string path = logPath("BinaryLogTest_Tail");
+    static const LogSite site(LogLevel::Error, "Crash.cpp", "run", 7);
+    BinaryLogWriter writer;
+    ASSERT_TRUE(writer.open(path));
+    for (int i = 0; i < 3; ++i) {
+        BinaryLogRecord record(site);
+        record << "step " << i;
+        ASSERT_TRUE(writer.push(std::move(record)));
+    }
+    writer.flush();
+
+    auto entries = readLog(path);
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[2].message, "step 2");
+    EXPECT_EQ(entries[2].line, 7);
+    writer.close();
+}
+
+TEST_F(BinaryLogTest, ReportsDroppedMessages)
+{
+    std::string path = logPath("BinaryLogTest_Dropped");
+    static const LogSite site(LogLevel::Info, "Burst.cpp", "burst", 1);
+    BinaryLogWriter::Options options;
+    options.capacity = 4;
+    BinaryLogWriter writer(options);
+    ASSERT_TRUE(writer.open(path));
+    const int pushed = 1000;
+    for (int i = 0; i < pushed; ++i) {
+        BinaryLogRecord record(site);
+        record << i;
+        writer.push(std::move(record));
+    }
+    writer.close();
+
+    // Every message is either in the file or counted in a drop notice
+    uint64_t written = 0;
+    uint64_t dropped = 0;
+    for (const auto& entry : readLog(path)) {
+        if (entry.file.empty())
+            dropped += std::stoull(entry.message.substr(entry.message.find(' ') + 1));
+        else
+            ++written;
+    }
+    EXPECT_EQ(written + dropped, static_cast<uint64_t>(pushed));
+    EXPECT_EQ(dropped, writer.dropped());
+}
+
+TEST_F(BinaryLogTest, RejectsOtherFiles)
+{
+    std::string path = logPath("BinaryLogTest_Other");
+    std::ofstream(path) << "[12:00:00.000] [INFO] a text log\n";
+    BinaryLogReader reader;
+    Logger::instance().enableLogging(false);
+    EXPECT_FALSE(reader.open(path));
+    Logger::instance().enableLogging(true);
+}
@@ -0,0 +1,250 @@
+#include "CameraSimulator.h"
+#include "Commands.h"
+
+#include <gtest/gtest.h>
+
+using namespace Visca;
+using namespace std::chrono_literals;
+
+namespace {
+using Clock = CameraSimulator::Clock;
+using Bytes = std::vector<uint8_t>;
+
+class CameraSimulatorTest : public ::testing::Test {
+protected:
+    CameraSimulatorTest()
+    {
+        config.ackDelay = 1ms;
+        config.commandTime = 5ms;
+        config.zoomFullTravel = 1000ms;
+        config.focusFullTravel = 1000ms;
+        camera = CameraSimulator(config);
+    }
+
+    void send(const Command& command, Clock::time_point at) { camera.process(command.packet().data(), command.size(), at); }
+    void send(const Bytes& packet, Clock::time_point at) { camera.process(packet.data(), packet.size(), at); }
+
+    std::vector<CameraSimulator::Reply> collect(Clock::time_point until)
+    {
+        std::vector<CameraSimulator::Reply> replies;
+        camera.collectReplies(until, replies);
+        return replies;
+    }
+
+    CameraSimulator::Config config;
+    CameraSimulator camera;
+    Clock::time_point t0 { Clock::now() };
+};
+}
+
+TEST_F(CameraSimulatorTest, CommandGetsAckThenCompletion)
+{
+    send(Command::zoomStop(), t0);
+
+    auto replies = collect(t0 + 1s);
+    ASSERT_EQ(replies.size(), 2u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x41, 0xFF }));
+    EXPECT_EQ(replies[0].due, t0 + 1ms);
+    EXPECT_EQ(replies[1].data, (Bytes { 0x90, 0x51, 0xFF }));
+    EXPECT_EQ(replies[1].due, t0 + 6ms);
+}
+
+TEST_F(CameraSimulatorTest, RepliesAreReleasedWhenDue)
+{
+    send(Command::zoomStop(), t0);
+
+    Clock::time_point due;
+    ASSERT_TRUE(camera.nextReplyTime(due));
+    EXPECT_EQ(due, t0 + 1ms);
+
+    EXPECT_TRUE(collect(t0).empty());
+    EXPECT_EQ(collect(t0 + 1ms).size(), 1u);
+    EXPECT_EQ(collect(t0 + 6ms).size(), 1u);
+    EXPECT_FALSE(camera.nextReplyTime(due));
+}
+
+TEST_F(CameraSimulatorTest, InquiryIsAnsweredWithoutAck)
+{
+    send(Command::powerInquiry(), t0);
+
+    auto replies = collect(t0 + 1s);
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x50, 0x02, 0xFF }));
+}
+
+TEST_F(CameraSimulatorTest, VersionInquiry)
+{
+    send(Command::versionInquiry(), t0);
+
+    auto replies = collect(t0 + 1s);
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x50, 0x00, 0x20, 0x07, 0x13, 0x01, 0x00, 0x02, 0xFF }));
+}
+
+TEST_F(CameraSimulatorTest, ThirdCommandFindsBufferFull)
+{
+    send(Command::zoomDirect(1, 0x4000), t0);
+    send(Command::focusManual(), t0);
+    send(Command::zoomStop(), t0);
+
+    auto replies = collect(t0 + 2ms);
+    ASSERT_EQ(replies.size(), 3u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x41, 0xFF }));
+    EXPECT_EQ(replies[1].data, (Bytes { 0x90, 0x42, 0xFF }));
+    EXPECT_EQ(replies[2].data, (Bytes { 0x90, 0x60, 0x03, 0xFF }));
+}
+
+TEST_F(CameraSimulatorTest, DirectZoomCompletesOnArrival)
+{
+    send(Command::zoomDirect(1, 0x2000), t0);
+    collect(t0 + 1ms);
+
+    // Half the range at full speed takes half the full travel time
+    EXPECT_TRUE(collect(t0 + 400ms).empty());
+    auto replies = collect(t0 + 600ms);
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x51, 0xFF }));
+
+    camera.advance(t0 + 600ms);
+    EXPECT_EQ(camera.zoomPosition(), 0x2000);
+    EXPECT_FALSE(camera.isZoomMoving());
+}
+
+TEST_F(CameraSimulatorTest, ContinuousZoomMovesUntilStopped)
+{
+    send(Command::zoomTeleVariable(1, 7), t0);
+    EXPECT_EQ(collect(t0 + 10ms).size(), 2u);
+
+    camera.advance(t0 + 250ms);
+    EXPECT_TRUE(camera.isZoomMoving());
+    EXPECT_NEAR(camera.zoomPosition(), 0x1000, 2);
+
+    send(Command::zoomStop(), t0 + 250ms);
+    camera.advance(t0 + 500ms);
+    EXPECT_FALSE(camera.isZoomMoving());
+    EXPECT_NEAR(camera.zoomPosition(), 0x1000, 2);
+}
+
+TEST_F(CameraSimulatorTest, ContinuousZoomStopsAtLimit)
+{
+    send(Command::zoomTeleVariable(1, 7), t0);
+    camera.advance(t0 + 5s);
+    EXPECT_EQ(camera.zoomPosition(), config.zoomMax);
+    EXPECT_FALSE(camera.isZoomMoving());
+}
+
+TEST_F(CameraSimulatorTest, PositionInquiryFollowsMotor)
+{
+    send(Command::zoomDirect(1, 0x1234), t0);
+    send(Command::zoomPositionInquiry(), t0 + 1s);
+
+    auto replies = collect(t0 + 2s);
+    ASSERT_EQ(replies.size(), 3u);
+    EXPECT_EQ(replies[2].data, (Bytes { 0x90, 0x50, 0x01, 0x02, 0x03, 0x04, 0xFF }));
+}
+
+TEST_F(CameraSimulatorTest, CancelStopsDirectMove)
+{
+    send(Command::zoomDirect(1, 0x4000), t0);
+    send(Bytes { 0x81, 0x21, 0xFF }, t0 + 100ms);
+
+    auto replies = collect(t0 + 2s);
+    ASSERT_EQ(replies.size(), 2u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x41, 0xFF }));
+    EXPECT_EQ(replies[1].data, (Bytes { 0x90, 0x61, 0x04, 0xFF }));
+    EXPECT_FALSE(camera.isZoomMoving());
+    EXPECT_LT(camera.zoomPosition(), 0x4000);
+}
+
+TEST_F(CameraSimulatorTest, CancelOnCopyStopsOnlyTheCopy)
+{
+    send(Command::zoomDirect(1, 0x4000), t0);
+    CameraSimulator copy = camera;
+    copy.process(Bytes { 0x81, 0x21, 0xFF }.data(), 3, t0 + 100ms);
+
+    EXPECT_FALSE(copy.isZoomMoving());
+    EXPECT_TRUE(camera.isZoomMoving());
+}
+
+TEST_F(CameraSimulatorTest, CancelOfIdleSocket)
+{
+    send(Bytes { 0x81, 0x22, 0xFF }, t0);
+
+    auto replies = collect(t0 + 1s);
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x62, 0x05, 0xFF }));
+}
+
+TEST_F(CameraSimulatorTest, ManualFocusNeedsManualMode)
+{
+    send(Command::focusDirect(1, 0x2000), t0);
+    auto replies = collect(t0 + 1s);
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x61, 0x41, 0xFF }));
+
+    send(Command::focusManual(), t0 + 1s);
+    send(Command::focusDirect(1, 0x2000), t0 + 1s);
+    camera.advance(t0 + 3s);
+    EXPECT_FALSE(camera.isAutoFocus());
+    EXPECT_EQ(camera.focusPosition(), 0x2000);
+}
+
+TEST_F(CameraSimulatorTest, PoweredOffCameraOnlyAcceptsPowerOn)
+{
+    send(Command::powerOff(), t0);
+    collect(t0 + 1s);
+    EXPECT_FALSE(camera.isPoweredOn());
+
+    send(Command::zoomTeleStandard(), t0 + 1s);
+    auto replies = collect(t0 + 2s);
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x61, 0x41, 0xFF }));
+
+    send(Command::powerOn(), t0 + 2s);
+    replies = collect(t0 + 2s + config.ackDelay + config.powerTime);
+    ASSERT_EQ(replies.size(), 2u);
+    EXPECT_EQ(replies[1].data, (Bytes { 0x90, 0x51, 0xFF }));
+    EXPECT_TRUE(camera.isPoweredOn());
+}
+
+TEST_F(CameraSimulatorTest, UnknownCommandIsSyntaxError)
+{
+    send(Bytes { 0x81, 0x01, 0x04, 0x7F, 0x00, 0xFF }, t0);
+
+    auto replies = collect(t0 + 1s);
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x60, 0x02, 0xFF }));
+    EXPECT_EQ(camera.errorCount(), 1u);
+}
+
+TEST_F(CameraSimulatorTest, OtherAddressesAreIgnored)
+{
+    send(Command::zoomStop(2), t0);
+    EXPECT_TRUE(collect(t0 + 1s).empty());
+}
+
+TEST_F(CameraSimulatorTest, IfClearBroadcastDropsPendingCompletions)
+{
+    send(Command::zoomDirect(1, 0x4000), t0);
+    send(Bytes { 0x88, 0x01, 0x00, 0x01, 0xFF }, t0 + 10ms);
+
+    auto replies = collect(t0 + 5s);
+    ASSERT_EQ(replies.size(), 2u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x90, 0x41, 0xFF }));
+    EXPECT_EQ(replies[1].data, (Bytes { 0x88, 0x01, 0x00, 0x01, 0xFF }));
+}
+
+TEST_F(CameraSimulatorTest, AddressSet)
+{
+    send(Bytes { 0x88, 0x30, 0x03, 0xFF }, t0);
+
+    auto replies = collect(t0 + 1s);
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].data, (Bytes { 0x88, 0x30, 0x04, 0xFF }));
+    EXPECT_EQ(camera.address(), 3);
+
+    send(Command::powerInquiry(3), t0 + 1s);
+    replies = collect(t0 + 2s);
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].data[0], 0xB0);
+}
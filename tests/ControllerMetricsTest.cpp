@@ -0,0 +1,189 @@
+#include "ControllerMetrics.h"
+#include "MockCommunicator.h"
+#include "ViscaController.h"
+#if defined(__linux__)
+#include "MetricsEndpoint.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace Visca;
+
+TEST(ControllerMetricsTest, HistogramBucketsStayWithinAFewPercent)
+{
+    for (uint64_t value : { 0ull, 1ull, 15ull, 16ull, 17ull, 1000ull, 123456ull, 987654321ull, 1ull << 39 }) {
+        size_t index = HdrHistogram::bucketIndex(value);
+        ASSERT_LT(index, HdrHistogram::Buckets);
+        uint64_t upper = HdrHistogram::bucketUpperBound(index);
+        EXPECT_GE(upper, value);
+        EXPECT_LE(upper - value, value / 16 + 1) << value;
+        if (index > 0) {
+            EXPECT_LT(HdrHistogram::bucketUpperBound(index - 1), value);
+        }
+    }
+    EXPECT_EQ(HdrHistogram::bucketIndex(~uint64_t(0)), HdrHistogram::Buckets - 1);
+
+    HdrHistogram histogram;
+    for (uint64_t us = 1; us <= 1000; ++us)
+        histogram.record(std::chrono::microseconds(us));
+    histogram.record(std::chrono::nanoseconds(-5)); // Counts as 0
+
+    auto snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 1001u);
+    EXPECT_EQ(snapshot.maxNs, 1000000u);
+    EXPECT_NEAR(static_cast<double>(snapshot.percentileNs(0.5)), 500000.0, 500000.0 / 16);
+    EXPECT_NEAR(static_cast<double>(snapshot.percentileNs(0.99)), 990000.0, 990000.0 / 16);
+    EXPECT_EQ(snapshot.percentileNs(1.0), 1000000u);
+    EXPECT_EQ(snapshot.countAtOrBelow(2000000), 1001u);
+    EXPECT_GE(snapshot.countAtOrBelow(1000000), 1001u - 1000u / 16); // Values sharing a bucket with 1 ms are left out
+    EXPECT_EQ(snapshot.countAtOrBelow(0), 1u);
+}
+
+TEST(ControllerMetricsTest, ConcurrentRecordingLosesNothing)
+{
+    ControllerMetrics metrics;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&metrics, t] {
+            for (int i = 0; i < 10000; ++i) {
+                metrics.recordCommand(CommandCategory::Zoom);
+                metrics.recordAck(CommandCategory::Zoom, std::chrono::microseconds(100 + t));
+                metrics.recordSent(6);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    auto snapshot = metrics.snapshot();
+    const auto& zoom = snapshot.categories[static_cast<size_t>(CommandCategory::Zoom)];
+    EXPECT_EQ(zoom.commands, 40000u);
+    EXPECT_EQ(zoom.ack.count, 40000u);
+    EXPECT_EQ(zoom.ack.maxNs, 103000u);
+    EXPECT_EQ(snapshot.framesOut, 40000u);
+    EXPECT_EQ(snapshot.bytesOut, 240000u);
+}
+
+TEST(ControllerMetricsTest, CommandCategories)
+{
+    EXPECT_EQ(commandCategory(Command::powerOn()), CommandCategory::Power);
+    EXPECT_EQ(commandCategory(Command::zoomDirect(1, 0x1000)), CommandCategory::Zoom);
+    EXPECT_EQ(commandCategory(Command::zoomTeleStandard()), CommandCategory::Zoom);
+    EXPECT_EQ(commandCategory(Command::focusOnePushTrigger()), CommandCategory::Focus);
+    EXPECT_EQ(commandCategory(Command::focusAuto()), CommandCategory::Focus);
+    EXPECT_EQ(commandCategory(Command::zoomPositionInquiry()), CommandCategory::Inquiry);
+}
+
+TEST(ControllerMetricsTest, ControllerRecordsLatenciesAndErrors)
+{
+    MockCommunicator::Config config;
+    config.camera.ackDelay = std::chrono::milliseconds(2);
+    config.camera.commandTime = std::chrono::milliseconds(5);
+    ViscaController camera(std::make_unique<MockCommunicator>(config));
+    camera.setFailureDumpFrames(0);
+    ASSERT_TRUE(camera.connect());
+
+    EXPECT_TRUE(camera.execute(Command::zoomDirect(1, 0x1000)));
+    EXPECT_NE(camera.getZoomPosition(), 0xFFFF);
+    EXPECT_TRUE(camera.execute(Command::powerOff()));
+    EXPECT_FALSE(camera.execute(Command::zoomTeleStandard())); // Powered off: command not executable
+    camera.disconnect();
+
+    auto snapshot = camera.metrics();
+    const auto& zoom = snapshot.categories[static_cast<size_t>(CommandCategory::Zoom)];
+    const auto& inquiry = snapshot.categories[static_cast<size_t>(CommandCategory::Inquiry)];
+    EXPECT_EQ(zoom.commands, 2u);
+    EXPECT_EQ(zoom.errors, 1u);
+    EXPECT_EQ(zoom.ack.count, 1u);
+    EXPECT_GE(zoom.ack.maxNs, 2000000u);
+    EXPECT_EQ(zoom.completion.count, 1u);
+    EXPECT_GE(zoom.completion.maxNs, 4000000u);
+    EXPECT_EQ(inquiry.commands, 1u);
+    EXPECT_EQ(inquiry.ack.count, 1u);
+    EXPECT_EQ(inquiry.completion.count, 0u);
+    EXPECT_EQ(snapshot.errorsByCode.at(0x41), 1u);
+    EXPECT_EQ(snapshot.framesOut, 4u);
+    EXPECT_EQ(snapshot.framesIn, 6u);
+    EXPECT_GT(snapshot.bytesIn, snapshot.framesIn * 2);
+    EXPECT_EQ(snapshot.receiveQueueCapacity, 63u);
+}
+
+TEST(ControllerMetricsTest, PrometheusText)
+{
+    ControllerMetrics metrics;
+    metrics.recordCommand(CommandCategory::Focus);
+    metrics.recordAck(CommandCategory::Focus, std::chrono::microseconds(300));
+    metrics.recordCompletion(CommandCategory::Focus, std::chrono::milliseconds(40));
+    metrics.recordError(CommandCategory::Focus, 0x41);
+    metrics.recordTimeout(CommandCategory::PanTilt);
+
+    auto snapshot = metrics.snapshot();
+    snapshot.receiveQueueDepth = 3;
+    std::string text = ControllerMetrics::prometheus(snapshot, "camera=\"studio-1\"");
+
+    EXPECT_NE(text.find("# TYPE visca_command_ack_seconds histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("visca_commands_total{camera=\"studio-1\",category=\"focus\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("visca_command_timeouts_total{camera=\"studio-1\",category=\"pan_tilt\"} 1\n"),
+        std::string::npos);
+    EXPECT_NE(text.find("visca_errors_by_code_total{camera=\"studio-1\",code=\"0x41\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("visca_command_ack_seconds_bucket{camera=\"studio-1\",category=\"focus\",le=\"0.00025\"} 0\n"),
+        std::string::npos);
+    EXPECT_NE(text.find("visca_command_ack_seconds_bucket{camera=\"studio-1\",category=\"focus\",le=\"0.0005\"} 1\n"),
+        std::string::npos);
+    EXPECT_NE(
+        text.find("visca_command_completion_seconds_bucket{camera=\"studio-1\",category=\"focus\",le=\"+Inf\"} 1\n"),
+        std::string::npos);
+    EXPECT_NE(text.find("visca_command_completion_seconds_sum{camera=\"studio-1\",category=\"focus\"} 0.04\n"),
+        std::string::npos);
+    EXPECT_NE(text.find("visca_receive_queue_depth{camera=\"studio-1\"} 3\n"), std::string::npos);
+
+    std::string path = testing::TempDir() + "visca_metrics_test.prom";
+    ASSERT_TRUE(ControllerMetrics::writePrometheusFile(path, snapshot, "camera=\"studio-1\""));
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_EQ(content.str(), text);
+    std::remove(path.c_str());
+}
+
+#if defined(__linux__)
+TEST(ControllerMetricsTest, EndpointServesMetrics)
+{
+    std::string path = testing::TempDir() + "visca_metrics_test.sock";
+    MetricsEndpoint endpoint;
+    ASSERT_TRUE(endpoint.start(path, [] { return std::string("visca_commands_total 7\n"); }));
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+    ASSERT_EQ(::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+
+    const char request[] = "GET /metrics HTTP/1.0\r\n\r\n";
+    ASSERT_EQ(::send(fd, request, sizeof(request) - 1, 0), static_cast<ssize_t>(sizeof(request) - 1));
+    std::string response;
+    char buffer[256];
+    ssize_t received;
+    while ((received = ::recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        response.append(buffer, static_cast<size_t>(received));
+    ::close(fd);
+    endpoint.stop();
+
+    EXPECT_EQ(response.rfind("HTTP/1.0 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("Content-Type: text/plain; version=0.0.4\r\n"), std::string::npos);
+    EXPECT_NE(response.find("\r\n\r\nvisca_commands_total 7\n"), std::string::npos);
+    EXPECT_NE(::access(path.c_str(), F_OK), 0);
+}
+#endif
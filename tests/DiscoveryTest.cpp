@@ -0,0 +1,215 @@
+#include "Commands.h"
+#include "Discovery.h"
+#include "ViscaOverIp.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <functional>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace Visca;
+using namespace std::chrono_literals;
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief A camera stand-in on 127.0.0.1 that answers the first datagram it gets.
+ *
+ * Without a reply function it stays silent; being bound, it still keeps the kernel from answering with a
+ * port-unreachable.
+ */
+class Responder {
+public:
+    explicit Responder(std::function<Bytes(const Bytes&)> reply = nullptr)
+        : m_fd(::socket(AF_INET, SOCK_DGRAM, 0))
+    {
+        struct sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        ::bind(m_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+        ::getsockname(m_fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+        m_port = ntohs(addr.sin_port);
+
+        if (!reply)
+            return;
+        m_thread = std::thread([this, reply] {
+            struct pollfd pfd = { m_fd, POLLIN, 0 };
+            if (::poll(&pfd, 1, 2000) <= 0)
+                return;
+            uint8_t buffer[1500];
+            struct sockaddr_in src {};
+            socklen_t srcLen = sizeof(src);
+            ssize_t n = ::recvfrom(m_fd, buffer, sizeof(buffer), 0, reinterpret_cast<struct sockaddr*>(&src), &srcLen);
+            if (n <= 0)
+                return;
+            received.assign(buffer, buffer + n);
+            Bytes answer = reply(received);
+            ::sendto(m_fd, answer.data(), answer.size(), 0, reinterpret_cast<struct sockaddr*>(&src), srcLen);
+        });
+    }
+
+    ~Responder()
+    {
+        if (m_thread.joinable())
+            m_thread.join();
+        ::close(m_fd);
+    }
+
+    uint16_t port() const { return m_port; }
+
+    /**
+     * @brief Wait for the exchange, after which received can be read.
+     */
+    void join() { m_thread.join(); }
+
+    Bytes received; ///< The datagram that was answered
+
+private:
+    int m_fd;
+    uint16_t m_port { 0 };
+    std::thread m_thread;
+};
+
+Bytes networkReply()
+{
+    const std::string fields[] = { "MAC:00-1d-c1-0a-21-37", "INFO:", "MODEL:IPCARD", "SOFTVERSION:2.10",
+        "IPADR:192.168.0.100", "MASK:255.255.255.0", "NAME:CAM1" };
+    Bytes reply { 0x02 };
+    for (const auto& field : fields) {
+        reply.insert(reply.end(), field.begin(), field.end());
+        reply.push_back(0xFF);
+    }
+    reply.push_back(0x03);
+    reply.push_back(0xFF);
+    return reply;
+}
+
+/**
+ * @brief Options that leave the network inquiry and the subnet probe off, for the test to enable one of them.
+ */
+Discovery::Options quietOptions()
+{
+    Discovery::Options options;
+    options.networkInquiry = false;
+    options.timeoutMs = 500;
+    return options;
+}
+}
+
+TEST(DiscoveryTest, NetworkInquiryReplyIsParsed)
+{
+    Responder camera([](const Bytes&) { return networkReply(); });
+
+    Discovery::Options options = quietOptions();
+    options.networkInquiry = true;
+    options.broadcastAddress = "127.0.0.1";
+    options.networkSettingPort = camera.port();
+
+    auto cameras = Discovery(options).run();
+    camera.join();
+
+    EXPECT_EQ(camera.received, Discovery::networkInquiryPacket());
+    ASSERT_EQ(cameras.size(), 1u);
+    // The source of the reply wins over the IPADR field
+    EXPECT_EQ(cameras[0].address, "127.0.0.1");
+    EXPECT_EQ(cameras[0].macAddress, "00-1d-c1-0a-21-37");
+    EXPECT_EQ(cameras[0].model, "IPCARD");
+    EXPECT_EQ(cameras[0].name, "CAM1");
+    EXPECT_EQ(cameras[0].softVersion, "2.10");
+    EXPECT_TRUE(cameras[0].answeredNetworkInquiry);
+    EXPECT_FALSE(cameras[0].answeredVersionInquiry);
+}
+
+TEST(DiscoveryTest, SubnetProbeReplyIsParsed)
+{
+    Responder camera([](const Bytes& probe) {
+        ViscaOverIp::Header header;
+        if (!ViscaOverIp::decode(probe.data(), probe.size(), header))
+            return Bytes {};
+        const uint8_t version[] = { 0x90, 0x50, 0x00, 0x20, 0x05, 0x1A, 0x01, 0x23, 0x02, 0xFF };
+        return ViscaOverIp::encode(ViscaOverIp::PayloadType::Reply, header.sequence, version, sizeof(version));
+    });
+
+    Discovery::Options options = quietOptions();
+    options.probeSubnet = "127.0.0.1/32";
+    options.probePort = camera.port();
+    options.timeoutMs = 2000;
+
+    auto start = Clock::now();
+    auto cameras = Discovery(options).run();
+    auto elapsed = Clock::now() - start;
+    camera.join();
+
+    ViscaOverIp::Header header;
+    ASSERT_TRUE(ViscaOverIp::decode(camera.received.data(), camera.received.size(), header));
+    EXPECT_EQ(header.type, ViscaOverIp::PayloadType::Inquiry);
+    EXPECT_EQ(Bytes(camera.received.begin() + ViscaOverIp::HeaderSize, camera.received.end()),
+        Command::versionInquiry(1).packet());
+
+    ASSERT_EQ(cameras.size(), 1u);
+    EXPECT_EQ(cameras[0].address, "127.0.0.1");
+    EXPECT_TRUE(cameras[0].answeredVersionInquiry);
+    EXPECT_FALSE(cameras[0].answeredNetworkInquiry);
+    EXPECT_EQ(cameras[0].vendorId, 0x0020);
+    EXPECT_EQ(cameras[0].modelId, 0x051A);
+    EXPECT_EQ(cameras[0].romRevision, 0x0123u);
+    // Every probe answered and no broadcast to wait for: the scan ends without using up the window
+    EXPECT_LT(elapsed, 1s);
+}
+
+TEST(DiscoveryTest, NoResponderFindsNothing)
+{
+    Responder silent;
+
+    Discovery::Options options = quietOptions();
+    options.networkInquiry = true;
+    options.broadcastAddress = "127.0.0.1";
+    options.networkSettingPort = silent.port();
+    options.probeSubnet = "127.0.0.1/32";
+    options.probePort = silent.port();
+    options.timeoutMs = 200;
+
+    auto start = Clock::now();
+    auto cameras = Discovery(options).run();
+    auto elapsed = Clock::now() - start;
+
+    EXPECT_TRUE(cameras.empty());
+    // The broadcast keeps the scan open for the whole window, and no longer
+    EXPECT_GE(elapsed, 200ms);
+    EXPECT_LT(elapsed, 2s);
+}
+
+TEST(DiscoveryTest, UnansweredProbeEndsTheScanEarly)
+{
+    Responder silent;
+
+    Discovery::Options options = quietOptions();
+    options.probeSubnet = "127.0.0.1/32";
+    options.probePort = silent.port();
+    options.probeTimeoutMs = 50;
+    options.timeoutMs = 2000;
+
+    auto start = Clock::now();
+    auto cameras = Discovery(options).run();
+    auto elapsed = Clock::now() - start;
+
+    EXPECT_TRUE(cameras.empty());
+    EXPECT_GE(elapsed, 50ms);
+    EXPECT_LT(elapsed, 1s);
+}
+
+TEST(DiscoveryTest, InvalidSubnetIsRejected)
+{
+    Discovery::Options options = quietOptions();
+    options.probeSubnet = "127.0.0.1/8";
+    EXPECT_TRUE(Discovery(options).run().empty());
+}
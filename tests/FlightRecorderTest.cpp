@@ -0,0 +1,138 @@
+#include "FlightRecorder.h"
+#include "Logger.h"
+#include "MockCommunicator.h"
+#include "ViscaController.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <csignal>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+
+Bytes bytesOf(const FlightRecord& record) { return Bytes(record.data, record.data + record.size); }
+}
+
+TEST(FlightRecorderTest, KeepsTheLastFramesInOrder)
+{
+    FlightRecorder recorder(4);
+    EXPECT_EQ(recorder.capacity(), 4u);
+
+    for (uint8_t i = 0; i < 6; ++i)
+        recorder.record(CaptureDirection::Sent, Bytes { 0x81, 0x01, 0x04, 0x07, i, 0xFF });
+
+    auto records = recorder.snapshot();
+    ASSERT_EQ(records.size(), 4u);
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(records[i].index, i + 2);
+        EXPECT_EQ(bytesOf(records[i]), (Bytes { 0x81, 0x01, 0x04, 0x07, static_cast<uint8_t>(i + 2), 0xFF }));
+    }
+    EXPECT_LE(records.front().timestampNs, records.back().timestampNs);
+    EXPECT_EQ(recorder.snapshot(2).front().index, 4u);
+    EXPECT_EQ(recorder.recorded(), 6u);
+}
+
+TEST(FlightRecorderTest, SocketsAndLongFrames)
+{
+    FlightRecorder recorder;
+    recorder.record(CaptureDirection::Sent, Bytes { 0x81, 0x21, 0xFF }); // Cancel socket 1
+    recorder.record(CaptureDirection::Received, Bytes { 0x90, 0x42, 0xFF }); // ACK socket 2
+    recorder.record(CaptureDirection::Received, Bytes { 0x90, 0x61, 0x41, 0xFF }); // Error socket 1
+    recorder.record(CaptureDirection::Sent, Bytes { 0x81, 0x01, 0x04, 0x07, 0x02, 0xFF });
+    recorder.record(CaptureDirection::Received, Bytes(20, 0x55));
+
+    auto records = recorder.snapshot();
+    ASSERT_EQ(records.size(), 5u);
+    EXPECT_EQ(records[0].socket, 1);
+    EXPECT_EQ(records[1].socket, 2);
+    EXPECT_EQ(records[2].socket, 1);
+    EXPECT_EQ(records[3].socket, 0);
+    EXPECT_EQ(records[4].size, FlightRecord::MaxFrameSize);
+    EXPECT_TRUE(records[4].truncated);
+
+    std::string text = recorder.dump();
+    EXPECT_NE(text.find("ms TX socket 1  81 21 FF\n"), std::string::npos);
+    EXPECT_NE(text.find("ms RX socket 2  90 42 FF\n"), std::string::npos);
+    EXPECT_NE(text.find("ms TX           81 01 04 07 02 FF\n"), std::string::npos);
+    EXPECT_NE(text.find("55 55 ...\n"), std::string::npos);
+}
+
+TEST(FlightRecorderTest, ReadersNeverSeeTornFrames)
+{
+    FlightRecorder recorder(64);
+    std::atomic<bool> done { false };
+
+    // Every frame is one byte value repeated as often as the value says
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; ++w) {
+        writers.emplace_back([&recorder, w] {
+            for (int i = 0; i < 20000; ++i) {
+                uint8_t value = static_cast<uint8_t>(1 + (i + w) % FlightRecord::MaxFrameSize);
+                recorder.record(CaptureDirection::Received, Bytes(value, value));
+            }
+        });
+    }
+    std::thread reader([&recorder, &done] {
+        while (!done) {
+            for (const auto& record : recorder.snapshot()) {
+                ASSERT_GT(record.size, 0);
+                for (size_t i = 0; i < record.size; ++i)
+                    ASSERT_EQ(record.data[i], record.size);
+            }
+        }
+    });
+
+    for (auto& writer : writers)
+        writer.join();
+    done = true;
+    reader.join();
+    EXPECT_EQ(recorder.recorded(), 40000u);
+}
+
+#ifndef _WIN32
+TEST(FlightRecorderTest, DumpsOnSignal)
+{
+    FlightRecorder recorder;
+    recorder.record(CaptureDirection::Received, Bytes { 0x90, 0x51, 0xFF });
+    ASSERT_TRUE(FlightRecorder::installSignalHandler(SIGUSR1));
+
+    testing::internal::CaptureStderr();
+    std::raise(SIGUSR1);
+    std::string text = testing::internal::GetCapturedStderr();
+    std::signal(SIGUSR1, SIG_DFL);
+
+    EXPECT_NE(text.find("Flight recorder:\n"), std::string::npos);
+    EXPECT_NE(text.find("ms RX socket 1  90 51 FF\n"), std::string::npos);
+}
+#endif
+
+TEST(FlightRecorderTest, ControllerDumpsOnFailure)
+{
+    std::ostringstream log;
+    Logger::instance().setLevel(LogLevel::Warning);
+    Logger::instance().setOutput(&log);
+
+    MockCommunicator::Config config;
+    config.camera.poweredOn = false;
+    ViscaController camera(std::make_unique<MockCommunicator>(config));
+    ASSERT_TRUE(camera.connect());
+    EXPECT_FALSE(camera.execute(Command::zoomTeleStandard()));
+    camera.disconnect();
+    Logger::instance().setOutput(&std::cout);
+
+    auto records = camera.flightRecorder().snapshot();
+    ASSERT_GE(records.size(), 2u);
+    EXPECT_EQ(records[0].direction, CaptureDirection::Sent);
+    EXPECT_EQ(bytesOf(records[0]), Command::zoomTeleStandard().packet());
+    EXPECT_EQ(records[1].direction, CaptureDirection::Received);
+    EXPECT_EQ(records[1].data[1] & 0xF0, 0x60);
+
+    EXPECT_NE(log.str().find("Last frames on the link:"), std::string::npos);
+    EXPECT_NE(log.str().find("ms TX           81 01 04 07 02 FF"), std::string::npos);
+}
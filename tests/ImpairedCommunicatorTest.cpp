@@ -0,0 +1,145 @@
+#include "Commands.h"
+#include "ImpairedCommunicator.h"
+#include "Logger.h"
+#include "MockCommunicator.h"
+#include "ViscaController.h"
+
+#include <gtest/gtest.h>
+
+using namespace Visca;
+using namespace std::chrono_literals;
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+
+std::unique_ptr<ImpairedCommunicator> makeImpaired(const ImpairedCommunicator::Config& config)
+{
+    MockCommunicator::Config mock;
+    mock.receiveTimeoutMs = 50;
+    auto communicator = std::make_unique<ImpairedCommunicator>(std::make_unique<MockCommunicator>(mock), config);
+    communicator->open();
+    return communicator;
+}
+
+std::vector<Bytes> readAll(ICommunicator& communicator)
+{
+    std::vector<Bytes> reads;
+    uint8_t buffer[256];
+    while (size_t size = communicator.receive(buffer, sizeof(buffer)))
+        reads.emplace_back(buffer, buffer + size);
+    return reads;
+}
+}
+
+TEST(ImpairedCommunicatorTest, PassesThroughWithoutImpairment)
+{
+    auto communicator = makeImpaired({});
+    communicator->send(Command::zoomStop().packet());
+
+    auto reads = readAll(*communicator);
+    ASSERT_EQ(reads.size(), 2u);
+    EXPECT_EQ(reads[0], (Bytes { 0x90, 0x41, 0xFF }));
+    EXPECT_EQ(reads[1], (Bytes { 0x90, 0x51, 0xFF }));
+}
+
+TEST(ImpairedCommunicatorTest, DropsEverything)
+{
+    ImpairedCommunicator::Config config;
+    config.dropRate = 1.0;
+    auto communicator = makeImpaired(config);
+    communicator->send(Command::zoomStop().packet());
+
+    EXPECT_TRUE(readAll(*communicator).empty());
+    EXPECT_EQ(communicator->stats().dropped, 2u);
+}
+
+TEST(ImpairedCommunicatorTest, DuplicatesAcksOnly)
+{
+    ImpairedCommunicator::Config config;
+    config.duplicateAckRate = 1.0;
+    auto communicator = makeImpaired(config);
+    communicator->send(Command::zoomStop().packet());
+
+    auto reads = readAll(*communicator);
+    ASSERT_EQ(reads.size(), 3u);
+    EXPECT_EQ(reads[0], reads[1]);
+    EXPECT_EQ(reads[2], (Bytes { 0x90, 0x51, 0xFF }));
+}
+
+TEST(ImpairedCommunicatorTest, SplitsFrames)
+{
+    ImpairedCommunicator::Config config;
+    config.splitRate = 1.0;
+    auto communicator = makeImpaired(config);
+    communicator->send(Command::versionInquiry().packet());
+
+    auto reads = readAll(*communicator);
+    ASSERT_EQ(reads.size(), 2u);
+    Bytes joined = reads[0];
+    joined.insert(joined.end(), reads[1].begin(), reads[1].end());
+    EXPECT_EQ(joined.size(), 10u);
+    EXPECT_EQ(joined.back(), 0xFF);
+}
+
+TEST(ImpairedCommunicatorTest, MergesFrames)
+{
+    ImpairedCommunicator::Config config;
+    config.mergeRate = 1.0;
+    auto communicator = makeImpaired(config);
+    communicator->send(Command::zoomStop().packet());
+
+    auto reads = readAll(*communicator);
+    ASSERT_EQ(reads.size(), 1u);
+    EXPECT_EQ(reads[0], (Bytes { 0x90, 0x41, 0xFF, 0x90, 0x51, 0xFF }));
+}
+
+TEST(ImpairedCommunicatorTest, SameSeedSameErrors)
+{
+    ImpairedCommunicator::Config config;
+    config.seed = 42;
+    config.bitErrorRate = 0.3;
+
+    std::vector<Bytes> runs[2];
+    for (auto& run : runs) {
+        auto communicator = makeImpaired(config);
+        for (int i = 0; i < 10; ++i)
+            communicator->send(Command::versionInquiry().packet());
+        run = readAll(*communicator);
+        EXPECT_GT(communicator->stats().corruptedBytes, 0u);
+    }
+    EXPECT_EQ(runs[0], runs[1]);
+}
+
+TEST(ImpairedCommunicatorTest, JitterDelaysReplies)
+{
+    ImpairedCommunicator::Config config;
+    config.jitter = 20ms;
+    config.seed = 7;
+    auto communicator = makeImpaired(config);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 20; ++i) {
+        communicator->send(Command::powerInquiry().packet());
+        uint8_t buffer[16];
+        ASSERT_GT(communicator->receive(buffer, sizeof(buffer)), 0u);
+    }
+    // 20 uniform delays of up to 20ms, far above the 1ms ACK delay of the camera
+    EXPECT_GT(std::chrono::steady_clock::now() - start, 60ms);
+}
+
+TEST(ImpairedCommunicatorTest, ControllerToleratesSplitMergedAndDuplicated)
+{
+    Logger::instance().setLevel(LogLevel::Warning);
+
+    ImpairedCommunicator::Config config;
+    config.splitRate = 0.5;
+    config.mergeRate = 0.5;
+    config.duplicateAckRate = 1.0;
+    ViscaController camera(makeImpaired(config));
+    ASSERT_TRUE(camera.connect());
+
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(camera.execute(Command::zoomStop()));
+        EXPECT_EQ(camera.getPowerStatus(), 0x02);
+    }
+}
@@ -0,0 +1,192 @@
+#include "IoEngine.h"
+#include "IoEngineTesting.h"
+#include "Logger.h"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace Visca;
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+
+/**
+ * @brief One end of a stream socket pair, as the engine sees a TCP connection.
+ */
+class SocketEnd : public ICommunicator {
+public:
+    explicit SocketEnd(int fd)
+        : m_fd(fd)
+    {
+    }
+    ~SocketEnd() override { close(); }
+
+    bool open() override { return m_fd >= 0; }
+    bool send(Span<const uint8_t> data) override
+    {
+        return ::send(m_fd, data.data(), data.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(data.size());
+    }
+    size_t receive(uint8_t* buffer, size_t maxSize) override
+    {
+        ssize_t n = ::recv(m_fd, buffer, maxSize, 0);
+        return n > 0 ? static_cast<size_t>(n) : 0;
+    }
+    int nativeHandle() const override { return m_fd; }
+    bool isOpen() const override { return m_fd >= 0; }
+    void close() override
+    {
+        if (m_fd >= 0)
+            ::close(m_fd);
+        m_fd = -1;
+    }
+
+private:
+    int m_fd;
+};
+
+/**
+ * @brief Log into a string for the test's lifetime.
+ */
+struct CapturedLog {
+    CapturedLog()
+    {
+        Logger::instance().setOutput(&text);
+        Logger::instance().setLevel(LogLevel::Info);
+    }
+    ~CapturedLog() { Logger::instance().setOutput(&std::cout); }
+
+    std::ostringstream text;
+};
+
+/**
+ * @brief Poll until the handler got the expected number of bytes or a second passed.
+ */
+void pollFor(IoEngine& engine, const Bytes& received, size_t size)
+{
+    for (int i = 0; i < 100 && received.size() < size; ++i)
+        engine.poll(10);
+}
+}
+
+TEST(IoEngineTest, UringFallsBackToSingleShotReceives)
+{
+    auto engine = IoEngineTesting::createIoUringRejectingMultishot(IoEngine::Options());
+    if (!engine)
+        GTEST_SKIP() << "io_uring not available";
+
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    SocketEnd local(fds[0]);
+    SocketEnd peer(fds[1]);
+
+    CapturedLog log;
+
+    Bytes received;
+    int id = engine->add(local, [&](int, const uint8_t* data, size_t size) {
+        received.insert(received.end(), data, data + size);
+    });
+    ASSERT_GE(id, 0);
+
+    // Every message needs the receive re-armed; a multishot re-arm would be refused forever
+    Bytes expected;
+    for (uint8_t i = 0; i < 5; ++i) {
+        Bytes packet { 0x90, 0x50, i, 0xFF };
+        ASSERT_TRUE(peer.send(packet));
+        expected.insert(expected.end(), packet.begin(), packet.end());
+        pollFor(*engine, received, expected.size());
+        ASSERT_EQ(received, expected);
+    }
+
+    if (VISCA_LOG_MIN_LEVEL >= 2) {
+        EXPECT_NE(log.text.str().find("using single-shot receives"), std::string::npos);
+    }
+
+    // Sending still works on the same endpoint
+    ASSERT_TRUE(engine->send(id, Bytes { 0x81, 0x01, 0x04, 0x07, 0x00, 0xFF }));
+    engine->poll(0);
+    uint8_t buffer[16];
+    EXPECT_EQ(peer.receive(buffer, sizeof(buffer)), 6u);
+}
+
+TEST(IoEngineTest, EpollKeepsUnsentBytesUntilWritable)
+{
+    auto engine = IoEngine::createEpoll(IoEngine::Options());
+    ASSERT_TRUE(engine);
+
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int sendBuffer = 4096;
+    ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+    ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    ::fcntl(fds[1], F_SETFL, ::fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    SocketEnd local(fds[0]);
+    SocketEnd peer(fds[1]);
+
+    int id = engine->add(local, [](int, const uint8_t*, size_t) {});
+    ASSERT_GE(id, 0);
+
+    // Far more than the socket takes at once: the tail has to wait for EPOLLOUT
+    Bytes expected(256 * 1024);
+    for (size_t i = 0; i < expected.size(); ++i)
+        expected[i] = static_cast<uint8_t>(i * 7);
+    ASSERT_TRUE(engine->send(id, expected));
+
+    Bytes received;
+    uint8_t buffer[4096];
+    for (int i = 0; i < 1000 && received.size() < expected.size(); ++i) {
+        engine->poll(10);
+        size_t n;
+        while ((n = peer.receive(buffer, sizeof(buffer))) > 0)
+            received.insert(received.end(), buffer, buffer + n);
+    }
+    EXPECT_EQ(received, expected);
+}
+
+TEST(IoEngineTest, HandlerMayAddEndpoints)
+{
+    for (auto backend : { IoEngine::Backend::Epoll, IoEngine::Backend::IoUring }) {
+        auto engine = IoEngine::create(backend);
+        if (!engine)
+            continue;
+        SCOPED_TRACE(IoEngine::backendName(backend));
+
+        int fds[2];
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        SocketEnd local(fds[0]);
+        SocketEnd peer(fds[1]);
+
+        // Every packet registers more endpoints from inside the handler, growing the endpoint table under it
+        std::vector<std::unique_ptr<SocketEnd>> added;
+        Bytes received;
+        int id = engine->add(local, [&](int, const uint8_t* data, size_t size) {
+            for (int i = 0; i < 16; ++i) {
+                int pair[2];
+                if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+                    return;
+                added.push_back(std::make_unique<SocketEnd>(pair[0]));
+                added.push_back(std::make_unique<SocketEnd>(pair[1]));
+                engine->add(*added[added.size() - 2], [](int, const uint8_t*, size_t) {});
+            }
+            received.insert(received.end(), data, data + size);
+        });
+        ASSERT_GE(id, 0);
+
+        Bytes expected;
+        for (uint8_t i = 0; i < 4; ++i) {
+            Bytes packet { 0x90, 0x50, i, 0xFF };
+            ASSERT_TRUE(peer.send(packet));
+            expected.insert(expected.end(), packet.begin(), packet.end());
+            pollFor(*engine, received, expected.size());
+            ASSERT_EQ(received, expected);
+        }
+
+        // Endpoints go away before their sockets close
+        engine.reset();
+    }
+}
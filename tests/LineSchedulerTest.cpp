@@ -0,0 +1,147 @@
+#include "Commands.h"
+#include "LineScheduler.h"
+#include "MockCommunicator.h"
+#include "ScheduledCommunicator.h"
+
+#include <gtest/gtest.h>
+
+using namespace Visca;
+using namespace std::chrono_literals;
+
+namespace {
+using Clock = LineScheduler::Clock;
+
+const Clock::time_point T0 = Clock::time_point() + 1h;
+
+bool admit(LineScheduler& scheduler, const Command& command, Clock::time_point now, Clock::time_point& sendAt)
+{
+    return scheduler.admit(command.packet().data(), command.packet().size(), now, sendAt);
+}
+}
+
+TEST(LineSchedulerTest, WireTimeAt9600Baud)
+{
+    EXPECT_EQ(Command::zoomDirect(1, 0x1000).packet().size(), 9u);
+    EXPECT_EQ(LineScheduler::wireTime(9, 9600), 9375us);
+    EXPECT_EQ(LineScheduler::wireTime(9, 0), Clock::duration::zero());
+}
+
+TEST(LineSchedulerTest, PacesPacketsBackToBack)
+{
+    LineScheduler scheduler;
+    Clock::time_point first;
+    Clock::time_point second;
+    ASSERT_TRUE(admit(scheduler, Command::zoomDirect(1, 0x1000), T0, first));
+    ASSERT_TRUE(admit(scheduler, Command::focusDirect(1, 0x2000), T0, second));
+    EXPECT_EQ(first, T0);
+    EXPECT_EQ(second, T0 + 9375us);
+    EXPECT_EQ(scheduler.backlog(T0), 9375us * 2 + LineScheduler::wireTime(6, 9600)) << "ACK and completion of the second";
+    EXPECT_EQ(scheduler.stats(LineScheduler::Class::Control).deferred, 1u);
+}
+
+TEST(LineSchedulerTest, InquiryWaitsForItsReplyToFitTheReceiveSide)
+{
+    LineScheduler scheduler;
+    Clock::time_point sendAt;
+    ASSERT_TRUE(admit(scheduler, Command::zoomPositionInquiry(), T0, sendAt));
+    ASSERT_TRUE(admit(scheduler, Command::zoomPositionInquiry(), T0, sendAt));
+
+    // Requests are 5 bytes, but each answer takes 7 bytes of the receive side
+    EXPECT_EQ(sendAt, T0 + LineScheduler::wireTime(7, 9600));
+}
+
+TEST(LineSchedulerTest, ShedsTelemetryButDefersControlWhenSaturated)
+{
+    LineScheduler scheduler;
+    Clock::time_point sendAt;
+    for (int i = 0; i < 5; ++i)
+        ASSERT_TRUE(admit(scheduler, Command::zoomDirect(1, 0x1000), T0, sendAt));
+
+    EXPECT_FALSE(admit(scheduler, Command::zoomPositionInquiry(), T0, sendAt));
+    ASSERT_TRUE(admit(scheduler, Command::zoomStop(), T0, sendAt));
+    EXPECT_EQ(sendAt, T0 + 9375us * 5);
+
+    // Once the line has drained the inquiry goes again
+    EXPECT_TRUE(admit(scheduler, Command::zoomPositionInquiry(), sendAt, sendAt));
+
+    const auto& telemetry = scheduler.stats(LineScheduler::Class::Telemetry);
+    EXPECT_EQ(telemetry.shed, 1u);
+    EXPECT_EQ(telemetry.admitted, 1u);
+    EXPECT_EQ(scheduler.stats(LineScheduler::Class::Control).admitted, 6u);
+    EXPECT_EQ(scheduler.stats(LineScheduler::Class::Control).shed, 0u);
+}
+
+TEST(LineSchedulerTest, TelemetryBudgetIsPerCamera)
+{
+    LineScheduler scheduler;
+    scheduler.setBudget(1, { 1.0, 0.1 });
+
+    // Both cameras are polled every 20 ms for one second
+    for (auto now = T0; now < T0 + 1s; now += 20ms) {
+        Clock::time_point sendAt;
+        auto one = Command::zoomPositionInquiry(1);
+        auto two = Command::zoomPositionInquiry(2);
+        scheduler.admit(one.packet().data(), one.packet().size(), now, sendAt);
+        scheduler.admit(two.packet().data(), two.packet().size(), now, sendAt);
+    }
+
+    auto one = scheduler.cameraStats(1, LineScheduler::Class::Telemetry);
+    auto two = scheduler.cameraStats(2, LineScheduler::Class::Telemetry);
+    EXPECT_GT(one.shed, 0u);
+    EXPECT_LE(one.wireTime, 100ms + scheduler.config().burst / 10 + LineScheduler::wireTime(7, 9600));
+    EXPECT_EQ(two.shed, 0u);
+    EXPECT_EQ(two.admitted, 50u);
+}
+
+TEST(LineSchedulerTest, ReportsUtilisationPerDirection)
+{
+    LineScheduler scheduler;
+    Clock::time_point sendAt;
+    for (auto now = T0; now < T0 + 1s; now += 100ms)
+        ASSERT_TRUE(admit(scheduler, Command::zoomDirect(1, 0x1000), now, sendAt));
+    scheduler.onReceived(96, T0 + 500ms);
+
+    auto utilisation = scheduler.utilisation(T0 + 1s);
+    EXPECT_NEAR(utilisation.transmit, 0.09375, 1e-6);
+    EXPECT_NEAR(utilisation.receive, 0.1, 1e-6);
+    EXPECT_NEAR(scheduler.utilisation(T0 + 3s).transmit, 0.0, 1e-9);
+}
+
+TEST(LineSchedulerTest, CommunicatorPacesAndSheds)
+{
+    MockCommunicator::Config mock;
+    mock.baudRate = 9600;
+    LineScheduler::Config config;
+    config.baudRate = 9600;
+    ScheduledCommunicator comm(std::make_unique<MockCommunicator>(mock), config);
+    ASSERT_TRUE(comm.open());
+
+    auto start = Clock::now();
+    for (int i = 0; i < 4; ++i)
+        ASSERT_TRUE(comm.send(Command::zoomDirect(1, 0x1000).packet()));
+    EXPECT_GE(Clock::now() - start, 9375us * 3) << "the fourth packet waits for the line";
+
+    // A burst that books the line for longer than an inquiry may wait
+    std::vector<uint8_t> burst;
+    for (int i = 0; i < 4; ++i) {
+        auto packet = Command::focusDirect(1, 0x1000).packet();
+        burst.insert(burst.end(), packet.begin(), packet.end());
+    }
+    ASSERT_TRUE(comm.send(burst));
+    EXPECT_FALSE(comm.send(Command::zoomPositionInquiry().packet()));
+    EXPECT_EQ(comm.stats(LineScheduler::Class::Telemetry).shed, 1u);
+    EXPECT_EQ(comm.stats(LineScheduler::Class::Control).admitted, 8u);
+    EXPECT_GT(comm.utilisation().transmit, 0.0);
+}
+
+TEST(LineSchedulerTest, CommunicatorRejectsEmptyPacket)
+{
+    ScheduledCommunicator comm(
+        std::make_unique<MockCommunicator>(MockCommunicator::Config {}), LineScheduler::Config {});
+    ASSERT_TRUE(comm.open());
+
+    auto packet = Command::zoomDirect(1, 0x1000).packet();
+    std::vector<Span<const uint8_t>> packets { Span<const uint8_t>(), Span<const uint8_t>(packet) };
+    EXPECT_FALSE(comm.sendv(packets));
+    EXPECT_EQ(comm.stats(LineScheduler::Class::Control).admitted, 1u) << "the packet after it still goes out";
+}
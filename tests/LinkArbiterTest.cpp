@@ -0,0 +1,251 @@
+#include "CameraSimulator.h"
+#include "Commands.h"
+#include "LinkArbiter.h"
+
+#include <gtest/gtest.h>
+
+using namespace Visca;
+using namespace std::chrono_literals;
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+using Clock = LinkArbiter::Clock;
+
+const Clock::time_point T0 = Clock::time_point() + 1h;
+
+void submit(LinkArbiter& arbiter, LinkArbiter::ClientId client, uint32_t tag, const Command& command,
+    Clock::time_point now = T0)
+{
+    std::vector<LinkArbiter::Output> out;
+    ASSERT_TRUE(arbiter.submit(client, tag, command.packet().data(), command.packet().size(), now, out));
+    ASSERT_TRUE(out.empty());
+}
+
+std::vector<LinkArbiter::Output> reply(LinkArbiter& arbiter, const Bytes& frame, Clock::time_point now = T0)
+{
+    std::vector<LinkArbiter::Output> out;
+    arbiter.onReply(frame.data(), frame.size(), now, out);
+    return out;
+}
+}
+
+TEST(LinkArbiterTest, ServesClientsRoundRobinOnePacketAtATime)
+{
+    LinkArbiter arbiter;
+    submit(arbiter, 1, 10, Command::zoomPositionInquiry());
+    submit(arbiter, 1, 11, Command::focusPositionInquiry());
+    submit(arbiter, 2, 20, Command::powerInquiry());
+
+    LinkArbiter::Dispatch dispatch;
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    EXPECT_EQ(dispatch.client, 1u);
+    EXPECT_EQ(dispatch.tag, 10u);
+    EXPECT_FALSE(arbiter.next(dispatch, T0)) << "second packet must wait for the first reply";
+
+    auto out = reply(arbiter, { 0x90, 0x50, 0x00, 0x00, 0x00, 0x00, 0xFF });
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].client, 1u);
+    EXPECT_EQ(out[0].tag, 10u);
+
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    EXPECT_EQ(dispatch.client, 2u);
+    reply(arbiter, { 0x90, 0x50, 0x02, 0xFF });
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    EXPECT_EQ(dispatch.client, 1u);
+    EXPECT_EQ(dispatch.tag, 11u);
+}
+
+TEST(LinkArbiterTest, RoutesCompletionToSocketOwner)
+{
+    LinkArbiter arbiter;
+    submit(arbiter, 1, 10, Command::zoomDirect(1, 0x1000));
+    submit(arbiter, 2, 20, Command::focusDirect(1, 0x2000));
+
+    LinkArbiter::Dispatch dispatch;
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    EXPECT_EQ(reply(arbiter, { 0x90, 0x41, 0xFF })[0].client, 1u);
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    EXPECT_EQ(reply(arbiter, { 0x90, 0x42, 0xFF })[0].client, 2u);
+    EXPECT_EQ(arbiter.busySockets(), 2u);
+
+    auto out = reply(arbiter, { 0x90, 0x52, 0xFF });
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].client, 2u);
+    EXPECT_EQ(out[0].tag, 20u);
+
+    out = reply(arbiter, { 0x90, 0x51, 0xFF });
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].client, 1u);
+    EXPECT_EQ(out[0].tag, 10u);
+    EXPECT_TRUE(arbiter.isIdle());
+}
+
+TEST(LinkArbiterTest, InquiriesPassCommandsWaitingForASocket)
+{
+    LinkArbiter arbiter;
+    LinkArbiter::Dispatch dispatch;
+    for (uint8_t socket = 1; socket <= 2; ++socket) {
+        submit(arbiter, socket, 0, Command::zoomTeleStandard());
+        ASSERT_TRUE(arbiter.next(dispatch, T0));
+        reply(arbiter, { 0x90, static_cast<uint8_t>(0x40 | socket), 0xFF });
+    }
+
+    submit(arbiter, 3, 30, Command::zoomStop());
+    submit(arbiter, 4, 40, Command::zoomPositionInquiry());
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    EXPECT_EQ(dispatch.client, 4u) << "the inquiry goes while both sockets are busy";
+    reply(arbiter, { 0x90, 0x50, 0x00, 0x00, 0x00, 0x00, 0xFF });
+    EXPECT_FALSE(arbiter.next(dispatch, T0));
+
+    auto later = T0 + 3ms;
+    reply(arbiter, { 0x90, 0x51, 0xFF }, later);
+    ASSERT_TRUE(arbiter.next(dispatch, later + 1ms));
+    EXPECT_EQ(dispatch.client, 3u);
+    EXPECT_EQ(dispatch.eligible, later);
+}
+
+TEST(LinkArbiterTest, RoutesErrorsAndCancels)
+{
+    LinkArbiter arbiter;
+    LinkArbiter::Dispatch dispatch;
+
+    // A command refused by the camera is answered with an error instead of an ACK
+    submit(arbiter, 1, 10, Command::focusFarStandard());
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    auto out = reply(arbiter, { 0x90, 0x61, 0x41, 0xFF });
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].tag, 10u);
+    EXPECT_EQ(arbiter.busySockets(), 0u);
+
+    submit(arbiter, 1, 11, Command::zoomTeleStandard());
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    reply(arbiter, { 0x90, 0x41, 0xFF });
+
+    const uint8_t cancel[] = { 0x81, 0x21, 0xFF };
+    std::vector<LinkArbiter::Output> none;
+    ASSERT_TRUE(arbiter.submit(2, 20, cancel, sizeof(cancel), T0, none));
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    out = reply(arbiter, { 0x90, 0x61, 0x04, 0xFF });
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].client, 2u);
+    EXPECT_EQ(arbiter.busySockets(), 0u);
+}
+
+TEST(LinkArbiterTest, RoutesSocketErrorToSocketOwner)
+{
+    LinkArbiter arbiter;
+    LinkArbiter::Dispatch dispatch;
+
+    submit(arbiter, 1, 10, Command::zoomDirect(1, 0x4000));
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    reply(arbiter, { 0x90, 0x41, 0xFF });
+
+    // Client 2's inquiry is outstanding when client 1's running zoom fails
+    submit(arbiter, 2, 20, Command::zoomPositionInquiry());
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    auto out = reply(arbiter, { 0x90, 0x61, 0x41, 0xFF });
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].client, 1u);
+    EXPECT_EQ(out[0].tag, 10u);
+    EXPECT_EQ(arbiter.busySockets(), 0u);
+
+    out = reply(arbiter, { 0x90, 0x50, 0x01, 0x02, 0x03, 0x04, 0xFF });
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].client, 2u);
+    EXPECT_EQ(out[0].tag, 20u);
+    EXPECT_TRUE(arbiter.isIdle());
+}
+
+TEST(LinkArbiterTest, RejectsWhenClientQueueIsFull)
+{
+    LinkArbiter::Config config;
+    config.maxQueued = 2;
+    LinkArbiter arbiter(config);
+    submit(arbiter, 1, 0, Command::zoomStop());
+    submit(arbiter, 1, 1, Command::zoomStop());
+
+    std::vector<LinkArbiter::Output> out;
+    auto packet = Command::zoomStop().packet();
+    EXPECT_FALSE(arbiter.submit(1, 2, packet.data(), packet.size(), T0, out));
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].data, (Bytes { 0x90, 0x60, 0x03, 0xFF }));
+    EXPECT_EQ(out[0].tag, 2u);
+    EXPECT_EQ(arbiter.stats().rejected, 1u);
+}
+
+TEST(LinkArbiterTest, MovesOnAfterReplyTimeout)
+{
+    LinkArbiter arbiter;
+    submit(arbiter, 1, 0, Command::zoomPositionInquiry());
+    submit(arbiter, 2, 0, Command::zoomPositionInquiry());
+
+    LinkArbiter::Dispatch dispatch;
+    ASSERT_TRUE(arbiter.next(dispatch, T0));
+    Clock::time_point deadline;
+    ASSERT_TRUE(arbiter.nextDeadline(deadline));
+    EXPECT_EQ(deadline, T0 + 200ms);
+
+    arbiter.expire(deadline - 1ms);
+    EXPECT_FALSE(arbiter.next(dispatch, deadline - 1ms));
+    arbiter.expire(deadline);
+    ASSERT_TRUE(arbiter.next(dispatch, deadline));
+    EXPECT_EQ(dispatch.client, 2u);
+    EXPECT_EQ(arbiter.stats().replyTimeouts, 1u);
+}
+
+TEST(LinkArbiterTest, NotificationsGoToAllClients)
+{
+    LinkArbiter arbiter;
+    auto out = reply(arbiter, { 0x90, 0x38, 0xFF });
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0].client, LinkArbiter::AllClients);
+
+    out = reply(arbiter, { 0x90, 0x51, 0xFF });
+    EXPECT_TRUE(out.empty());
+    EXPECT_EQ(arbiter.stats().unroutable, 1u);
+}
+
+TEST(LinkArbiterTest, SharesSimulatedCameraBetweenClients)
+{
+    CameraSimulator::Config config;
+    config.zoomFullTravel = 100ms;
+    CameraSimulator camera(config);
+    LinkArbiter arbiter;
+
+    // Four clients, each a direct move and an inquiry
+    for (LinkArbiter::ClientId client = 1; client <= 4; ++client) {
+        submit(arbiter, client, client * 10, Command::zoomDirect(1, static_cast<uint16_t>(client * 0x0400)));
+        submit(arbiter, client, client * 10 + 1, Command::zoomPositionInquiry());
+    }
+
+    std::map<LinkArbiter::ClientId, std::vector<LinkArbiter::Output>> received;
+    std::vector<CameraSimulator::Reply> replies;
+    auto now = T0;
+    for (int step = 0; step < 2000 && !arbiter.isIdle(); ++step) {
+        LinkArbiter::Dispatch dispatch;
+        while (arbiter.next(dispatch, now))
+            camera.process(dispatch.data.data(), dispatch.data.size(), now);
+
+        replies.clear();
+        camera.collectReplies(now, replies);
+        for (const auto& r : replies) {
+            std::vector<LinkArbiter::Output> out;
+            arbiter.onReply(r.data.data(), r.data.size(), now, out);
+            for (auto& output : out)
+                received[output.client].push_back(std::move(output));
+        }
+        now += 1ms;
+    }
+
+    ASSERT_TRUE(arbiter.isIdle());
+    EXPECT_EQ(camera.errorCount(), 0u) << "the arbiter never overfills the camera sockets";
+    for (LinkArbiter::ClientId client = 1; client <= 4; ++client) {
+        const auto& outputs = received[client];
+        ASSERT_EQ(outputs.size(), 3u) << "client " << client;
+        EXPECT_EQ(outputs[0].data[1] & 0xF0, 0x40);
+        EXPECT_EQ(outputs[0].tag, client * 10);
+        EXPECT_EQ(outputs[1].tag, client * 10 + 1) << "inquiry answered while the move runs";
+        EXPECT_EQ(outputs[2].data[1] & 0xF0, 0x50);
+        EXPECT_EQ(outputs[2].tag, client * 10);
+    }
+}
@@ -0,0 +1,257 @@
+#include "LockFreeQueue.h"
+#include "Logger.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+
+/**
+ * @brief Stream buffer that holds up every write until opened, to keep the logger's writer busy.
+ */
+class GateBuffer : public std::stringbuf {
+public:
+    void open()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = true;
+        m_cond.notify_all();
+    }
+
+    void waitUntilEntered()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this] { return m_entered; });
+    }
+
+protected:
+    std::streamsize xsputn(const char* data, std::streamsize size) override
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_entered = true;
+        m_cond.notify_all();
+        m_cond.wait(lock, [this] { return m_open; });
+        return std::stringbuf::xsputn(data, size);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_entered { false };
+    bool m_open { false };
+};
+
+/**
+ * @brief An INFO line straight to the logger, for tests of the queue that must run whatever VISCA_LOG_MIN_LEVEL is.
+ */
+void logInfo(const std::string& message)
+{
+    Logger::instance().log(LogLevel::Info, __FILE__, __FUNCTION__, __LINE__, message);
+}
+
+class LoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        Logger::instance().setLevel(LogLevel::Info);
+        Logger::instance().enableLocationInfo(false);
+    }
+
+    void TearDown() override
+    {
+        Logger::instance().stopAsync();
+        Logger::instance().setOutput(&std::cout);
+        Logger::instance().enableLocationInfo(true);
+        Logger::instance().setLevel(LogLevel::Warning);
+    }
+
+    static size_t count(const std::string& text, const std::string& what)
+    {
+        size_t found = 0;
+        for (size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1))
+            ++found;
+        return found;
+    }
+};
+}
+
+TEST(LockFreeQueueTest, BoundedFifo)
+{
+    LockFreeQueue<int> queue(3);
+    ASSERT_EQ(queue.capacity(), 4u);
+    for (int i = 0; i < 4; ++i)
+        EXPECT_TRUE(queue.push(int(i)));
+    EXPECT_FALSE(queue.push(4));
+    EXPECT_EQ(queue.size(), 4u);
+
+    int item = -1;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.pop(item));
+        EXPECT_EQ(item, i);
+    }
+    EXPECT_FALSE(queue.pop(item));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(LockFreeQueueTest, ProducersKeepTheirOrder)
+{
+    constexpr int Producers = 4;
+    constexpr int Items = 20000;
+    LockFreeQueue<int> queue(64);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < Producers; ++p) {
+        producers.emplace_back([&queue, p] {
+            for (int i = 0; i < Items; ++i) {
+                while (!queue.push(p * Items + i))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<int> next(Producers, 0);
+    bool ordered = true;
+    for (int received = 0; received < Producers * Items;) {
+        int item;
+        if (!queue.pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int producer = item / Items;
+        ordered = ordered && item % Items == next[producer];
+        next[producer] = item % Items + 1;
+        ++received;
+    }
+    for (auto& producer : producers)
+        producer.join();
+
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(LoggerTest, AsyncWritesEverythingInOrder)
+{
+    std::ostringstream output;
+    Logger::instance().setOutput(&output);
+    ASSERT_TRUE(Logger::instance().startAsync());
+
+    for (int i = 0; i < 1000; ++i)
+        logInfo("message " + std::to_string(i));
+    VISCALOG_DEBUG("filtered");
+    Logger::instance().flush();
+
+    std::string text = output.str();
+    EXPECT_EQ(count(text, "[INFO] message "), 1000u);
+    EXPECT_LT(text.find("message 998\n"), text.find("message 999\n"));
+    EXPECT_EQ(text.find("filtered"), std::string::npos);
+    EXPECT_EQ(Logger::instance().droppedMessages(), 0u);
+}
+
+TEST_F(LoggerTest, FullQueueDropsAndReports)
+{
+    GateBuffer gate;
+    std::ostream output(&gate);
+    Logger::instance().setOutput(&output);
+    Logger::AsyncOptions options;
+    options.capacity = 16;
+    ASSERT_TRUE(Logger::instance().startAsync(options));
+
+    // The writer takes the first message and waits in the stream, the rest pile up
+    logInfo("first");
+    gate.waitUntilEntered();
+    uint64_t dropped = Logger::instance().droppedMessages();
+    for (int i = 0; i < 100; ++i)
+        logInfo("message " + std::to_string(i));
+    EXPECT_EQ(Logger::instance().droppedMessages() - dropped, 100u - 16u);
+
+    gate.open();
+    Logger::instance().flush();
+    Logger::instance().stopAsync();
+    std::string text = gate.str();
+    EXPECT_EQ(count(text, "[INFO] message "), 16u);
+    EXPECT_NE(text.find("84 messages dropped"), std::string::npos);
+}
+
+TEST_F(LoggerTest, FullQueueBlocksWhenAsked)
+{
+    GateBuffer gate;
+    std::ostream output(&gate);
+    Logger::instance().setOutput(&output);
+    Logger::AsyncOptions options;
+    options.capacity = 16;
+    options.overflow = LogOverflow::Block;
+    ASSERT_TRUE(Logger::instance().startAsync(options));
+
+    logInfo("first");
+    gate.waitUntilEntered();
+    uint64_t dropped = Logger::instance().droppedMessages();
+    std::atomic<bool> done { false };
+    std::thread producer([&done] {
+        for (int i = 0; i < 100; ++i)
+            logInfo("message " + std::to_string(i));
+        done = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(done);
+    gate.open();
+    producer.join();
+    Logger::instance().flush();
+
+    EXPECT_EQ(count(gate.str(), "[INFO] message "), 100u);
+    EXPECT_EQ(Logger::instance().droppedMessages(), dropped);
+}
+
+TEST_F(LoggerTest, FilteredStatementsEvaluateNothing)
+{
+    std::ostringstream output;
+    Logger::instance().setOutput(&output);
+    int evaluated = 0;
+    auto expensive = [&evaluated] { return ++evaluated; };
+
+    VISCALOG_DEBUG("value " << expensive());
+    VISCALOG_ERROR_IF(expensive() > 100, "never");
+    EXPECT_EQ(evaluated, 1) << "only the condition of the enabled ERROR statement runs";
+    EXPECT_TRUE(output.str().empty());
+
+    // Enabled at runtime, but a build leaving INFO out evaluates nothing either
+    VISCALOG_INFO_IF(expensive() > 100, "never");
+    EXPECT_EQ(evaluated, VISCA_LOG_MIN_LEVEL >= 2 ? 2 : 1);
+
+    Logger::instance().enableLogging(false);
+    VISCALOG_ERROR("value " << expensive());
+    Logger::instance().enableLogging(true);
+    EXPECT_EQ(evaluated, VISCA_LOG_MIN_LEVEL >= 2 ? 2 : 1);
+    EXPECT_FALSE(Logger::instance().isEnabled(LogLevel::Debug));
+    EXPECT_TRUE(Logger::instance().isEnabled(LogLevel::Info));
+}
+
+TEST_F(LoggerTest, HexDumpsAWholePacket)
+{
+    std::ostringstream output;
+    Logger::instance().setOutput(&output);
+    Logger::instance().setLevel(LogLevel::Debug);
+
+    // Longer than the formatting buffer
+    std::vector<uint8_t> large(100, 0xAB);
+    std::ostringstream dump;
+    dump << LogHex(large.data(), large.size());
+    EXPECT_EQ(dump.str().size(), 3 * large.size() - 1);
+    EXPECT_EQ(dump.str().find("ABAB"), std::string::npos);
+
+    if (VISCA_LOG_MIN_LEVEL < 3)
+        GTEST_SKIP() << "DEBUG statements are compiled out";
+    const uint8_t packet[] = { 0x81, 0x01, 0x04, 0x07, 0x00, 0xFF };
+    VISCALOG_DEBUG_HEX("Sending: ", packet, sizeof(packet));
+    EXPECT_NE(output.str().find("[DEBUG] Sending: 81 01 04 07 00 FF\n"), std::string::npos);
+}
@@ -0,0 +1,133 @@
+#include "Commands.h"
+#include "MockCommunicator.h"
+
+#include <gtest/gtest.h>
+
+using namespace Visca;
+using namespace std::chrono_literals;
+
+namespace {
+using Clock = MockCommunicator::Clock;
+using Bytes = std::vector<uint8_t>;
+
+Bytes receiveFrames(MockCommunicator& communicator, size_t frames)
+{
+    Bytes received;
+    uint8_t buffer[256];
+    size_t terminators = 0;
+    while (terminators < frames) {
+        size_t size = communicator.receive(buffer, sizeof(buffer));
+        if (size == 0)
+            break;
+        for (size_t i = 0; i < size; ++i) {
+            received.push_back(buffer[i]);
+            terminators += buffer[i] == 0xFF ? 1 : 0;
+        }
+    }
+    return received;
+}
+}
+
+TEST(MockCommunicatorTest, SendFailsWhenClosed)
+{
+    MockCommunicator communicator;
+    EXPECT_FALSE(communicator.isOpen());
+    EXPECT_FALSE(communicator.send(Command::zoomStop().packet()));
+
+    EXPECT_TRUE(communicator.open());
+    EXPECT_TRUE(communicator.send(Command::zoomStop().packet()));
+}
+
+TEST(MockCommunicatorTest, ReturnsAckAndCompletion)
+{
+    MockCommunicator communicator;
+    communicator.open();
+    communicator.send(Command::zoomStop().packet());
+
+    EXPECT_EQ(receiveFrames(communicator, 2), (Bytes { 0x90, 0x41, 0xFF, 0x90, 0x51, 0xFF }));
+
+    auto stats = communicator.stats();
+    EXPECT_EQ(stats.framesSent, 1u);
+    EXPECT_EQ(stats.framesReceived, 2u);
+    EXPECT_EQ(stats.bytesReceived, 6u);
+}
+
+TEST(MockCommunicatorTest, PacketSplitAcrossSends)
+{
+    MockCommunicator communicator;
+    communicator.open();
+
+    auto packet = Command::powerInquiry().packet();
+    communicator.send(Span<const uint8_t>(packet.data(), 2));
+    communicator.send(Span<const uint8_t>(packet.data() + 2, packet.size() - 2));
+
+    EXPECT_EQ(receiveFrames(communicator, 1), (Bytes { 0x90, 0x50, 0x02, 0xFF }));
+}
+
+TEST(MockCommunicatorTest, ReceiveTimesOut)
+{
+    MockCommunicator::Config config;
+    config.receiveTimeoutMs = 20;
+    MockCommunicator communicator(config);
+    communicator.open();
+
+    uint8_t buffer[16];
+    auto start = Clock::now();
+    EXPECT_EQ(communicator.receive(buffer, sizeof(buffer)), 0u);
+    EXPECT_GE(Clock::now() - start, 20ms);
+}
+
+TEST(MockCommunicatorTest, LatencyIsAddedInBothDirections)
+{
+    MockCommunicator::Config config;
+    config.latency = 20ms;
+    config.camera.ackDelay = 1ms;
+    MockCommunicator communicator(config);
+    communicator.open();
+
+    auto start = Clock::now();
+    communicator.send(Command::powerInquiry().packet());
+    receiveFrames(communicator, 1);
+    EXPECT_GE(Clock::now() - start, 41ms);
+}
+
+TEST(MockCommunicatorTest, WireTime)
+{
+    EXPECT_EQ(MockCommunicator::wireTime(3, 0), Clock::duration::zero());
+    EXPECT_EQ(std::chrono::duration_cast<std::chrono::microseconds>(MockCommunicator::wireTime(96, 9600)),
+        std::chrono::microseconds(100000));
+}
+
+TEST(MockCommunicatorTest, BaudRateSerializesReplies)
+{
+    // 9600 baud: a 3 byte reply takes 3.125ms on the wire, 50 commands queue up 100 replies
+    MockCommunicator::Config config;
+    config.baudRate = 9600;
+    config.camera.ackDelay = 0ms;
+    config.camera.commandTime = 0ms;
+    MockCommunicator communicator(config);
+    communicator.open();
+
+    auto packet = Command::zoomStop().packet();
+    std::vector<Span<const uint8_t>> packets(50, Span<const uint8_t>(packet));
+
+    auto start = Clock::now();
+    communicator.sendv(packets);
+    auto received = receiveFrames(communicator, 100);
+    auto elapsed = Clock::now() - start;
+
+    EXPECT_EQ(received.size(), 300u);
+    EXPECT_GE(elapsed, MockCommunicator::wireTime(300, config.baudRate));
+}
+
+TEST(MockCommunicatorTest, CameraStateIsVisible)
+{
+    MockCommunicator::Config config;
+    config.camera.zoomFullTravel = 100ms;
+    MockCommunicator communicator(config);
+    communicator.open();
+
+    communicator.send(Command::zoomDirect(1, 0x3000).packet());
+    receiveFrames(communicator, 2);
+    EXPECT_EQ(communicator.camera().zoomPosition(), 0x3000);
+}
@@ -0,0 +1,136 @@
+#include "Logger.h"
+#include "RotatingFile.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace Visca;
+
+namespace {
+std::string filePath(const char* name) { return testing::TempDir() + name + ".log"; }
+
+bool exists(const std::string& path) { return std::ifstream(path).good(); }
+
+std::string contents(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+void removeAll(const std::string& path)
+{
+    std::remove(path.c_str());
+    for (int i = 1; i < 10; ++i)
+        std::remove((path + "." + std::to_string(i)).c_str());
+}
+}
+
+TEST(RotatingFileTest, RotatesBySizeAndKeepsMaxFiles)
+{
+    std::string path = filePath("RotatingFileTest_Size");
+    removeAll(path);
+
+    RotatingFile::Options options;
+    options.maxFileSize = 100;
+    options.maxFiles = 3;
+    RotatingFile file(options);
+    ASSERT_TRUE(file.open(path));
+
+    // 40 byte lines, two per file
+    for (int i = 0; i < 10; ++i) {
+        char line[41];
+        std::snprintf(line, sizeof(line), "line %02d %031d\n", i, 0);
+        ASSERT_TRUE(file.write(line, 40));
+    }
+    file.close();
+
+    EXPECT_EQ(file.rotations(), 4u);
+    EXPECT_EQ(contents(path).substr(0, 7), "line 08");
+    EXPECT_EQ(contents(path).size(), 80u);
+    EXPECT_EQ(contents(path + ".1").substr(0, 7), "line 06");
+    EXPECT_EQ(contents(path + ".2").substr(0, 7), "line 04");
+    EXPECT_FALSE(exists(path + ".3"));
+    removeAll(path);
+}
+
+TEST(RotatingFileTest, KeepsThePreviousRun)
+{
+    std::string path = filePath("RotatingFileTest_Previous");
+    removeAll(path);
+    std::ofstream(path) << "previous run\n";
+
+    RotatingFile file;
+    ASSERT_TRUE(file.open(path));
+    ASSERT_TRUE(file.write("this run\n", 9));
+    EXPECT_TRUE(file.sync());
+    file.close();
+
+    EXPECT_EQ(contents(path), "this run\n");
+    EXPECT_EQ(contents(path + ".1"), "previous run\n");
+    removeAll(path);
+}
+
+TEST(RotatingFileTest, RotatesByAge)
+{
+    std::string path = filePath("RotatingFileTest_Age");
+    removeAll(path);
+
+    RotatingFile::Options options;
+    options.maxAge = std::chrono::milliseconds(50);
+    RotatingFile file(options);
+    ASSERT_TRUE(file.open(path));
+    ASSERT_TRUE(file.write("first\n", 6));
+    ASSERT_TRUE(file.write("second\n", 7));
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    ASSERT_TRUE(file.write("third\n", 6));
+    file.close();
+
+    EXPECT_EQ(file.rotations(), 1u);
+    EXPECT_EQ(contents(path + ".1"), "first\nsecond\n");
+    EXPECT_EQ(contents(path), "third\n");
+    removeAll(path);
+}
+
+TEST(RotatingFileTest, LoggerWritesRotatingFiles)
+{
+    std::string path = filePath("RotatingFileTest_Logger");
+    removeAll(path);
+
+    RotatingFile::Options options;
+    options.maxFileSize = 4096;
+    options.maxFiles = 2;
+    Logger::instance().setLevel(LogLevel::Info);
+    Logger::instance().enableLocationInfo(false);
+    ASSERT_TRUE(Logger::instance().setRotatingOutputFile(path, options));
+    // Straight to the logger, so no VISCA_LOG_MIN_LEVEL compiles the INFO lines out
+    for (int i = 0; i < 200; ++i)
+        Logger::instance().log(LogLevel::Info, __FILE__, __FUNCTION__, __LINE__, "message %d", i);
+    VISCALOG_ERROR("last message");
+
+    // Error lines are synced, the mapping already holds them before the file is closed
+    std::string current = contents(path);
+    EXPECT_NE(current.find("[ERROR] last message"), std::string::npos);
+
+    Logger::instance().closeFile();
+    Logger::instance().setOutput(&std::cout);
+    Logger::instance().enableLocationInfo(true);
+    Logger::instance().setLevel(LogLevel::Warning);
+
+    current = contents(path);
+    std::string previous = contents(path + ".1");
+    EXPECT_LE(current.size(), options.maxFileSize);
+    EXPECT_LE(previous.size(), options.maxFileSize);
+    EXPECT_EQ(current.find('\0'), std::string::npos);
+    EXPECT_NE(current.find("[ERROR] last message\n"), std::string::npos);
+    EXPECT_NE(previous.find("[INFO] message"), std::string::npos);
+    EXPECT_FALSE(exists(path + ".2"));
+    removeAll(path);
+}
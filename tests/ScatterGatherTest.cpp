@@ -0,0 +1,159 @@
+#include "TcpCommunicator.h"
+#include "UdpCommunicator.h"
+#include "WriteAll.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace Visca;
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+
+/**
+ * @brief A loopback port nobody listens on right now.
+ */
+uint16_t freePort(int type)
+{
+    int fd = ::socket(AF_INET, type, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    ::getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+/**
+ * @brief Packets of varying size with distinct contents, and their spans for sendv().
+ */
+struct Packets {
+    Packets(size_t count, size_t maxSize)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            Bytes packet(1 + i % maxSize);
+            for (size_t j = 0; j < packet.size(); ++j)
+                packet[j] = static_cast<uint8_t>(i + j);
+            all.insert(all.end(), packet.begin(), packet.end());
+            packets.push_back(std::move(packet));
+        }
+        for (const auto& packet : packets)
+            spans.emplace_back(packet);
+    }
+
+    std::vector<Bytes> packets;
+    std::vector<Span<const uint8_t>> spans;
+    Bytes all; ///< Everything concatenated, as a stream reader sees it
+};
+}
+
+TEST(ScatterGatherTest, WritevAllResumesAfterPartialWrites)
+{
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int sendBuffer = 4096;
+    ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+    ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    // More packets than one writev() takes, and more bytes than the socket buffers hold
+    Packets data(1000, 200);
+    socklen_t len = sizeof(sendBuffer);
+    ::getsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sendBuffer, &len);
+    ASSERT_LT(static_cast<size_t>(sendBuffer), data.all.size() / 4);
+
+    Bytes received;
+    std::thread reader([&] {
+        // Let the writer fill the buffer and stop mid-packet first
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint8_t buffer[1000];
+        while (received.size() < data.all.size()) {
+            ssize_t n = ::read(fds[1], buffer, sizeof(buffer));
+            if (n <= 0)
+                break;
+            received.insert(received.end(), buffer, buffer + n);
+        }
+    });
+
+    bool written = writevAll(fds[0], data.spans);
+    reader.join();
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    EXPECT_TRUE(written);
+    EXPECT_EQ(received, data.all);
+}
+
+TEST(ScatterGatherTest, TcpSendvArrivesAsOneStream)
+{
+    uint16_t port = freePort(SOCK_STREAM);
+    TcpCommunicator server("0.0.0.0", port, NetworkMode::Server);
+    TcpCommunicator client("127.0.0.1", port, NetworkMode::Client);
+
+    std::thread accepting([&] { server.open(); });
+    for (int attempt = 0; attempt < 100 && !client.open(); ++attempt)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    accepting.join();
+    ASSERT_TRUE(client.isOpen());
+    ASSERT_TRUE(server.isOpen());
+
+    Packets data(100, 16);
+    ASSERT_TRUE(client.sendv(data.spans));
+
+    // A stream transport fills the first slot only, with whatever bytes are there
+    uint8_t first[64];
+    uint8_t second[64];
+    FrameSlot slots[2];
+    slots[0].data = first;
+    slots[0].capacity = sizeof(first);
+    slots[1].data = second;
+    slots[1].capacity = sizeof(second);
+
+    Bytes received;
+    while (received.size() < data.all.size()) {
+        size_t filled = server.receivev(slots);
+        ASSERT_EQ(filled, 1u);
+        ASSERT_LE(slots[0].size, slots[0].capacity);
+        EXPECT_EQ(slots[1].size, 0u);
+        received.insert(received.end(), first, first + slots[0].size);
+    }
+    EXPECT_EQ(received, data.all);
+}
+
+TEST(ScatterGatherTest, UdpReceivevFillsOneSlotPerDatagram)
+{
+    uint16_t port = freePort(SOCK_DGRAM);
+    UdpCommunicator server("127.0.0.1", port, NetworkMode::Server);
+    UdpCommunicator client("127.0.0.1", port, NetworkMode::Client);
+    ASSERT_TRUE(server.open());
+    ASSERT_TRUE(client.open());
+
+    Packets data(3, 16);
+    data.packets[2].assign(20, 0xAB);
+    data.spans[2] = Span<const uint8_t>(data.packets[2]);
+    ASSERT_TRUE(client.sendv(data.spans));
+
+    uint8_t buffers[4][32];
+    FrameSlot slots[4];
+    for (size_t i = 0; i < 4; ++i) {
+        slots[i].data = buffers[i];
+        slots[i].capacity = sizeof(buffers[i]);
+    }
+
+    std::vector<Bytes> received;
+    while (received.size() < data.packets.size()) {
+        size_t filled = server.receivev(slots);
+        ASSERT_GT(filled, 0u);
+        for (size_t i = 0; i < filled; ++i)
+            received.emplace_back(slots[i].data, slots[i].data + slots[i].size);
+    }
+    EXPECT_EQ(received, data.packets);
+    EXPECT_EQ(slots[3].size, 0u);
+}
@@ -0,0 +1,141 @@
+#include "Logger.h"
+#include "MockCommunicator.h"
+#include "SharedCameraState.h"
+#include "ViscaController.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+using namespace Visca;
+
+namespace {
+std::string segmentName(const char* name) { return "visca-" + std::to_string(::getpid()) + "-" + name; }
+
+/**
+ * @brief State whose fields all derive from one counter, a torn copy mixes two counters.
+ */
+CameraState stateFor(uint64_t i)
+{
+    CameraState state;
+    state.zoomPosition = static_cast<uint16_t>(i);
+    state.focusPosition = static_cast<uint16_t>(~i);
+    state.zoomUpdatedNs = static_cast<int64_t>(i);
+    state.updatedNs = static_cast<int64_t>(i * 3);
+    state.commands = i;
+    state.linkErrors = i * 7;
+    return state;
+}
+
+bool isConsistent(const CameraState& state)
+{
+    uint64_t i = state.commands;
+    return state.zoomPosition == static_cast<uint16_t>(i) && state.focusPosition == static_cast<uint16_t>(~i)
+        && state.zoomUpdatedNs == static_cast<int64_t>(i) && state.updatedNs == static_cast<int64_t>(i * 3)
+        && state.linkErrors == i * 7;
+}
+}
+
+TEST(SharedCameraStateTest, ReaderSeesPublishedState)
+{
+    CameraStatePublisher publisher;
+    ASSERT_TRUE(publisher.open(segmentName("basic")));
+
+    CameraStateReader reader;
+    ASSERT_TRUE(reader.open(segmentName("basic")));
+    uint64_t sequence = reader.sequence();
+
+    publisher.publish(stateFor(42));
+    EXPECT_EQ(reader.sequence(), sequence + 2);
+
+    CameraState state;
+    ASSERT_TRUE(reader.read(state));
+    EXPECT_EQ(state.commands, 42u);
+    EXPECT_TRUE(isConsistent(state));
+
+    publisher.close();
+    CameraStateReader late;
+    EXPECT_FALSE(late.open(segmentName("basic"))) << "closing the publisher removes the name";
+    EXPECT_TRUE(reader.read(state)) << "attached readers keep their mapping";
+}
+
+TEST(SharedCameraStateTest, ReaderNeedsPublisher)
+{
+    CameraStateReader reader;
+    EXPECT_FALSE(reader.open(segmentName("missing")));
+    CameraState state;
+    EXPECT_FALSE(reader.read(state));
+}
+
+TEST(SharedCameraStateTest, ReadsAreNeverTorn)
+{
+    CameraStatePublisher publisher;
+    ASSERT_TRUE(publisher.open(segmentName("torn")));
+    publisher.publish(stateFor(0));
+    std::atomic<bool> running { true };
+    std::thread writer([&] {
+        for (uint64_t i = 1; running; ++i)
+            publisher.publish(stateFor(i));
+    });
+
+    CameraStateReader reader;
+    ASSERT_TRUE(reader.open(segmentName("torn")));
+    constexpr int Reads = 200000;
+    int torn = 0;
+    uint64_t last = 0;
+    bool monotonic = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Reads; ++i) {
+        CameraState state;
+        if (!reader.read(state))
+            continue;
+        if (!isConsistent(state))
+            ++torn;
+        monotonic = monotonic && state.commands >= last;
+        last = state.commands;
+    }
+    auto mean = (std::chrono::steady_clock::now() - start) / Reads;
+    running = false;
+    writer.join();
+
+    EXPECT_EQ(torn, 0);
+    EXPECT_TRUE(monotonic);
+    // Tens of nanoseconds uncontended, the bound leaves room for a writer hammering the same cache line
+    EXPECT_LT(mean, std::chrono::microseconds(5));
+}
+
+TEST(SharedCameraStateTest, ControllerPublishesWhatItLearns)
+{
+    Logger::instance().setLevel(LogLevel::Warning);
+    ViscaController controller(std::make_unique<MockCommunicator>());
+    ASSERT_TRUE(controller.publishState(segmentName("controller")));
+    ASSERT_TRUE(controller.connect());
+
+    CameraStateReader reader;
+    ASSERT_TRUE(reader.open(segmentName("controller")));
+
+    ASSERT_TRUE(controller.execute(Command::zoomDirect(1, 0x1234)));
+    ASSERT_TRUE(controller.execute(Command::focusManual()));
+    EXPECT_EQ(controller.getPowerStatus(), 0x02);
+    uint16_t focus = controller.getFocusPosition();
+    EXPECT_EQ(controller.state().focusPosition, focus);
+
+    CameraState state;
+    ASSERT_TRUE(reader.read(state));
+    EXPECT_EQ(state.connected, 1);
+    EXPECT_EQ(state.address, 1);
+    EXPECT_EQ(state.zoomPosition, 0x1234);
+    EXPECT_EQ(state.focusMode, 0x03);
+    EXPECT_EQ(state.power, 0x02);
+    EXPECT_EQ(state.commands, 4u);
+    EXPECT_EQ(state.errors + state.timeouts + state.linkErrors, 0u);
+    EXPECT_GT(state.zoomUpdatedNs, 0);
+    EXPECT_GE(state.updatedNs, state.zoomUpdatedNs);
+
+    controller.disconnect();
+    ASSERT_TRUE(reader.read(state));
+    EXPECT_EQ(state.connected, 0);
+}
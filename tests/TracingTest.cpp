@@ -0,0 +1,117 @@
+#include "MockCommunicator.h"
+#include "Tracing.h"
+#include "ViscaController.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace Visca;
+
+namespace {
+struct RecordingTracer : ITracer {
+    void trace(TraceEvent event, uint64_t id, uint64_t value) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.emplace_back(event, id, value);
+    }
+
+    std::vector<TraceEvent> kinds(uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<TraceEvent> result;
+        for (const auto& event : events) {
+            if (std::get<1>(event) == id)
+                result.push_back(std::get<0>(event));
+        }
+        return result;
+    }
+
+    std::mutex mutex;
+    std::vector<std::tuple<TraceEvent, uint64_t, uint64_t>> events;
+};
+}
+
+TEST(TracingTest, ChromeTraceJson)
+{
+    ChromeTraceWriter writer(4);
+    writer.trace(TraceEvent::CommandEnqueued, 7, 9);
+    writer.trace(TraceEvent::AckMatched, 7, 1);
+    writer.trace(TraceEvent::CompletionMatched, 7, 1);
+    writer.trace(TraceEvent::BytesWritten, 0, 9);
+    writer.trace(TraceEvent::FrameReassembled, 0, 3); // Over capacity
+
+    EXPECT_EQ(writer.size(), 4u);
+    EXPECT_EQ(writer.dropped(), 1u);
+
+    std::string json = writer.json();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[{", 0), 0u);
+    EXPECT_NE(json.find("\"name\":\"command\",\"cat\":\"visca\",\"ph\":\"b\",\"id\":\"0x7\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"ack\",\"cat\":\"visca\",\"ph\":\"n\",\"id\":\"0x7\""), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"e\",\"id\":\"0x7\""), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"result\":\"completed\",\"socket\":1}"), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"bytes_written\",\"cat\":\"visca\",\"ph\":\"i\""), std::string::npos);
+    EXPECT_EQ(json.find("frame_reassembled"), std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+}
+
+TEST(TracingTest, ConcurrentEventsAreAllKept)
+{
+    ChromeTraceWriter writer(40000);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&writer] {
+            for (int i = 0; i < 10000; ++i)
+                writer.trace(TraceEvent::BytesWritten, 0, 6);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(writer.size(), 40000u);
+    EXPECT_EQ(writer.dropped(), 0u);
+    std::string json = writer.json();
+    size_t count = 0;
+    for (size_t at = json.find("bytes_written"); at != std::string::npos; at = json.find("bytes_written", at + 1))
+        ++count;
+    EXPECT_EQ(count, 40000u);
+}
+
+TEST(TracingTest, ControllerEvents)
+{
+    if (!Tracing::compiledIn())
+        GTEST_SKIP() << "Library built without ENABLE_TRACING";
+
+    RecordingTracer tracer;
+    Tracing::setTracer(&tracer);
+    MockCommunicator::Config config;
+    config.camera.poweredOn = false;
+    ViscaController camera(std::make_unique<MockCommunicator>(config));
+    camera.setFailureDumpFrames(0);
+    ASSERT_TRUE(camera.connect());
+    EXPECT_NE(camera.getPowerStatus(), 0);
+    EXPECT_FALSE(camera.execute(Command::zoomTeleStandard()));
+    camera.disconnect();
+    Tracing::setTracer(nullptr);
+
+    // Ids count up from the first command traced
+    std::vector<uint64_t> ids;
+    for (const auto& event : tracer.events) {
+        if (std::get<0>(event) == TraceEvent::CommandEnqueued)
+            ids.push_back(std::get<1>(event));
+    }
+    ASSERT_EQ(ids.size(), 2u);
+    EXPECT_NE(ids[0], 0u);
+    EXPECT_EQ(tracer.kinds(ids[0]), (std::vector<TraceEvent> { TraceEvent::CommandEnqueued,
+                                        TraceEvent::CompletionMatched }));
+    EXPECT_EQ(tracer.kinds(ids[1]), (std::vector<TraceEvent> { TraceEvent::CommandEnqueued,
+                                        TraceEvent::CommandFailed }));
+
+    auto kinds = tracer.kinds(0);
+    EXPECT_EQ(std::count(kinds.begin(), kinds.end(), TraceEvent::BytesWritten), 2);
+    EXPECT_EQ(std::count(kinds.begin(), kinds.end(), TraceEvent::FrameReassembled), 2);
+}
@@ -0,0 +1,217 @@
+#include "CaptureCommunicator.h"
+#include "Commands.h"
+#include "Logger.h"
+#include "MockCommunicator.h"
+#include "ReplayCommunicator.h"
+#include "TrafficCapture.h"
+#include "ViscaController.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+using namespace Visca;
+using namespace std::chrono_literals;
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+using Clock = std::chrono::steady_clock;
+
+std::string capturePath(const char* name) { return testing::TempDir() + name + ".vcap"; }
+
+struct Frame {
+    CaptureDirection direction;
+    Bytes data;
+};
+
+std::vector<Frame> readCapture(const std::string& path)
+{
+    std::vector<Frame> frames;
+    CaptureReader reader;
+    if (!reader.open(path))
+        return frames;
+    CaptureRecord record;
+    while (reader.next(record))
+        frames.push_back({ record.direction, Bytes(record.data.begin(), record.data.end()) });
+    return frames;
+}
+
+// Runs a short session against a simulated camera and records it
+void recordSession(const std::string& path, Clock::duration zoomFullTravel = std::chrono::milliseconds(100))
+{
+    MockCommunicator::Config mock;
+    mock.camera.zoomFullTravel = zoomFullTravel;
+    ViscaController camera(std::make_unique<CaptureCommunicator>(std::make_unique<MockCommunicator>(mock), path));
+    ASSERT_TRUE(camera.connect());
+    ASSERT_TRUE(camera.execute(Command::zoomDirect(1, 0x1234)));
+    Response response;
+    ASSERT_TRUE(camera.execute(Command::zoomPositionInquiry(), response));
+    camera.disconnect();
+}
+}
+
+TEST(TrafficCaptureTest, WriterAndReaderRoundTrip)
+{
+    std::string path = capturePath("RoundTrip");
+    CaptureWriter writer;
+    ASSERT_TRUE(writer.open(path));
+
+    // Enough records to grow the mapping a few times
+    const size_t count = 200000;
+    for (size_t i = 0; i < count; ++i) {
+        Bytes frame { 0x81, 0x09, static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), 0xFF };
+        ASSERT_TRUE(writer.record(i % 2 ? CaptureDirection::Received : CaptureDirection::Sent, i * 1000,
+            Span<const uint8_t>(frame)));
+    }
+    EXPECT_FALSE(writer.record(CaptureDirection::Sent, Span<const uint8_t>()));
+    EXPECT_EQ(writer.records(), count);
+    writer.close();
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_GT(reader.startWallClockNs(), 0u);
+
+    CaptureRecord record;
+    size_t read = 0;
+    while (reader.next(record)) {
+        ASSERT_EQ(record.timestampNs, read * 1000);
+        ASSERT_EQ(record.direction, read % 2 ? CaptureDirection::Received : CaptureDirection::Sent);
+        ASSERT_EQ(record.data.size(), 5u);
+        ASSERT_EQ(record.data[2], static_cast<uint8_t>(read));
+        ++read;
+    }
+    EXPECT_EQ(read, count);
+
+    reader.rewind();
+    EXPECT_TRUE(reader.next(record));
+    EXPECT_EQ(record.timestampNs, 0u);
+    std::remove(path.c_str());
+}
+
+TEST(TrafficCaptureTest, ReaderStopsAtZeroFilledTail)
+{
+    std::string path = capturePath("ZeroTail");
+    CaptureWriter writer;
+    ASSERT_TRUE(writer.open(path));
+    Bytes frame { 0x81, 0x01, 0x04, 0x07, 0x00, 0xFF };
+    writer.record(CaptureDirection::Sent, Span<const uint8_t>(frame));
+    writer.close();
+
+    // What a crash leaves behind: the preallocated part of the file is still zero
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        std::string zeros(4096, '\0');
+        file.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+
+    auto frames = readCapture(path);
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].data, frame);
+    std::remove(path.c_str());
+}
+
+TEST(TrafficCaptureTest, RejectsOtherFiles)
+{
+    std::string path = capturePath("NotACapture");
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "this is not a capture file at all";
+    }
+    CaptureReader reader;
+    EXPECT_FALSE(reader.open(path));
+    EXPECT_FALSE(reader.open(capturePath("DoesNotExist")));
+    std::remove(path.c_str());
+}
+
+TEST(TrafficCaptureTest, CaptureCommunicatorRecordsFrames)
+{
+    std::string path = capturePath("Session");
+    recordSession(path);
+
+    auto frames = readCapture(path);
+    ASSERT_EQ(frames.size(), 5u);
+    EXPECT_EQ(frames[0].direction, CaptureDirection::Sent);
+    EXPECT_EQ(frames[0].data, Command::zoomDirect(1, 0x1234).packet());
+    EXPECT_EQ(frames[1].direction, CaptureDirection::Received);
+    EXPECT_EQ(frames[1].data, (Bytes { 0x90, 0x41, 0xFF }));
+    EXPECT_EQ(frames[2].data, (Bytes { 0x90, 0x51, 0xFF }));
+    EXPECT_EQ(frames[3].direction, CaptureDirection::Sent);
+    EXPECT_EQ(frames[3].data, Command::zoomPositionInquiry().packet());
+    EXPECT_EQ(frames[4].direction, CaptureDirection::Received);
+    EXPECT_EQ(frames[4].data.size(), 7u);
+    std::remove(path.c_str());
+}
+
+TEST(TrafficCaptureTest, ReplayDrivesController)
+{
+    std::string path = capturePath("Replay");
+    recordSession(path);
+
+    ReplayCommunicator::Config config;
+    config.path = path;
+    config.speed = 0;
+    auto replay = std::make_unique<ReplayCommunicator>(config);
+    ReplayCommunicator* link = replay.get();
+
+    ViscaController camera(std::move(replay));
+    ASSERT_TRUE(camera.connect());
+    EXPECT_TRUE(camera.execute(Command::zoomDirect(1, 0x1234)));
+    Response response;
+    ASSERT_TRUE(camera.execute(Command::zoomPositionInquiry(), response));
+    EXPECT_EQ(response.getZoomPosition(), 0x1234);
+
+    EXPECT_TRUE(link->finished());
+    auto stats = link->stats();
+    EXPECT_EQ(stats.framesSent, 2u);
+    EXPECT_EQ(stats.mismatched, 0u);
+    EXPECT_EQ(stats.unexpected, 0u);
+    camera.disconnect();
+    std::remove(path.c_str());
+}
+
+TEST(TrafficCaptureTest, ReplayCountsDivergingSends)
+{
+    std::string path = capturePath("Diverging");
+    recordSession(path);
+
+    ReplayCommunicator::Config config;
+    config.path = path;
+    config.speed = 0;
+    config.receiveTimeoutMs = 10;
+    ReplayCommunicator replay(config);
+    ASSERT_TRUE(replay.open());
+
+    replay.send(Command::focusStop().packet());
+    replay.send(Command::zoomPositionInquiry().packet());
+    replay.send(Command::zoomStop().packet());
+
+    auto stats = replay.stats();
+    EXPECT_EQ(stats.framesSent, 3u);
+    EXPECT_EQ(stats.mismatched, 1u);
+    EXPECT_EQ(stats.unexpected, 1u);
+    std::remove(path.c_str());
+}
+
+TEST(TrafficCaptureTest, ReplayKeepsCapturedTiming)
+{
+    // zoomDirect to 0x1234 completes after about 115ms
+    std::string path = capturePath("Timing");
+    recordSession(path, 400ms);
+
+    auto timeZoomDirect = [&path](double speed) {
+        ReplayCommunicator::Config config;
+        config.path = path;
+        config.speed = speed;
+        ViscaController camera(std::make_unique<ReplayCommunicator>(config));
+        camera.connect();
+        auto start = Clock::now();
+        EXPECT_TRUE(camera.execute(Command::zoomDirect(1, 0x1234)));
+        return Clock::now() - start;
+    };
+
+    EXPECT_GE(timeZoomDirect(1.0), 90ms);
+    EXPECT_LT(timeZoomDirect(0), 50ms);
+    std::remove(path.c_str());
+}
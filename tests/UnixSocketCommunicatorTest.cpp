@@ -0,0 +1,125 @@
+#include "Commands.h"
+#include "UnixSocketCommunicator.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+using namespace Visca;
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+
+std::string socketPath(const char* name) { return "/tmp/visca-" + std::to_string(::getpid()) + "-" + name + ".sock"; }
+
+/**
+ * @brief Server and client connected to each other, the server accepting in the background.
+ */
+struct Pair {
+    explicit Pair(const char* name)
+        : server(socketPath(name), NetworkMode::Server)
+        , client(socketPath(name))
+    {
+        std::thread accepting([this] { server.open(); });
+        for (int attempt = 0; attempt < 100 && !client.open(); ++attempt)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        accepting.join();
+    }
+
+    UnixSocketCommunicator server;
+    UnixSocketCommunicator client;
+};
+
+Bytes receiveFrame(ICommunicator& comm)
+{
+    uint8_t buffer[64];
+    size_t size = comm.receive(buffer, sizeof(buffer));
+    return Bytes(buffer, buffer + size);
+}
+}
+
+TEST(UnixSocketCommunicatorTest, SendsOneMessagePerPacket)
+{
+    Pair pair("packets");
+    ASSERT_TRUE(pair.client.isOpen());
+    ASSERT_TRUE(pair.server.isOpen());
+
+    Bytes both = Command::zoomStop().packet();
+    const Bytes inquiry = Command::zoomPositionInquiry().packet();
+    both.insert(both.end(), inquiry.begin(), inquiry.end());
+    ASSERT_TRUE(pair.client.send(both));
+
+    EXPECT_EQ(receiveFrame(pair.server), Command::zoomStop().packet());
+    EXPECT_EQ(receiveFrame(pair.server), inquiry);
+
+    ASSERT_TRUE(pair.server.send(Bytes { 0x90, 0x41, 0xFF }));
+    EXPECT_EQ(receiveFrame(pair.client), (Bytes { 0x90, 0x41, 0xFF }));
+}
+
+TEST(UnixSocketCommunicatorTest, ReceivevFillsOneSlotPerMessage)
+{
+    Pair pair("slots");
+    Bytes replies[] = { { 0x90, 0x41, 0xFF }, { 0x90, 0x51, 0xFF }, { 0x90, 0x50, 0x01, 0x02, 0x03, 0x04, 0xFF } };
+    Span<const uint8_t> packets[] = { Span<const uint8_t>(replies[0]), Span<const uint8_t>(replies[1]),
+        Span<const uint8_t>(replies[2]) };
+    ASSERT_TRUE(pair.server.sendv(Span<const Span<const uint8_t>>(packets)));
+
+    uint8_t buffers[4][16];
+    FrameSlot slots[4];
+    for (size_t i = 0; i < 4; ++i) {
+        slots[i].data = buffers[i];
+        slots[i].capacity = sizeof(buffers[i]);
+    }
+    size_t filled = 0;
+    for (int attempt = 0; attempt < 3 && filled < 3; ++attempt)
+        filled += pair.client.receivev(Span<FrameSlot>(slots + filled, 4 - filled));
+    ASSERT_EQ(filled, 3u);
+    for (size_t i = 0; i < 3; ++i)
+        EXPECT_EQ(Bytes(slots[i].data, slots[i].data + slots[i].size), replies[i]);
+}
+
+TEST(UnixSocketCommunicatorTest, RoundTripIsFast)
+{
+    Pair pair("latency");
+    constexpr int RoundTrips = 2000;
+
+    std::thread echo([&pair] {
+        uint8_t buffer[64];
+        for (int i = 0; i < RoundTrips; ++i) {
+            size_t size = pair.server.receive(buffer, sizeof(buffer));
+            if (size == 0)
+                break;
+            pair.server.send(Span<const uint8_t>(buffer, size));
+        }
+    });
+
+    const Bytes packet = Command::zoomPositionInquiry().packet();
+    uint8_t buffer[64];
+    int completed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (; completed < RoundTrips; ++completed) {
+        if (!pair.client.send(packet) || pair.client.receive(buffer, sizeof(buffer)) != packet.size())
+            break;
+    }
+    auto mean = (std::chrono::steady_clock::now() - start) / RoundTrips;
+
+    // Closing ends the echo thread early if a round trip failed; it is joined before any assertion can return
+    if (completed < RoundTrips)
+        pair.client.close();
+    echo.join();
+    ASSERT_EQ(completed, RoundTrips);
+
+    // Well below 100 us on an idle machine, the bound leaves room for loaded CI hosts
+    EXPECT_LT(mean, std::chrono::microseconds(500));
+}
+
+TEST(UnixSocketCommunicatorTest, NoticesPeerClosing)
+{
+    Pair pair("closing");
+    pair.server.close();
+    EXPECT_TRUE(receiveFrame(pair.client).empty());
+    EXPECT_FALSE(pair.client.isOpen());
+    EXPECT_FALSE(pair.client.send(Command::zoomStop().packet()));
+}
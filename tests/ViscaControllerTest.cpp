@@ -0,0 +1,189 @@
+#include "Logger.h"
+#include "MockCommunicator.h"
+#include "ViscaController.h"
+
+#include <gtest/gtest.h>
+
+using namespace Visca;
+using namespace std::chrono_literals;
+
+namespace {
+using Clock = MockCommunicator::Clock;
+
+class ViscaControllerTest : public ::testing::Test {
+protected:
+    void SetUp() override { Logger::instance().setLevel(LogLevel::Warning); }
+
+    ViscaController& connect(const MockCommunicator::Config& config = MockCommunicator::Config())
+    {
+        auto communicator = std::make_unique<MockCommunicator>(config);
+        mock = communicator.get();
+        controller = std::make_unique<ViscaController>(std::move(communicator));
+        EXPECT_TRUE(controller->connect());
+        return *controller;
+    }
+
+    MockCommunicator* mock { nullptr };
+    std::unique_ptr<ViscaController> controller;
+};
+}
+
+TEST_F(ViscaControllerTest, ExecuteCommand)
+{
+    auto& camera = connect();
+    EXPECT_TRUE(camera.execute(Command::zoomStop()));
+    EXPECT_EQ(mock->camera().commandCount(), 1u);
+}
+
+TEST_F(ViscaControllerTest, InquiriesDoNotWaitForAck)
+{
+    auto& camera = connect();
+    camera.setResponseTimeout(200);
+
+    auto start = Clock::now();
+    EXPECT_EQ(camera.getPowerStatus(), 0x02);
+    EXPECT_LT(Clock::now() - start, 150ms);
+}
+
+TEST_F(ViscaControllerTest, ZoomDirectThenInquiry)
+{
+    MockCommunicator::Config config;
+    config.camera.zoomFullTravel = 200ms;
+    auto& camera = connect(config);
+
+    EXPECT_TRUE(camera.execute(Command::zoomDirect(1, 0x1800)));
+    EXPECT_EQ(camera.getZoomPosition(), 0x1800);
+}
+
+TEST_F(ViscaControllerTest, VersionInfo)
+{
+    auto& camera = connect();
+    auto info = camera.getVersionInfo();
+    EXPECT_EQ(info.vendorId, 0x0020);
+    EXPECT_EQ(info.modelId, 0x0713);
+    EXPECT_EQ(info.romRevision, 0x0100u);
+    EXPECT_EQ(info.maxSocket, 2);
+}
+
+TEST_F(ViscaControllerTest, ErrorFailsExecute)
+{
+    MockCommunicator::Config config;
+    config.camera.poweredOn = false;
+    auto& camera = connect(config);
+
+    Response response;
+    EXPECT_FALSE(camera.execute(Command::zoomTeleStandard(), response));
+    EXPECT_TRUE(response.isError());
+    EXPECT_EQ(response.errorCode(), 0x41);
+}
+
+TEST_F(ViscaControllerTest, RoundTripFollowsLatency)
+{
+    MockCommunicator::Config config;
+    config.latency = 10ms;
+    config.camera.ackDelay = 1ms;
+    config.camera.commandTime = 4ms;
+    auto& camera = connect(config);
+
+    // Out 10ms, ACK after 1ms, completion 4ms later, back 10ms
+    auto start = Clock::now();
+    EXPECT_TRUE(camera.execute(Command::zoomStop()));
+    auto elapsed = Clock::now() - start;
+    EXPECT_GE(elapsed, 25ms);
+    EXPECT_LT(elapsed, 200ms);
+}
+
+TEST_F(ViscaControllerTest, BatchedSendAsync)
+{
+    auto& camera = connect();
+
+    std::vector<Command> commands { Command::zoomStop(), Command::focusAuto() };
+    ASSERT_TRUE(camera.sendAsync(commands));
+
+    int acks = 0;
+    int completions = 0;
+    Response response;
+    while (camera.pollResponse(response, 200)) {
+        acks += response.isAcknowledge() ? 1 : 0;
+        completions += response.isCompletion() ? 1 : 0;
+    }
+    EXPECT_EQ(acks, 2);
+    EXPECT_EQ(completions, 2);
+    EXPECT_EQ(mock->stats().framesReceived, 4u);
+}
+
+TEST_F(ViscaControllerTest, ExecuteLeavesAsyncRepliesAlone)
+{
+    auto& camera = connect();
+
+    ASSERT_TRUE(camera.sendAsync(Command::zoomPositionInquiry()));
+    ASSERT_TRUE(camera.sendAsync(Command::zoomStop()));
+    EXPECT_FALSE(camera.execute(Command::zoomStop()));
+
+    // The inquiry reply, then the ACK and completion of zoomStop, none of them discarded
+    int replies = 0;
+    bool inquiryReply = false;
+    Response response;
+    while (camera.pollResponse(response, 200)) {
+        ++replies;
+        inquiryReply = inquiryReply || (response.isCompletion() && response.data().size() > 3);
+    }
+    EXPECT_EQ(replies, 3);
+    EXPECT_TRUE(inquiryReply);
+    EXPECT_EQ(camera.metrics().staleReplies, 0u);
+
+    // Everything owed has been polled
+    EXPECT_TRUE(camera.execute(Command::zoomStop()));
+}
+
+TEST_F(ViscaControllerTest, ExecuteAfterAsyncCancel)
+{
+    auto& camera = connect();
+
+    ASSERT_TRUE(camera.sendAsync(Command::zoomDirect(1, 0x4000)));
+    Response response;
+    ASSERT_TRUE(camera.pollResponse(response, 200));
+    ASSERT_TRUE(response.isAcknowledge());
+
+    // The running zoom is answered by "cancelled" only, which settles both the cancel and the socket
+    auto cancel = static_cast<uint8_t>(0x20 | response.socketNumber());
+    ASSERT_TRUE(camera.sendAsync(Command::fromPacket({ 0x81, cancel, 0xFF })));
+    ASSERT_TRUE(camera.pollResponse(response, 200));
+    EXPECT_TRUE(response.isError());
+    EXPECT_EQ(response.errorCode(), 0x04);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(camera.execute(Command::zoomStop()));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+}
+
+TEST_F(ViscaControllerTest, ExecuteAfterAsyncBroadcast)
+{
+    auto& camera = connect();
+
+    // Address set is passed along the chain, not acknowledged: nothing is owed for it
+    ASSERT_TRUE(camera.sendAsync(Command::fromPacket({ 0x88, 0x30, 0x01, 0xFF })));
+    Response response;
+    camera.pollResponse(response, 100);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(camera.execute(Command::zoomStop()));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+}
+
+TEST_F(ViscaControllerTest, PacketFromBytes)
+{
+    auto& camera = connect();
+
+    Command zoomTele = Command::fromPacket({ 0x81, 0x01, 0x04, 0x07, 0x02, 0xFF });
+    ASSERT_FALSE(zoomTele.empty());
+    EXPECT_EQ(zoomTele.packet(), Command::zoomTeleStandard().packet());
+    EXPECT_TRUE(camera.execute(zoomTele));
+    EXPECT_TRUE(Command::fromPacket({ 0x81, 0x09, 0x04, 0x47, 0xFF }).isInquiry());
+
+    EXPECT_TRUE(Command::fromPacket({ 0x81, 0xFF }).empty());
+    EXPECT_TRUE(Command::fromPacket({ 0x90, 0x41, 0xFF }).empty());
+    EXPECT_TRUE(Command::fromPacket({ 0x81, 0x01, 0x04, 0x07, 0x02 }).empty());
+    EXPECT_TRUE(Command::fromPacket({ 0x81, 0xFF, 0x04, 0xFF }).empty());
+    EXPECT_TRUE(Command::fromPacket(std::vector<uint8_t>(17, 0x00)).empty());
+}